@@ -519,6 +519,7 @@ public:
 		native::HPipeline_ lastBoundProgram;
 		bool enabledScissorTest;
 		bool enabledBlend;
+		bool enabledPrimitiveRestart;
 
 		Rectanglei viewport;
 		Rectanglei scissor;
@@ -555,6 +556,7 @@ public:
 			destAlphaFactor(types::BlendFactor::DefaultDestRgba),
 			enabledScissorTest(types::PipelineDefaults::ViewportScissor::ScissorTestEnabled),
 			enabledBlend(types::PipelineDefaults::ColorBlend::BlendEnabled),
+			enabledPrimitiveRestart(types::PipelineDefaults::InputAssembler::PrimitiveRestartEnabled),
 			viewport(0, 0, 0, 0),
 			scissor(0, 0, 0, 0),
 			attributesToEnableBitfield(0),
@@ -175,6 +175,11 @@ void createStateObjects(const InputAssemblerStateCreateParam& thisobject,
 		thisobject.topology = types::PrimitiveTopology::TriangleList;
 	}
 	else { thisobject.topology = storage.primitiveTopology = parent_param->topology; }
+
+	if (!parent_param || parent_param->isPrimitiveRestartEnabled() != thisobject.isPrimitiveRestartEnabled())
+	{
+		storage.addState(new gles::PrimitiveRestartState(thisobject.isPrimitiveRestartEnabled()));
+	}
 }
 
 void createStateObjects(const VertexShaderStageCreateParam& thisobject,
@@ -272,6 +272,24 @@ void ScissorTestState::commitState(IGraphicsContext& device, bool enable)
 	debugLogApiError("StencilOpBackState::commitState exit");
 }
 
+void PrimitiveRestartState::commitState(IGraphicsContext& device, bool enable)
+{
+	debugLogApiError("PrimitiveRestartState::commitState enter");
+	if (native_cast(device).getCurrentRenderStates().enabledPrimitiveRestart == enable) { return; }
+#if (!defined(BUILD_API_MAX)||(BUILD_API_MAX>=30))
+	if (device.getApiType() < Api::OpenGLES3)
+	{
+		if (enable) { Log(Log.Error, "PrimitiveRestartState::commitState: Primitive restart requires OpenGL ES 3.0"); }
+		return;
+	}
+	native_cast(device).getCurrentRenderStates().enabledPrimitiveRestart = enable;
+	(enable ? gl::Enable(GL_PRIMITIVE_RESTART_FIXED_INDEX) : gl::Disable(GL_PRIMITIVE_RESTART_FIXED_INDEX));
+#else
+	if (enable) { Log(Log.Error, "PrimitiveRestartState::commitState: Primitive restart requires OpenGL ES 3.0"); }
+#endif
+	debugLogApiError("PrimitiveRestartState::commitState exit");
+}
+
 void StencilCompareOpFront::commitState(IGraphicsContext& device, ComparisonMode cmp)
 {
 	debugLogApiError("StencilComapreOpFront::commitState enter");
@@ -23,7 +23,7 @@ enum class GraphicsStateType
 	PolygonCulling, PolygonWindingOrder, BlendRgba, BlendTest, PolygonFill,
 	ScissorTest, StencilOpFront, StencilOpBack, FrameBufferClear,
 	FrameBufferWrite, DepthFunc, BlendEq, StencilTest, StencilClear,
-	VertexAttributeFormatState, VertexAttributeLocation, Count
+	VertexAttributeFormatState, VertexAttributeLocation, PrimitiveRestart, Count
 };
 
 class GraphicsPipeline_;
@@ -470,6 +470,28 @@ public:
 	bool _scissorTest;
 };
 
+/// <summary>Pipeline. Controls primitive restart with a fixed (all bits set) restart index. Enable/ disable.
+/// </summary><remarks>Requires OpenGL ES 3.0. On OpenGL ES 2.0 contexts enabling it logs an error and does nothing.
+/// </remarks>
+class PrimitiveRestartState : public impl::GraphicsPipelineImplState
+{
+public:
+	void set(IGraphicsContext& device) { commitState(device, _primitiveRestart); }
+	impl::PipelineState::ptr_type createClone()const  { return new PrimitiveRestartState(*this); }
+	impl::PipelineState::ptr_type createDefault()const
+	{
+		return new PrimitiveRestartState(types::PipelineDefaults::InputAssembler::PrimitiveRestartEnabled);
+	}
+	bool operator==(const PrimitiveRestartState& rhs) { return ((_primitiveRestart == rhs._primitiveRestart)); }
+	bool operator!=(const PrimitiveRestartState& rhs) { return !(*this == rhs); }
+	impl::GraphicsStateType getStateType()const { return impl::GraphicsStateType::PrimitiveRestart; }
+
+	PrimitiveRestartState() : _primitiveRestart(types::PipelineDefaults::InputAssembler::PrimitiveRestartEnabled) { }
+	PrimitiveRestartState(bool enable) : _primitiveRestart(enable) {}
+	void commitState(IGraphicsContext& device, bool enable);
+	bool _primitiveRestart;
+};
+
 /// <summary>Pipeline graphics shader program state.</summary>
 class GraphicsShaderProgramState : public impl::GraphicsPipelineImplState
 {
@@ -6,11 +6,136 @@
 */
 #pragma once
 #include <PVRAssets/Model.h>
+#include <PVRAssets/Helper.h>
 #include <PVRCore/Math/AxisAlignedBox.h>
+#include <PVRCore/Math/BoundingSphere.h>
 namespace pvr {
 namespace assets {
 /// <summary>Contains utilities and helpers</summary>
 namespace utils {
+namespace internal {
+// The positions of a mesh: where they are and how to read them.
+struct PositionData
+{
+	const byte* data;
+	types::DataType type;
+	uint32 numComponents;
+	uint32 stride;
+	uint32 numVertices;
+	const glm::mat4* transform; // The unpack matrix of the mesh, or NULL if it is the identity
+};
+
+inline bool getPositionData(const Mesh& mesh, const char* positionSemanticName, PositionData& positions)
+{
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName(positionSemanticName);
+	if (!attribute || attribute->getDataIndex() < 0 || (uint32)attribute->getDataIndex() >= mesh.getNumDataElements() ||
+	    !mesh.getNumVertices())
+	{
+		return false;
+	}
+	positions.type = attribute->getVertexLayout().dataType;
+	positions.numComponents = (std::min)(attribute->getN(), 3u);
+	positions.stride = mesh.getStride(attribute->getDataIndex());
+	positions.numVertices = mesh.getNumVertices();
+	positions.data = static_cast<const byte*>(mesh.getData(attribute->getDataIndex()));
+	const size_t lastVertex = attribute->getOffset() + (size_t)(positions.numVertices - 1) * positions.stride;
+	if (!positions.data || !positions.numComponents || mesh.getDataSize(attribute->getDataIndex()) <
+	    lastVertex + types::dataTypeSize(positions.type) * positions.numComponents)
+	{
+		return false;
+	}
+	positions.data += attribute->getOffset();
+	positions.transform = mesh.getUnpackMatrix() == glm::mat4(1.0f) ? NULL : &mesh.getUnpackMatrix();
+	return true;
+}
+
+// Read the positions a block at a time, converted with VertexReadBatch to four floats per vertex (the fourth
+// unspecified), and pass each block and its number of vertices to a function.
+template<typename Function>
+inline void readPositionBlocks(const PositionData& positions, Function function)
+{
+	const uint32 BlockSize = 256;
+	float32 block[BlockSize * 4];
+	for (uint32 first = 0; first < positions.numVertices; first += BlockSize)
+	{
+		const uint32 count = (std::min)(BlockSize, positions.numVertices - first);
+		VertexReadBatch(positions.data + (size_t)first * positions.stride, positions.stride, positions.type,
+		                positions.numComponents, count, block, 4);
+		for (uint32 i = 0; i < count && positions.numComponents < 3; ++i)
+		{
+			for (uint32 c = positions.numComponents; c < 3; ++c) { block[i * 4 + c] = 0.0f; }
+		}
+		if (positions.transform)
+		{
+			for (uint32 i = 0; i < count; ++i)
+			{
+				const glm::vec4 position = *positions.transform *
+				                           glm::vec4(block[i * 4], block[i * 4 + 1], block[i * 4 + 2], 1.0f);
+				memcpy(&block[i * 4], &position, 3 * sizeof(float32));
+			}
+		}
+		function(block, count);
+	}
+}
+
+inline void getMinMax(const PositionData& positions, glm::vec3& min, glm::vec3& max)
+{
+	float32 low[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX }, high[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	readPositionBlocks(positions, [&](const float32* block, uint32 count)
+	{
+		// Local copies of all four lanes, so that the loop vectorizes; the fourth is ignored.
+		float32 blockLow[4] = { low[0], low[1], low[2], low[3] }, blockHigh[4] = { high[0], high[1], high[2], high[3] };
+		for (uint32 i = 0; i < count; ++i)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				blockLow[c] = block[i * 4 + c] < blockLow[c] ? block[i * 4 + c] : blockLow[c];
+				blockHigh[c] = block[i * 4 + c] > blockHigh[c] ? block[i * 4 + c] : blockHigh[c];
+			}
+		}
+		memcpy(low, blockLow, sizeof(low));
+		memcpy(high, blockHigh, sizeof(high));
+	});
+	min = glm::vec3(low[0], low[1], low[2]);
+	max = glm::vec3(high[0], high[1], high[2]);
+}
+
+inline float32 getMaxSquaredDistance(const PositionData& positions, const glm::vec3& centre)
+{
+	float32 result = 0.0f;
+	readPositionBlocks(positions, [&](const float32* block, uint32 count)
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			const float32 x = block[i * 4] - centre.x, y = block[i * 4 + 1] - centre.y, z = block[i * 4 + 2] - centre.z;
+			const float32 squaredDistance = x * x + y * y + z * z;
+			result = squaredDistance > result ? squaredDistance : result;
+		}
+	});
+	return result;
+}
+}
+
+/// <summary>Return the bounding box of vertex positions of any data type.</summary>
+/// <param name="data">The position of the first vertex</param>
+/// <param name="type">The data type of the positions</param>
+/// <param name="numComponents">The number of components of the positions (1 to 3). Missing components are 0.</param>
+/// <param name="stride">Vertex stride in bytes</param>
+/// <param name="numVertices">The number of vertices</param>
+/// <returns>The Axis-aligned bounding box of the positions, empty at the origin if there are none</returns>
+inline math::AxisAlignedBox getBoundingBox(const byte* data, types::DataType type, uint32 numComponents, uint32 stride,
+    uint32 numVertices)
+{
+	math::AxisAlignedBox aabb;
+	if (data && numVertices && numComponents)
+	{
+		internal::PositionData positions = { data, type, (std::min)(numComponents, 3u), stride, numVertices, NULL };
+		glm::vec3 minvec, maxvec;
+		internal::getMinMax(positions, minvec, maxvec);
+		aabb.setMinMax(minvec, maxvec);
+	}
+	return aabb;
+}
 
 /// <summary>Return bounding box from vertex data.</summary>
 /// <param name="data">?ertex data</param>
@@ -18,52 +143,40 @@ namespace utils {
 /// <param name="offset_bytes">Offset to the vertex data</param>
 /// <param name="size_bytes">Data size</param>
 /// <returns>The Axis-aligned bounding box of the data</returns>
+/// <remarks>It will be assumed that Vertex Position is a vec3 of float32.</remarks>
 inline math::AxisAlignedBox getBoundingBox(const byte* data, size_t stride_bytes, size_t offset_bytes, size_t size_bytes)
 {
-	math::AxisAlignedBox aabb;
 	assertion(data);
 	assertion(stride_bytes >= 12 || !stride_bytes);
 	assertion(size_bytes >= stride_bytes);
-	if (size_bytes && data)
-	{
-		data = data + offset_bytes;
-		glm::vec3 minvec; glm::vec3 maxvec;
-		memcpy(&minvec, data, 12);
-		memcpy(&maxvec, data, 12);
-
-		for (size_t i = stride_bytes; i < size_bytes; i += stride_bytes)
-		{
-			glm::vec3 vec; memcpy(&vec, data + i, 12);
-			minvec = glm::min(vec, minvec);
-			maxvec = glm::max(vec, maxvec);
-		}
-		aabb.setMinMax(minvec, maxvec);
-	}
-	else
-	{
-		aabb.setMinMax(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-	}
+	if (!data || size_bytes < offset_bytes + 12) { return math::AxisAlignedBox(); }
+	const uint32 numVertices = stride_bytes ? (uint32)((size_bytes - offset_bytes - 12) / stride_bytes + 1) : 1;
+	return getBoundingBox(data + offset_bytes, types::DataType::Float32, 3, (uint32)stride_bytes, numVertices);
 }
 
 /// <summary>Return bounding box of a mesh.</summary>
 /// <param name="mesh">A mesh from which to get the bounding box of</param>
 /// <param name="positionSemanticName">Position attribute semantic name</param>
-/// <returns>Axis-aligned bounding box</returns>
-/// <remarks>It will be assumed that Vertex Position is a vec3.</remarks>
+/// <returns>Axis-aligned bounding box, after the unpack matrix of the mesh. Empty at the origin if the mesh has no
+/// such attribute.</returns>
+/// <remarks>The positions can be of any data type.</remarks>
 inline math::AxisAlignedBox getBoundingBox(const Mesh& mesh, const char* positionSemanticName)
 {
-	const Mesh::VertexAttributeData* vbo = mesh.getVertexAttributeByName(positionSemanticName);
-	if (vbo)
+	math::AxisAlignedBox aabb;
+	internal::PositionData positions;
+	if (internal::getPositionData(mesh, positionSemanticName, positions))
 	{
-		return getBoundingBox(static_cast<const byte*>(mesh.getData(vbo->getDataIndex())), vbo->getStride(), vbo->getOffset(),
-		                      mesh.getDataSize(vbo->getDataIndex()));
+		glm::vec3 minvec, maxvec;
+		internal::getMinMax(positions, minvec, maxvec);
+		aabb.setMinMax(minvec, maxvec);
 	}
+	return aabb;
 }
 
 /// <summary>Return bounding box of a mesh.</summary>
 /// <param name="mesh">A mesh from which to get the bounding box of</param>
 /// <returns>Axis-aligned bounding box</returns>
-/// <remarks>It will be assumed that Vertex Position is a vec3 and has the semantic "POSITION".</remarks>
+/// <remarks>The Vertex Position is read from the semantic "POSITION".</remarks>
 inline math::AxisAlignedBox getBoundingBox(const Mesh& mesh)
 {
 	return getBoundingBox(mesh, "POSITION");
@@ -72,13 +185,13 @@ inline math::AxisAlignedBox getBoundingBox(const Mesh& mesh)
 /// <summary>Return bounding box of a model.</summary>
 /// <param name="model">A model from which to get the bounding box of. All meshes will be considered.</param>
 /// <returns>Axis-aligned bounding box</returns>
-/// <remarks>It will be assumed that Vertex Position is a vec3 and has the semantic "POSITION".</remarks>
+/// <remarks>The Vertex Position is read from the semantic "POSITION".</remarks>
 inline math::AxisAlignedBox getBoundingBox(const Model& model)
 {
 	if (model.getNumMeshes())
 	{
 		math::AxisAlignedBox retval(getBoundingBox(model.getMesh(0)));
-		for (int i = 1; i < model.getNumMeshes(); ++i)
+		for (uint32 i = 1; i < model.getNumMeshes(); ++i)
 		{
 			retval.mergeBox(getBoundingBox(model.getMesh(i)));
 		}
@@ -90,6 +203,59 @@ inline math::AxisAlignedBox getBoundingBox(const Model& model)
 	}
 }
 
+/// <summary>Return a bounding sphere of a mesh: centred on its bounding box, with the radius of its furthest vertex.
+/// </summary>
+/// <param name="mesh">A mesh from which to get the bounding sphere of</param>
+/// <param name="positionSemanticName">Position attribute semantic name</param>
+/// <returns>The bounding sphere, after the unpack matrix of the mesh. Of radius 0 at the origin if the mesh has no
+/// such attribute.</returns>
+inline math::BoundingSphere getBoundingSphere(const Mesh& mesh, const char* positionSemanticName)
+{
+	math::BoundingSphere sphere;
+	sphere.set(glm::vec3(0.0f), 0.0f);
+	internal::PositionData positions;
+	if (internal::getPositionData(mesh, positionSemanticName, positions))
+	{
+		glm::vec3 minvec, maxvec;
+		internal::getMinMax(positions, minvec, maxvec);
+		const glm::vec3 centre = (minvec + maxvec) * 0.5f;
+		sphere.set(centre, sqrtf(internal::getMaxSquaredDistance(positions, centre)));
+	}
+	return sphere;
+}
+
+/// <summary>Return a bounding sphere of a mesh: centred on its bounding box, with the radius of its furthest vertex.
+/// </summary>
+/// <param name="mesh">A mesh from which to get the bounding sphere of</param>
+/// <returns>The bounding sphere</returns>
+/// <remarks>The Vertex Position is read from the semantic "POSITION".</remarks>
+inline math::BoundingSphere getBoundingSphere(const Mesh& mesh)
+{
+	return getBoundingSphere(mesh, "POSITION");
+}
+
+/// <summary>Return a bounding sphere of a model: centred on its bounding box, with the radius of its furthest vertex.
+/// </summary>
+/// <param name="model">A model from which to get the bounding sphere of. All meshes will be considered.</param>
+/// <returns>The bounding sphere</returns>
+/// <remarks>The Vertex Position is read from the semantic "POSITION".</remarks>
+inline math::BoundingSphere getBoundingSphere(const Model& model)
+{
+	const glm::vec3 centre = getBoundingBox(model).center();
+	float32 squaredRadius = 0.0f;
+	for (uint32 i = 0; i < model.getNumMeshes(); ++i)
+	{
+		internal::PositionData positions;
+		if (internal::getPositionData(model.getMesh(i), "POSITION", positions))
+		{
+			squaredRadius = (std::max)(squaredRadius, internal::getMaxSquaredDistance(positions, centre));
+		}
+	}
+	math::BoundingSphere sphere;
+	sphere.set(centre, sqrtf(squaredRadius));
+	return sphere;
+}
+
+}
 }
 }
-}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*!
+\brief Constants and structures describing the layout of cooked model files.
+\file PVRAssets/FileIO/CookedModelDefines.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/CoreIncludes.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>Contains the definitions of the cooked model file format.</summary>
+/// <remarks>A cooked model file stores a Model in the form it is rendered from, so that loading it needs no parsing
+/// or conversion of vertex data. The file starts with a FileHeader followed by an array of SectionEntry. The Tables
+/// section contains the scene, node hierarchy, materials, textures, cameras, lights and the description of each
+/// mesh. The Blobs section contains the vertex and index data of all meshes, each blob aligned to BlobAlignment. The
+/// Blobs section itself starts at a multiple of SectionAlignment, so that it can be memory mapped and each blob
+/// handed directly to a buffer creation or update. All values are little endian.</remarks>
+namespace cookedModel {
+enum
+{
+	Magic = ('P' << 0) | ('V' << 8) | ('R' << 16) | ('C' << 24), //!< Identifies cooked model files
+	Version = 3, //!< The version of the format written by CookedModelWriter
+	SectionAlignment = 4096, //!< Alignment of the Blobs section in the file
+	BlobAlignment = 16 //!< Alignment of each blob within the Blobs section
+};
+
+/// <summary>Identifies a section of a cooked model file.</summary>
+enum SectionId
+{
+	SectionTables = 1, //!< Scene, nodes, materials, textures, cameras, lights and mesh descriptions
+	SectionBlobs = 2 //!< Vertex and index data
+};
+
+/// <summary>The header at the start of a cooked model file.</summary>
+struct FileHeader
+{
+	uint32 magic; //!< Must be Magic
+	uint32 version; //!< Must be Version
+	uint32 numSections; //!< Number of SectionEntry following the header
+	uint32 reserved; //!< Zero
+};
+
+/// <summary>Describes the position of a section in a cooked model file.</summary>
+struct SectionEntry
+{
+	uint32 id; //!< The SectionId of the section
+	uint32 reserved; //!< Zero
+	uint64 offset; //!< Offset of the section from the start of the file
+	uint64 size; //!< Size of the section in bytes
+};
+
+/// <summary>Describes a block of data in the Blobs section.</summary>
+struct BlobReference
+{
+	uint64 offset; //!< Offset of the blob from the start of the Blobs section
+	uint32 size; //!< Size of the blob in bytes
+	uint32 stride; //!< Distance between consecutive vertices in bytes, or zero for index data
+};
+
+/// <summary>The position of the vertex and index data of a mesh in a cooked model file.</summary>
+struct MeshBlobs
+{
+	/// <summary>One entry per data block of the mesh. Offsets are from the start of the file.</summary>
+	std::vector<BlobReference> vertexData;
+	/// <summary>The index data of the mesh. Offset is from the start of the file. Size is zero if not indexed.
+	/// </summary>
+	BlobReference indexData;
+	/// <summary>The type of the indices</summary>
+	types::IndexType indexType;
+	/// <summary>The index data of each level of detail of the mesh (Mesh::getLevelOfDetail), from the most detailed to
+	/// the least. Offsets are from the start of the file. The indices have the type of their level of detail.
+	/// </summary>
+	std::vector<BlobReference> levelOfDetailIndexData;
+};
+}
+}
+}
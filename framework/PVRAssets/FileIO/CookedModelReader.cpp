@@ -0,0 +1,442 @@
+/*!
+\brief Implementation of methods of the CookedModelReader class.
+\file PVRAssets/FileIO/CookedModelReader.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/CookedModelReader.h"
+#include "PVRAssets/Model.h"
+#include "PVRCore/Log.h"
+using std::vector;
+namespace pvr {
+namespace assets {
+namespace {
+using namespace cookedModel;
+
+// Deserializes the Tables section. Every read is bounds checked; after the first failure all reads fail.
+struct TableReader
+{
+	const byte* data;
+	size_t size;
+	size_t position;
+	bool isValid;
+
+	TableReader(const vector<byte>& tables) : data(tables.data()), size(tables.size()), position(0), isValid(true) {}
+
+	bool readRaw(void* value, size_t valueSize)
+	{
+		isValid = isValid && size - position >= valueSize;
+		if (isValid && valueSize)
+		{
+			memcpy(value, data + position, valueSize);
+			position += valueSize;
+		}
+		return isValid;
+	}
+	template<typename T>
+	bool read(T& value) { return readRaw(&value, sizeof(T)); }
+	template<typename T>
+	bool readVector(vector<T>& values)
+	{
+		uint32 byteSize = 0;
+		if (!read(byteSize) || byteSize % sizeof(T) || byteSize > size - position) { return isValid = false; }
+		values.resize(byteSize / sizeof(T));
+		return readRaw(values.data(), byteSize);
+	}
+	bool readString(StringHash& string)
+	{
+		uint32 length = 0;
+		if (!read(length) || length > size - position) { return isValid = false; }
+		string = StringHash(std::string(reinterpret_cast<const char*>(data + position), length));
+		position += length;
+		return true;
+	}
+	bool readFreeValue(FreeValue& value)
+	{
+		uint32 dataType = 0;
+		char raw[64];
+		if (!read(dataType) || !readRaw(raw, sizeof(raw))) { return false; }
+		value.fastSet((types::GpuDatatypes::Enum)dataType, raw);
+		return true;
+	}
+	// Read an element count, rejecting counts that could not possibly fit in the remaining data.
+	bool readCount(uint32& count, size_t minElementSize)
+	{
+		if (!read(count) || count > (size - position) / minElementSize) { return isValid = false; }
+		return true;
+	}
+};
+
+bool readSemantics(TableReader& tables, ContiguousMap<StringHash, FreeValue>& semantics)
+{
+	uint32 count = 0;
+	if (!tables.readCount(count, 4 + 4 + 64)) { return false; }
+	for (uint32 i = 0; i < count; ++i)
+	{
+		StringHash name;
+		if (!tables.readString(name) || !tables.readFreeValue(semantics[name])) { return false; }
+	}
+	return true;
+}
+
+bool readAnimation(TableReader& tables, Animation::InternalData& animation)
+{
+	return tables.read(animation.flags) && tables.read(animation.numberOfFrames) &&
+	       tables.readVector(animation.positions) && tables.readVector(animation.rotations) &&
+	       tables.readVector(animation.scales) && tables.readVector(animation.matrices) &&
+	       tables.readVector(animation.positionIndices) && tables.readVector(animation.rotationIndices) &&
+	       tables.readVector(animation.scaleIndices) && tables.readVector(animation.matrixIndices);
+}
+
+// Check that a blob lies within the Blobs section, and make its offset relative to the start of the file.
+bool resolveBlob(BlobReference& blob, const SectionEntry& blobSection)
+{
+	if (blob.offset > blobSection.size || blob.size > blobSection.size - blob.offset) { return false; }
+	blob.offset += blobSection.offset;
+	return true;
+}
+
+bool readMesh(TableReader& tables, Mesh& mesh, MeshBlobs& outBlobs, const SectionEntry& blobSection,
+              const vector<byte>* blobData)
+{
+	Mesh::InternalData& data = mesh.getInternalData();
+	Mesh::MeshInfo& info = data.primitiveData;
+	uint32 primitiveType = 0;
+	uint8 isIndexed = 0, isSkinned = 0, usesPrimitiveRestart = 0;
+	if (!tables.read(info.numVertices) || !tables.read(info.numFaces) || !tables.read(info.numPatchSubdivisions) ||
+	    !tables.read(info.numPatches) || !tables.read(info.numControlPointsPerPatch) || !tables.read(info.units) ||
+	    !tables.read(primitiveType) || !tables.read(isIndexed) || !tables.read(isSkinned) ||
+	    !tables.read(usesPrimitiveRestart) || !tables.readVector(info.stripLengths) || !tables.read(data.boneCount) ||
+	    !tables.read(data.boneBatches.boneBatchStride) || !tables.readVector(data.boneBatches.batches) ||
+	    !tables.readVector(data.boneBatches.boneCounts) || !tables.readVector(data.boneBatches.offsets) ||
+	    !tables.read(data.unpackMatrix) || !readSemantics(tables, data.semantics))
+	{
+		return false;
+	}
+	info.primitiveType = (types::PrimitiveTopology)primitiveType;
+	info.isIndexed = isIndexed != 0;
+	info.isSkinned = isSkinned != 0;
+	info.usesPrimitiveRestart = usesPrimitiveRestart != 0;
+
+	uint32 numAttributes = 0;
+	if (!tables.readCount(numAttributes, 4 + 4 + 1 + 2 + 2)) { return false; }
+	for (uint32 i = 0; i < numAttributes; ++i)
+	{
+		StringHash semantic;
+		uint32 dataType = 0;
+		uint8 n = 0;
+		uint16 offset = 0, dataIndex = 0;
+		if (!tables.readString(semantic) || !tables.read(dataType) || !tables.read(n) || !tables.read(offset) ||
+		    !tables.read(dataIndex))
+		{
+			return false;
+		}
+		mesh.addVertexAttribute(Mesh::VertexAttributeData(semantic, (types::DataType)dataType, n, offset, dataIndex));
+	}
+
+	uint32 numDataBlocks = 0;
+	if (!tables.readCount(numDataBlocks, sizeof(BlobReference))) { return false; }
+	outBlobs.vertexData.resize(numDataBlocks);
+	for (uint32 i = 0; i < numDataBlocks; ++i)
+	{
+		BlobReference& blob = outBlobs.vertexData[i];
+		if (!tables.read(blob)) { return false; }
+		const uint64 blobOffset = blob.offset;
+		if (!resolveBlob(blob, blobSection)) { return false; }
+		mesh.addData(blobData ? blobData->data() + blobOffset : NULL, blobData ? blob.size : 0, blob.stride);
+	}
+
+	uint32 indexType = 0;
+	BlobReference& indexBlob = outBlobs.indexData;
+	if (!tables.read(indexType) || !tables.read(indexBlob)) { return false; }
+	outBlobs.indexType = (types::IndexType)indexType;
+	const uint64 indexOffset = indexBlob.offset;
+	if (!resolveBlob(indexBlob, blobSection)) { return false; }
+	data.faces.setData(blobData ? blobData->data() + indexOffset : NULL, blobData ? indexBlob.size : 0,
+	                   outBlobs.indexType);
+
+	uint32 numLevelsOfDetail = 0;
+	if (!tables.readCount(numLevelsOfDetail, 4 * 4 + sizeof(BlobReference))) { return false; }
+	data.levelsOfDetail.resize(numLevelsOfDetail);
+	outBlobs.levelOfDetailIndexData.resize(numLevelsOfDetail);
+	for (uint32 i = 0; i < numLevelsOfDetail; ++i)
+	{
+		Mesh::LevelOfDetail& levelOfDetail = data.levelsOfDetail[i];
+		BlobReference& blob = outBlobs.levelOfDetailIndexData[i];
+		uint32 levelIndexType = 0;
+		if (!tables.read(levelOfDetail.numFaces) || !tables.read(levelOfDetail.numVertices) ||
+		    !tables.read(levelOfDetail.error) || !tables.read(levelIndexType) || !tables.read(blob))
+		{
+			return false;
+		}
+		const uint64 blobOffset = blob.offset;
+		if (!resolveBlob(blob, blobSection)) { return false; }
+		levelOfDetail.faces.setData(blobData ? blobData->data() + blobOffset : NULL, blobData ? blob.size : 0,
+		                            (types::IndexType)levelIndexType);
+	}
+	return true;
+}
+
+bool readTables(TableReader& tables, Model& model, vector<MeshBlobs>& outMeshBlobs, const SectionEntry& blobSection,
+                const vector<byte>* blobData)
+{
+	Model::InternalData& data = model.getInternalData();
+	if (!tables.read(data.clearColor) || !tables.read(data.ambientColor) || !tables.read(data.numMeshNodes) ||
+	    !tables.read(data.numLightNodes) || !tables.read(data.numCameraNodes) || !tables.read(data.numFrames) ||
+	    !tables.read(data.currentFrame) || !tables.read(data.FPS) || !tables.read(data.units) ||
+	    !tables.read(data.flags) || !tables.readVector(data.userData) || !readSemantics(tables, data.semantics))
+	{
+		return false;
+	}
+
+	uint32 count = 0;
+	if (!tables.readCount(count, 4)) { return false; }
+	data.textures.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (!tables.readString(data.textures[i].getName())) { return false; }
+	}
+
+	if (!tables.readCount(count, 4 * 6)) { return false; }
+	data.materials.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		Model::Material::InternalData& material = data.materials[i].getInternalData();
+		uint32 numEntries = 0;
+		if (!tables.readString(material.name) || !tables.readString(material.effectFile) ||
+		    !tables.readString(material.effectName) || !tables.readVector(material.userData) ||
+		    !tables.readCount(numEntries, 4 + 4 + 64))
+		{
+			return false;
+		}
+		for (uint32 entry = 0; entry < numEntries; ++entry)
+		{
+			StringHash name;
+			if (!tables.readString(name) || !tables.readFreeValue(material.materialSemantics[name])) { return false; }
+		}
+		if (!tables.readCount(numEntries, 4 + 4)) { return false; }
+		for (uint32 entry = 0; entry < numEntries; ++entry)
+		{
+			StringHash name;
+			if (!tables.readString(name) || !tables.read(material.textureIndexes[name])) { return false; }
+		}
+	}
+
+	if (!tables.readCount(count, 4 * 4)) { return false; }
+	data.cameras.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		Camera::InternalData& camera = data.cameras[i].getInternalData();
+		if (!tables.read(camera.targetNodeIdx) || !tables.read(camera.farClip) || !tables.read(camera.nearClip) ||
+		    !tables.readVector(camera.FOVs))
+		{
+			return false;
+		}
+	}
+
+	if (!tables.readCount(count, 4 * 11)) { return false; }
+	data.lights.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		Light::InternalData& light = data.lights[i].getInternalData();
+		uint32 type = 0;
+		if (!tables.read(light.spotTargetNodeIdx) || !tables.read(light.color) || !tables.read(type) ||
+		    !tables.read(light.constantAttenuation) || !tables.read(light.linearAttenuation) ||
+		    !tables.read(light.quadraticAttenuation) || !tables.read(light.falloffAngle) ||
+		    !tables.read(light.falloffExponent))
+		{
+			return false;
+		}
+		light.type = (Light::LightType)type;
+	}
+
+	if (!tables.readCount(count, 4 * 5)) { return false; }
+	data.nodes.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		Model::Node::InternalData& node = data.nodes[i].getInternalData();
+		if (!tables.readString(node.name) || !tables.read(node.objectIndex) || !tables.read(node.materialIndex) ||
+		    !tables.read(node.parentIndex) || !tables.readVector(node.userData) ||
+		    !readAnimation(tables, node.animation.getInternalData()))
+		{
+			return false;
+		}
+		node.animation.buildKeyIndex();
+	}
+
+	if (!tables.readCount(count, 4 * 8)) { return false; }
+	data.meshes.resize(count);
+	outMeshBlobs.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (!readMesh(tables, data.meshes[i], outMeshBlobs[i], blobSection, blobData)) { return false; }
+	}
+	return true;
+}
+
+// Check an index into a table that may also be -1 for none.
+inline bool isOptionalIndex(int32 index, size_t tableSize)
+{
+	return index == -1 || (index >= 0 && (size_t)index < tableSize);
+}
+
+// Check the indices that link the tables, so that a corrupted file cannot make the model read out of bounds. The mesh,
+// light and camera nodes come first, in that order, each referring to an object of its kind; the nodes after them
+// (camera and spot targets, bones) are not checked against any object. Material, parent and target indices are -1 or
+// refer to an existing entry, and no node is its own ancestor.
+bool validateTables(const Model::InternalData& data)
+{
+	const size_t numNodes = data.nodes.size();
+	if (data.numMeshNodes > numNodes || numNodes - data.numMeshNodes < data.lights.size() + data.cameras.size())
+	{
+		return false;
+	}
+	const size_t numKindNodes[3] = { data.numMeshNodes, data.lights.size(), data.cameras.size() };
+	const size_t numObjects[3] = { data.meshes.size(), data.lights.size(), data.cameras.size() };
+	size_t nodeIndex = 0;
+	for (uint32 kind = 0; kind < 3; ++kind)
+	{
+		for (size_t i = 0; i < numKindNodes[kind]; ++i, ++nodeIndex)
+		{
+			const int32 objectIndex = data.nodes[nodeIndex].getInternalData().objectIndex;
+			if (objectIndex < 0 || (size_t)objectIndex >= numObjects[kind]) { return false; }
+		}
+	}
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		const Model::Node::InternalData& node = data.nodes[i].getInternalData();
+		if (!isOptionalIndex(node.materialIndex, data.materials.size()) || !isOptionalIndex(node.parentIndex, numNodes))
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < data.cameras.size(); ++i)
+	{
+		if (!isOptionalIndex(data.cameras[i].getInternalData().targetNodeIdx, numNodes)) { return false; }
+	}
+	for (size_t i = 0; i < data.lights.size(); ++i)
+	{
+		if (!isOptionalIndex(data.lights[i].getInternalData().spotTargetNodeIdx, numNodes)) { return false; }
+	}
+
+	// Walk up from each node, marking the nodes on the way (1) until reaching the root or a node already known to have
+	// no cycle above it (2). Reaching a node marked on the same walk is a cycle.
+	vector<byte> state(numNodes, 0);
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		int32 node = (int32)i;
+		while (node != -1 && !state[node])
+		{
+			state[node] = 1;
+			node = data.nodes[node].getInternalData().parentIndex;
+		}
+		if (node != -1 && state[node] == 1) { return false; }
+		for (node = (int32)i; node != -1 && state[node] == 1; node = data.nodes[node].getInternalData().parentIndex)
+		{
+			state[node] = 2;
+		}
+	}
+	return true;
+}
+
+// Check that a section lies within a stream of the given size, before any memory is allocated for it.
+bool isSectionInStream(const SectionEntry& section, uint64 streamSize)
+{
+	return section.size <= streamSize && section.offset <= streamSize - section.size;
+}
+
+bool readFileHeader(Stream& stream, FileHeader& header)
+{
+	size_t dataRead = 0;
+	return stream.read(sizeof(header), 1, &header, dataRead) && dataRead == 1 && header.magic == Magic;
+}
+}
+
+bool CookedModelReader::readNextAsset(Model& asset)
+{
+	_modelsToLoad = false;
+	_meshBlobs.clear();
+
+	FileHeader header;
+	if (!readFileHeader(*_assetStream, header) || header.version != Version)
+	{
+		Log(Log.Error, "CookedModelReader: Not a cooked model file, or unsupported version");
+		return false;
+	}
+
+	SectionEntry tablesSection, blobSection;
+	memset(&tablesSection, 0, sizeof(tablesSection));
+	memset(&blobSection, 0, sizeof(blobSection));
+	size_t dataRead = 0;
+	for (uint32 i = 0; i < header.numSections; ++i)
+	{
+		SectionEntry section;
+		if (!_assetStream->read(sizeof(section), 1, &section, dataRead) || dataRead != 1) { return false; }
+		if (section.id == SectionTables) { tablesSection = section; }
+		else if (section.id == SectionBlobs) { blobSection = section; }
+	}
+
+	const uint64 streamSize = _assetStream->getSize();
+	if (!isSectionInStream(tablesSection, streamSize) || !isSectionInStream(blobSection, streamSize))
+	{
+		Log(Log.Error, "CookedModelReader: Cooked model file is truncated");
+		return false;
+	}
+
+	vector<byte> tablesData((size_t)tablesSection.size);
+	vector<byte> blobData;
+	bool result = _assetStream->seek((long)tablesSection.offset, Stream::SeekOriginFromStart) &&
+	              _assetStream->read(1, tablesData.size(), tablesData.data(), dataRead) && dataRead == tablesData.size();
+	if (result && _loadVertexData && blobSection.size)
+	{
+		blobData.resize((size_t)blobSection.size);
+		result = _assetStream->seek((long)blobSection.offset, Stream::SeekOriginFromStart) &&
+		         _assetStream->read(1, blobData.size(), blobData.data(), dataRead) && dataRead == blobData.size();
+	}
+	if (!result)
+	{
+		Log(Log.Error, "CookedModelReader: Cooked model file is truncated");
+		return false;
+	}
+
+	TableReader tables(tablesData);
+	if (!readTables(tables, asset, _meshBlobs, blobSection, _loadVertexData ? &blobData : NULL) ||
+	    !validateTables(asset.getInternalData()))
+	{
+		Log(Log.Error, "CookedModelReader: Cooked model file is corrupted");
+		_meshBlobs.clear();
+		return false;
+	}
+	asset.initCache();
+	return true;
+}
+
+bool CookedModelReader::hasAssetsLeftToLoad()
+{
+	return _modelsToLoad;
+}
+
+bool CookedModelReader::canHaveMultipleAssets()
+{
+	return false;
+}
+
+bool CookedModelReader::isSupportedFile(Stream& assetStream)
+{
+	if (!assetStream.isopen() && !assetStream.open()) { return false; }
+	FileHeader header;
+	const bool result = readFileHeader(assetStream, header);
+	assetStream.seek(0, Stream::SeekOriginFromStart);
+	return result;
+}
+
+vector<string> CookedModelReader::getSupportedFileExtensions()
+{
+	vector<string> extensions;
+	extensions.push_back("pvrcm");
+	return extensions;
+}
+}
+}
+//!\endcond
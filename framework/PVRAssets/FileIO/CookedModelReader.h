@@ -0,0 +1,64 @@
+/*!
+\brief An AssetReader that reads cooked model files and creates pvr::assets::Model objects out of them.
+\file PVRAssets/FileIO/CookedModelReader.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/AssetIncludes.h"
+#include "PVRAssets/FileIO/CookedModelDefines.h"
+
+namespace pvr {
+namespace assets {
+class Model;
+
+/// <summary>This class creates pvr::assets::Model objects from cooked model files, as written by
+/// assetWriters::CookedModelWriter. Reading a cooked model is two large reads (tables and blobs) followed by one copy
+/// of each vertex and index blob into its mesh; no vertex data is converted.</summary>
+/// <remarks>Applications that map the file into memory can skip the copy of the vertex and index data with
+/// setLoadVertexData(false), and create their buffers directly from the mapped blobs listed by getMeshBlobs().
+/// </remarks>
+class CookedModelReader : public AssetReader<Model>
+{
+public:
+	/// <summary>Construct empty reader.</summary>
+	CookedModelReader() : _modelsToLoad(true), _loadVertexData(true) {}
+	/// <summary>Construct reader from the specified stream.</summary>
+	CookedModelReader(Stream::ptr_type assetStream) :
+		AssetReader<Model>(assetStream), _modelsToLoad(true), _loadVertexData(true) { }
+
+	/// <summary>Set whether the vertex and index data is read into the meshes of the model. Default true. If false,
+	/// the data blocks and faces of the meshes are left empty (attributes and strides are set), and the data must be
+	/// taken from the file with the offsets returned by getMeshBlobs().</summary>
+	/// <param name="loadVertexData">True to read the vertex and index data, otherwise false</param>
+	void setLoadVertexData(bool loadVertexData) { _loadVertexData = loadVertexData; }
+
+	/// <summary>Get the position in the file of the vertex and index data of each mesh of the last model read.
+	/// </summary>
+	/// <returns>One entry per mesh, in the order of the meshes of the model</returns>
+	const std::vector<cookedModel::MeshBlobs>& getMeshBlobs() const { return _meshBlobs; }
+
+	/// <summary>Check if there more assets in the stream.</summary>
+	/// <returns>True if the readAsset() method can be called again to read another asset</returns>
+	bool hasAssetsLeftToLoad();
+
+	/// <summary>Check if this reader supports multiple assets per stream.</summary>
+	/// <returns>True if this reader supports multiple assets per stream</returns>
+	virtual bool canHaveMultipleAssets();
+
+	/// <summary>Check if this reader supports the particular assetStream.</summary>
+	/// <returns>True if this reader supports the particular assetStream</returns>
+	virtual bool isSupportedFile(Stream& assetStream);
+
+	/// <summary>Check what are the expected file extensions for files supported by this reader.</summary>
+	/// <returns>A vector with the expected file extensions for files supported by this reader</returns>
+	virtual std::vector<std::string> getSupportedFileExtensions();
+private:
+	bool readNextAsset(Model& asset);
+
+	bool _modelsToLoad;
+	bool _loadVertexData;
+	std::vector<cookedModel::MeshBlobs> _meshBlobs;
+};
+}
+}
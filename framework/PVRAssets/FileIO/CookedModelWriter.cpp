@@ -0,0 +1,388 @@
+/*!
+\brief Implementation of methods of the CookedModelWriter class.
+\file PVRAssets/FileIO/CookedModelWriter.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/CookedModelWriter.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+using std::vector;
+namespace pvr {
+namespace assets {
+namespace assetWriters {
+namespace {
+using namespace cookedModel;
+
+inline uint64 alignUp(uint64 value, uint64 alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// Serializes the Tables section.
+struct TableWriter
+{
+	vector<byte> data;
+
+	template<typename T>
+	void write(const T& value)
+	{
+		const byte* bytes = reinterpret_cast<const byte*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+	void writeBytes(const void* bytes, size_t size)
+	{
+		write((uint32)size);
+		data.insert(data.end(), static_cast<const byte*>(bytes), static_cast<const byte*>(bytes) + size);
+	}
+	template<typename T>
+	void writeVector(const vector<T>& values) { writeBytes(values.data(), values.size() * sizeof(T)); }
+	void writeString(const StringHash& string) { writeBytes(string.c_str(), string.str().length()); }
+	void writeFreeValue(const FreeValue& value)
+	{
+		// Only the bytes used by typed values are copied, the rest are zeroed so that the output is deterministic.
+		// Untyped values (strings or raw bytes) do not record their size, so all of their storage is kept. The
+		// storage is read directly: raw() is not updated when a FreeValue is copied into a container.
+		const byte* raw = &value.interpretValueAs<byte>();
+		size_t size = 64;
+		if (value.dataType() != types::GpuDatatypes::none)
+		{
+			size = (std::min)(size, (size_t)types::GpuDatatypes::getCpuPackedSize(value.dataType()));
+		}
+		byte bytes[64] = {};
+		memcpy(bytes, raw, size);
+		write((uint32)value.dataType());
+		write(bytes);
+	}
+};
+
+// Accumulates the Blobs section.
+struct BlobWriter
+{
+	vector<byte> data;
+
+	BlobReference add(const void* blob, size_t size, uint32 stride)
+	{
+		BlobReference reference;
+		reference.offset = alignUp(data.size(), BlobAlignment);
+		reference.size = (uint32)size;
+		reference.stride = stride;
+		data.resize((size_t)reference.offset + size);
+		if (size) { memcpy(data.data() + reference.offset, blob, size); }
+		return reference;
+	}
+};
+
+void writeSemantics(TableWriter& tables, const ContiguousMap<StringHash, FreeValue>& semantics)
+{
+	tables.write((uint32)semantics.size());
+	for (auto it = semantics.begin(); it != semantics.end(); ++it)
+	{
+		tables.writeString(it->first);
+		tables.writeFreeValue(it->second);
+	}
+}
+
+void writeAnimation(TableWriter& tables, const Animation::InternalData& animation)
+{
+	tables.write(animation.flags);
+	tables.write(animation.numberOfFrames);
+	tables.writeVector(animation.positions);
+	tables.writeVector(animation.rotations);
+	tables.writeVector(animation.scales);
+	tables.writeVector(animation.matrices);
+	tables.writeVector(animation.positionIndices);
+	tables.writeVector(animation.rotationIndices);
+	tables.writeVector(animation.scaleIndices);
+	tables.writeVector(animation.matrixIndices);
+}
+
+struct AttributeOrder
+{
+	bool operator()(const Mesh::VertexAttributeData& lhs, const Mesh::VertexAttributeData& rhs) const
+	{
+		return lhs.getDataIndex() != rhs.getDataIndex() ? lhs.getDataIndex() < rhs.getDataIndex() :
+		       lhs.getOffset() < rhs.getOffset();
+	}
+};
+
+// Interleave all vertex data blocks of a mesh into one, keeping each attribute 4-byte aligned. Returns false (and
+// leaves the outputs untouched) if the data blocks do not hold a complete set of vertices.
+bool interleaveVertexData(const Mesh& mesh, vector<Mesh::VertexAttributeData>& inOutAttributes,
+                          vector<byte>& outData, uint32& outStride)
+{
+	const uint32 numVertices = mesh.getNumVertices();
+	std::sort(inOutAttributes.begin(), inOutAttributes.end(), AttributeOrder());
+	vector<uint32> newOffsets(inOutAttributes.size());
+	uint32 stride = 0;
+	for (size_t i = 0; i < inOutAttributes.size(); ++i)
+	{
+		const Mesh::VertexAttributeData& attribute = inOutAttributes[i];
+		const uint32 dataIndex = (uint32)attribute.getDataIndex();
+		const uint32 size = types::dataTypeSize(attribute.getVertexLayout().dataType) * attribute.getN();
+		if (dataIndex >= mesh.getNumDataElements() || attribute.getOffset() + size > mesh.getStride(dataIndex) ||
+		    mesh.getDataSize(dataIndex) < (size_t)mesh.getStride(dataIndex) * numVertices)
+		{
+			return false;
+		}
+		newOffsets[i] = stride;
+		stride = (uint32)alignUp(stride + size, 4);
+	}
+
+	outData.resize((size_t)stride * numVertices);
+	for (size_t i = 0; i < inOutAttributes.size(); ++i)
+	{
+		Mesh::VertexAttributeData& attribute = inOutAttributes[i];
+		const uint32 srcStride = mesh.getStride(attribute.getDataIndex());
+		const uint32 size = types::dataTypeSize(attribute.getVertexLayout().dataType) * attribute.getN();
+		const byte* src = static_cast<const byte*>(mesh.getData(attribute.getDataIndex())) + attribute.getOffset();
+		byte* dst = outData.data() + newOffsets[i];
+		for (uint32 vertex = 0; vertex < numVertices; ++vertex, src += srcStride, dst += stride)
+		{
+			memcpy(dst, src, size);
+		}
+		attribute.setOffset(newOffsets[i]);
+		attribute.setDataIndex(0);
+	}
+	outStride = stride;
+	return true;
+}
+
+void writeMesh(TableWriter& tables, BlobWriter& blobs, const Mesh& mesh, bool interleave)
+{
+	const Mesh::InternalData& data = mesh.getInternalData();
+	const Mesh::MeshInfo& info = data.primitiveData;
+	tables.write(info.numVertices);
+	tables.write(info.numFaces);
+	tables.write(info.numPatchSubdivisions);
+	tables.write(info.numPatches);
+	tables.write(info.numControlPointsPerPatch);
+	tables.write(info.units);
+	tables.write((uint32)info.primitiveType);
+	tables.write((uint8)info.isIndexed);
+	tables.write((uint8)info.isSkinned);
+	tables.write((uint8)info.usesPrimitiveRestart);
+	tables.writeVector(info.stripLengths);
+	tables.write(data.boneCount);
+	tables.write(data.boneBatches.boneBatchStride);
+	tables.writeVector(data.boneBatches.batches);
+	tables.writeVector(data.boneBatches.boneCounts);
+	tables.writeVector(data.boneBatches.offsets);
+	tables.write(data.unpackMatrix);
+	writeSemantics(tables, data.semantics);
+
+	vector<Mesh::VertexAttributeData> attributes;
+	for (auto it = data.vertexAttributes.begin(); it != data.vertexAttributes.end(); ++it)
+	{
+		attributes.push_back(it->value);
+	}
+
+	vector<byte> interleavedData;
+	uint32 interleavedStride = 0;
+	const bool isInterleaved = interleave && mesh.getNumDataElements() > 1 &&
+	                           interleaveVertexData(mesh, attributes, interleavedData, interleavedStride);
+
+	tables.write((uint32)attributes.size());
+	for (size_t i = 0; i < attributes.size(); ++i)
+	{
+		tables.writeString(attributes[i].getSemantic());
+		tables.write((uint32)attributes[i].getVertexLayout().dataType);
+		tables.write((uint8)attributes[i].getN());
+		tables.write((uint16)attributes[i].getOffset());
+		tables.write((uint16)attributes[i].getDataIndex());
+	}
+
+	if (isInterleaved)
+	{
+		tables.write((uint32)1);
+		tables.write(blobs.add(interleavedData.data(), interleavedData.size(), interleavedStride));
+	}
+	else
+	{
+		tables.write(mesh.getNumDataElements());
+		for (uint32 i = 0; i < mesh.getNumDataElements(); ++i)
+		{
+			tables.write(blobs.add(mesh.getData(i), mesh.getDataSize(i), mesh.getStride(i)));
+		}
+	}
+	tables.write((uint32)data.faces.getDataType());
+	tables.write(blobs.add(data.faces.getData(), data.faces.getDataSize(), 0));
+
+	tables.write((uint32)data.levelsOfDetail.size());
+	for (size_t i = 0; i < data.levelsOfDetail.size(); ++i)
+	{
+		const Mesh::LevelOfDetail& levelOfDetail = data.levelsOfDetail[i];
+		tables.write(levelOfDetail.numFaces);
+		tables.write(levelOfDetail.numVertices);
+		tables.write(levelOfDetail.error);
+		tables.write((uint32)levelOfDetail.faces.getDataType());
+		tables.write(blobs.add(levelOfDetail.faces.getData(), levelOfDetail.faces.getDataSize(), 0));
+	}
+}
+
+void writeTables(TableWriter& tables, BlobWriter& blobs, const Model& model, bool interleave)
+{
+	const Model::InternalData& data = model.getInternalData();
+	tables.write(data.clearColor);
+	tables.write(data.ambientColor);
+	tables.write(data.numMeshNodes);
+	tables.write(data.numLightNodes);
+	tables.write(data.numCameraNodes);
+	tables.write(data.numFrames);
+	tables.write(data.currentFrame);
+	tables.write(data.FPS);
+	tables.write(data.units);
+	tables.write(data.flags);
+	tables.writeVector(data.userData);
+	writeSemantics(tables, data.semantics);
+
+	tables.write((uint32)data.textures.size());
+	for (size_t i = 0; i < data.textures.size(); ++i) { tables.writeString(data.textures[i].getName()); }
+
+	tables.write((uint32)data.materials.size());
+	for (size_t i = 0; i < data.materials.size(); ++i)
+	{
+		const Model::Material::InternalData& material = data.materials[i].getInternalData();
+		tables.writeString(material.name);
+		tables.writeString(material.effectFile);
+		tables.writeString(material.effectName);
+		tables.writeVector(material.userData);
+		tables.write((uint32)material.materialSemantics.size());
+		for (auto it = material.materialSemantics.begin(); it != material.materialSemantics.end(); ++it)
+		{
+			tables.writeString(it->first);
+			tables.writeFreeValue(it->second);
+		}
+		tables.write((uint32)material.textureIndexes.size());
+		for (auto it = material.textureIndexes.begin(); it != material.textureIndexes.end(); ++it)
+		{
+			tables.writeString(it->first);
+			tables.write(it->second);
+		}
+	}
+
+	tables.write((uint32)data.cameras.size());
+	for (size_t i = 0; i < data.cameras.size(); ++i)
+	{
+		const Camera::InternalData& camera = data.cameras[i].getInternalData();
+		tables.write(camera.targetNodeIdx);
+		tables.write(camera.farClip);
+		tables.write(camera.nearClip);
+		tables.writeVector(camera.FOVs);
+	}
+
+	tables.write((uint32)data.lights.size());
+	for (size_t i = 0; i < data.lights.size(); ++i)
+	{
+		const Light::InternalData& light = data.lights[i].getInternalData();
+		tables.write(light.spotTargetNodeIdx);
+		tables.write(light.color);
+		tables.write((uint32)light.type);
+		tables.write(light.constantAttenuation);
+		tables.write(light.linearAttenuation);
+		tables.write(light.quadraticAttenuation);
+		tables.write(light.falloffAngle);
+		tables.write(light.falloffExponent);
+	}
+
+	tables.write((uint32)data.nodes.size());
+	for (size_t i = 0; i < data.nodes.size(); ++i)
+	{
+		const Model::Node::InternalData& node = data.nodes[i].getInternalData();
+		tables.writeString(node.name);
+		tables.write(node.objectIndex);
+		tables.write(node.materialIndex);
+		tables.write(node.parentIndex);
+		tables.writeVector(node.userData);
+		writeAnimation(tables, node.animation.getInternalData());
+	}
+
+	tables.write((uint32)data.meshes.size());
+	for (size_t i = 0; i < data.meshes.size(); ++i) { writeMesh(tables, blobs, data.meshes[i], interleave); }
+}
+}
+
+bool CookedModelWriter::addAssetToWrite(const Model& asset)
+{
+	if (_assetsToWrite.size() >= 1)
+	{
+		return false;
+	}
+	_assetsToWrite.push_back(&asset);
+	return true;
+}
+
+bool CookedModelWriter::writeAllAssets()
+{
+	if (_assetsToWrite.empty() || !_assetStream.get()) { return false; }
+
+	TableWriter tables;
+	BlobWriter blobs;
+	writeTables(tables, blobs, *_assetsToWrite[0], _interleaveVertexData);
+
+	FileHeader header;
+	header.magic = Magic;
+	header.version = Version;
+	header.numSections = 2;
+	header.reserved = 0;
+
+	SectionEntry sections[2];
+	sections[0].id = SectionTables;
+	sections[0].reserved = 0;
+	sections[0].offset = alignUp(sizeof(header) + sizeof(sections), BlobAlignment);
+	sections[0].size = tables.data.size();
+	sections[1].id = SectionBlobs;
+	sections[1].reserved = 0;
+	sections[1].offset = alignUp(sections[0].offset + sections[0].size, SectionAlignment);
+	sections[1].size = blobs.data.size();
+
+	// Everything before the Blobs section (header, section table, Tables section and padding) is written at once.
+	vector<byte> head((size_t)sections[1].offset, 0);
+	memcpy(head.data(), &header, sizeof(header));
+	memcpy(head.data() + sizeof(header), sections, sizeof(sections));
+	if (!tables.data.empty()) { memcpy(head.data() + sections[0].offset, tables.data.data(), tables.data.size()); }
+
+	size_t dataWritten = 0;
+	if (!_assetStream->write(1, head.size(), head.data(), dataWritten) || dataWritten != head.size() ||
+	    (!blobs.data.empty() && (!_assetStream->write(1, blobs.data.size(), blobs.data.data(), dataWritten) ||
+	                             dataWritten != blobs.data.size())))
+	{
+		Log(Log.Error, "CookedModelWriter: Failed to write to the stream");
+		return false;
+	}
+	return true;
+}
+
+uint32 CookedModelWriter::assetsAddedSoFar()
+{
+	return (uint32)_assetsToWrite.size();
+}
+
+bool CookedModelWriter::supportsMultipleAssets()
+{
+	return false;
+}
+
+bool CookedModelWriter::canWriteAsset(const Model&)
+{
+	return true;
+}
+
+vector<string> CookedModelWriter::getSupportedFileExtensions()
+{
+	vector<string> extensions;
+	extensions.push_back("pvrcm");
+	return extensions;
+}
+
+string CookedModelWriter::getWriterName()
+{
+	return "PowerVR Cooked Model Writer";
+}
+
+string CookedModelWriter::getWriterVersion()
+{
+	return "1.0.0";
+}
+}
+}
+}
+//!\endcond
@@ -0,0 +1,49 @@
+/*!
+\brief An AssetWriter that writes pvr::assets::Model objects into cooked model files.
+\file PVRAssets/FileIO/CookedModelWriter.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model.h"
+#include "PVRAssets/FileIO/CookedModelDefines.h"
+#include "PVRCore/IO/AssetWriter.h"
+
+namespace pvr {
+namespace assets {
+namespace assetWriters {
+/// <summary>Writes a pvr::assets::Model into a cooked model file (see cookedModel). Cooked models are meant to be
+/// produced offline (for example from POD files) and loaded at runtime with CookedModelReader.</summary>
+class CookedModelWriter : public AssetWriter<Model>
+{
+public:
+	/// <summary>Constructor.</summary>
+	CookedModelWriter() : _interleaveVertexData(true) {}
+
+	/// <summary>Set whether the vertex data of meshes that use more than one data block is interleaved into a single
+	/// data block when written. Interleaving is on by default, so that each mesh can be drawn from one vertex buffer.
+	/// </summary>
+	/// <param name="interleave">True to interleave, false to write the data blocks as they are</param>
+	void setInterleaveVertexData(bool interleave) { _interleaveVertexData = interleave; }
+
+	/// <summary>Add the model to write. Only one model can be written per file.</summary>
+	/// <param name="asset">The model. Must be kept alive until writeAllAssets is called.</param>
+	/// <returns>False if a model was already added, otherwise true.</returns>
+	virtual bool addAssetToWrite(const Model& asset);
+
+	/// <summary>Write the model to the stream.</summary>
+	/// <returns>True on success, false if no model was added or the stream could not be written.</returns>
+	virtual bool writeAllAssets();
+
+	virtual uint32 assetsAddedSoFar();
+	virtual bool supportsMultipleAssets();
+	virtual bool canWriteAsset(const Model& asset);
+	virtual std::vector<string> getSupportedFileExtensions();
+	virtual string getWriterName();
+	virtual string getWriterVersion();
+private:
+	bool _interleaveVertexData;
+};
+}
+}
+}
@@ -0,0 +1,71 @@
+/*!
+\brief Constants and structures describing the layout of effect cache files.
+\file PVRAssets/FileIO/EffectCacheDefines.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/CoreIncludes.h"
+#include "PVRCore/Interfaces/IAssetProvider.h"
+#include "PVRCore/IO/FileStream.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>Contains the definitions of the effect cache file format.</summary>
+/// <remarks>An effect cache file stores an effect::Effect in binary form, so that loading it needs no XML parsing.
+/// The file starts with a FileHeader, followed by one SourceFileEntry (each followed by its path) per file the effect
+/// was created from: the PFX file and its shader files. The cache is only used while the size and hash of each of
+/// these files match. The effect follows. Each name is stored with its StringHash hash, so that names are not hashed
+/// again when loaded. All values are little endian.</remarks>
+namespace effectCache {
+enum
+{
+	Magic = ('P' << 0) | ('V' << 8) | ('R' << 16) | ('X' << 24), //!< Identifies effect cache files
+	Version = 1 //!< The version of the format written by EffectCacheWriter
+};
+
+/// <summary>The header at the start of an effect cache file.</summary>
+struct FileHeader
+{
+	uint32 magic; //!< Must be Magic
+	uint32 version; //!< Must be Version
+	uint32 stringHashCheck; //!< getStringHashCheck() of the writer. The stored hashes are only used if it matches.
+	uint32 numSourceFiles; //!< Number of SourceFileEntry following the header
+};
+
+/// <summary>Describes a file the effect was created from. Followed by the path of the file (pathLength chars, not
+/// null terminated).</summary>
+struct SourceFileEntry
+{
+	uint64 size; //!< Size of the file in bytes
+	uint32 hash; //!< hash32_bytes of the contents of the file
+	uint32 pathLength; //!< Length of the path of the file
+};
+
+/// <summary>Get a value identifying the StringHash hash function, to detect caches written with a different one.
+/// </summary>
+/// <returns>The hash of a fixed string</returns>
+inline uint32 getStringHashCheck()
+{
+	return (uint32)StringHash("PVRAssets effect cache").getHash();
+}
+
+/// <summary>Get the size and hash of the contents of a source file.</summary>
+/// <param name="filename">The file</param>
+/// <param name="assetProvider">Used to open the file. If NULL, the file is opened as a FileStream.</param>
+/// <param name="outEntry">The size and hash of the file are written here</param>
+/// <returns>True on success, false if the file could not be read</returns>
+inline bool hashSourceFile(const std::string& filename, IAssetProvider* assetProvider, SourceFileEntry& outEntry)
+{
+	Stream::ptr_type stream(assetProvider ? assetProvider->getAssetStream(filename, false) :
+	                        Stream::ptr_type(new FileStream(filename, "rb")));
+	std::vector<byte> data;
+	if (!stream.get() || (!stream->isopen() && !stream->open()) || !stream->readIntoBuffer(data)) { return false; }
+	outEntry.size = data.size();
+	outEntry.hash = hash32_bytes(data.data(), data.size());
+	outEntry.pathLength = (uint32)filename.length();
+	return true;
+}
+}
+}
+}
@@ -0,0 +1,436 @@
+/*!
+\brief Implementation of methods of the EffectCacheReader class.
+\file PVRAssets/FileIO/EffectCacheReader.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/EffectCacheReader.h"
+#include "PVRAssets/FileIO/EffectCacheWriter.h"
+#include "PVRAssets/FileIO/PFXParser.h"
+#include "PVRCore/Log.h"
+using std::vector;
+namespace pvr {
+namespace assets {
+namespace {
+using namespace effectCache;
+
+// Deserializes the effect. Every read is bounds checked; after the first failure all reads fail.
+struct DataReader
+{
+	const byte* data;
+	size_t size;
+	size_t position;
+	bool isValid;
+	bool useHashes; // Whether the stored hashes of names were made by the StringHash function of this build
+
+	DataReader(const vector<byte>& bytes) : data(bytes.data()), size(bytes.size()), position(0), isValid(true),
+		useHashes(false) {}
+
+	bool readRaw(void* value, size_t valueSize)
+	{
+		isValid = isValid && size - position >= valueSize;
+		if (isValid && valueSize)
+		{
+			memcpy(value, data + position, valueSize);
+			position += valueSize;
+		}
+		return isValid;
+	}
+	template<typename T>
+	bool read(T& value) { return readRaw(&value, sizeof(T)); }
+	// Read a value stored as uint32 (enumerations) or uint8 (bools) into its actual type.
+	template<typename Stored, typename T>
+	bool readAs(T& value)
+	{
+		Stored stored = 0;
+		if (!read(stored)) { return false; }
+		value = (T)stored;
+		return true;
+	}
+	bool readString(std::string& string)
+	{
+		uint32 length = 0;
+		if (!read(length) || length > size - position) { return isValid = false; }
+		string.assign(reinterpret_cast<const char*>(data + position), length);
+		position += length;
+		return true;
+	}
+	bool readStringHash(StringHash& string)
+	{
+		uint32 length = 0, hash = 0;
+		if (!read(length) || !read(hash) || length > size - position) { return isValid = false; }
+		const std::string value(reinterpret_cast<const char*>(data + position), length);
+		string = useHashes ? StringHash(value, hash) : StringHash(value);
+		position += length;
+		return true;
+	}
+	// Read an element count, rejecting counts that could not possibly fit in the remaining data.
+	bool readCount(uint32& count, size_t minElementSize)
+	{
+		if (!read(count) || count > (size - position) / minElementSize) { return isValid = false; }
+		return true;
+	}
+};
+
+// The shaders of the effect in the order they are stored, by which pipelines reference them.
+struct ShaderTable
+{
+	vector<StringHash> versions;
+	vector<vector<StringHash>/**/> names;
+};
+
+bool readStencilState(DataReader& reader, types::StencilState& stencil)
+{
+	return reader.readAs<uint32>(stencil.opDepthPass) && reader.readAs<uint32>(stencil.opDepthFail) &&
+	       reader.readAs<uint32>(stencil.opStencilFail) && reader.read(stencil.compareMask) &&
+	       reader.read(stencil.writeMask) && reader.read(stencil.reference) && reader.readAs<uint32>(stencil.compareOp);
+}
+
+bool readPipeline(DataReader& reader, effect::Effect& effect, const ShaderTable& shaderTable,
+                  effect::PipelineDefinition& pipeline)
+{
+	uint32 count = 0;
+	if (!reader.readStringHash(pipeline.name) || !reader.readCount(count, 4 + 4)) { return false; }
+	pipeline.shaders.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		uint32 version = 0, index = 0;
+		if (!reader.read(version) || !reader.read(index) || version >= shaderTable.versions.size() ||
+		    index >= shaderTable.names[version].size())
+		{
+			return false;
+		}
+		pipeline.shaders[i] = &effect.versionedShaders.find(shaderTable.versions[version])->second.find(
+		                        shaderTable.names[version][index])->second;
+	}
+	if (!reader.readCount(count, 1 + 1 + 8 + 8 + 4 + 4 + 4)) { return false; }
+	pipeline.uniforms.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::UniformSemantic& uniform = pipeline.uniforms[i];
+		if (!reader.read(uniform.set) || !reader.read(uniform.binding) || !reader.readStringHash(uniform.semantic) ||
+		    !reader.readStringHash(uniform.variableName) || !reader.readAs<uint32>(uniform.dataType) ||
+		    !reader.read(uniform.arrayElements) || !reader.readAs<uint32>(uniform.scope))
+		{
+			return false;
+		}
+	}
+	if (!reader.readCount(count, 8 + 8 + 4 + 1 + 1)) { return false; }
+	pipeline.attributes.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::AttributeSemantic& attribute = pipeline.attributes[i];
+		if (!reader.readStringHash(attribute.semantic) || !reader.readStringHash(attribute.variableName) ||
+		    !reader.readAs<uint32>(attribute.dataType) || !reader.read(attribute.location) ||
+		    !reader.read(attribute.vboBinding))
+		{
+			return false;
+		}
+	}
+	if (!reader.readCount(count, 8 + 1 + 1 + 8 + 4 * 4 + 8)) { return false; }
+	pipeline.textures.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::TextureReference& texture = pipeline.textures[i];
+		if (!reader.readStringHash(texture.textureName) || !reader.read(texture.set) || !reader.read(texture.binding) ||
+		    !reader.readStringHash(texture.variableName) || !reader.readAs<uint32>(texture.samplerFilter) ||
+		    !reader.readAs<uint32>(texture.wrapS) || !reader.readAs<uint32>(texture.wrapT) ||
+		    !reader.readAs<uint32>(texture.wrapR) || !reader.readStringHash(texture.semantic))
+		{
+			return false;
+		}
+	}
+	if (!reader.readCount(count, 1 + 1 + 8 + 8 + 4)) { return false; }
+	pipeline.buffers.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::BufferRef& buffer = pipeline.buffers[i];
+		if (!reader.read(buffer.set) || !reader.read(buffer.binding) || !reader.readStringHash(buffer.semantic) ||
+		    !reader.readStringHash(buffer.bufferName) || !reader.readAs<uint32>(buffer.type))
+		{
+			return false;
+		}
+	}
+	types::BlendingConfig& blending = pipeline.blending;
+	if (!reader.readAs<uint8>(blending.blendEnable) || !reader.readAs<uint32>(blending.srcBlendColor) ||
+	    !reader.readAs<uint32>(blending.destBlendColor) || !reader.readAs<uint32>(blending.srcBlendAlpha) ||
+	    !reader.readAs<uint32>(blending.destBlendAlpha) || !reader.readAs<uint32>(blending.blendOpColor) ||
+	    !reader.readAs<uint32>(blending.blendOpAlpha) || !reader.readAs<uint32>(blending.channelWriteMask))
+	{
+		return false;
+	}
+	if (!reader.readCount(count, 1 + 1 + 1)) { return false; }
+	pipeline.inputAttachments.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::InputAttachmentRef& inputAttachment = pipeline.inputAttachments[i];
+		if (!reader.read(inputAttachment.set) || !reader.read(inputAttachment.binding) ||
+		    !reader.read(inputAttachment.targetIndex))
+		{
+			return false;
+		}
+	}
+	if (!reader.readCount(count, 4 + 4)) { return false; }
+	pipeline.vertexBinding.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (!reader.read(pipeline.vertexBinding[i].index) || !reader.readAs<uint32>(pipeline.vertexBinding[i].stepRate))
+		{
+			return false;
+		}
+	}
+	return reader.readAs<uint8>(pipeline.enableDepthTest) && reader.readAs<uint8>(pipeline.enableDepthWrite) &&
+	       reader.readAs<uint32>(pipeline.depthCmpFunc) && reader.readAs<uint8>(pipeline.enableStencilTest) &&
+	       readStencilState(reader, pipeline.stencilFront) && readStencilState(reader, pipeline.stencilBack) &&
+	       reader.readAs<uint32>(pipeline.windingOrder) && reader.readAs<uint32>(pipeline.cullFace);
+}
+
+bool readPass(DataReader& reader, effect::Pass& pass)
+{
+	uint32 count = 0;
+	if (!reader.readStringHash(pass.name) || !reader.readStringHash(pass.targetDepthStencil) ||
+	    !reader.readCount(count, (effect::Subpass::MaxTargets + effect::Subpass::MaxInputs) * 8 + 1 + 4))
+	{
+		return false;
+	}
+	pass.subpasses.resize(count);
+	for (uint32 i = 0; i < pass.subpasses.size(); ++i)
+	{
+		effect::Subpass& subpass = pass.subpasses[i];
+		for (uint32 j = 0; j < effect::Subpass::MaxTargets; ++j)
+		{
+			if (!reader.readStringHash(subpass.targets[j])) { return false; }
+		}
+		for (uint32 j = 0; j < effect::Subpass::MaxInputs; ++j)
+		{
+			if (!reader.readStringHash(subpass.inputs[j])) { return false; }
+		}
+		if (!reader.readAs<uint8>(subpass.useDepthStencil) || !reader.readCount(count, 8 + 4)) { return false; }
+		subpass.groups.resize(count);
+		for (uint32 j = 0; j < subpass.groups.size(); ++j)
+		{
+			effect::SubpassGroup& group = subpass.groups[j];
+			if (!reader.readStringHash(group.name) || !reader.readCount(count, 8 + 4 + 4)) { return false; }
+			group.pipelines.resize(count);
+			for (uint32 k = 0; k < group.pipelines.size(); ++k)
+			{
+				effect::PipelineReference& pipeline = group.pipelines[k];
+				if (!reader.readStringHash(pipeline.pipelineName) || !reader.readCount(count, 4 + 8)) { return false; }
+				pipeline.conditions.resize(count);
+				for (uint32 l = 0; l < pipeline.conditions.size(); ++l)
+				{
+					if (!reader.readAs<uint32>(pipeline.conditions[l].type) ||
+					    !reader.readStringHash(pipeline.conditions[l].value))
+					{
+						return false;
+					}
+				}
+				if (!reader.readCount(count, 8)) { return false; }
+				pipeline.identifiers.resize(count);
+				for (uint32 l = 0; l < pipeline.identifiers.size(); ++l)
+				{
+					if (!reader.readStringHash(pipeline.identifiers[l])) { return false; }
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool readEffect(DataReader& reader, effect::Effect& effect)
+{
+	uint32 count = 0;
+	if (!reader.readStringHash(effect.name) || !reader.readCount(count, 8 + 4)) { return false; }
+	for (uint32 i = 0; i < count; ++i)
+	{
+		StringHash name;
+		if (!reader.readStringHash(name) || !reader.readString(effect.headerAttributes[name])) { return false; }
+	}
+	if (!reader.readCount(count, 8 + 8 + 4 + 4 + 8 + 4 + 4)) { return false; }
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::TextureDefinition texture;
+		uint64 pixelFormat = 0;
+		if (!reader.readStringHash(texture.name) || !reader.readStringHash(texture.path) || !reader.read(texture.width) ||
+		    !reader.read(texture.height) || !reader.read(pixelFormat) || !reader.readAs<uint32>(texture.fmt.dataType) ||
+		    !reader.readAs<uint32>(texture.fmt.colorSpace))
+		{
+			return false;
+		}
+		texture.fmt.format = PixelFormat(pixelFormat);
+		effect.addTexture(std::move(texture));
+	}
+	if (!reader.readCount(count, 8 + 4 + 1 + 4 + 1 + 4)) { return false; }
+	for (uint32 i = 0; i < count; ++i)
+	{
+		effect::BufferDefinition buffer;
+		uint32 numEntries = 0;
+		if (!reader.readStringHash(buffer.name) || !reader.readAs<uint32>(buffer.allSupportedBindings) ||
+		    !reader.readAs<uint8>(buffer.isDynamic) || !reader.readAs<uint32>(buffer.scope) ||
+		    !reader.readAs<uint8>(buffer.multibuffering) || !reader.readCount(numEntries, 8 + 4 + 4))
+		{
+			return false;
+		}
+		buffer.entries.resize(numEntries);
+		for (uint32 j = 0; j < numEntries; ++j)
+		{
+			if (!reader.readStringHash(buffer.entries[j].semantic) || !reader.readAs<uint32>(buffer.entries[j].dataType) ||
+			    !reader.read(buffer.entries[j].arrayElements))
+			{
+				return false;
+			}
+		}
+		effect.addBuffer(std::move(buffer));
+	}
+	ShaderTable shaderTable;
+	if (!reader.readCount(count, 8 + 4)) { return false; }
+	shaderTable.versions.resize(count);
+	shaderTable.names.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		uint32 numShaders = 0;
+		if (!reader.readStringHash(shaderTable.versions[i]) || !reader.readCount(numShaders, 8 + 4 + 4)) { return false; }
+		pvr::ContiguousMap<StringHash, effect::Shader>& shaders = effect.versionedShaders[shaderTable.versions[i]];
+		shaderTable.names[i].resize(numShaders);
+		for (uint32 j = 0; j < numShaders; ++j)
+		{
+			effect::Shader shader;
+			if (!reader.readStringHash(shader.name) || !reader.readAs<uint32>(shader.type) ||
+			    !reader.readString(shader.source))
+			{
+				return false;
+			}
+			shaderTable.names[i][j] = shader.name;
+			shaders[shader.name] = std::move(shader);
+		}
+	}
+	if (!reader.readCount(count, 8 + 4)) { return false; }
+	for (uint32 i = 0; i < count; ++i)
+	{
+		StringHash version;
+		uint32 numPipelines = 0;
+		if (!reader.readStringHash(version) || !reader.readCount(numPipelines, 8 + 4 * 7)) { return false; }
+		for (uint32 j = 0; j < numPipelines; ++j)
+		{
+			effect::PipelineDefinition pipeline;
+			if (!readPipeline(reader, effect, shaderTable, pipeline)) { return false; }
+			effect.addPipeline(version, std::move(pipeline));
+		}
+	}
+	if (!reader.readCount(count, 8 + 8 + 4)) { return false; }
+	effect.passes.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (!readPass(reader, effect.passes[i])) { return false; }
+	}
+	return true;
+}
+
+bool readFileHeader(Stream& stream, FileHeader& header)
+{
+	size_t dataRead = 0;
+	return stream.read(sizeof(header), 1, &header, dataRead) && dataRead == 1 && header.magic == Magic;
+}
+}
+
+bool EffectCacheReader::readNextAsset(effect::Effect& asset)
+{
+	_effectsToLoad = false;
+	_isOutOfDate = false;
+	asset.clear();
+	const vector<byte> data = _assetStream->readToEnd<byte>();
+	DataReader reader(data);
+	FileHeader header;
+	if (!reader.read(header) || header.magic != Magic || header.version != Version)
+	{
+		Log(Log.Error, "EffectCacheReader: Not an effect cache file, or unsupported version");
+		return false;
+	}
+	reader.useHashes = header.stringHashCheck == getStringHashCheck();
+	for (uint32 i = 0; i < header.numSourceFiles; ++i)
+	{
+		SourceFileEntry stored, current;
+		std::string path;
+		if (!reader.read(stored) || stored.pathLength > reader.size - reader.position)
+		{
+			Log(Log.Error, "EffectCacheReader: Effect cache file is corrupted");
+			return false;
+		}
+		path.assign(reinterpret_cast<const char*>(reader.data + reader.position), stored.pathLength);
+		reader.position += stored.pathLength;
+		if (_validateSourceFiles && (!hashSourceFile(path, _assetProvider, current) || current.size != stored.size ||
+		                             current.hash != stored.hash))
+		{
+			Log(Log.Information, "EffectCacheReader: Source file [%s] changed, the effect cache is out of date",
+			    path.c_str());
+			_isOutOfDate = true;
+			return false;
+		}
+	}
+	if (!readEffect(reader, asset))
+	{
+		Log(Log.Error, "EffectCacheReader: Effect cache file is corrupted");
+		asset.clear();
+		return false;
+	}
+	return true;
+}
+
+bool EffectCacheReader::hasAssetsLeftToLoad()
+{
+	return _effectsToLoad;
+}
+
+bool EffectCacheReader::canHaveMultipleAssets()
+{
+	return false;
+}
+
+bool EffectCacheReader::isSupportedFile(Stream& assetStream)
+{
+	if (!assetStream.isopen() && !assetStream.open()) { return false; }
+	FileHeader header;
+	const bool result = readFileHeader(assetStream, header);
+	assetStream.seek(0, Stream::SeekOriginFromStart);
+	return result;
+}
+
+vector<string> EffectCacheReader::getSupportedFileExtensions()
+{
+	vector<string> extensions;
+	extensions.push_back("pfxcache");
+	return extensions;
+}
+
+bool loadEffect(const std::string& pfxFilename, const std::string& cacheFilename, IAssetProvider* assetProvider,
+                effect::Effect& outEffect)
+{
+	{
+		Stream::ptr_type cacheStream(new FileStream(cacheFilename, "rb"));
+		if (cacheStream->open())
+		{
+			EffectCacheReader cacheReader(cacheStream, assetProvider);
+			if (cacheReader.readAsset(outEffect)) { return true; }
+		}
+	}
+	pfx::PfxParser parser(pfxFilename, assetProvider);
+	if (!parser.readAsset(outEffect)) { return false; }
+
+	assetWriters::EffectCacheWriter cacheWriter;
+	bool result = cacheWriter.addSourceFile(pfxFilename, assetProvider);
+	for (size_t i = 0; result && i < parser.getShaderFiles().size(); ++i)
+	{
+		result = cacheWriter.addSourceFile(parser.getShaderFiles()[i], assetProvider);
+	}
+	if (!result || !cacheWriter.addAssetToWrite(outEffect) ||
+	    !cacheWriter.openAssetStream(Stream::ptr_type(new FileStream(cacheFilename, "wb"))) ||
+	    !cacheWriter.writeAllAssets())
+	{
+		Log(Log.Warning, "loadEffect: Could not write the effect cache [%s]", cacheFilename.c_str());
+	}
+	return true;
+}
+}
+}
+//!\endcond
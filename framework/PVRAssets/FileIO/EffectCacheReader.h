@@ -0,0 +1,83 @@
+/*!
+\brief An AssetReader that reads effect cache files and creates pvr::assets::effect::Effect objects out of them.
+\file PVRAssets/FileIO/EffectCacheReader.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/AssetIncludes.h"
+#include "PVRAssets/Effect_2.h"
+#include "PVRAssets/FileIO/EffectCacheDefines.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>This class creates pvr::assets::effect::Effect objects from effect cache files, as written by
+/// assetWriters::EffectCacheWriter. The whole cache is read at once, and the names of the effect are restored with
+/// their stored hashes, so loading an effect needs no XML parsing and no hashing of names.</summary>
+/// <remarks>Before the effect is read, the size and hash of each source file recorded in the cache (the PFX file and
+/// its shader files) are checked against the files themselves. If any of them changed (or can no longer be read),
+/// reading fails and isOutOfDate() returns true: the effect must then be parsed from its PFX file again, and the
+/// cache rewritten. loadEffect does all of this.</remarks>
+class EffectCacheReader : public AssetReader<effect::Effect>
+{
+public:
+	/// <summary>Construct empty reader.</summary>
+	EffectCacheReader() : _assetProvider(NULL), _effectsToLoad(true), _validateSourceFiles(true), _isOutOfDate(false)
+	{}
+	/// <summary>Construct reader from the specified stream.</summary>
+	/// <param name="assetStream">The effect cache</param>
+	/// <param name="assetProvider">Used to open the source files to validate the cache against. If NULL, they are
+	/// opened as FileStreams.</param>
+	EffectCacheReader(Stream::ptr_type assetStream, IAssetProvider* assetProvider) :
+		AssetReader<effect::Effect>(assetStream), _assetProvider(assetProvider), _effectsToLoad(true),
+		_validateSourceFiles(true), _isOutOfDate(false) { }
+
+	/// <summary>Set whether the source files recorded in the cache are checked before the effect is read. Default
+	/// true. Turn it off only if the cache is known to be up to date, for example when it ships with the application
+	/// instead of the PFX and shader files.</summary>
+	/// <param name="validate">True to check the source files, otherwise false</param>
+	void setValidateSourceFiles(bool validate) { _validateSourceFiles = validate; }
+
+	/// <summary>Check if the last read failed because a source file of the cache changed.</summary>
+	/// <returns>True if the cache is out of date, false if it is up to date or the read failed for another reason
+	/// </returns>
+	bool isOutOfDate() const { return _isOutOfDate; }
+
+	/// <summary>Check if there more assets in the stream.</summary>
+	/// <returns>True if the readAsset() method can be called again to read another asset</returns>
+	bool hasAssetsLeftToLoad();
+
+	/// <summary>Check if this reader supports multiple assets per stream.</summary>
+	/// <returns>True if this reader supports multiple assets per stream</returns>
+	virtual bool canHaveMultipleAssets();
+
+	/// <summary>Check if this reader supports the particular assetStream.</summary>
+	/// <returns>True if this reader supports the particular assetStream</returns>
+	virtual bool isSupportedFile(Stream& assetStream);
+
+	/// <summary>Check what are the expected file extensions for files supported by this reader.</summary>
+	/// <returns>A vector with the expected file extensions for files supported by this reader</returns>
+	virtual std::vector<std::string> getSupportedFileExtensions();
+private:
+	bool readNextAsset(effect::Effect& asset);
+
+	IAssetProvider* _assetProvider;
+	bool _effectsToLoad;
+	bool _validateSourceFiles;
+	bool _isOutOfDate;
+};
+
+/// <summary>Load an effect from its cache file if the cache is up to date, otherwise parse its PFX file with
+/// pfx::PfxParser and write the cache for the next time.</summary>
+/// <param name="pfxFilename">The PFX file of the effect</param>
+/// <param name="cacheFilename">The cache file. It is opened as a FileStream, so it must be in a writable location.
+/// </param>
+/// <param name="assetProvider">Used to open the PFX and shader files. If NULL, they are opened as FileStreams.
+/// </param>
+/// <param name="outEffect">The effect is read into this</param>
+/// <returns>True if the effect was loaded, false if the cache was out of date and the PFX file could not be parsed.
+/// Failing to write the cache is only logged.</returns>
+bool loadEffect(const std::string& pfxFilename, const std::string& cacheFilename, IAssetProvider* assetProvider,
+                effect::Effect& outEffect);
+}
+}
@@ -0,0 +1,357 @@
+/*!
+\brief Implementation of methods of the EffectCacheWriter class.
+\file PVRAssets/FileIO/EffectCacheWriter.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/EffectCacheWriter.h"
+#include "PVRCore/Log.h"
+using std::vector;
+namespace pvr {
+namespace assets {
+namespace assetWriters {
+namespace {
+using namespace effectCache;
+
+// Serializes the effect. Names are written with their hash, other strings (shader sources, header attribute values)
+// without. Enumerations are all written as uint32.
+struct DataWriter
+{
+	vector<byte> data;
+
+	template<typename T>
+	void write(const T& value)
+	{
+		const byte* bytes = reinterpret_cast<const byte*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+	void writeBytes(const void* bytes, size_t size)
+	{
+		data.insert(data.end(), static_cast<const byte*>(bytes), static_cast<const byte*>(bytes) + size);
+	}
+	void writeString(const std::string& string)
+	{
+		write((uint32)string.length());
+		writeBytes(string.data(), string.length());
+	}
+	void writeStringHash(const StringHash& string)
+	{
+		write((uint32)string.length());
+		write((uint32)string.getHash());
+		writeBytes(string.c_str(), string.length());
+	}
+};
+
+void writeStencilState(DataWriter& writer, const types::StencilState& stencil)
+{
+	writer.write((uint32)stencil.opDepthPass);
+	writer.write((uint32)stencil.opDepthFail);
+	writer.write((uint32)stencil.opStencilFail);
+	writer.write(stencil.compareMask);
+	writer.write(stencil.writeMask);
+	writer.write(stencil.reference);
+	writer.write((uint32)stencil.compareOp);
+}
+
+// Find the version and index of a shader in the shaders of the effect, as pipelines reference shaders by pointer.
+bool findShader(const effect::Effect& effect, effect::ShaderReference shader, uint32& outVersion, uint32& outIndex)
+{
+	uint32 version = 0;
+	for (auto it = effect.versionedShaders.begin(); it != effect.versionedShaders.end(); ++it, ++version)
+	{
+		uint32 index = 0;
+		for (auto shaderIt = it->second.begin(); shaderIt != it->second.end(); ++shaderIt, ++index)
+		{
+			if (&shaderIt->second == shader)
+			{
+				outVersion = version;
+				outIndex = index;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool writePipeline(DataWriter& writer, const effect::Effect& effect, const effect::PipelineDefinition& pipeline)
+{
+	writer.writeStringHash(pipeline.name);
+	writer.write((uint32)pipeline.shaders.size());
+	for (size_t i = 0; i < pipeline.shaders.size(); ++i)
+	{
+		uint32 version = 0, index = 0;
+		if (!findShader(effect, pipeline.shaders[i], version, index))
+		{
+			Log(Log.Error, "EffectCacheWriter: Pipeline [%s] references a shader that is not part of the effect",
+			    pipeline.name.c_str());
+			return false;
+		}
+		writer.write(version);
+		writer.write(index);
+	}
+	writer.write((uint32)pipeline.uniforms.size());
+	for (size_t i = 0; i < pipeline.uniforms.size(); ++i)
+	{
+		const effect::UniformSemantic& uniform = pipeline.uniforms[i];
+		writer.write(uniform.set);
+		writer.write(uniform.binding);
+		writer.writeStringHash(uniform.semantic);
+		writer.writeStringHash(uniform.variableName);
+		writer.write((uint32)uniform.dataType);
+		writer.write(uniform.arrayElements);
+		writer.write((uint32)uniform.scope);
+	}
+	writer.write((uint32)pipeline.attributes.size());
+	for (size_t i = 0; i < pipeline.attributes.size(); ++i)
+	{
+		const effect::AttributeSemantic& attribute = pipeline.attributes[i];
+		writer.writeStringHash(attribute.semantic);
+		writer.writeStringHash(attribute.variableName);
+		writer.write((uint32)attribute.dataType);
+		writer.write(attribute.location);
+		writer.write(attribute.vboBinding);
+	}
+	writer.write((uint32)pipeline.textures.size());
+	for (size_t i = 0; i < pipeline.textures.size(); ++i)
+	{
+		const effect::TextureReference& texture = pipeline.textures[i];
+		writer.writeStringHash(texture.textureName);
+		writer.write(texture.set);
+		writer.write(texture.binding);
+		writer.writeStringHash(texture.variableName);
+		writer.write((uint32)texture.samplerFilter);
+		writer.write((uint32)texture.wrapS);
+		writer.write((uint32)texture.wrapT);
+		writer.write((uint32)texture.wrapR);
+		writer.writeStringHash(texture.semantic);
+	}
+	writer.write((uint32)pipeline.buffers.size());
+	for (size_t i = 0; i < pipeline.buffers.size(); ++i)
+	{
+		const effect::BufferRef& buffer = pipeline.buffers[i];
+		writer.write(buffer.set);
+		writer.write(buffer.binding);
+		writer.writeStringHash(buffer.semantic);
+		writer.writeStringHash(buffer.bufferName);
+		writer.write((uint32)buffer.type);
+	}
+	const types::BlendingConfig& blending = pipeline.blending;
+	writer.write((uint8)blending.blendEnable);
+	writer.write((uint32)blending.srcBlendColor);
+	writer.write((uint32)blending.destBlendColor);
+	writer.write((uint32)blending.srcBlendAlpha);
+	writer.write((uint32)blending.destBlendAlpha);
+	writer.write((uint32)blending.blendOpColor);
+	writer.write((uint32)blending.blendOpAlpha);
+	writer.write((uint32)blending.channelWriteMask);
+	writer.write((uint32)pipeline.inputAttachments.size());
+	for (size_t i = 0; i < pipeline.inputAttachments.size(); ++i)
+	{
+		writer.write(pipeline.inputAttachments[i].set);
+		writer.write(pipeline.inputAttachments[i].binding);
+		writer.write(pipeline.inputAttachments[i].targetIndex);
+	}
+	writer.write((uint32)pipeline.vertexBinding.size());
+	for (size_t i = 0; i < pipeline.vertexBinding.size(); ++i)
+	{
+		writer.write(pipeline.vertexBinding[i].index);
+		writer.write((uint32)pipeline.vertexBinding[i].stepRate);
+	}
+	writer.write((uint8)pipeline.enableDepthTest);
+	writer.write((uint8)pipeline.enableDepthWrite);
+	writer.write((uint32)pipeline.depthCmpFunc);
+	writer.write((uint8)pipeline.enableStencilTest);
+	writeStencilState(writer, pipeline.stencilFront);
+	writeStencilState(writer, pipeline.stencilBack);
+	writer.write((uint32)pipeline.windingOrder);
+	writer.write((uint32)pipeline.cullFace);
+	return true;
+}
+
+void writePass(DataWriter& writer, const effect::Pass& pass)
+{
+	writer.writeStringHash(pass.name);
+	writer.writeStringHash(pass.targetDepthStencil);
+	writer.write((uint32)pass.subpasses.size());
+	for (size_t i = 0; i < pass.subpasses.size(); ++i)
+	{
+		const effect::Subpass& subpass = pass.subpasses[i];
+		for (uint32 j = 0; j < effect::Subpass::MaxTargets; ++j) { writer.writeStringHash(subpass.targets[j]); }
+		for (uint32 j = 0; j < effect::Subpass::MaxInputs; ++j) { writer.writeStringHash(subpass.inputs[j]); }
+		writer.write((uint8)subpass.useDepthStencil);
+		writer.write((uint32)subpass.groups.size());
+		for (size_t j = 0; j < subpass.groups.size(); ++j)
+		{
+			const effect::SubpassGroup& group = subpass.groups[j];
+			writer.writeStringHash(group.name);
+			writer.write(group.pipelines.size());
+			for (uint32 k = 0; k < group.pipelines.size(); ++k)
+			{
+				const effect::PipelineReference& pipeline = group.pipelines[k];
+				writer.writeStringHash(pipeline.pipelineName);
+				writer.write(pipeline.conditions.size());
+				for (uint32 l = 0; l < pipeline.conditions.size(); ++l)
+				{
+					writer.write((uint32)pipeline.conditions[l].type);
+					writer.writeStringHash(pipeline.conditions[l].value);
+				}
+				writer.write(pipeline.identifiers.size());
+				for (uint32 l = 0; l < pipeline.identifiers.size(); ++l) { writer.writeStringHash(pipeline.identifiers[l]); }
+			}
+		}
+	}
+}
+
+bool writeEffect(DataWriter& writer, const effect::Effect& effect)
+{
+	writer.writeStringHash(effect.name);
+	writer.write((uint32)effect.headerAttributes.size());
+	for (auto it = effect.headerAttributes.begin(); it != effect.headerAttributes.end(); ++it)
+	{
+		writer.writeStringHash(it->first);
+		writer.writeString(it->second);
+	}
+	writer.write((uint32)effect.textures.size());
+	for (auto it = effect.textures.begin(); it != effect.textures.end(); ++it)
+	{
+		const effect::TextureDefinition& texture = it->second;
+		writer.writeStringHash(texture.name);
+		writer.writeStringHash(texture.path);
+		writer.write(texture.width);
+		writer.write(texture.height);
+		writer.write(texture.fmt.format.getPixelTypeId());
+		writer.write((uint32)texture.fmt.dataType);
+		writer.write((uint32)texture.fmt.colorSpace);
+	}
+	writer.write((uint32)effect.buffers.size());
+	for (auto it = effect.buffers.begin(); it != effect.buffers.end(); ++it)
+	{
+		const effect::BufferDefinition& buffer = it->second;
+		writer.writeStringHash(buffer.name);
+		writer.write((uint32)buffer.allSupportedBindings);
+		writer.write((uint8)buffer.isDynamic);
+		writer.write((uint32)buffer.scope);
+		writer.write((uint8)buffer.multibuffering);
+		writer.write((uint32)buffer.entries.size());
+		for (size_t i = 0; i < buffer.entries.size(); ++i)
+		{
+			writer.writeStringHash(buffer.entries[i].semantic);
+			writer.write((uint32)buffer.entries[i].dataType);
+			writer.write(buffer.entries[i].arrayElements);
+		}
+	}
+	writer.write((uint32)effect.versionedShaders.size());
+	for (auto it = effect.versionedShaders.begin(); it != effect.versionedShaders.end(); ++it)
+	{
+		writer.writeStringHash(it->first);
+		writer.write((uint32)it->second.size());
+		for (auto shader = it->second.begin(); shader != it->second.end(); ++shader)
+		{
+			writer.writeStringHash(shader->second.name);
+			writer.write((uint32)shader->second.type);
+			writer.writeString(shader->second.source);
+		}
+	}
+	writer.write((uint32)effect.versionedPipelines.size());
+	for (auto it = effect.versionedPipelines.begin(); it != effect.versionedPipelines.end(); ++it)
+	{
+		writer.writeStringHash(it->first);
+		writer.write((uint32)it->second.size());
+		for (auto pipeline = it->second.begin(); pipeline != it->second.end(); ++pipeline)
+		{
+			if (!writePipeline(writer, effect, pipeline->second)) { return false; }
+		}
+	}
+	writer.write((uint32)effect.passes.size());
+	for (size_t i = 0; i < effect.passes.size(); ++i) { writePass(writer, effect.passes[i]); }
+	return true;
+}
+}
+
+bool EffectCacheWriter::addSourceFile(const std::string& filename, IAssetProvider* assetProvider)
+{
+	SourceFile sourceFile;
+	if (!hashSourceFile(filename, assetProvider, sourceFile.entry))
+	{
+		Log(Log.Error, "EffectCacheWriter: Could not read source file [%s]", filename.c_str());
+		return false;
+	}
+	sourceFile.path = filename;
+	_sourceFiles.push_back(sourceFile);
+	return true;
+}
+
+bool EffectCacheWriter::addAssetToWrite(const effect::Effect& asset)
+{
+	if (_assetsToWrite.size() >= 1)
+	{
+		return false;
+	}
+	_assetsToWrite.push_back(&asset);
+	return true;
+}
+
+bool EffectCacheWriter::writeAllAssets()
+{
+	if (_assetsToWrite.empty() || !_assetStream.get()) { return false; }
+
+	DataWriter writer;
+	FileHeader header;
+	header.magic = Magic;
+	header.version = Version;
+	header.stringHashCheck = getStringHashCheck();
+	header.numSourceFiles = (uint32)_sourceFiles.size();
+	writer.write(header);
+	for (size_t i = 0; i < _sourceFiles.size(); ++i)
+	{
+		writer.write(_sourceFiles[i].entry);
+		writer.writeBytes(_sourceFiles[i].path.data(), _sourceFiles[i].path.length());
+	}
+	if (!writeEffect(writer, *_assetsToWrite[0])) { return false; }
+
+	size_t dataWritten = 0;
+	if (!_assetStream->write(1, writer.data.size(), writer.data.data(), dataWritten) ||
+	    dataWritten != writer.data.size())
+	{
+		Log(Log.Error, "EffectCacheWriter: Failed to write to the stream");
+		return false;
+	}
+	return true;
+}
+
+uint32 EffectCacheWriter::assetsAddedSoFar()
+{
+	return (uint32)_assetsToWrite.size();
+}
+
+bool EffectCacheWriter::supportsMultipleAssets()
+{
+	return false;
+}
+
+bool EffectCacheWriter::canWriteAsset(const effect::Effect&)
+{
+	return true;
+}
+
+vector<string> EffectCacheWriter::getSupportedFileExtensions()
+{
+	vector<string> extensions;
+	extensions.push_back("pfxcache");
+	return extensions;
+}
+
+string EffectCacheWriter::getWriterName()
+{
+	return "PowerVR Effect Cache Writer";
+}
+
+string EffectCacheWriter::getWriterVersion()
+{
+	return "1.0.0";
+}
+}
+}
+}
+//!\endcond
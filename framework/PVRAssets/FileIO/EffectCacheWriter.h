@@ -0,0 +1,54 @@
+/*!
+\brief An AssetWriter that writes pvr::assets::effect::Effect objects into effect cache files.
+\file PVRAssets/FileIO/EffectCacheWriter.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Effect_2.h"
+#include "PVRAssets/FileIO/EffectCacheDefines.h"
+#include "PVRCore/IO/AssetWriter.h"
+
+namespace pvr {
+namespace assets {
+namespace assetWriters {
+/// <summary>Writes a pvr::assets::effect::Effect into an effect cache file (see effectCache), to be loaded with
+/// EffectCacheReader instead of parsing its PFX file again. Add the files the effect was created from with
+/// addSourceFile, so that the cache is rejected once any of them changes.</summary>
+class EffectCacheWriter : public AssetWriter<effect::Effect>
+{
+public:
+	/// <summary>Record a file the effect was created from (the PFX file, or one of the shader files listed by
+	/// PfxParser::getShaderFiles). Its size and hash are calculated now and stored in the cache.</summary>
+	/// <param name="filename">The file, as it will be opened when the cache is read</param>
+	/// <param name="assetProvider">Used to open the file. If NULL, the file is opened as a FileStream.</param>
+	/// <returns>False if the file could not be read, otherwise true.</returns>
+	bool addSourceFile(const std::string& filename, IAssetProvider* assetProvider);
+
+	/// <summary>Add the effect to write. Only one effect can be written per file.</summary>
+	/// <param name="asset">The effect. Must be kept alive until writeAllAssets is called.</param>
+	/// <returns>False if an effect was already added, otherwise true.</returns>
+	virtual bool addAssetToWrite(const effect::Effect& asset);
+
+	/// <summary>Write the effect and its source files to the stream.</summary>
+	/// <returns>True on success, false if no effect was added, a pipeline of the effect references a shader that is
+	/// not in the effect, or the stream could not be written.</returns>
+	virtual bool writeAllAssets();
+
+	virtual uint32 assetsAddedSoFar();
+	virtual bool supportsMultipleAssets();
+	virtual bool canWriteAsset(const effect::Effect& asset);
+	virtual std::vector<string> getSupportedFileExtensions();
+	virtual string getWriterName();
+	virtual string getWriterVersion();
+private:
+	struct SourceFile
+	{
+		effectCache::SourceFileEntry entry;
+		std::string path;
+	};
+	std::vector<SourceFile> _sourceFiles;
+};
+}
+}
+}
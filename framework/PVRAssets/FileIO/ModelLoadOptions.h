@@ -0,0 +1,66 @@
+/*!
+\brief Options used by the model readers to load only the parts of a model that an application uses.
+\file PVRAssets/FileIO/ModelLoadOptions.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/AssetIncludes.h"
+#include <algorithm>
+
+namespace pvr {
+namespace assets {
+/// <summary>Controls which parts of a model a model reader loads. The default options load the whole model.
+/// </summary>
+struct ModelLoadOptions
+{
+	/// <summary>How meshes made of triangle strips are converted while they are loaded.</summary>
+	enum StripConversion
+	{
+		KeepStrips, //!< Strips are kept as they are. Each strip needs its own draw call.
+		ConvertStripsToTriangleList, //!< Strips become an indexed triangle list (utils::convertStripsToTriangleList)
+		                             //!< ordered for the vertex cache (utils::optimizeVertexCache)
+		JoinStripsWithPrimitiveRestart //!< Strips are joined with primitive restart indices (Vulkan or OpenGL ES 3.0)
+		                               //!< (utils::joinStripsWithPrimitiveRestart). Meshes with several bone
+		                               //!< batches are converted as with ConvertStripsToTriangleList instead.
+	};
+
+	/// <summary>If false, the animation of each node is reduced to its first frame (its static transformation) and the
+	/// model has no frames. Default true.</summary>
+	bool loadAnimation;
+	/// <summary>If false, the cameras and their nodes are removed, unless other nodes are attached to them. Default
+	/// true.</summary>
+	bool loadCameras;
+	/// <summary>If false, the lights and their nodes are removed, unless other nodes are attached to them. Default
+	/// true.</summary>
+	bool loadLights;
+	/// <summary>If true, the vertex data blocks of the meshes are not read with the model, but the first time they
+	/// are accessed (see Mesh::loadDeferredData). The file is opened again with deferredDataSource. Default false.
+	/// </summary>
+	bool deferVertexData;
+	/// <summary>The vertex attributes with these semantics (for example "UV1" or "TANGENT") are not loaded.
+	/// </summary>
+	std::vector<StringHash> skippedVertexSemantics;
+	/// <summary>How meshes made of triangle strips are converted, so that each is drawn with a single indexed draw
+	/// call. Meshes that cannot be converted keep their strips. Default KeepStrips.</summary>
+	StripConversion stripConversion;
+	/// <summary>Opens the file the model is read from, to read deferred vertex data. If empty, files read from a
+	/// FileStream are opened again by file name, and the vertex data of models read from other streams is not
+	/// deferred.</summary>
+	std::function<Stream::ptr_type()> deferredDataSource;
+
+	/// <summary>Constructor. Loads the whole model.</summary>
+	ModelLoadOptions() : loadAnimation(true), loadCameras(true), loadLights(true), deferVertexData(false),
+		stripConversion(KeepStrips) {}
+
+	/// <summary>Check if the vertex attribute with a semantic is skipped.</summary>
+	/// <param name="semantic">The semantic of the attribute</param>
+	/// <returns>True if the attribute must not be loaded</returns>
+	bool isVertexSemanticSkipped(const StringHash& semantic) const
+	{
+		return std::find(skippedVertexSemantics.begin(), skippedVertexSemantics.end(), semantic) !=
+		       skippedVertexSemantics.end();
+	}
+};
+}
+}
@@ -11,6 +11,7 @@
 #include "PVRCore/IO/BufferStream.h"
 #include "PVRCore/Texture.h"
 #include <set>
+#include <algorithm>
 
 namespace pvr {
 namespace assets {
@@ -452,7 +453,8 @@ bool addFileCodeSourceToVector(std::vector<char>& shaderSource, const char* file
 
 void addShaderCodeToVectors(const StringHash& /*name*/, types::ShaderType shaderType,
                             std::map<StringHash, std::pair<types::ShaderType, std::vector<char>/**/>/**/>& versionedShaders,
-                            const pugi::xml_node& node, const StringHash& apiVersion, bool isFile,  bool addToAll, IAssetProvider* assetProvider)
+                            const pugi::xml_node& node, const StringHash& apiVersion, bool isFile,  bool addToAll, IAssetProvider* assetProvider,
+                            std::vector<std::string>& shaderFiles)
 {
 	//The next two lines will select either running the for-loop just once for the value matching versionedShaders,
 	//or for all values in versionedShaders (i.e. was "apiVersion" nothing?)
@@ -470,6 +472,10 @@ void addShaderCodeToVectors(const StringHash& /*name*/, types::ShaderType shader
 		{
 			//Append the data to the "main" node's vector
 			addFileCodeSourceToVector(rawData_vector, node.attribute("path").value(), assetProvider);
+			if (std::find(shaderFiles.begin(), shaderFiles.end(), node.attribute("path").value()) == shaderFiles.end())
+			{
+				shaderFiles.push_back(node.attribute("path").value());
+			}
 		}
 		else
 		{
@@ -497,7 +503,8 @@ void addShaderCodeToVectors(const StringHash& /*name*/, types::ShaderType shader
 	}
 }
 
-void addShaders(effect::Effect& theEffect, pugi::xml_named_node_iterator begin, pugi::xml_named_node_iterator end, IAssetProvider* assetProvider)
+void addShaders(effect::Effect& theEffect, pugi::xml_named_node_iterator begin, pugi::xml_named_node_iterator end, IAssetProvider* assetProvider,
+                std::vector<std::string>& shaderFiles)
 {
 	//For each shader element, we will create one per version...
 	for (auto shader = begin; shader != end; ++shader)
@@ -559,7 +566,8 @@ void addShaders(effect::Effect& theEffect, pugi::xml_named_node_iterator begin,
 				  apiVersionAttr ? StringHash(apiVersionAttr.value()) : StringHash(),
 				  isFile,
 				  apiVersionAttr.empty(),
-				  assetProvider);
+				  assetProvider,
+				  shaderFiles);
 			}
 			else
 			{
@@ -1163,6 +1171,7 @@ PfxParser::PfxParser(Stream::ptr_type pfxStream, IAssetProvider* assetProvider)
 bool PfxParser::readNextAsset(effect::Effect& asset)
 {
 	asset.clear();
+	_shaderFiles.clear();
 	std::vector<char> v = _assetStream->readToEnd<char>();
 
 	pugi::xml_document doc;
@@ -1194,7 +1203,7 @@ bool PfxParser::readNextAsset(effect::Effect& asset)
 	addVersions(asset, root); //Pre-process a list of all different version flavors.
 	addTextures(asset, textures.begin(), textures.end());
 	addBuffers(asset, buffers.begin(), buffers.end());
-	addShaders(asset, shaders.begin(), shaders.end(), assetProvider);
+	addShaders(asset, shaders.begin(), shaders.end(), assetProvider, _shaderFiles);
 	addPipelines(asset, pipelines.begin(), pipelines.end());
 	addEffects(asset, effects.begin(), effects.end());
 	return true;
@@ -55,8 +55,14 @@ public:
 		static std::vector<string> extensions({ "pfx", "pfx3" });
 		return extensions;
 	}
+
+	/// <summary>Get the shader files (the path of each &lt;file&gt; element of a &lt;shader&gt;) read by the last
+	/// readAsset, for example to validate a cache of the effect (see EffectCacheWriter::addSourceFile).</summary>
+	/// <returns>The paths of the shader files, each listed once</returns>
+	const std::vector<std::string>& getShaderFiles() const { return _shaderFiles; }
 private:
 	IAssetProvider* assetProvider;
+	std::vector<std::string> _shaderFiles;
 };
 
 }
@@ -11,11 +11,16 @@
 #include "PVRCore/Log.h"
 //#include "PVRAssets/assets::Model.h"
 #include "PVRAssets/Helper.h"
+#include "PVRAssets/MeshOptimizer.h"
 //#include "PVRAssets/assets::Model/Light.h"
 //#include "PVRAssets/assets::Model/assets::Mesh.h"
 #include "PVRCore/Stream.h"
+#include "PVRCore/IO/BufferStream.h"
+#include "PVRCore/IO/FileStream.h"
 #include <cstdio>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 using std::vector;
 
 namespace { // LOCAL FUNCTIONS
@@ -173,6 +178,128 @@ bool readTag(Stream& stream, uint32& identifier, uint32& dataLength)
 	return true;
 }
 
+// Skip the rest of a block whose start tag has just been read.
+bool skipBlock(Stream& stream, uint32 blockIdentifier)
+{
+	uint32 identifier, dataLength;
+	while (readTag(stream, identifier, dataLength))
+	{
+		if (identifier == (blockIdentifier | pod::c_endTagMask)) { return true; }
+		if (!stream.seek(dataLength, Stream::SeekOriginFromCurrent)) { return false; }
+	}
+	return false;
+}
+
+// The load options, and where the stream being read is in the POD file.
+struct ReadContext
+{
+	const ModelLoadOptions* options;
+	std::function<Stream::ptr_type()> deferredDataSource; // Empty if vertex data cannot be deferred
+	size_t streamOffset; // The offset in the file of the start of the stream
+};
+
+// Record the vertex data block that starts at the current position of the stream, to be read on first use, and
+// skip it.
+bool deferVertexData(Stream& stream, assets::Mesh& mesh, uint32 dataLength, uint32 stride, const ReadContext& context,
+                     int32& outDataIndex)
+{
+	assets::Mesh::DeferredDataBlock block;
+	block.offset = context.streamOffset + stream.getPosition();
+	block.size = dataLength;
+	if (!stream.seek(dataLength, Stream::SeekOriginFromCurrent)) { return false; }
+	outDataIndex = mesh.addData(NULL, 0, stride);
+	block.dataIndex = (uint32)outDataIndex;
+	assets::Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	meshInternalData.deferredDataBlocks.push_back(block);
+	meshInternalData.deferredDataSource = context.deferredDataSource;
+	return true;
+}
+
+// Keep the first frame of one component of an animation. Indices are offsets into the values.
+void keepFirstFrame(std::vector<float32>& values, std::vector<uint32>& indices, uint32 frameSize)
+{
+	const size_t first = indices.empty() ? 0 : indices[0];
+	if (values.size() >= first + frameSize)
+	{
+		values.erase(values.begin() + first + frameSize, values.end());
+		values.erase(values.begin(), values.begin() + first);
+	}
+	indices.clear();
+}
+
+void removeAnimation(Animation::InternalData& animation)
+{
+	keepFirstFrame(animation.positions, animation.positionIndices, 3);
+	keepFirstFrame(animation.rotations, animation.rotationIndices, 4);
+	keepFirstFrame(animation.scales, animation.scaleIndices, 7);
+	keepFirstFrame(animation.matrices, animation.matrixIndices, 16);
+	animation.flags = 0;
+	animation.numberOfFrames = (std::min)(animation.numberOfFrames, 1u);
+}
+
+// Remove a range of light or camera nodes, unless other nodes are attached to them. Returns false if they are kept.
+bool removeNodes(assets::Model::InternalData& modelInternalData, uint32 firstNode, uint32 numNodes)
+{
+	vector<assets::Model::Node>& nodes = modelInternalData.nodes;
+	const int32 first = (int32)firstNode, last = (int32)(firstNode + numNodes);
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		const int32 parent = nodes[i].getParentID();
+		if (((int32)i < first || (int32)i >= last) && parent >= first && parent < last) { return false; }
+	}
+	struct Remap
+	{
+		int32 first, last;
+		int32 operator()(int32 index) const
+		{
+			return index < first ? index : index >= last ? index - (last - first) : -1;
+		}
+	} remap = { first, last };
+	nodes.erase(nodes.begin() + first, nodes.begin() + last);
+	for (size_t i = 0; i < nodes.size(); ++i) { nodes[i].setParentID(remap(nodes[i].getParentID())); }
+	for (size_t i = 0; i < modelInternalData.cameras.size(); ++i)
+	{
+		Camera& camera = modelInternalData.cameras[i];
+		camera.setTargetNodeIndex(remap(camera.getTargetNodeIndex()));
+	}
+	for (size_t i = 0; i < modelInternalData.lights.size(); ++i)
+	{
+		Light::InternalData& light = modelInternalData.lights[i].getInternalData();
+		light.spotTargetNodeIdx = remap(light.spotTargetNodeIdx);
+	}
+	return true;
+}
+
+// Remove the cameras and lights that the load options exclude. Nodes are laid out meshes, then lights, then cameras.
+void removeCamerasAndLights(assets::Model& model, const ModelLoadOptions& options)
+{
+	assets::Model::InternalData& modelInternalData = model.getInternalData();
+	const uint32 numLights = (uint32)modelInternalData.lights.size();
+	const uint32 numCameras = (uint32)modelInternalData.cameras.size();
+	if (!options.loadCameras && numCameras)
+	{
+		if (removeNodes(modelInternalData, modelInternalData.numMeshNodes + numLights, numCameras))
+		{
+			modelInternalData.cameras.clear();
+		}
+		else
+		{
+			Log(Log.Information, "PODReader: Keeping the cameras of the model because other nodes are attached to them");
+		}
+	}
+	if (!options.loadLights && numLights)
+	{
+		if (removeNodes(modelInternalData, modelInternalData.numMeshNodes, numLights))
+		{
+			modelInternalData.lights.clear();
+		}
+		else
+		{
+			Log(Log.Information, "PODReader: Keeping the lights of the model because other nodes are attached to them");
+		}
+	}
+}
+
 
 bool readVertexIndexData(Stream& stream, assets::Mesh& mesh)
 {
@@ -236,9 +363,11 @@ bool readVertexIndexData(Stream& stream, assets::Mesh& mesh)
 	return result;
 }
 
-bool readVertexData(Stream& stream, assets::Mesh& mesh, const char8* const semanticName, uint32 blockIdentifier, int32 dataIndex, bool& existed)
+bool readVertexData(Stream& stream, assets::Mesh& mesh, const char8* const semanticName, uint32 blockIdentifier, int32 dataIndex, bool& existed,
+                    const ReadContext& context)
 {
 	existed = false;
+	if (context.options->isVertexSemanticSkipped(semanticName)) { return skipBlock(stream, blockIdentifier); }
 	uint32 identifier, dataLength, numComponents(0), stride(0), offset(0);
 	DataType type(DataType::None);
 	while (readTag(stream, identifier, dataLength))
@@ -273,7 +402,11 @@ bool readVertexData(Stream& stream, assets::Mesh& mesh, const char8* const seman
 			if (!read4Bytes(stream, stride)) { return false; }
 			break;
 		case pod::e_blockData:
-			if (dataIndex == -1)   // This POD file isn't using interleaved data so this data block must be valid vertex data
+			if (dataIndex == -1 && context.options->deferVertexData && context.deferredDataSource)
+			{
+				if (!deferVertexData(stream, mesh, dataLength, stride, context, dataIndex)) { return false; }
+			}
+			else if (dataIndex == -1)   // This POD file isn't using interleaved data so this data block must be valid vertex data
 			{
 				std::vector<byte> data;
 				switch (dataTypeSize(type))
@@ -611,7 +744,7 @@ bool readLightBlock(Stream& stream, Light& light)
 	return result;
 }
 
-bool readNodeBlock(Stream& stream, assets::Model::Node& node)
+bool readNodeBlock(Stream& stream, assets::Model::Node& node, const ReadContext& context)
 {
 	bool result;
 	uint32 identifier, dataLength;
@@ -672,6 +805,8 @@ bool readNodeBlock(Stream& stream, assets::Model::Node& node)
 				}
 				animInternData.numberOfFrames = (std::max)(animInternData.numberOfFrames, (uint32)animInternData.matrices.size());
 			}
+			if (!context.options->loadAnimation) { removeAnimation(animInternData); }
+			nodeInternData.animation.buildKeyIndex();
 			return true;
 		}
 		case pod::e_nodeIndex | pod::c_startTagMask:
@@ -809,7 +944,7 @@ static void fixInterleavedEndiannessUsingVertexData(StridedBuffer& interleaved,
 
 static void fixInterleavedEndianness(assets::Mesh::InternalData& data, int32 interleavedDataIndex)
 {
-	if (interleavedDataIndex == -1 || utils::isLittleEndian())
+	if (interleavedDataIndex == -1 || pvr::utils::isLittleEndian())
 	{
 		return;
 	}
@@ -825,7 +960,30 @@ static void fixInterleavedEndianness(assets::Mesh::InternalData& data, int32 int
 	}
 }
 
-bool readMeshBlock(Stream& stream, assets::Mesh& mesh)
+// Apply the strip conversion of the load options. A mesh that cannot be converted keeps its strips, as it can still
+// be drawn.
+void convertStrips(assets::Mesh& mesh, ModelLoadOptions::StripConversion stripConversion)
+{
+	if (mesh.getPrimitiveType() != PrimitiveTopology::TriangleStrip) { return; }
+	switch (stripConversion)
+	{
+	case ModelLoadOptions::ConvertStripsToTriangleList:
+		if (assets::utils::convertStripsToTriangleList(mesh)) { assets::utils::optimizeVertexCache(mesh); }
+		break;
+	case ModelLoadOptions::JoinStripsWithPrimitiveRestart:
+		// A single restart strip cannot be split between bone batches, so those meshes become triangle lists.
+		if (mesh.getInternalData().boneBatches.getCount() > 1)
+		{
+			if (assets::utils::convertStripsToTriangleList(mesh)) { assets::utils::optimizeVertexCache(mesh); }
+		}
+		else { assets::utils::joinStripsWithPrimitiveRestart(mesh); }
+		break;
+	default:
+		break;
+	}
+}
+
+bool readMeshBlock(Stream& stream, assets::Mesh& mesh, const ReadContext& context)
 {
 	bool result;
 	bool exists = false;
@@ -853,6 +1011,7 @@ bool readMeshBlock(Stream& stream, assets::Mesh& mesh)
 			//  return false;
 			//}
 			fixInterleavedEndianness(meshInternalData, interleavedDataIndex);
+			convertStrips(mesh, context.options->stripConversion);
 			return true;
 		}
 		case pod::e_meshNumVertices | pod::c_startTagMask:
@@ -879,6 +1038,11 @@ bool readMeshBlock(Stream& stream, assets::Mesh& mesh)
 		}
 		case pod::e_meshInterleavedDataList | pod::c_startTagMask:
 		{
+			if (context.options->deferVertexData && context.deferredDataSource)
+			{
+				result = deferVertexData(stream, mesh, dataLength, 0, context, interleavedDataIndex);
+				break;
+			}
 			UCharBuffer data;
 			result = readByteArrayIntoVector<byte>(stream, data, dataLength);
 			if (!result) { return result; }
@@ -916,33 +1080,33 @@ bool readMeshBlock(Stream& stream, assets::Mesh& mesh)
 			result = readVertexIndexData(stream, mesh);
 			break;
 		case pod::e_meshVertexList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "POSITION", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "POSITION", identifier, interleavedDataIndex, exists, context);
 			break;
 		case pod::e_meshNormalList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "NORMAL", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "NORMAL", identifier, interleavedDataIndex, exists, context);
 			break;
 		case pod::e_meshTangentList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "TANGENT", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "TANGENT", identifier, interleavedDataIndex, exists, context);
 			break;
 		case pod::e_meshBinormalList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "BINORMAL", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "BINORMAL", identifier, interleavedDataIndex, exists, context);
 			break;
 		case pod::e_meshUVWList | pod::c_startTagMask:
 		{
 			char8 semantic[256];
 			sprintf(semantic, "UV%i", numUVWs++);
-			result = readVertexData(stream, mesh, semantic, identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, semantic, identifier, interleavedDataIndex, exists, context);
 			break;
 		}
 		case pod::e_meshVertexColorList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "VERTEXCOLOR", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "VERTEXCOLOR", identifier, interleavedDataIndex, exists, context);
 			break;
 		case pod::e_meshBoneIndexList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "BONEINDEX", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "BONEINDEX", identifier, interleavedDataIndex, exists, context);
 			if (exists) { meshInternalData.primitiveData.isSkinned = true; }
 			break;
 		case pod::e_meshBoneWeightList | pod::c_startTagMask:
-			result = readVertexData(stream, mesh, "BONEWEIGHT", identifier, interleavedDataIndex, exists);
+			result = readVertexData(stream, mesh, "BONEWEIGHT", identifier, interleavedDataIndex, exists, context);
 			if (exists)
 			{
 				meshInternalData.primitiveData.isSkinned = true;
@@ -965,7 +1129,118 @@ bool readMeshBlock(Stream& stream, assets::Mesh& mesh)
 	return result;
 }
 
-bool readSceneBlock(Stream& stream, assets::Model& model)
+// A block of the scene that is indexed by the first pass of the loader and decoded by the second.
+struct DeferredBlock
+{
+	uint32 identifier; // The start tag of the block
+	uint32 index;      // The index of the object in its array of the model
+	size_t offset;     // The offset of the contents of the block in the scene data
+	size_t size;       // The size of the contents of the block, including its end tag
+};
+
+bool deferBlock(Stream& stream, uint32 blockIdentifier, uint32 index, vector<DeferredBlock>& deferredBlocks)
+{
+	DeferredBlock block;
+	block.identifier = blockIdentifier;
+	block.index = index;
+	block.offset = stream.getPosition();
+	uint32 identifier, dataLength;
+	while (readTag(stream, identifier, dataLength))
+	{
+		if (identifier == (blockIdentifier | pod::c_endTagMask))
+		{
+			block.size = stream.getPosition() - block.offset;
+			deferredBlocks.push_back(block);
+			return true;
+		}
+		if (!stream.seek(dataLength, Stream::SeekOriginFromCurrent)) { return false; }
+	}
+	return false;
+}
+
+template<typename T>
+inline T* getObject(std::vector<T>& objects, uint32 index)
+{
+	return index < objects.size() ? &objects[index] : NULL;
+}
+
+bool decodeBlock(Stream& stream, assets::Model::InternalData& modelInternalData, const DeferredBlock& block,
+                 const ReadContext& context)
+{
+	switch (block.identifier)
+	{
+	case pod::e_sceneCamera | pod::c_startTagMask:
+	{
+		Camera* camera = getObject(modelInternalData.cameras, block.index);
+		return camera && readCameraBlock(stream, *camera);
+	}
+	case pod::e_sceneLight | pod::c_startTagMask:
+	{
+		Light* light = getObject(modelInternalData.lights, block.index);
+		return light && readLightBlock(stream, *light);
+	}
+	case pod::e_sceneMesh | pod::c_startTagMask:
+	{
+		assets::Mesh* mesh = getObject(modelInternalData.meshes, block.index);
+		return mesh && readMeshBlock(stream, *mesh, context);
+	}
+	case pod::e_sceneNode | pod::c_startTagMask:
+	{
+		assets::Model::Node* node = getObject(modelInternalData.nodes, block.index);
+		return node && readNodeBlock(stream, *node, context);
+	}
+	case pod::e_sceneTexture | pod::c_startTagMask:
+	{
+		assets::Model::Texture* texture = getObject(modelInternalData.textures, block.index);
+		return texture && readTextureBlock(stream, *texture);
+	}
+	case pod::e_sceneMaterial | pod::c_startTagMask:
+	{
+		assets::Model::Material* material = getObject(modelInternalData.materials, block.index);
+		return material && readMaterialBlock(stream, *material);
+	}
+	}
+	return false;
+}
+
+struct LargerBlockFirst
+{
+	bool operator()(const DeferredBlock& lhs, const DeferredBlock& rhs) const { return lhs.size > rhs.size; }
+};
+
+// Second pass: decode the indexed blocks concurrently. Every block writes to a different object of the model, which
+// have all been allocated by the first pass, so the workers only share the index of the next block to decode.
+bool decodeBlocks(const byte* sceneData, assets::Model& model, vector<DeferredBlock>& blocks, uint32 numThreads,
+                  const ReadContext& sceneContext)
+{
+	// Start with the largest blocks (usually meshes) so that the work is spread evenly.
+	std::sort(blocks.begin(), blocks.end(), LargerBlockFirst());
+	assets::Model::InternalData& modelInternalData = model.getInternalData();
+	std::atomic<size_t> nextBlock(0);
+	std::atomic<bool> failed(false);
+	auto worker = [&]()
+	{
+		for (size_t i = nextBlock++; i < blocks.size() && !failed; i = nextBlock++)
+		{
+			BufferStream blockStream("", sceneData + blocks[i].offset, blocks[i].size);
+			ReadContext blockContext = sceneContext;
+			blockContext.streamOffset += blocks[i].offset;
+			if (!blockStream.open() || !decodeBlock(blockStream, modelInternalData, blocks[i], blockContext)) { failed = true; }
+		}
+	};
+
+	numThreads = (std::min)(numThreads, (uint32)blocks.size());
+	vector<std::thread> threads;
+	for (uint32 i = 1; i < numThreads; ++i) { threads.push_back(std::thread(worker)); }
+	worker();
+	for (size_t i = 0; i < threads.size(); ++i) { threads[i].join(); }
+	return !failed;
+}
+
+// If deferredBlocks is not NULL, the cameras, lights, meshes, nodes, textures and materials are not decoded but only
+// indexed into it, and the objects they are decoded into are allocated.
+bool readSceneBlock(Stream& stream, assets::Model& model, const ReadContext& context,
+                    vector<DeferredBlock>* deferredBlocks)
 {
 	bool result;
 	uint32 identifier, dataLength, temporaryInt;
@@ -1056,22 +1331,28 @@ bool readSceneBlock(Stream& stream, assets::Model& model)
 			result = read4Bytes(stream, modelInternalData.numFrames);
 			break;
 		case pod::e_sceneCamera | pod::c_startTagMask:
-			result = readCameraBlock(stream, modelInternalData.cameras[numCameras++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numCameras++, *deferredBlocks) :
+			         readCameraBlock(stream, modelInternalData.cameras[numCameras++]);
 			break;
 		case pod::e_sceneLight | pod::c_startTagMask:
-			result = readLightBlock(stream, modelInternalData.lights[numLights++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numLights++, *deferredBlocks) :
+			         readLightBlock(stream, modelInternalData.lights[numLights++]);
 			break;
 		case pod::e_sceneMesh | pod::c_startTagMask:
-			result = readMeshBlock(stream, modelInternalData.meshes[numMeshes++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numMeshes++, *deferredBlocks) :
+			         readMeshBlock(stream, modelInternalData.meshes[numMeshes++], context);
 			break;
 		case pod::e_sceneNode | pod::c_startTagMask:
-			result = readNodeBlock(stream, modelInternalData.nodes[numNodes++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numNodes++, *deferredBlocks) :
+			         readNodeBlock(stream, modelInternalData.nodes[numNodes++], context);
 			break;
 		case pod::e_sceneTexture | pod::c_startTagMask:
-			result = readTextureBlock(stream, modelInternalData.textures[numTextures++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numTextures++, *deferredBlocks) :
+			         readTextureBlock(stream, modelInternalData.textures[numTextures++]);
 			break;
 		case pod::e_sceneMaterial | pod::c_startTagMask:
-			result = readMaterialBlock(stream, modelInternalData.materials[numMaterials++]);
+			result = deferredBlocks ? deferBlock(stream, identifier, numMaterials++, *deferredBlocks) :
+			         readMaterialBlock(stream, modelInternalData.materials[numMaterials++]);
 			break;
 		case pod::e_sceneFlags | pod::c_startTagMask:
 			result = read4Bytes(stream, modelInternalData.flags);
@@ -1096,6 +1377,29 @@ bool readSceneBlock(Stream& stream, assets::Model& model)
 	}
 	return result;
 }
+
+// Read the scene in two passes: load it into memory and index its blocks, then decode the blocks on several threads.
+bool readScene(Stream& stream, assets::Model& model, uint32 numThreads, const ReadContext& context)
+{
+	if (numThreads == 0) { numThreads = (std::max)(std::thread::hardware_concurrency(), 1u); }
+	if (numThreads == 1) { return readSceneBlock(stream, model, context, NULL); }
+
+	const size_t sceneStart = stream.getPosition();
+	vector<byte> sceneData(stream.getSize() - sceneStart);
+	size_t dataRead = 0;
+	if (sceneData.empty() || !stream.read(1, sceneData.size(), sceneData.data(), dataRead) || dataRead != sceneData.size())
+	{
+		return false;
+	}
+
+	BufferStream sceneStream("", sceneData.data(), sceneData.size());
+	ReadContext sceneContext = context;
+	sceneContext.streamOffset += sceneStart;
+	vector<DeferredBlock> blocks;
+	if (!sceneStream.open() || !readSceneBlock(sceneStream, model, sceneContext, &blocks)) { return false; }
+	stream.seek((long)(sceneStart + sceneStream.getPosition()), Stream::SeekOriginFromStart);
+	return decodeBlocks(sceneData.data(), model, blocks, numThreads, sceneContext);
+}
 //
 //bool getInformation(Stream& stream, string* history, string* options)
 //{
@@ -1179,8 +1483,23 @@ bool readSceneBlock(Stream& stream, assets::Model& model)
 
 namespace pvr {
 namespace assets {
-PODReader::PODReader() : _modelsToLoad(true)
+PODReader::PODReader() : _modelsToLoad(true), _numDecodeThreads(1)
+{
+}
+
+std::function<Stream::ptr_type()> PODReader::getDeferredDataSource()
 {
+	// Deferred data is read as it is stored in the file, which is little endian.
+	if (!_loadOptions.deferVertexData || !pvr::utils::isLittleEndian()) { return nullptr; }
+	if (_loadOptions.deferredDataSource) { return _loadOptions.deferredDataSource; }
+	if (!dynamic_cast<FileStream*>(_assetStream.get()))
+	{
+		Log(Log.Information, "PODReader: Vertex data can only be deferred for files read from a FileStream, unless a "
+		    "deferredDataSource is provided. Reading all vertex data now.");
+		return nullptr;
+	}
+	const std::string fileName = _assetStream->getFileName();
+	return [fileName]() { return Stream::ptr_type(new FileStream(fileName, "rb")); };
 }
 
 bool PODReader::readNextAsset(assets::Model& asset)
@@ -1212,8 +1531,22 @@ bool PODReader::readNextAsset(assets::Model& asset)
 		}
 		continue;
 		case pod::Scene | pod::c_startTagMask:
-			result = readSceneBlock(*_assetStream, asset);
-			if (result) { asset.initCache(); }
+		{
+			ReadContext context;
+			context.options = &_loadOptions;
+			context.deferredDataSource = getDeferredDataSource();
+			context.streamOffset = 0;
+			result = readScene(*_assetStream, asset, _numDecodeThreads, context);
+			if (result)
+			{
+				removeCamerasAndLights(asset, _loadOptions);
+				if (!_loadOptions.loadAnimation)
+				{
+					asset.getInternalData().numFrames = 0;
+				}
+				asset.initCache();
+			}
+		}
 			return result;
 		default:
 			// Unhandled data, skip it
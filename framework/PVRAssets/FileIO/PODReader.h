@@ -7,6 +7,7 @@
 #pragma once
 
 #include "PVRAssets/AssetIncludes.h"
+#include "PVRAssets/FileIO/ModelLoadOptions.h"
 
 namespace pvr {
 namespace assets {
@@ -20,7 +21,22 @@ public:
 	/// <summary>Construct empty reader.</summary>
 	PODReader();
 	/// <summary>Construct reader from the specified stream.</summary>
-	PODReader(Stream::ptr_type assetStream) : AssetReader<Model>(assetStream) { }
+	PODReader(Stream::ptr_type assetStream) : AssetReader<Model>(assetStream), _modelsToLoad(true), _numDecodeThreads(1) { }
+
+	/// <summary>Set the number of threads that decode the meshes, nodes, materials, textures, cameras and lights of
+	/// the model. With more than one thread, the scene is first read into memory and indexed, then its blocks are
+	/// decoded concurrently.</summary>
+	/// <param name="numThreads">The number of threads, including the calling thread. 1 (default) decodes the scene
+	/// sequentially from the stream; 0 uses one thread per hardware thread.</param>
+	void setNumDecodeThreads(uint32 numThreads) { _numDecodeThreads = numThreads; }
+
+	/// <summary>Set which parts of the model are loaded by the next calls to readAsset.</summary>
+	/// <param name="options">The load options. The default options load the whole model.</param>
+	void setLoadOptions(const ModelLoadOptions& options) { _loadOptions = options; }
+
+	/// <summary>Get the options that control which parts of the model are loaded.</summary>
+	/// <returns>The load options</returns>
+	const ModelLoadOptions& getLoadOptions() const { return _loadOptions; }
 
 	/// <summary>Check if there more assets in the stream.</summary>
 	/// <returns>True if the readAsset() method can be called again to read another asset</returns>
@@ -39,8 +55,11 @@ public:
 	virtual std::vector<std::string> getSupportedFileExtensions();
 private:
 	bool readNextAsset(Model& asset);
+	std::function<Stream::ptr_type()> getDeferredDataSource();
 
 	bool _modelsToLoad;
+	uint32 _numDecodeThreads;
+	ModelLoadOptions _loadOptions;
 };
 }
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "PVRCore/Texture/FileDefinesKTX.h"
 #include "PVRCore/Texture/TextureDefines.h"
 #include "PVRCore/Log.h"
+#include <algorithm>
 
 namespace {
 bool setopenGLFormat(pvr::TextureHeader& hd, pvr::uint32 glInternalFormat, pvr::uint32, pvr::uint32 glType)
@@ -1033,16 +1034,39 @@ bool setopenGLFormat(pvr::TextureHeader& hd, pvr::uint32 glInternalFormat, pvr::
 	//Return false if format isn't found/valid.
 	return false;
 }
+
+bool isCompressedFormat(const pvr::TextureHeader& header)
+{
+	return header.getPixelFormat().getPart().High == 0
+	       && header.getPixelFormat().getPixelTypeId() != (pvr::uint64)pvr::CompressedPixelFormat::SharedExponentR9G9B9E5;
+}
+
+bool isRegularCubeMap(const pvr::TextureHeader& header)
+{
+	return header.getNumberOfFaces() == 6 && header.getNumberOfArrayMembers() == 1;
+}
+
+pvr::uint32 getCubePadding(const pvr::TextureHeader& header, pvr::uint32 mipMapLevel)
+{
+	pvr::uint32 faceSize = header.getDataSize(mipMapLevel, false, false);
+	return faceSize % 4 ? 4 - (faceSize % 4) : 0;
+}
+
+pvr::uint32 getScanLinePadding(pvr::uint32 scanLineSize)
+{
+	return (static_cast<pvr::uint32>(-1) * scanLineSize) % 4;
+}
 }
 
 using std::vector;
 namespace pvr {
 namespace assets {
 namespace assetReaders {
-TextureReaderKTX::TextureReaderKTX() : _texturesToLoad(true)
+TextureReaderKTX::TextureReaderKTX() : _texturesToLoad(true), _numDroppedMipLevels(0), _firstResidentMipLevel(0)
 {
 }
-TextureReaderKTX::TextureReaderKTX(Stream::ptr_type assetStream) : AssetReader<Texture>(assetStream), _texturesToLoad(true)
+TextureReaderKTX::TextureReaderKTX(Stream::ptr_type assetStream) : AssetReader<Texture>(assetStream), _texturesToLoad(true),
+	_numDroppedMipLevels(0), _firstResidentMipLevel(0)
 {
 }
 
@@ -1198,112 +1222,175 @@ bool TextureReaderKTX::readNextAsset(Texture& asset)
 	textureHeader.setNumberOfMIPLevels(ktxFileHeader.numberOfMipmapLevels);
 	textureHeader.setOrientation(static_cast<TextureMetaData::AxisOrientation>(orientation));
 
-	// Initialize the texture to allocate data
-	asset = Texture(textureHeader, NULL);
-
 	// Seek to the start of the texture data, just in case.
 	if (!_assetStream->seek(ktxFileHeader.bytesOfKeyValueData + texture_ktx::c_expectedHeaderSize, Stream::SeekOriginFromStart)) { return false; }
 
+	// When streaming, skip the largest MIP levels, remembering where they are to read them later.
+	uint32 firstMipLevel = 0;
+	_numDroppedMipLevels = 0;
+	_mipLevelOffsets.clear();
+	if (_streamingOptions.isEnabled())
+	{
+		_streamingHeader = textureHeader;
+		_numDroppedMipLevels = textureStreaming::getNumDroppedMipLevels(textureHeader, _streamingOptions);
+		firstMipLevel = textureStreaming::getFirstResidentMipLevel(textureHeader, _streamingOptions);
+		for (uint32 mipMapLevel = 0; mipMapLevel < firstMipLevel; ++mipMapLevel)
+		{
+			_mipLevelOffsets.push_back(_assetStream->getPosition());
+			if (!skipMipLevel(textureHeader, mipMapLevel)) { return false; }
+		}
+	}
+	_firstResidentMipLevel = firstMipLevel;
+
+	// Initialize the texture to allocate data
+	asset = Texture(textureStreaming::getMipTailHeader(textureHeader, firstMipLevel), NULL);
+
 	// Read in the texture data
-	for (uint32 mipMapLevel = 0; mipMapLevel < ktxFileHeader.numberOfMipmapLevels; ++mipMapLevel)
+	for (uint32 mipMapLevel = 0; mipMapLevel < asset.getNumberOfMIPLevels(); ++mipMapLevel)
 	{
-		// Read the stored size of the MIP Map.
-		uint32 mipMapSize = 0;
-		if (!_assetStream->read(sizeof(mipMapSize), 1, &mipMapSize, dataRead) || dataRead != 1) { return false; }
+		if (!readMipLevel(asset, mipMapLevel)) { return false; }
+	}
+
+	// Return
+	return true;
+}
+
+bool TextureReaderKTX::readMipLevel(Texture& asset, uint32 mipMapLevel)
+{
+	size_t dataRead;
+
+	// Read the stored size of the MIP Map.
+	uint32 mipMapSize = 0;
+	if (!_assetStream->read(sizeof(mipMapSize), 1, &mipMapSize, dataRead) || dataRead != 1) { return false; }
 
-		// Sanity check the size - regular cube maps are a slight exception
-		if (asset.getNumberOfFaces() == 6 && asset.getNumberOfArrayMembers() == 1)
+	// Sanity check the size - regular cube maps are a slight exception
+	if (isRegularCubeMap(asset))
+	{
+		if (mipMapSize != asset.getDataSize(mipMapLevel, false, false))
 		{
-			if (mipMapSize != asset.getDataSize(mipMapLevel, false, false))
-			{
-				return false;
-			}
+			return false;
 		}
-		else
+	}
+	else
+	{
+		if (mipMapSize != asset.getDataSize(mipMapLevel))
 		{
-			if (mipMapSize != asset.getDataSize(mipMapLevel))
-			{
-				return false;
-			}
+			return false;
 		}
+	}
 
-		// Work out the Cube Map padding.
-		uint32 cubePadding = 0;
-		if (asset.getDataSize(mipMapLevel, false, false) % 4)
-		{
-			cubePadding = 4 - (asset.getDataSize(mipMapLevel, false, false) % 4);
-		}
+	// Work out the Cube Map padding.
+	uint32 cubePadding = getCubePadding(asset, mipMapLevel);
 
-		// Compressed images are written without scan line padding.
-		if (asset.getPixelFormat().getPart().High == 0
-		    && asset.getPixelFormat().getPixelTypeId() != (uint64)CompressedPixelFormat::SharedExponentR9G9B9E5)
+	// Compressed images are written without scan line padding.
+	if (isCompressedFormat(asset))
+	{
+		for (uint32 iSurface = 0; iSurface < asset.getNumberOfArrayMembers(); ++iSurface)
 		{
-			for (uint32 iSurface = 0; iSurface < asset.getNumberOfArrayMembers(); ++iSurface)
+			for (uint32 iFace = 0; iFace < asset.getNumberOfFaces(); ++iFace)
 			{
-				for (uint32 iFace = 0; iFace < asset.getNumberOfFaces(); ++iFace)
-				{
-					// Read in the texture data.
-					if (!_assetStream->read(asset.getDataSize(mipMapLevel, false, false), 1,
-					                         asset.getDataPointer(mipMapLevel, iSurface, iFace), dataRead) || dataRead != 1) { return false; }
+				// Read in the texture data.
+				if (!_assetStream->read(asset.getDataSize(mipMapLevel, false, false), 1,
+				                         asset.getDataPointer(mipMapLevel, iSurface, iFace), dataRead) || dataRead != 1) { return false; }
 
-					// Advance past the cube face padding
-					if (cubePadding && asset.getNumberOfFaces() == 6 && asset.getNumberOfArrayMembers() == 1)
-					{
-						if (_assetStream->seek(cubePadding, Stream::SeekOriginFromCurrent) != true) { return false; }
-					}
+				// Advance past the cube face padding
+				if (cubePadding && isRegularCubeMap(asset))
+				{
+					if (_assetStream->seek(cubePadding, Stream::SeekOriginFromCurrent) != true) { return false; }
 				}
 			}
 		}
-		// Uncompressed images have scan line padding.
-		else
+	}
+	// Uncompressed images have scan line padding.
+	else
+	{
+		const uint32 scanLineSize = (asset.getBitsPerPixel() / 8) * asset.getWidth(mipMapLevel);
+		for (uint32 iSurface = 0; iSurface < asset.getNumberOfArrayMembers(); ++iSurface)
 		{
-			for (uint32 iSurface = 0; iSurface < asset.getNumberOfArrayMembers(); ++iSurface)
+			for (uint32 iFace = 0; iFace < asset.getNumberOfFaces(); ++iFace)
 			{
-				for (uint32 iFace = 0; iFace < asset.getNumberOfFaces(); ++iFace)
+				for (uint32 texDepth = 0; texDepth < asset.getDepth(mipMapLevel); ++texDepth)
 				{
-					for (uint32 texDepth = 0; texDepth < asset.getDepth(); ++texDepth)
+					for (uint32 texHeight = 0; texHeight < asset.getHeight(mipMapLevel); ++texHeight)
 					{
-						for (uint32 texHeight = 0; texHeight < asset.getHeight(); ++texHeight)
+						// Calculate the data offset for the relevant scan line
+						uint64 scanLineOffset = (textureOffset3D(0, texHeight, texDepth, asset.getWidth(mipMapLevel),
+						                         asset.getHeight(mipMapLevel)) * (asset.getBitsPerPixel() / 8));
+						// Read in the texture data for the current scan line.
+						if (!_assetStream->read(scanLineSize, 1, asset.getDataPointer(mipMapLevel, iSurface, iFace) + scanLineOffset,
+						                         dataRead) || dataRead != 1) { return false; }
+
+						// Advance past the scan line padding
+						if (getScanLinePadding(scanLineSize))
 						{
-							// Calculate the data offset for the relevant scan line
-							uint64 scanLineOffset = (textureOffset3D(0, texHeight, texDepth, asset.getWidth(), asset.getHeight()) *
-							                         (asset.getBitsPerPixel() / 8));
-							// Read in the texture data for the current scan line.
-							if (!_assetStream->read((asset.getBitsPerPixel() / 8) * asset.getWidth(mipMapLevel), 1,
-							                         asset.getDataPointer(mipMapLevel, iSurface, iFace) + scanLineOffset, dataRead) || dataRead != 1) { return false; }
-
-							// Work out the amount of scan line padding.
-							uint32 scanLinePadding = (static_cast<uint32>(-1) * ((asset.getBitsPerPixel() / 8) *
-							                          asset.getWidth(mipMapLevel))) % 4;
-
-							// Advance past the scan line padding
-							if (scanLinePadding)
-							{
-								if (!_assetStream->seek(scanLinePadding, Stream::SeekOriginFromCurrent)) { return false; }
-							}
+							if (!_assetStream->seek(getScanLinePadding(scanLineSize), Stream::SeekOriginFromCurrent)) { return false; }
 						}
 					}
+				}
 
-					// Advance past the cube face padding
-					if (cubePadding && asset.getNumberOfFaces() == 6 && asset.getNumberOfArrayMembers() == 1)
-					{
-						if (!_assetStream->seek(cubePadding, Stream::SeekOriginFromCurrent)) { return false; }
-					}
+				// Advance past the cube face padding
+				if (cubePadding && isRegularCubeMap(asset))
+				{
+					if (!_assetStream->seek(cubePadding, Stream::SeekOriginFromCurrent)) { return false; }
 				}
 			}
 		}
+	}
+
+	// Calculate the amount MIP Map padding.
+	uint32 mipMapPadding = (3 - ((mipMapSize + 3) % 4));
+
+	// Advance past the MIP Map padding if appropriate
+	if (mipMapPadding)
+	{
+		if (!_assetStream->seek(mipMapPadding, Stream::SeekOriginFromCurrent)) { return false; }
+	}
+	return true;
+}
+
+bool TextureReaderKTX::skipMipLevel(const TextureHeader& header, uint32 mipMapLevel)
+{
+	size_t dataRead;
+	uint32 mipMapSize = 0;
+	if (!_assetStream->read(sizeof(mipMapSize), 1, &mipMapSize, dataRead) || dataRead != 1) { return false; }
 
-		// Calculate the amount MIP Map padding.
-		uint32 mipMapPadding = (3 - ((mipMapSize + 3) % 4));
+	// Same layout as read by readMipLevel.
+	uint64 faceSize = header.getDataSize(mipMapLevel, false, false);
+	if (!isCompressedFormat(header))
+	{
+		const uint32 scanLineSize = (header.getBitsPerPixel() / 8) * header.getWidth(mipMapLevel);
+		faceSize = (uint64)header.getDepth(mipMapLevel) * header.getHeight(mipMapLevel) *
+		           (scanLineSize + getScanLinePadding(scanLineSize));
+	}
+	if (isRegularCubeMap(header)) { faceSize += getCubePadding(header, mipMapLevel); }
+
+	const uint64 levelSize = faceSize * header.getNumberOfArrayMembers() * header.getNumberOfFaces() +
+	                         (3 - ((mipMapSize + 3) % 4));
+	return _assetStream->seek((long)levelSize, Stream::SeekOriginFromCurrent);
+}
 
-		// Advance past the MIP Map padding if appropriate
-		if (mipMapPadding)
+bool TextureReaderKTX::streamMipLevels(Texture& asset, uint32 numMipLevels)
+{
+	numMipLevels = std::min(numMipLevels, getNumPendingMipLevels());
+	if (!numMipLevels) { return true; }
+	if (!_assetStream.get() || (!_assetStream->isopen() && !_assetStream->open()))
+	{
+		Log(Log.Error, "TextureReaderKTX::streamMipLevels: The texture stream is not available");
+		return false;
+	}
+
+	const uint32 newFirstMipLevel = _firstResidentMipLevel - numMipLevels;
+	textureStreaming::growMipTail(asset, _streamingHeader, newFirstMipLevel);
+	for (uint32 mipMapLevel = newFirstMipLevel; mipMapLevel < _firstResidentMipLevel; ++mipMapLevel)
+	{
+		if (!_assetStream->seek((long)_mipLevelOffsets[mipMapLevel], Stream::SeekOriginFromStart) ||
+		    !readMipLevel(asset, mipMapLevel - newFirstMipLevel))
 		{
-			if (!_assetStream->seek(mipMapPadding, Stream::SeekOriginFromCurrent)) { return false; }
+			Log(Log.Error, "TextureReaderKTX::streamMipLevels: Failed to read MIP levels from the texture stream");
+			return false;
 		}
 	}
-
-	// Return
+	_firstResidentMipLevel = newFirstMipLevel;
 	return true;
 }
 
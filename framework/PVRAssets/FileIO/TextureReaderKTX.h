@@ -8,6 +8,7 @@
 #pragma once
 #include "PVRCore/Texture.h"
 #include "PVRCore/IO/AssetReader.h"
+#include "PVRAssets/FileIO/TextureStreaming.h"
 
 namespace pvr {
 namespace assets {
@@ -24,9 +25,34 @@ public:
 
 	virtual bool isSupportedFile(Stream& assetStream);
 	virtual std::vector<std::string> getSupportedFileExtensions();
+
+	/// <summary>Set which MIP levels the next readAsset call loads. By default, the whole texture is loaded.</summary>
+	/// <param name="options">The streaming options</param>
+	void setStreamingOptions(const TextureStreamingOptions& options) { _streamingOptions = options; }
+
+	/// <summary>Get the number of MIP levels of the last texture read that have been deferred by the streaming
+	/// options and not yet read with streamMipLevels. Dropped MIP levels are not counted.</summary>
+	/// <returns>The number of MIP levels that can still be streamed in</returns>
+	uint32 getNumPendingMipLevels() const { return _firstResidentMipLevel - _numDroppedMipLevels; }
+
+	/// <summary>Read the next larger deferred MIP levels of the last texture read into it. The texture is
+	/// reallocated to contain the new levels, keeping the data of the levels already loaded. The stream must still
+	/// be available.</summary>
+	/// <param name="asset">The texture returned by the last readAsset call, possibly already extended by
+	/// streamMipLevels</param>
+	/// <param name="numMipLevels">The maximum number of MIP levels to read</param>
+	/// <returns>True on success (including if there were no levels left to read), false on a read error.</returns>
+	bool streamMipLevels(Texture& asset, uint32 numMipLevels = 1);
 private:
 	virtual bool readNextAsset(Texture& asset);
+	bool readMipLevel(Texture& asset, uint32 mipMapLevel);
+	bool skipMipLevel(const TextureHeader& header, uint32 mipMapLevel);
 	bool _texturesToLoad;
+	TextureStreamingOptions _streamingOptions;
+	TextureHeader _streamingHeader; // Header of the full texture, as in the file.
+	std::vector<size_t> _mipLevelOffsets; // File offsets of the MIP levels that were not read.
+	uint32 _numDroppedMipLevels;
+	uint32 _firstResidentMipLevel;
 };
 }
 }
@@ -7,21 +7,25 @@
 //!\cond NO_DOXYGEN
 #include "PVRAssets/FileIO/TextureReaderPVR.h"
 #include "PVRCore/Log.h"
+#include <algorithm>
 using std::vector;
 namespace pvr {
 using namespace types;
 namespace assets {
 namespace assetReaders {
-TextureReaderPVR::TextureReaderPVR() : _texturesToLoad(true)
+TextureReaderPVR::TextureReaderPVR() : _texturesToLoad(true), _textureDataOffset(0), _numDroppedMipLevels(0),
+	_firstResidentMipLevel(0)
 { }
 
-TextureReaderPVR::TextureReaderPVR(Stream::ptr_type assetStream) : AssetReader<Texture>(assetStream), _texturesToLoad(true)
+TextureReaderPVR::TextureReaderPVR(Stream::ptr_type assetStream) : AssetReader<Texture>(assetStream),
+	_texturesToLoad(true), _textureDataOffset(0), _numDroppedMipLevels(0), _firstResidentMipLevel(0)
 { }
 
 bool TextureReaderPVR::readNextAsset(Texture& asset)
 {
 	// Acknowledge that once this function has returned the user won't be able load a texture from the file.
 	_texturesToLoad = false;
+	_numDroppedMipLevels = _firstResidentMipLevel = 0;
 
 	// Get the file header to Read.
 	TextureHeader::Header textureFileHeader;
@@ -75,7 +79,6 @@ bool TextureReaderPVR::readNextAsset(Texture& asset)
 		textureFileHeader.metaDataSize = 0;
 		TextureHeader textureHeader(textureFileHeader, 0, NULL);
 
-		asset.initializeWithHeader(textureHeader);
 		// Read the meta data
 		uint32 metaDataRead = 0;
 		while (metaDataRead < tempMetaDataSize)
@@ -84,10 +87,10 @@ bool TextureReaderPVR::readNextAsset(Texture& asset)
 			if (!metaDataBlock.loadFromStream(*_assetStream)) { return false; }
 
 			// Add the meta data
-			asset.addMetaData(metaDataBlock);
+			textureHeader.addMetaData(metaDataBlock);
 
 			// Evaluate the meta data read
-			metaDataRead = asset.getMetaDataSize();
+			metaDataRead = textureHeader.getMetaDataSize();
 		}
 
 
@@ -100,6 +103,27 @@ bool TextureReaderPVR::readNextAsset(Texture& asset)
 			return false;
 		}
 
+		if (_streamingOptions.isEnabled())
+		{
+			// Only allocate and read the MIP levels from the first resident one down. They are at the end of the data.
+			_streamingHeader = textureHeader;
+			_textureDataOffset = _assetStream->getPosition();
+			_numDroppedMipLevels = textureStreaming::getNumDroppedMipLevels(textureHeader, _streamingOptions);
+			_firstResidentMipLevel = textureStreaming::getFirstResidentMipLevel(textureHeader, _streamingOptions);
+			asset.initializeWithHeader(textureStreaming::getMipTailHeader(textureHeader, _firstResidentMipLevel));
+
+			size_t skippedDataSize = 0;
+			for (uint32 mipLevel = 0; mipLevel < _firstResidentMipLevel; ++mipLevel)
+			{
+				skippedDataSize += textureHeader.getDataSize(mipLevel);
+			}
+			if (!_assetStream->seek((long)skippedDataSize, Stream::SeekOriginFromCurrent)) { return false; }
+		}
+		else
+		{
+			asset.initializeWithHeader(textureHeader);
+		}
+
 		// Read the texture data
 		if (!_assetStream->read(1, asset.getDataSize(), asset.getDataPointer(), dataRead) || dataRead != asset.getDataSize()) { return false; }
 	}
@@ -196,6 +220,40 @@ bool TextureReaderPVR::readNextAsset(Texture& asset)
 	return true;
 }
 
+bool TextureReaderPVR::streamMipLevels(Texture& asset, uint32 numMipLevels)
+{
+	numMipLevels = std::min(numMipLevels, getNumPendingMipLevels());
+	if (!numMipLevels) { return true; }
+	if (!_assetStream.get() || (!_assetStream->isopen() && !_assetStream->open()))
+	{
+		Log(Log.Error, "TextureReaderPVR::streamMipLevels: The texture stream is not available");
+		return false;
+	}
+
+	const uint32 newFirstMipLevel = _firstResidentMipLevel - numMipLevels;
+	size_t levelOffset = _textureDataOffset;
+	for (uint32 mipLevel = 0; mipLevel < newFirstMipLevel; ++mipLevel)
+	{
+		levelOffset += _streamingHeader.getDataSize(mipLevel);
+	}
+	textureStreaming::growMipTail(asset, _streamingHeader, newFirstMipLevel);
+
+	// The new levels are contiguous in both the file and the texture.
+	size_t dataSize = 0, dataRead = 0;
+	for (uint32 mipLevel = newFirstMipLevel; mipLevel < _firstResidentMipLevel; ++mipLevel)
+	{
+		dataSize += _streamingHeader.getDataSize(mipLevel);
+	}
+	if (!_assetStream->seek((long)levelOffset, Stream::SeekOriginFromStart) ||
+	    !_assetStream->read(1, dataSize, asset.getDataPointer(), dataRead) || dataRead != dataSize)
+	{
+		Log(Log.Error, "TextureReaderPVR::streamMipLevels: Failed to read MIP levels from the texture stream");
+		return false;
+	}
+	_firstResidentMipLevel = newFirstMipLevel;
+	return true;
+}
+
 bool TextureReaderPVR::hasAssetsLeftToLoad()
 {
 	return _texturesToLoad;
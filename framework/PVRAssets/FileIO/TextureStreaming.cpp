@@ -0,0 +1,62 @@
+/*!
+\brief Implementation of the helpers used by the texture readers to load textures progressively.
+\file PVRAssets/FileIO/TextureStreaming.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/TextureStreaming.h"
+#include <algorithm>
+
+namespace pvr {
+namespace assets {
+namespace textureStreaming {
+TextureHeader getMipTailHeader(const TextureHeader& header, uint32 firstMipLevel)
+{
+	TextureHeader tailHeader(header);
+	tailHeader.setWidth(header.getWidth(firstMipLevel));
+	tailHeader.setHeight(header.getHeight(firstMipLevel));
+	tailHeader.setDepth(header.getDepth(firstMipLevel));
+	tailHeader.setNumberOfMIPLevels(header.getNumberOfMIPLevels() - firstMipLevel);
+	return tailHeader;
+}
+
+uint32 getNumDroppedMipLevels(const TextureHeader& header, const TextureStreamingOptions& options)
+{
+	return std::min(options.numMipLevelsToDrop, header.getNumberOfMIPLevels() - 1);
+}
+
+uint32 getFirstResidentMipLevel(const TextureHeader& header, const TextureStreamingOptions& options)
+{
+	const uint32 firstLevel = getNumDroppedMipLevels(header, options);
+	if (!options.initialByteBudget) { return firstLevel; }
+
+	// Walk up from the smallest level, which is always loaded, while the budget allows.
+	uint32 residentLevel = header.getNumberOfMIPLevels() - 1;
+	uint64 residentSize = header.getDataSize(residentLevel);
+	while (residentLevel > firstLevel)
+	{
+		const uint64 levelSize = header.getDataSize(residentLevel - 1);
+		if (residentSize + levelSize > options.initialByteBudget) { break; }
+		residentSize += levelSize;
+		--residentLevel;
+	}
+	return residentLevel;
+}
+
+void growMipTail(Texture& texture, const TextureHeader& fullHeader, uint32 newFirstMipLevel)
+{
+	const uint32 numNewLevels = fullHeader.getNumberOfMIPLevels() - newFirstMipLevel - texture.getNumberOfMIPLevels();
+	if (!numNewLevels) { return; }
+
+	// MIP levels are the outermost dimension of the texture data, so the levels already loaded are the end of the
+	// data of the extended texture.
+	TextureHeader newHeader = getMipTailHeader(fullHeader, newFirstMipLevel);
+	Texture newTexture(newHeader);
+	memcpy(newTexture.getDataPointer(numNewLevels), texture.getDataPointer(), texture.getDataSize());
+	texture = std::move(newTexture);
+}
+}
+}
+}
+//!\endcond
@@ -0,0 +1,67 @@
+/*!
+\brief Options and helpers used by the texture readers to load textures progressively, smallest MIP levels first.
+\file PVRAssets/FileIO/TextureStreaming.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/Texture.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>Controls which MIP levels of a texture a texture reader loads initially. The default options load the
+/// whole texture.</summary>
+/// <remarks>Texture data is laid out largest MIP level first, so dropping or deferring the largest levels keeps
+/// a texture usable (and small) while the rest of its data is still on disk. The levels not read initially can
+/// be read later with the streamMipLevels method of the reader.</remarks>
+struct TextureStreamingOptions
+{
+	/// <summary>Number of the largest MIP levels to skip permanently, for example on low memory devices. At least
+	/// the smallest MIP level is always kept.</summary>
+	uint32 numMipLevelsToDrop;
+	/// <summary>Maximum number of bytes of texture data to read initially, taken from the smallest MIP levels up.
+	/// The smallest MIP level is always read. Zero means no limit.</summary>
+	uint32 initialByteBudget;
+
+	/// <summary>Constructor.</summary>
+	/// <param name="numMipLevelsToDrop">Number of the largest MIP levels to skip permanently</param>
+	/// <param name="initialByteBudget">Maximum number of bytes to read initially. Zero means no limit.</param>
+	TextureStreamingOptions(uint32 numMipLevelsToDrop = 0, uint32 initialByteBudget = 0) :
+		numMipLevelsToDrop(numMipLevelsToDrop), initialByteBudget(initialByteBudget) {}
+
+	/// <summary>Check if these options load anything less than the whole texture.</summary>
+	/// <returns>True if any MIP levels will be dropped or deferred.</returns>
+	bool isEnabled() const { return numMipLevelsToDrop != 0 || initialByteBudget != 0; }
+};
+
+namespace textureStreaming {
+/// <summary>Get the header of the texture made of the MIP levels of a texture from a specific level down.</summary>
+/// <param name="header">The header of the full texture</param>
+/// <param name="firstMipLevel">The MIP level that will be level 0 of the new header</param>
+/// <returns>A header with the dimensions of firstMipLevel, and the MIP levels from firstMipLevel to the smallest.
+/// </returns>
+TextureHeader getMipTailHeader(const TextureHeader& header, uint32 firstMipLevel);
+
+/// <summary>Get the number of the largest MIP levels a reader will never load, according to streaming options.
+/// </summary>
+/// <param name="header">The header of the full texture</param>
+/// <param name="options">The streaming options</param>
+/// <returns>The number of largest MIP levels that are dropped.</returns>
+uint32 getNumDroppedMipLevels(const TextureHeader& header, const TextureStreamingOptions& options);
+
+/// <summary>Get the largest MIP level a reader loads initially, according to streaming options.</summary>
+/// <param name="header">The header of the full texture</param>
+/// <param name="options">The streaming options</param>
+/// <returns>The first MIP level to load. All MIP levels from this one to the smallest are loaded.</returns>
+uint32 getFirstResidentMipLevel(const TextureHeader& header, const TextureStreamingOptions& options);
+
+/// <summary>Extend a texture holding the MIP tail of a larger texture with larger MIP levels. The data of the
+/// levels already in the texture is kept. The data of the new levels is uninitialized.</summary>
+/// <param name="texture">A texture containing the MIP levels of fullHeader from some level down. Will be replaced
+/// by a texture containing the levels from newFirstMipLevel down.</param>
+/// <param name="fullHeader">The header of the full texture</param>
+/// <param name="newFirstMipLevel">The new largest MIP level. Must not be smaller than the current one.</param>
+void growMipTail(Texture& texture, const TextureHeader& fullHeader, uint32 newFirstMipLevel);
+}
+}
+}
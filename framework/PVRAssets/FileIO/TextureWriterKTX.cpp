@@ -229,13 +229,13 @@ bool TextureWriterKTX::writeAllAssets()
 			{
 				for (uint32 iFace = 0; iFace < _assetsToWrite[0]->getNumberOfFaces(); ++iFace)
 				{
-					for (uint32 texDepth = 0; texDepth < _assetsToWrite[0]->getDepth(); ++texDepth)
+					for (uint32 texDepth = 0; texDepth < _assetsToWrite[0]->getDepth(mipMapLevel); ++texDepth)
 					{
-						for (uint32 texHeight = 0; texHeight < _assetsToWrite[0]->getHeight(); ++texHeight)
+						for (uint32 texHeight = 0; texHeight < _assetsToWrite[0]->getHeight(mipMapLevel); ++texHeight)
 						{
 							// Calculate the data offset for the relevant scan line
-							uint64 scanLineOffset = (textureOffset3D(0, texHeight, texDepth, _assetsToWrite[0]->getWidth(),
-							                         _assetsToWrite[0]->getHeight()) * (_assetsToWrite[0]->getBitsPerPixel() / 8));
+							uint64 scanLineOffset = (textureOffset3D(0, texHeight, texDepth, _assetsToWrite[0]->getWidth(mipMapLevel),
+							                         _assetsToWrite[0]->getHeight(mipMapLevel)) * (_assetsToWrite[0]->getBitsPerPixel() / 8));
 							// Write in the texture data for the current scan line.
 							result = _assetStream->write((_assetsToWrite[0]->getBitsPerPixel() / 8) *
 							                              _assetsToWrite[0]->getWidth(mipMapLevel), 1,
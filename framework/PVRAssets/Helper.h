@@ -7,6 +7,14 @@
 #pragma once
 
 #include "PVRAssets/Model/Mesh.h"
+#include "PVRCore/Base/HalfFloat.h"
+#include <cstring>
+#if defined(PVR_SUPPORT_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(PVR_SUPPORT_NEON)
+#include <arm_neon.h>
+#endif
 namespace pvr {
 /// <summary>Read vertex data into float32 buffer.</summary>
 /// <param name="data">Data to read from</param>
@@ -117,10 +125,19 @@ inline void VertexRead(const byte* const data, const types::DataType type, uint3
 		}
 		break;
 
-	//case PVRDataType::Int16Norm:
-	//	for(i = 0; i < count; ++i)
-	//		out[i] = (float32)((uint16*)data)[i] / (float32)((1 << 16)-1);
-	//	break;
+    case types::DataType::UInt16Norm:
+		for (i = 0; i < count; ++i)
+		{
+			out[i] = (float32)((uint16*)data)[i] / (float32)((1 << 16) - 1);
+		}
+		break;
+
+    case types::DataType::Float16:
+		for (i = 0; i < count; ++i)
+		{
+			out[i] = (float32)((HalfFloat*)data)[i];
+		}
+		break;
 
     case types::DataType::RGBA:
 	{
@@ -210,6 +227,205 @@ inline void VertexRead(const byte* const data, const types::DataType type, uint3
 	}
 }
 
+namespace internal {
+// VertexReadBatch for the formats with one value of type Type per component, converted as VertexRead does.
+template<typename Type>
+inline void vertexReadComponents(const byte* data, uint32 stride, uint32 count, uint32 numVertices, float32* out,
+                                 uint32 outStride, float32 divisor)
+{
+	for (uint32 i = 0; i < numVertices; ++i, data += stride, out += outStride)
+	{
+		for (uint32 c = 0; c < count; ++c)
+		{
+			Type value;
+			memcpy(&value, data + c * sizeof(Type), sizeof(Type));
+			out[c] = (float32)value / divisor;
+		}
+	}
+}
+
+// VertexReadBatch for the most common formats, a vertex at a time with its components in the lanes of a vector.
+// Each vertex reads and writes four components, so the last vertex is left to the scalar version, and so are vertices
+// whose four components would reach past the next vertex. Returns the number of vertices read.
+inline uint32 vertexReadSimd(const byte* data, uint32 stride, types::DataType type, uint32 count, uint32 numVertices,
+                             float32* out, uint32 outStride)
+{
+	uint32 size;
+	switch (type)
+	{
+	case types::DataType::Float32: case types::DataType::Fixed16_16: size = 4; break;
+	case types::DataType::Int16Norm: size = 2; break;
+	case types::DataType::UInt8Norm: size = 1; break;
+	default: return 0;
+	}
+	// Writing four floats only overwrites floats of the next vertex that it writes itself (or padding).
+	if (numVertices < 2 || size * 4 > stride || outStride + count < 4) { return 0; }
+	const uint32 numSimd = numVertices - 1;
+#if defined(PVR_SUPPORT_SSE2)
+	switch (type)
+	{
+	case types::DataType::Float32:
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			_mm_storeu_ps(out + i * outStride, _mm_loadu_ps(reinterpret_cast<const float32*>(data + i * stride)));
+		}
+		return numSimd;
+	case types::DataType::Fixed16_16:
+	{
+		const __m128 scale = _mm_set1_ps(1.0f / 65536.0f); // Exact, as VertexRead's division by a power of two
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * stride));
+			_mm_storeu_ps(out + i * outStride, _mm_mul_ps(_mm_cvtepi32_ps(value), scale));
+		}
+		return numSimd;
+	}
+	case types::DataType::Int16Norm:
+	{
+		const __m128 divisor = _mm_set1_ps((float32)((1 << 15) - 1));
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			const __m128i value = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i * stride));
+			const __m128i extended = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+			_mm_storeu_ps(out + i * outStride, _mm_div_ps(_mm_cvtepi32_ps(extended), divisor));
+		}
+		return numSimd;
+	}
+	default:
+	{
+		const __m128 divisor = _mm_set1_ps((float32)((1 << 8) - 1));
+		const __m128i zero = _mm_setzero_si128();
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			int32 bytes;
+			memcpy(&bytes, data + i * stride, 4);
+			const __m128i value = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+			_mm_storeu_ps(out + i * outStride, _mm_div_ps(_mm_cvtepi32_ps(value), divisor));
+		}
+		return numSimd;
+	}
+	}
+#elif defined(PVR_SUPPORT_NEON)
+	switch (type)
+	{
+	case types::DataType::Float32:
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			vst1q_f32(out + i * outStride, vld1q_f32(reinterpret_cast<const float32*>(data + i * stride)));
+		}
+		return numSimd;
+	case types::DataType::Fixed16_16:
+	{
+		const float32x4_t scale = vdupq_n_f32(1.0f / 65536.0f);
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			const int32x4_t value = vreinterpretq_s32_u8(vld1q_u8(data + i * stride));
+			vst1q_f32(out + i * outStride, vmulq_f32(vcvtq_f32_s32(value), scale));
+		}
+		return numSimd;
+	}
+#if defined(__aarch64__)
+	// The normalized formats divide as VertexRead does, which ARMv7 NEON cannot.
+	case types::DataType::Int16Norm:
+	{
+		const float32x4_t divisor = vdupq_n_f32((float32)((1 << 15) - 1));
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			const int16x4_t value = vreinterpret_s16_u8(vld1_u8(data + i * stride));
+			vst1q_f32(out + i * outStride, vdivq_f32(vcvtq_f32_s32(vmovl_s16(value)), divisor));
+		}
+		return numSimd;
+	}
+	case types::DataType::UInt8Norm:
+	{
+		const float32x4_t divisor = vdupq_n_f32((float32)((1 << 8) - 1));
+		for (uint32 i = 0; i < numSimd; ++i)
+		{
+			uint32 bytes;
+			memcpy(&bytes, data + i * stride, 4);
+			const uint16x4_t value = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bytes))));
+			vst1q_f32(out + i * outStride, vdivq_f32(vcvtq_f32_u32(vmovl_u16(value)), divisor));
+		}
+		return numSimd;
+	}
+#endif
+	default: return 0;
+	}
+#else
+	(void)out;
+	return 0;
+#endif
+}
+}
+
+/// <summary>Read the same attribute of many vertices into a float32 array. Gives the same values as calling
+/// VertexRead for each vertex, but converts the common formats (Float32, Fixed16_16, Int16Norm and UInt8Norm) with
+/// SSE2 or NEON and the others without a switch per vertex.</summary>
+/// <param name="data">The attribute of the first vertex</param>
+/// <param name="stride">The number of bytes between the attributes of two vertices</param>
+/// <param name="type">Data type of the attribute</param>
+/// <param name="count">Number of components of the attribute to read (1 to 4)</param>
+/// <param name="numVertices">Number of vertices to read</param>
+/// <param name="out">Receives count floats per vertex, outStride floats apart. Floats between the last component of
+/// a vertex and the next vertex are overwritten with unspecified values.</param>
+/// <param name="outStride">The number of floats between two vertices in out. At least count.</param>
+inline void VertexReadBatch(const byte* data, uint32 stride, types::DataType type, uint32 count, uint32 numVertices,
+                            float32* out, uint32 outStride)
+{
+	const uint32 numSimd = internal::vertexReadSimd(data, stride, type, count, numVertices, out, outStride);
+	data += numSimd * stride;
+	out += numSimd * outStride;
+	numVertices -= numSimd;
+	switch (type)
+	{
+	case types::DataType::Float32:
+		internal::vertexReadComponents<float32>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::Fixed16_16:
+		internal::vertexReadComponents<int32>(data, stride, count, numVertices, out, outStride, (float32)(1 << 16));
+		break;
+	case types::DataType::Int32:
+		internal::vertexReadComponents<int32>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::UInt32:
+		internal::vertexReadComponents<uint32>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::Int8:
+		internal::vertexReadComponents<char8>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::Int8Norm:
+		internal::vertexReadComponents<char8>(data, stride, count, numVertices, out, outStride, (float32)((1 << 7) - 1));
+		break;
+	case types::DataType::UInt8:
+		internal::vertexReadComponents<byte>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::UInt8Norm:
+		internal::vertexReadComponents<byte>(data, stride, count, numVertices, out, outStride, (float32)((1 << 8) - 1));
+		break;
+	case types::DataType::Int16:
+		internal::vertexReadComponents<int16>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::Int16Norm:
+		internal::vertexReadComponents<int16>(data, stride, count, numVertices, out, outStride, (float32)((1 << 15) - 1));
+		break;
+	case types::DataType::UInt16:
+		internal::vertexReadComponents<uint16>(data, stride, count, numVertices, out, outStride, 1.0f);
+		break;
+	case types::DataType::UInt16Norm:
+		internal::vertexReadComponents<uint16>(data, stride, count, numVertices, out, outStride, (float32)((1 << 16) - 1));
+		break;
+	default:
+		// Half floats and the packed formats, which VertexRead unpacks into up to four floats.
+		for (uint32 i = 0; i < numVertices; ++i, data += stride, out += outStride)
+		{
+			float32 values[4];
+			VertexRead(data, type, type == types::DataType::Float16 ? count : 4, values);
+			memcpy(out, values, count * sizeof(float32));
+		}
+		break;
+	}
+}
+
 /// <summary>Read vertex index data into uin32 buffer.</summary>
 /// <param name="data">Data to read from</param>
 /// <param name="type">Index type to read</param>
@@ -0,0 +1,220 @@
+/*!
+\brief Implementation of the mesh cluster functions.
+\file PVRAssets/MeshClusters.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/MeshClusters.h"
+#include "PVRAssets/MeshDataHelpers.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace {
+using internal::readIndices;
+using internal::readPositions;
+
+// Normal cones wider than this (the cosine of their angle) cannot cull anything useful.
+const float32 MinConeCosine = 0.1f;
+
+void computeClusterBounds(const std::vector<glm::vec3>& positions, const uint32* indices, MeshCluster& cluster)
+{
+	glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+	for (uint32 i = 0; i < cluster.numFaces * 3; ++i)
+	{
+		minimum = glm::min(minimum, positions[indices[i]]);
+		maximum = glm::max(maximum, positions[indices[i]]);
+	}
+	cluster.center = (minimum + maximum) * 0.5f;
+	cluster.radius = 0.0f;
+	for (uint32 i = 0; i < cluster.numFaces * 3; ++i)
+	{
+		cluster.radius = (std::max)(cluster.radius, glm::length(positions[indices[i]] - cluster.center));
+	}
+
+	// The cone axis is the average normal, and its angle covers the normal furthest from it.
+	glm::vec3 normalSum(0.0f);
+	for (uint32 i = 0; i < cluster.numFaces; ++i)
+	{
+		const glm::vec3& p0 = positions[indices[i * 3]];
+		const glm::vec3 normal = glm::cross(positions[indices[i * 3 + 1]] - p0, positions[indices[i * 3 + 2]] - p0);
+		const float32 length = glm::length(normal);
+		if (length > 0.0f) { normalSum += normal / length; }
+	}
+	cluster.coneApex = cluster.center;
+	cluster.coneAxis = glm::vec3(0.0f);
+	cluster.coneCutoff = 1.0f;
+	const float32 sumLength = glm::length(normalSum);
+	if (sumLength == 0.0f) { return; }
+	const glm::vec3 axis = normalSum / sumLength;
+	float32 minCosine = 1.0f;
+	for (uint32 i = 0; i < cluster.numFaces; ++i)
+	{
+		const glm::vec3& p0 = positions[indices[i * 3]];
+		const glm::vec3 normal = glm::cross(positions[indices[i * 3 + 1]] - p0, positions[indices[i * 3 + 2]] - p0);
+		const float32 length = glm::length(normal);
+		if (length > 0.0f) { minCosine = (std::min)(minCosine, glm::dot(axis, normal / length)); }
+	}
+	if (minCosine <= MinConeCosine) { return; }
+
+	// Move the apex back along the axis until every triangle plane is in front of it, so that a camera that sees
+	// the apex from behind the cone sees the back of every triangle.
+	float32 maxDistance = 0.0f;
+	for (uint32 i = 0; i < cluster.numFaces; ++i)
+	{
+		const glm::vec3& p0 = positions[indices[i * 3]];
+		glm::vec3 normal = glm::cross(positions[indices[i * 3 + 1]] - p0, positions[indices[i * 3 + 2]] - p0);
+		const float32 length = glm::length(normal);
+		if (length == 0.0f) { continue; }
+		normal /= length;
+		maxDistance = (std::max)(maxDistance, glm::dot(cluster.center - p0, normal) / glm::dot(axis, normal));
+	}
+	cluster.coneApex = cluster.center - axis * maxDistance;
+	cluster.coneAxis = axis;
+	cluster.coneCutoff = sqrtf(1.0f - minCosine * minCosine);
+}
+
+// Grow clusters one triangle at a time, preferring the neighbouring triangle that adds the fewest vertices, then the
+// one closest to the cluster. A cluster is closed when it is full or has no neighbouring triangle left.
+void buildRangeClusters(const std::vector<glm::vec3>& positions, const std::vector<uint32>& indices,
+                        const std::vector<uint32>& adjacencyOffsets, const std::vector<uint32>& adjacency,
+                        uint32 beginFace, uint32 endFace, uint32 maxVertices, uint32 maxFaces,
+                        std::vector<uint8>& emitted, std::vector<uint32>& vertexCluster, std::vector<uint32>& outIndices,
+                        std::vector<MeshCluster>& clusters)
+{
+	std::vector<uint32> clusterVertices;
+	uint32 seed = beginFace;
+	for (;;)
+	{
+		while (seed < endFace && emitted[seed]) { ++seed; }
+		if (seed == endFace) { break; }
+
+		const uint32 clusterId = (uint32)clusters.size() + 1;
+		MeshCluster cluster;
+		cluster.firstFace = (uint32)(outIndices.size() / 3);
+		cluster.numFaces = 0;
+		clusterVertices.clear();
+		glm::vec3 positionSum(0.0f);
+		uint32 next = seed;
+		while (next != 0xFFFFFFFFu)
+		{
+			emitted[next] = 1;
+			++cluster.numFaces;
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				const uint32 vertex = indices[next * 3 + k];
+				outIndices.push_back(vertex);
+				if (vertexCluster[vertex] != clusterId)
+				{
+					vertexCluster[vertex] = clusterId;
+					clusterVertices.push_back(vertex);
+					positionSum += positions[vertex];
+				}
+			}
+			if (cluster.numFaces == maxFaces) { break; }
+
+			const glm::vec3 centroid = positionSum / (float32)clusterVertices.size();
+			uint32 bestNewVertices = 4;
+			float32 bestDistance = FLT_MAX;
+			next = 0xFFFFFFFFu;
+			for (size_t v = 0; v < clusterVertices.size(); ++v)
+			{
+				for (uint32 a = adjacencyOffsets[clusterVertices[v]]; a < adjacencyOffsets[clusterVertices[v] + 1]; ++a)
+				{
+					const uint32 face = adjacency[a];
+					if (face < beginFace || face >= endFace || emitted[face]) { continue; }
+					uint32 newVertices = 0;
+					glm::vec3 faceCentroid(0.0f);
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						newVertices += vertexCluster[indices[face * 3 + k]] != clusterId;
+						faceCentroid += positions[indices[face * 3 + k]];
+					}
+					if (clusterVertices.size() + newVertices > maxVertices || newVertices > bestNewVertices) { continue; }
+					const glm::vec3 offset = faceCentroid / 3.0f - centroid;
+					const float32 distance = glm::dot(offset, offset);
+					if (newVertices < bestNewVertices || distance < bestDistance)
+					{
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+						next = face;
+					}
+				}
+			}
+		}
+		cluster.numVertices = (uint32)clusterVertices.size();
+		computeClusterBounds(positions, &outIndices[cluster.firstFace * 3], cluster);
+		clusters.push_back(cluster);
+	}
+}
+}
+
+bool buildMeshClusters(Mesh& mesh, std::vector<MeshCluster>& clusters, uint32 maxVertices, uint32 maxFaces)
+{
+	clusters.clear();
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty() ||
+	    !mesh.getMeshInfo().isIndexed || !mesh.getFaces().getDataSize())
+	{
+		Log(Log.Error, "buildMeshClusters: Only indexed triangle lists can be split into clusters");
+		return false;
+	}
+	if (maxVertices < 3 || maxFaces < 1)
+	{
+		Log(Log.Error, "buildMeshClusters: A cluster must have room for at least one triangle");
+		return false;
+	}
+	if (mesh.hasDeferredData() && !mesh.loadDeferredData()) { return false; }
+	std::vector<glm::vec3> positions;
+	std::vector<uint32> indices;
+	if (!readPositions(mesh, positions, "buildMeshClusters") || !readIndices(mesh, indices, "buildMeshClusters"))
+	{
+		return false;
+	}
+
+	// The triangles that use each vertex.
+	const uint32 numVertices = mesh.getNumVertices();
+	std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+	std::vector<uint32> adjacency(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) { ++adjacencyOffsets[indices[i] + 1]; }
+	for (uint32 i = 0; i < numVertices; ++i) { adjacencyOffsets[i + 1] += adjacencyOffsets[i]; }
+	for (size_t i = 0; i < indices.size(); ++i) { adjacency[adjacencyOffsets[indices[i]]++] = (uint32)(i / 3); }
+	for (uint32 i = numVertices; i > 0; --i) { adjacencyOffsets[i] = adjacencyOffsets[i - 1]; }
+	adjacencyOffsets[0] = 0;
+
+	// Bone batches are drawn separately, so each is split on its own.
+	const Mesh::BoneBatches& boneBatches = mesh.getInternalData().boneBatches;
+	std::vector<uint8> emitted(mesh.getNumFaces(), 0);
+	std::vector<uint32> vertexCluster(numVertices, 0);
+	std::vector<uint32> outIndices;
+	outIndices.reserve(indices.size());
+	const uint32 numRanges = boneBatches.getCount() < 2 ? 1 : boneBatches.getCount();
+	for (uint32 i = 0; i < numRanges; ++i)
+	{
+		const uint32 beginFace = numRanges == 1 ? 0 : boneBatches.offsets[i];
+		const uint32 endFace = i + 1 < numRanges ? boneBatches.offsets[i + 1] : mesh.getNumFaces();
+		buildRangeClusters(positions, indices, adjacencyOffsets, adjacency, beginFace, endFace, maxVertices, maxFaces,
+		                   emitted, vertexCluster, outIndices, clusters);
+	}
+
+	Mesh::FaceData& faces = mesh.getFaces();
+	if (faces.getDataType() == types::IndexType::IndexType16Bit)
+	{
+		std::vector<uint16> narrow(outIndices.begin(), outIndices.end());
+		faces.setData((const byte*)narrow.data(), (uint32)(narrow.size() * 2), faces.getDataType());
+	}
+	else
+	{
+		faces.setData((const byte*)outIndices.data(), (uint32)(outIndices.size() * 4), faces.getDataType());
+	}
+	return true;
+}
+}
+}
+}
+//!\endcond
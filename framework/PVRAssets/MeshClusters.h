@@ -0,0 +1,70 @@
+/*!
+\brief Functions that split meshes into small clusters of triangles that can be culled individually.
+\file PVRAssets/MeshClusters.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model/Mesh.h"
+#include "PVRCore/Math/AxisAlignedBox.h"
+
+namespace pvr {
+namespace assets {
+namespace utils {
+/// <summary>A range of contiguous triangles of a mesh, with the bounds used to cull it.</summary>
+struct MeshCluster
+{
+	uint32 firstFace;    //!< The first triangle of the cluster in the faces of the mesh
+	uint32 numFaces;     //!< The number of triangles of the cluster
+	uint32 numVertices;  //!< The number of distinct vertices the triangles of the cluster use
+	glm::vec3 center;    //!< The center of the bounding sphere of the cluster, in model space
+	float32 radius;      //!< The radius of the bounding sphere of the cluster
+	glm::vec3 coneApex;  //!< The apex of the cone that contains the normals of the triangles of the cluster
+	glm::vec3 coneAxis;  //!< The axis of the normal cone
+	float32 coneCutoff;  //!< The sine of the angle of the normal cone. 1 if the cluster can never be backface culled.
+};
+
+/// <summary>Reorder the triangles of an indexed mesh into clusters of neighbouring triangles with a limited number of
+/// vertices and triangles, and compute the bounding sphere and normal cone of each cluster.</summary>
+/// <param name="mesh">An indexed triangle list mesh with a POSITION attribute. Its faces are reordered so that the
+/// triangles of each cluster are contiguous. Clusters never cross bone batches.</param>
+/// <param name="clusters">The clusters, in the order of the faces of the mesh</param>
+/// <param name="maxVertices">The largest number of distinct vertices of a cluster (at least 3)</param>
+/// <param name="maxFaces">The largest number of triangles of a cluster (at least 1)</param>
+/// <returns>True on success, false if the mesh is not an indexed triangle list or has no POSITION attribute
+/// </returns>
+/// <remarks>Bounds are in model space, after the unpack matrix of the mesh is applied to the positions. Running
+/// optimizeVertexCache before this function keeps the vertex cache efficiency of the clusters.</remarks>
+bool buildMeshClusters(Mesh& mesh, std::vector<MeshCluster>& clusters, uint32 maxVertices = 64, uint32 maxFaces = 124);
+
+/// <summary>Check if all the triangles of a cluster face away from the camera.</summary>
+/// <param name="cluster">A cluster</param>
+/// <param name="cameraPosition">The position of the camera, in the model space of the mesh</param>
+/// <returns>True if the cluster can be culled</returns>
+inline bool isClusterBackFacing(const MeshCluster& cluster, const glm::vec3& cameraPosition)
+{
+	const glm::vec3 direction = cluster.coneApex - cameraPosition;
+	return glm::dot(direction, cluster.coneAxis) >= cluster.coneCutoff * glm::length(direction);
+}
+
+/// <summary>Check if the bounding sphere of a cluster is completely outside a frustum.</summary>
+/// <param name="cluster">A cluster</param>
+/// <param name="frustum">A frustum in the model space of the mesh, with its planes pointing inwards (for example
+/// from math::getFrustumPlanes with a projection * view * model matrix)</param>
+/// <returns>True if the cluster can be culled</returns>
+inline bool isClusterOutsideFrustum(const MeshCluster& cluster, const math::Frustum& frustum)
+{
+	const glm::vec4* planes[] = { &frustum.minusX, &frustum.plusX, &frustum.minusY, &frustum.plusY, &frustum.minusZ,
+	                              &frustum.plusZ };
+	for (uint32 i = 0; i < 6; ++i)
+	{
+		if (math::distancePointToPlane(cluster.center, *planes[i]) < -cluster.radius * glm::length(glm::vec3(*planes[i])))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+}
+}
+}
@@ -0,0 +1,151 @@
+/*!
+\brief Internal helpers that read the vertex attributes and indices of a mesh for the mesh processing functions.
+\file PVRAssets/MeshDataHelpers.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Helper.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+
+//!\cond NO_DOXYGEN
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace internal {
+// Read the first indices.size() indices of the face data, without any check.
+inline void readIndexData(const Mesh::FaceData& faces, std::vector<uint32>& indices)
+{
+	const byte* data = faces.getData();
+	if (faces.getDataType() == types::IndexType::IndexType16Bit)
+	{
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			uint16 index;
+			memcpy(&index, data + i * 2, 2);
+			indices[i] = index;
+		}
+	}
+	else if (!indices.empty())
+	{
+		memcpy(indices.data(), data, indices.size() * 4);
+	}
+}
+
+// Read numIndices indices of a mesh as 32 bit values. A mesh that is not indexed uses its vertices in order. Fails,
+// logging an error prefixed with the name of the calling function, if the face data is too small or uses vertices
+// that the mesh does not have.
+inline bool readIndices(const Mesh& mesh, uint32 numIndices, std::vector<uint32>& indices, const char* function)
+{
+	indices.resize(numIndices);
+	if (!mesh.getMeshInfo().isIndexed)
+	{
+		for (uint32 i = 0; i < indices.size(); ++i) { indices[i] = i; }
+	}
+	else if (mesh.getFaces().getDataSize() < indices.size() * (mesh.getFaces().getDataTypeSize() / 8))
+	{
+		Log(Log.Error, "%s: The face data is smaller than the number of faces", function);
+		return false;
+	}
+	else
+	{
+		readIndexData(mesh.getFaces(), indices);
+	}
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (indices[i] >= mesh.getNumVertices())
+		{
+			Log(Log.Error, "%s: The mesh uses vertices that it does not have", function);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Read the indices of the triangles of a triangle list mesh.
+inline bool readIndices(const Mesh& mesh, std::vector<uint32>& indices, const char* function)
+{
+	return readIndices(mesh, mesh.getNumFaces() * 3, indices, function);
+}
+
+// Check that a mesh has an attribute whose data block exists.
+inline bool hasAttribute(const Mesh& mesh, const StringHash& semantic)
+{
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName(semantic);
+	return attribute && attribute->getDataIndex() >= 0 && (uint32)attribute->getDataIndex() < mesh.getNumDataElements();
+}
+
+// Find an attribute and check that its data covers all the vertices of the mesh. Fails, logging an error prefixed with
+// the name of the calling function, if the attribute is missing, has fewer than minComponents components or its data
+// is too small.
+inline const Mesh::VertexAttributeData* findAttribute(const Mesh& mesh, const StringHash& semantic,
+    uint32 minComponents, const char* function)
+{
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName(semantic);
+	if (!hasAttribute(mesh, semantic))
+	{
+		Log(Log.Error, "%s: The mesh has no %s attribute", function, semantic.c_str());
+		return NULL;
+	}
+	if (attribute->getN() < minComponents)
+	{
+		Log(Log.Error, "%s: The %s attribute has fewer than %d components", function, semantic.c_str(), minComponents);
+		return NULL;
+	}
+	const uint32 stride = mesh.getStride(attribute->getDataIndex());
+	const uint32 n = (std::min)(attribute->getN(), 4u);
+	if (!stride || !mesh.getData(attribute->getDataIndex()) ||
+	    mesh.getDataSize(attribute->getDataIndex()) < (size_t)mesh.getNumVertices() * stride ||
+	    attribute->getOffset() + types::dataTypeSize(attribute->getVertexLayout().dataType) * n > stride)
+	{
+		Log(Log.Error, "%s: The %s data is smaller than the number of vertices", function, semantic.c_str());
+		return NULL;
+	}
+	return attribute;
+}
+
+// Read the first components of an attribute of all the vertices, components floats per vertex.
+inline bool readAttribute(const Mesh& mesh, const StringHash& semantic, uint32 components,
+                          std::vector<float32>& values, const char* function)
+{
+	const Mesh::VertexAttributeData* attribute = findAttribute(mesh, semantic, components, function);
+	if (!attribute) { return false; }
+	const byte* data = static_cast<const byte*>(mesh.getData(attribute->getDataIndex())) + attribute->getOffset();
+	values.resize(mesh.getNumVertices() * components);
+	if (!values.empty())
+	{
+		VertexReadBatch(data, mesh.getStride(attribute->getDataIndex()), attribute->getVertexLayout().dataType,
+		                components, mesh.getNumVertices(), values.data(), components);
+	}
+	return true;
+}
+
+// Read the POSITION attribute of all the vertices in model units: quantized positions are unpacked with the unpack
+// matrix of the mesh. Missing components are zero.
+inline bool readPositions(const Mesh& mesh, std::vector<glm::vec3>& positions, const char* function)
+{
+	const Mesh::VertexAttributeData* position = findAttribute(mesh, "POSITION", 1, function);
+	if (!position) { return false; }
+	const uint32 stride = mesh.getStride(position->getDataIndex());
+	const uint32 components = (std::min)(position->getN(), 3u);
+	const glm::mat4& unpackMatrix = mesh.getUnpackMatrix();
+	const byte* data = static_cast<const byte*>(mesh.getData(position->getDataIndex())) + position->getOffset();
+	positions.assign(mesh.getNumVertices(), glm::vec3(0.0f));
+	if (!positions.empty())
+	{
+		VertexReadBatch(data, stride, position->getVertexLayout().dataType, components, mesh.getNumVertices(),
+		                &positions[0].x, 3);
+	}
+	for (uint32 i = 0; i < positions.size(); ++i)
+	{
+		for (uint32 c = components; c < 3; ++c) { positions[i][c] = 0.0f; }
+		positions[i] = glm::vec3(unpackMatrix * glm::vec4(positions[i], 1.0f));
+	}
+	return true;
+}
+}
+}
+}
+}
+//!\endcond
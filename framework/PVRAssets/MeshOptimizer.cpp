@@ -0,0 +1,875 @@
+/*!
+\brief Implementation of the mesh optimisation functions.
+\file PVRAssets/MeshOptimizer.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/MeshOptimizer.h"
+#include "PVRAssets/MeshDataHelpers.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace {
+using internal::readIndexData;
+using internal::readIndices;
+using internal::readPositions;
+
+typedef std::pair<uint32, uint32> TriangleRange;
+
+// The optimisations only understand triangle lists whose vertex data is fully in memory. Optimisations that only
+// touch the indices do not need the vertex data, so that they can run before deferred vertex data is loaded.
+bool checkMesh(Mesh& mesh, const char* function, bool requireIndexed, bool requireVertexData = true)
+{
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty())
+	{
+		Log(Log.Error, "%s: Only triangle lists can be optimised", function);
+		return false;
+	}
+	if (requireIndexed && (!mesh.getMeshInfo().isIndexed || !mesh.getFaces().getDataSize()))
+	{
+		Log(Log.Error, "%s: The mesh is not indexed", function);
+		return false;
+	}
+	if (!requireVertexData) { return true; }
+	if (mesh.hasDeferredData() && !mesh.loadDeferredData()) { return false; }
+	for (uint32 i = 0; i < mesh.getNumDataElements(); ++i)
+	{
+		if (mesh.getDataSize(i) && (!mesh.getStride(i) || mesh.getDataSize(i) < mesh.getNumVertices() * mesh.getStride(i)))
+		{
+			Log(Log.Error, "%s: Vertex data block %d is smaller than the number of vertices", function, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Read the indices of a triangle strip mesh, and the number of triangles of each of its strips. The strips follow
+// each other in the index data (or the vertex data, if the mesh is not indexed). A mesh without strip lengths is a
+// single strip.
+bool readStrips(const Mesh& mesh, std::vector<uint32>& indices, std::vector<uint32>& lengths, const char* function)
+{
+	const Mesh::MeshInfo& meshInfo = mesh.getMeshInfo();
+	if (meshInfo.primitiveType != types::PrimitiveTopology::TriangleStrip || meshInfo.usesPrimitiveRestart)
+	{
+		Log(Log.Error, "%s: Only triangle strips without primitive restart can be converted", function);
+		return false;
+	}
+	lengths = meshInfo.stripLengths;
+	if (lengths.empty()) { lengths.push_back(meshInfo.numFaces); }
+	uint64 numFaces = 0;
+	for (size_t i = 0; i < lengths.size(); ++i) { numFaces += lengths[i]; }
+	if (numFaces != meshInfo.numFaces)
+	{
+		Log(Log.Error, "%s: The strip lengths do not add up to the number of faces", function);
+		return false;
+	}
+	return readIndices(mesh, (uint32)(numFaces + lengths.size() * 2), indices, function);
+}
+
+void writeIndices(Mesh& mesh, const std::vector<uint32>& indices, types::IndexType indexType)
+{
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	meshInternalData.primitiveData.isIndexed = true;
+	if (indexType == types::IndexType::IndexType16Bit)
+	{
+		std::vector<uint16> narrow(indices.begin(), indices.end());
+		meshInternalData.faces.setData((const byte*)narrow.data(), (uint32)(narrow.size() * 2), indexType);
+	}
+	else
+	{
+		meshInternalData.faces.setData((const byte*)indices.data(), (uint32)(indices.size() * 4), indexType);
+	}
+}
+
+types::IndexType smallestIndexType(uint32 numVertices)
+{
+	return numVertices < 0xFFFF ? types::IndexType::IndexType16Bit : types::IndexType::IndexType32Bit;
+}
+
+// Triangles are only reordered within a bone batch, as each batch is drawn separately.
+void getTriangleRanges(const Mesh& mesh, std::vector<TriangleRange>& ranges)
+{
+	const Mesh::BoneBatches& boneBatches = mesh.getInternalData().boneBatches;
+	ranges.clear();
+	if (boneBatches.getCount() < 2)
+	{
+		ranges.push_back(TriangleRange(0, mesh.getNumFaces()));
+		return;
+	}
+	for (uint32 i = 0; i < boneBatches.getCount(); ++i)
+	{
+		ranges.push_back(TriangleRange(boneBatches.offsets[i], i + 1 < boneBatches.getCount() ?
+		                               boneBatches.offsets[i + 1] : mesh.getNumFaces()));
+	}
+}
+
+// Rebuild every data block with the vertices listed in newToOld. The levels of detail of the mesh index the old
+// vertices, so they are removed.
+void remapVertices(Mesh& mesh, const std::vector<uint32>& newToOld)
+{
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	mesh.clearLevelsOfDetail();
+	for (size_t i = 0; i < meshInternalData.vertexAttributeDataBlocks.size(); ++i)
+	{
+		StridedBuffer& block = meshInternalData.vertexAttributeDataBlocks[i];
+		const uint32 stride = block.stride;
+		if (block.empty() || !stride) { continue; }
+		UCharBuffer data(newToOld.size() * stride);
+		for (size_t j = 0; j < newToOld.size(); ++j)
+		{
+			memcpy(data.data() + j * stride, block.data() + newToOld[j] * stride, stride);
+		}
+		static_cast<UCharBuffer&>(block).swap(data);
+	}
+	meshInternalData.primitiveData.numVertices = (uint32)newToOld.size();
+}
+
+// Simulate a FIFO vertex cache. Returns the number of vertices of the triangle that missed the cache.
+class FifoCache
+{
+	std::vector<uint32> _timestamps;
+	uint32 _time;
+	uint32 _size;
+public:
+	FifoCache(uint32 numVertices, uint32 size) : _timestamps(numVertices, 0), _time(size + 1), _size(size) {}
+	void reset() { _time += _size + 1; }
+	uint32 addTriangle(const uint32* triangle)
+	{
+		uint32 misses = 0;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			if (_time - _timestamps[triangle[i]] > _size)
+			{
+				_timestamps[triangle[i]] = _time++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+};
+
+// Forsyth's scoring, see "Linear-Speed Vertex Cache Optimisation".
+const uint32 MaxCacheSize = 64;
+const float32 CacheDecayPower = 1.5f;
+const float32 LastTriangleScore = 0.75f;
+const float32 ValenceBoostScale = 2.0f;
+const float32 ValenceBoostPower = 0.5f;
+const uint32 MaxValenceScore = 32;
+
+const uint32 NoTriangles = 0xFFFFFFFFu;
+
+// Per vertex arrays of optimizeRangeForCache, sized to the vertices of the mesh once and shared by all its ranges.
+// Between ranges, remaining and filled are zero and firstTriangle is NoTriangles for every vertex.
+struct CacheOptimizerScratch
+{
+	std::vector<uint32> remaining, firstTriangle, filled;
+	std::vector<float32> vertexScores;
+	explicit CacheOptimizerScratch(uint32 numVertices) : remaining(numVertices, 0),
+		firstTriangle(numVertices, NoTriangles), filled(numVertices, 0), vertexScores(numVertices, 0.0f) {}
+};
+
+void optimizeRangeForCache(uint32* indices, uint32 numTriangles, CacheOptimizerScratch& scratch, uint32 cacheSize)
+{
+	if (numTriangles < 2) { return; }
+	float32 cacheScores[MaxCacheSize];
+	for (uint32 i = 0; i < cacheSize; ++i)
+	{
+		cacheScores[i] = i < 3 ? LastTriangleScore :
+		                 powf(1.0f - float32(i - 3) / float32(cacheSize - 3), CacheDecayPower);
+	}
+	float32 valenceScores[MaxValenceScore];
+	for (uint32 i = 0; i < MaxValenceScore; ++i) { valenceScores[i] = i ? ValenceBoostScale * powf(float32(i), -ValenceBoostPower) : 0.0f; }
+
+	// Triangles using each vertex, as offsets into one array. Only the vertices of the range are touched, so that
+	// the cost does not grow with the number of vertices of the mesh.
+	std::vector<uint32>& remaining = scratch.remaining;
+	std::vector<uint32>& firstTriangle = scratch.firstTriangle;
+	std::vector<uint32>& filled = scratch.filled;
+	std::vector<float32>& vertexScores = scratch.vertexScores;
+	for (uint32 i = 0; i < numTriangles * 3; ++i) { ++remaining[indices[i]]; }
+	uint32 offset = 0;
+	for (uint32 i = 0; i < numTriangles * 3; ++i)
+	{
+		const uint32 v = indices[i];
+		if (firstTriangle[v] == NoTriangles)
+		{
+			firstTriangle[v] = offset;
+			offset += remaining[v];
+		}
+	}
+	std::vector<uint32> vertexTriangles(numTriangles * 3);
+	for (uint32 i = 0; i < numTriangles * 3; ++i)
+	{
+		const uint32 v = indices[i];
+		vertexTriangles[firstTriangle[v] + filled[v]++] = i / 3;
+	}
+
+	struct Score
+	{
+		const float32* cacheScores;
+		const float32* valenceScores;
+		float32 operator()(int32 position, uint32 valence) const
+		{
+			if (!valence) { return -1.0f; }
+			float32 score = position < 0 ? 0.0f : cacheScores[position];
+			return score + valenceScores[(std::min)(valence, MaxValenceScore - 1)];
+		}
+	} score = { cacheScores, valenceScores };
+	for (uint32 i = 0; i < numTriangles * 3; ++i) { vertexScores[indices[i]] = score(-1, remaining[indices[i]]); }
+
+	std::vector<uint32> output(numTriangles * 3);
+	std::vector<bool> emitted(numTriangles, false);
+	uint32 cache[MaxCacheSize + 3], newCache[MaxCacheSize + 3];
+	uint32 cacheCount = 0, nextUnemitted = 0;
+	int32 bestTriangle = 0;
+	for (uint32 t = 0; t < numTriangles; ++t)
+	{
+		if (bestTriangle < 0)
+		{
+			// Nothing in the cache has triangles left: continue with the first triangle not emitted yet.
+			while (emitted[nextUnemitted]) { ++nextUnemitted; }
+			bestTriangle = (int32)nextUnemitted;
+		}
+		const uint32* triangle = indices + bestTriangle * 3;
+		memcpy(&output[t * 3], triangle, 12);
+		emitted[bestTriangle] = true;
+
+		uint32 newCount = 0;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			const uint32 v = triangle[i];
+			newCache[newCount++] = v;
+			uint32* begin = &vertexTriangles[firstTriangle[v]];
+			uint32* end = begin + remaining[v];
+			std::swap(*std::find(begin, end, (uint32)bestTriangle), *(end - 1));
+			--remaining[v];
+		}
+		for (uint32 i = 0; i < cacheCount; ++i)
+		{
+			const uint32 v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) { newCache[newCount++] = v; }
+		}
+		// Vertices pushed out of the cache lose their cache score.
+		for (uint32 i = cacheSize; i < newCount; ++i) { vertexScores[newCache[i]] = score(-1, remaining[newCache[i]]); }
+		cacheCount = (std::min)(newCount, cacheSize);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32));
+
+		for (uint32 i = 0; i < cacheCount; ++i) { vertexScores[cache[i]] = score((int32)i, remaining[cache[i]]); }
+		bestTriangle = -1;
+		float32 bestScore = -1.0f;
+		for (uint32 i = 0; i < newCount; ++i)
+		{
+			const uint32 v = newCache[i];
+			const uint32* triangles = &vertexTriangles[firstTriangle[v]];
+			for (uint32 j = 0; j < remaining[v]; ++j)
+			{
+				const uint32 tri = triangles[j];
+				const float32 triangleScore = vertexScores[indices[tri * 3]] + vertexScores[indices[tri * 3 + 1]] +
+				                              vertexScores[indices[tri * 3 + 2]];
+				if (triangleScore > bestScore)
+				{
+					bestScore = triangleScore;
+					bestTriangle = (int32)tri;
+				}
+			}
+		}
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32));
+	// Every triangle was emitted, so remaining is back to zero: reset the rest for the next range.
+	for (uint32 i = 0; i < numTriangles * 3; ++i)
+	{
+		filled[indices[i]] = 0;
+		firstTriangle[indices[i]] = NoTriangles;
+	}
+}
+
+struct Cluster
+{
+	uint32 begin, end;
+	float32 sortKey;
+};
+
+bool CompareClusters(const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; }
+
+void optimizeRangeForOverdraw(uint32* indices, uint32 numTriangles, const std::vector<glm::vec3>& positions,
+                              float32 threshold)
+{
+	if (numTriangles < 2) { return; }
+	const uint32 CacheSize = 16;
+	FifoCache cache((uint32)positions.size(), CacheSize);
+
+	// Hard boundaries: triangles whose three vertices miss the cache start a new cluster anyway.
+	std::vector<uint32> hardBoundaries;
+	for (uint32 i = 0; i < numTriangles; ++i)
+	{
+		if (cache.addTriangle(indices + i * 3) == 3) { hardBoundaries.push_back(i); }
+	}
+	if (hardBoundaries.empty() || hardBoundaries[0] != 0) { hardBoundaries.insert(hardBoundaries.begin(), 0); }
+	hardBoundaries.push_back(numTriangles);
+
+	// Soft boundaries: split the hard clusters wherever the cache miss ratio so far stays within the threshold.
+	std::vector<uint32> boundaries;
+	for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c)
+	{
+		const uint32 begin = hardBoundaries[c], end = hardBoundaries[c + 1];
+		cache.reset();
+		uint32 clusterMisses = 0;
+		for (uint32 i = begin; i < end; ++i) { clusterMisses += cache.addTriangle(indices + i * 3); }
+		const float32 targetRatio = threshold * float32(clusterMisses) / float32(end - begin);
+
+		cache.reset();
+		boundaries.push_back(begin);
+		uint32 runningBegin = begin, runningMisses = 0;
+		for (uint32 i = begin; i < end; ++i)
+		{
+			runningMisses += cache.addTriangle(indices + i * 3);
+			if (i + 1 < end && float32(runningMisses) <= targetRatio * float32(i + 1 - runningBegin))
+			{
+				boundaries.push_back(i + 1);
+				runningBegin = i + 1;
+				runningMisses = 0;
+				cache.reset();
+			}
+		}
+	}
+	boundaries.push_back(numTriangles);
+
+	// Sort the clusters by how much they face away from the centre of the mesh.
+	std::vector<Cluster> clusters(boundaries.size() - 1);
+	std::vector<glm::vec3> clusterCentroids(clusters.size()), clusterNormals(clusters.size());
+	glm::vec3 meshCentroid(0.0f);
+	float32 meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		clusters[c].begin = boundaries[c];
+		clusters[c].end = boundaries[c + 1];
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float32 area = 0.0f;
+		for (uint32 i = clusters[c].begin; i < clusters[c].end; ++i)
+		{
+			const glm::vec3& p0 = positions[indices[i * 3]];
+			const glm::vec3& p1 = positions[indices[i * 3 + 1]];
+			const glm::vec3& p2 = positions[indices[i * 3 + 2]];
+			const glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+			const float32 triangleArea = glm::length(triangleNormal);
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		clusterCentroids[c] = area > 0.0f ? centroid / area : positions[indices[clusters[c].begin * 3]];
+		clusterNormals[c] = normal;
+	}
+	if (meshArea > 0.0f) { meshCentroid /= meshArea; }
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		const float32 length = glm::length(clusterNormals[c]);
+		clusters[c].sortKey = length > 0.0f ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length) : 0.0f;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), CompareClusters);
+
+	std::vector<uint32> output;
+	output.reserve(numTriangles * 3);
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		output.insert(output.end(), indices + clusters[c].begin * 3, indices + clusters[c].end * 3);
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32));
+}
+
+// The bone index types that repackBoneBatches can rewrite.
+bool isBoneIndexType(types::DataType type)
+{
+	return type == types::DataType::UInt8 || type == types::DataType::Int8 || type == types::DataType::UBYTE4 ||
+	       type == types::DataType::UInt16 || type == types::DataType::Int16 || type == types::DataType::UInt32 ||
+	       type == types::DataType::Int32 || type == types::DataType::Float32;
+}
+
+void writeBoneIndex(byte* out, types::DataType type, uint32 value)
+{
+	switch (type)
+	{
+	case types::DataType::UInt8:
+	case types::DataType::Int8:
+	case types::DataType::UBYTE4:
+		*out = (byte)value;
+		break;
+	case types::DataType::UInt16:
+	case types::DataType::Int16:
+	{
+		const uint16 narrow = (uint16)value;
+		memcpy(out, &narrow, 2);
+	}
+	break;
+	case types::DataType::Float32:
+	{
+		const float32 converted = (float32)value;
+		memcpy(out, &converted, 4);
+	}
+	break;
+	default:
+		memcpy(out, &value, 4);
+		break;
+	}
+}
+}
+
+bool weldVertices(Mesh& mesh)
+{
+	if (!checkMesh(mesh, "weldVertices", false)) { return false; }
+	const uint32 numVertices = mesh.getNumVertices();
+	std::vector<uint32> indices;
+	if (!readIndices(mesh, indices, "weldVertices")) { return false; }
+	if (!numVertices) { return true; }
+
+	// The bytes of each vertex that belong to an attribute.
+	struct ByteRange { const byte* data; uint32 stride, offset, size; };
+	std::vector<ByteRange> ranges;
+	for (uint32 i = 0; i < mesh.getVertexAttributesSize(); ++i)
+	{
+		const Mesh::VertexAttributeData& attribute = *mesh.getVertexAttribute(i);
+		if (attribute.getDataIndex() < 0 || (uint32)attribute.getDataIndex() >= mesh.getNumDataElements()) { continue; }
+		const ByteRange range = { mesh.getData(attribute.getDataIndex()), mesh.getStride(attribute.getDataIndex()),
+		                          attribute.getOffset(), types::dataTypeSize(attribute.getVertexLayout().dataType) * attribute.getN()
+		                        };
+		if (range.data && range.offset + range.size <= range.stride) { ranges.push_back(range); }
+	}
+
+	std::vector<uint32> vertexBatch(numVertices, 0);
+	std::vector<TriangleRange> batches;
+	getTriangleRanges(mesh, batches);
+	for (uint32 b = 0; b < batches.size(); ++b)
+	{
+		for (uint32 i = batches[b].first * 3; i < batches[b].second * 3; ++i) { vertexBatch[indices[i]] = b; }
+	}
+
+	struct Key
+	{
+		const std::vector<ByteRange>& ranges;
+		const std::vector<uint32>& vertexBatch;
+		Key& operator=(const Key&);
+		uint32 hash(uint32 v) const
+		{
+			uint32 hash = 2166136261u ^ vertexBatch[v];
+			for (size_t r = 0; r < ranges.size(); ++r)
+			{
+				const byte* bytes = ranges[r].data + v * ranges[r].stride + ranges[r].offset;
+				for (uint32 i = 0; i < ranges[r].size; ++i) { hash = (hash ^ bytes[i]) * 16777619u; }
+			}
+			return hash;
+		}
+		bool equal(uint32 a, uint32 b) const
+		{
+			if (vertexBatch[a] != vertexBatch[b]) { return false; }
+			for (size_t r = 0; r < ranges.size(); ++r)
+			{
+				const byte* base = ranges[r].data + ranges[r].offset;
+				if (memcmp(base + a * ranges[r].stride, base + b * ranges[r].stride, ranges[r].size)) { return false; }
+			}
+			return true;
+		}
+	} key = { ranges, vertexBatch };
+
+	uint32 tableSize = 1;
+	while (tableSize < numVertices * 2) { tableSize *= 2; }
+	std::vector<uint32> table(tableSize, 0); // New vertex index + 1, 0 if empty
+	std::vector<uint32> remap(numVertices), newToOld;
+	for (uint32 v = 0; v < numVertices; ++v)
+	{
+		uint32 slot = key.hash(v) & (tableSize - 1);
+		while (table[slot] && !key.equal(newToOld[table[slot] - 1], v)) { slot = (slot + 1) & (tableSize - 1); }
+		if (!table[slot])
+		{
+			newToOld.push_back(v);
+			table[slot] = (uint32)newToOld.size();
+		}
+		remap[v] = table[slot] - 1;
+	}
+	for (size_t i = 0; i < indices.size(); ++i) { indices[i] = remap[indices[i]]; }
+
+	const types::IndexType indexType = mesh.getMeshInfo().isIndexed ? mesh.getFaces().getDataType() :
+	                                   smallestIndexType((uint32)newToOld.size());
+	if (newToOld.size() != numVertices) { remapVertices(mesh, newToOld); }
+	writeIndices(mesh, indices, indexType);
+	return true;
+}
+
+bool optimizeVertexCache(Mesh& mesh, uint32 cacheSize)
+{
+	if (!checkMesh(mesh, "optimizeVertexCache", true, false)) { return false; }
+	cacheSize = (std::max)(4u, (std::min)(cacheSize, MaxCacheSize));
+	std::vector<uint32> indices;
+	if (!readIndices(mesh, indices, "optimizeVertexCache")) { return false; }
+	std::vector<TriangleRange> ranges;
+	getTriangleRanges(mesh, ranges);
+	CacheOptimizerScratch scratch(mesh.getNumVertices());
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		optimizeRangeForCache(indices.data() + ranges[i].first * 3, ranges[i].second - ranges[i].first, scratch,
+		                      cacheSize);
+	}
+	writeIndices(mesh, indices, mesh.getFaces().getDataType());
+	return true;
+}
+
+bool optimizeOverdraw(Mesh& mesh, float32 threshold)
+{
+	if (!checkMesh(mesh, "optimizeOverdraw", true)) { return false; }
+	std::vector<glm::vec3> positions;
+	if (!readPositions(mesh, positions, "optimizeOverdraw")) { return false; }
+	std::vector<uint32> indices;
+	if (!readIndices(mesh, indices, "optimizeOverdraw")) { return false; }
+	std::vector<TriangleRange> ranges;
+	getTriangleRanges(mesh, ranges);
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		optimizeRangeForOverdraw(indices.data() + ranges[i].first * 3, ranges[i].second - ranges[i].first, positions,
+		                         (std::max)(threshold, 1.0f));
+	}
+	writeIndices(mesh, indices, mesh.getFaces().getDataType());
+	return true;
+}
+
+bool optimizeVertexFetch(Mesh& mesh)
+{
+	if (!checkMesh(mesh, "optimizeVertexFetch", true)) { return false; }
+	std::vector<uint32> indices;
+	if (!readIndices(mesh, indices, "optimizeVertexFetch")) { return false; }
+	std::vector<uint32> remap(mesh.getNumVertices(), uint32(-1)), newToOld;
+	newToOld.reserve(mesh.getNumVertices());
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		uint32& newIndex = remap[indices[i]];
+		if (newIndex == uint32(-1))
+		{
+			newIndex = (uint32)newToOld.size();
+			newToOld.push_back(indices[i]);
+		}
+		indices[i] = newIndex;
+	}
+	remapVertices(mesh, newToOld);
+	writeIndices(mesh, indices, mesh.getFaces().getDataType());
+	return true;
+}
+
+bool narrowIndices(Mesh& mesh)
+{
+	if (!mesh.getMeshInfo().isIndexed) { return false; }
+	if (mesh.getFaces().getDataType() == types::IndexType::IndexType16Bit) { return true; }
+	std::vector<uint32> indices(mesh.getFaces().getDataSize() / 4);
+	readIndexData(mesh.getFaces(), indices);
+	const bool usesPrimitiveRestart = mesh.getMeshInfo().usesPrimitiveRestart;
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (usesPrimitiveRestart && indices[i] == 0xFFFFFFFF) { indices[i] = 0xFFFF; }
+		else if (indices[i] >= 0xFFFF) { return false; }
+	}
+	writeIndices(mesh, indices, types::IndexType::IndexType16Bit);
+	return true;
+}
+
+bool repackBoneBatches(Mesh& mesh, uint32 maxBones)
+{
+	if (!checkMesh(mesh, "repackBoneBatches", true)) { return false; }
+	const Mesh::BoneBatches& oldBatches = mesh.getInternalData().boneBatches;
+	const Mesh::VertexAttributeData* boneIndex = mesh.getVertexAttributeByName("BONEINDEX");
+	if (!mesh.getMeshInfo().isSkinned || !oldBatches.getCount() || !boneIndex || boneIndex->getDataIndex() < 0 ||
+	    (uint32)boneIndex->getDataIndex() >= mesh.getNumDataElements() || !mesh.getData(boneIndex->getDataIndex()))
+	{
+		Log(Log.Error, "repackBoneBatches: The mesh is not skinned or has no bone batches");
+		return false;
+	}
+	const types::DataType indexType = boneIndex->getVertexLayout().dataType;
+	const uint32 indexStride = mesh.getStride(boneIndex->getDataIndex());
+	const uint32 numInfluences = indexType == types::DataType::UBYTE4 ? 4 : (std::min)(boneIndex->getN(), 4u);
+	const uint32 indexSize = indexType == types::DataType::UBYTE4 ? 1 : types::dataTypeSize(indexType);
+	if (!maxBones || !isBoneIndexType(indexType) || !numInfluences ||
+	    boneIndex->getOffset() + indexSize * numInfluences > indexStride)
+	{
+		Log(Log.Error, "repackBoneBatches: The bone indices are not in a supported format");
+		return false;
+	}
+	std::vector<uint32> indices;
+	if (!readIndices(mesh, indices, "repackBoneBatches")) { return false; }
+	const uint32 numVertices = mesh.getNumVertices();
+	const uint32 numTriangles = mesh.getNumFaces();
+	std::vector<TriangleRange> ranges;
+	getTriangleRanges(mesh, ranges);
+
+	// The bones of each vertex, in the batch of the triangles using it (a welded mesh never shares vertices between
+	// batches). Influences with a zero weight are marked unused.
+	const uint32 Unused = 0xFFFFFFFFu;
+	const Mesh::VertexAttributeData* boneWeight = mesh.getVertexAttributeByName("BONEWEIGHT");
+	const bool hasWeights = boneWeight && boneWeight->getDataIndex() >= 0 &&
+	                        (uint32)boneWeight->getDataIndex() < mesh.getNumDataElements() &&
+	                        mesh.getData(boneWeight->getDataIndex());
+	const uint32 numWeights = hasWeights ? (std::min)(boneWeight->getN(), 4u) : 0;
+	std::vector<uint32> vertexBones(numVertices * 4, Unused);
+	uint32 numNodes = 0;
+	for (uint32 b = 0; b < ranges.size(); ++b)
+	{
+		for (uint32 i = ranges[b].first * 3; i < (std::min)(ranges[b].second, numTriangles) * 3; ++i)
+		{
+			const uint32 v = indices[i];
+			float32 local[4], weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			VertexRead(mesh.getData(boneIndex->getDataIndex()) + v * indexStride + boneIndex->getOffset(), indexType,
+			           numInfluences, local);
+			if (numWeights)
+			{
+				VertexRead(mesh.getData(boneWeight->getDataIndex()) + v * mesh.getStride(boneWeight->getDataIndex()) +
+				           boneWeight->getOffset(), boneWeight->getVertexLayout().dataType, numWeights, weights);
+			}
+			for (uint32 j = 0; j < numInfluences; ++j)
+			{
+				if (j < numWeights && weights[j] == 0.0f) { continue; }
+				if (local[j] < 0.0f || (uint32)local[j] >= oldBatches.boneCounts[b])
+				{
+					Log(Log.Error, "repackBoneBatches: Vertex %d uses bone %d, which batch %d does not have", v,
+					    (int32)local[j], b);
+					return false;
+				}
+				vertexBones[v * 4 + j] = oldBatches.batches[b * oldBatches.boneBatchStride + (uint32)local[j]];
+				numNodes = (std::max)(numNodes, vertexBones[v * 4 + j] + 1);
+			}
+		}
+	}
+
+	// The sorted, distinct bones of each triangle, as offsets into one array.
+	std::vector<uint32> triangleBones, firstBone(numTriangles + 1, 0);
+	triangleBones.reserve(numTriangles * 4);
+	for (uint32 t = 0; t < numTriangles; ++t)
+	{
+		const size_t begin = triangleBones.size();
+		for (uint32 i = 0; i < 12; ++i)
+		{
+			const uint32 bone = vertexBones[indices[t * 3 + i / 4] * 4 + i % 4];
+			if (bone != Unused) { triangleBones.push_back(bone); }
+		}
+		std::sort(triangleBones.begin() + begin, triangleBones.end());
+		triangleBones.erase(std::unique(triangleBones.begin() + begin, triangleBones.end()), triangleBones.end());
+		firstBone[t + 1] = (uint32)triangleBones.size();
+		if (firstBone[t + 1] - firstBone[t] > maxBones)
+		{
+			Log(Log.Error, "repackBoneBatches: Triangle %d uses %d bones, more than the %d of a batch", t,
+			    firstBone[t + 1] - firstBone[t], maxBones);
+			return false;
+		}
+	}
+
+	// Grow each batch from the first triangle left, adding the triangle that needs the fewest new bones. Triangles
+	// needing none are added as soon as they are found.
+	std::vector<uint32> boneBatch(numNodes, Unused), batchBones, batchCounts, batchOffsets, triangleOrder;
+	std::vector<bool> batched(numTriangles, false);
+	triangleOrder.reserve(numTriangles);
+	uint32 firstLeft = 0;
+	while (firstLeft < numTriangles)
+	{
+		const uint32 batch = (uint32)batchCounts.size();
+		const size_t batchBegin = triangleOrder.size(), bonesBegin = batchBones.size();
+		batchOffsets.push_back((uint32)batchBegin);
+		for (uint32 t = firstLeft; t != Unused;)
+		{
+			batched[t] = true;
+			triangleOrder.push_back(t);
+			for (uint32 i = firstBone[t]; i < firstBone[t + 1]; ++i)
+			{
+				if (boneBatch[triangleBones[i]] != batch)
+				{
+					boneBatch[triangleBones[i]] = batch;
+					batchBones.push_back(triangleBones[i]);
+				}
+			}
+			const uint32 room = maxBones - (uint32)(batchBones.size() - bonesBegin);
+			uint32 best = Unused, bestNew = 0, bestShared = 0;
+			for (uint32 candidate = firstLeft; candidate < numTriangles; ++candidate)
+			{
+				if (batched[candidate]) { continue; }
+				uint32 shared = 0;
+				for (uint32 i = firstBone[candidate]; i < firstBone[candidate + 1]; ++i)
+				{
+					shared += boneBatch[triangleBones[i]] == batch;
+				}
+				const uint32 newBones = firstBone[candidate + 1] - firstBone[candidate] - shared;
+				if (!newBones)
+				{
+					batched[candidate] = true;
+					triangleOrder.push_back(candidate);
+				}
+				else if (newBones <= room && (best == Unused || newBones < bestNew ||
+				                              (newBones == bestNew && shared > bestShared)))
+				{
+					best = candidate;
+					bestNew = newBones;
+					bestShared = shared;
+				}
+			}
+			t = best;
+		}
+		std::sort(triangleOrder.begin() + batchBegin, triangleOrder.end());
+		std::sort(batchBones.begin() + bonesBegin, batchBones.end());
+		batchCounts.push_back((uint32)(batchBones.size() - bonesBegin));
+		while (firstLeft < numTriangles && batched[firstLeft]) { ++firstLeft; }
+	}
+
+	// Give each batch its own copy of the vertices it shares with a previous batch.
+	std::vector<uint32> newToOld(numVertices), newVertexBatch(numVertices, Unused), copies(numVertices, Unused);
+	for (uint32 v = 0; v < numVertices; ++v) { newToOld[v] = v; }
+	std::vector<uint32> newIndices(indices.size());
+	for (uint32 batch = 0, t = 0; batch < batchCounts.size(); ++batch)
+	{
+		const uint32 end = batch + 1 < batchCounts.size() ? batchOffsets[batch + 1] : numTriangles;
+		for (; t < end; ++t)
+		{
+			for (uint32 i = 0; i < 3; ++i)
+			{
+				const uint32 v = indices[triangleOrder[t] * 3 + i];
+				if (newVertexBatch[v] == Unused) { newVertexBatch[v] = batch; }
+				else if (newVertexBatch[v] != batch && (copies[v] == Unused || newVertexBatch[copies[v]] != batch))
+				{
+					copies[v] = (uint32)newToOld.size();
+					newToOld.push_back(v);
+					newVertexBatch.push_back(batch);
+				}
+				newIndices[t * 3 + i] = newVertexBatch[v] == batch ? v : copies[v];
+			}
+		}
+	}
+	if (newToOld.size() != numVertices) { remapVertices(mesh, newToOld); }
+
+	// Rewrite the bone indices relative to the new batches.
+	uint32 stride = 0;
+	std::vector<uint32> batchFirstBone(batchCounts.size() + 1, 0);
+	for (uint32 batch = 0; batch < batchCounts.size(); ++batch)
+	{
+		stride = (std::max)(stride, batchCounts[batch]);
+		batchFirstBone[batch + 1] = batchFirstBone[batch] + batchCounts[batch];
+	}
+	byte* indexData = mesh.getInternalData().vertexAttributeDataBlocks[boneIndex->getDataIndex()].data() +
+	                  boneIndex->getOffset();
+	for (uint32 v = 0; v < newToOld.size(); ++v)
+	{
+		if (newVertexBatch[v] == Unused) { continue; }
+		const uint32* bonesBegin = batchBones.data() + batchFirstBone[newVertexBatch[v]];
+		const uint32* bonesEnd = batchBones.data() + batchFirstBone[newVertexBatch[v] + 1];
+		for (uint32 j = 0; j < numInfluences; ++j)
+		{
+			const uint32 bone = vertexBones[newToOld[v] * 4 + j];
+			const uint32 local = bone == Unused ? 0 : (uint32)(std::lower_bound(bonesBegin, bonesEnd, bone) - bonesBegin);
+			writeBoneIndex(indexData + v * indexStride + j * indexSize, indexType, local);
+		}
+	}
+
+	Mesh::BoneBatches& newBatches = mesh.getInternalData().boneBatches;
+	newBatches.boneBatchStride = stride;
+	newBatches.batches.assign(batchCounts.size() * stride, 0);
+	for (uint32 batch = 0; batch < batchCounts.size(); ++batch)
+	{
+		std::copy(batchBones.begin() + batchFirstBone[batch], batchBones.begin() + batchFirstBone[batch + 1],
+		          newBatches.batches.begin() + batch * stride);
+	}
+	newBatches.boneCounts = batchCounts;
+	newBatches.offsets = batchOffsets;
+	mesh.clearLevelsOfDetail();
+	writeIndices(mesh, newIndices, mesh.getFaces().getDataType() == types::IndexType::IndexType32Bit ?
+	             types::IndexType::IndexType32Bit : smallestIndexType((uint32)newToOld.size()));
+	return true;
+}
+
+bool convertStripsToTriangleList(Mesh& mesh)
+{
+	std::vector<uint32> stripIndices, lengths;
+	if (!readStrips(mesh, stripIndices, lengths, "convertStripsToTriangleList")) { return false; }
+	const uint32 numFaces = mesh.getNumFaces();
+	// The first new triangle of each old one, to move the bone batches past the degenerate triangles dropped.
+	std::vector<uint32> newFaceOffsets;
+	newFaceOffsets.reserve(numFaces + 1);
+	std::vector<uint32> indices;
+	indices.reserve(numFaces * 3);
+	const uint32* strip = stripIndices.data();
+	for (size_t i = 0; i < lengths.size(); ++i)
+	{
+		for (uint32 j = 0; j < lengths[i]; ++j)
+		{
+			newFaceOffsets.push_back((uint32)(indices.size() / 3));
+			// Every other triangle of a strip is wound the other way.
+			const uint32 a = strip[j + (j & 1)], b = strip[j + 1 - (j & 1)], c = strip[j + 2];
+			if (a == b || b == c || c == a) { continue; }
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+		strip += lengths[i] + 2;
+	}
+	newFaceOffsets.push_back((uint32)(indices.size() / 3));
+
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	std::vector<uint32>& batchOffsets = meshInternalData.boneBatches.offsets;
+	for (size_t i = 0; i < batchOffsets.size(); ++i)
+	{
+		batchOffsets[i] = newFaceOffsets[(std::min)(batchOffsets[i], numFaces)];
+	}
+	const types::IndexType indexType = meshInternalData.primitiveData.isIndexed ? mesh.getFaces().getDataType() :
+	                                   smallestIndexType(mesh.getNumVertices());
+	meshInternalData.primitiveData.primitiveType = types::PrimitiveTopology::TriangleList;
+	meshInternalData.primitiveData.stripLengths.clear();
+	meshInternalData.primitiveData.numFaces = (uint32)(indices.size() / 3);
+	mesh.clearLevelsOfDetail();
+	writeIndices(mesh, indices, indexType);
+	return true;
+}
+
+bool joinStripsWithPrimitiveRestart(Mesh& mesh)
+{
+	if (mesh.getInternalData().boneBatches.getCount() > 1)
+	{
+		Log(Log.Error, "joinStripsWithPrimitiveRestart: The mesh has several bone batches, which are drawn separately");
+		return false;
+	}
+	std::vector<uint32> stripIndices, lengths;
+	if (!readStrips(mesh, stripIndices, lengths, "joinStripsWithPrimitiveRestart")) { return false; }
+	// 32 bit indices are kept, narrowIndices can convert them later.
+	const types::IndexType indexType = mesh.getMeshInfo().isIndexed &&
+	                                   mesh.getFaces().getDataType() == types::IndexType::IndexType32Bit ?
+	                                   types::IndexType::IndexType32Bit : smallestIndexType(mesh.getNumVertices());
+	const uint32 restartIndex = indexType == types::IndexType::IndexType16Bit ? 0xFFFF : 0xFFFFFFFF;
+	std::vector<uint32> indices;
+	indices.reserve(stripIndices.size() + lengths.size() - 1);
+	const uint32* strip = stripIndices.data();
+	for (size_t i = 0; i < lengths.size(); ++i)
+	{
+		if (i) { indices.push_back(restartIndex); }
+		indices.insert(indices.end(), strip, strip + lengths[i] + 2);
+		strip += lengths[i] + 2;
+	}
+
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	meshInternalData.primitiveData.stripLengths = lengths;
+	meshInternalData.primitiveData.usesPrimitiveRestart = true;
+	mesh.clearLevelsOfDetail();
+	writeIndices(mesh, indices, indexType);
+	return true;
+}
+
+bool optimizeMesh(Mesh& mesh)
+{
+	if (mesh.getPrimitiveType() == types::PrimitiveTopology::TriangleStrip && !convertStripsToTriangleList(mesh))
+	{
+		return false;
+	}
+	if (!weldVertices(mesh) || !optimizeVertexCache(mesh)) { return false; }
+	if (mesh.getVertexAttributeByName("POSITION") && !optimizeOverdraw(mesh)) { return false; }
+	if (!optimizeVertexFetch(mesh)) { return false; }
+	narrowIndices(mesh);
+	return true;
+}
+}
+}
+}
+//!\endcond
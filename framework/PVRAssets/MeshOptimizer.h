@@ -0,0 +1,98 @@
+/*!
+\brief Functions that reorder the vertex and index data of meshes so that they render faster.
+\file PVRAssets/MeshOptimizer.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model/Mesh.h"
+
+namespace pvr {
+namespace assets {
+namespace utils {
+/// <summary>Merge the vertices of a mesh whose attributes are identical, and index the mesh if it is not indexed.
+/// </summary>
+/// <param name="mesh">A triangle list mesh. Its data blocks and faces are replaced.</param>
+/// <returns>True on success, false if the mesh is not a triangle list or its vertex data is malformed</returns>
+/// <remarks>Only the bytes covered by vertex attributes are compared, so padding in the vertex data is ignored.
+/// Vertices of skinned meshes are only merged within the same bone batch, as bone indices are local to a batch.
+/// If vertices are merged, the levels of detail of the mesh are removed.</remarks>
+bool weldVertices(Mesh& mesh);
+
+/// <summary>Reorder the triangles of an indexed mesh so that their vertices are found in the post-transform vertex
+/// cache as often as possible (Tom Forsyth's linear-speed vertex cache optimisation).</summary>
+/// <param name="mesh">An indexed triangle list mesh. Triangles are reordered within each bone batch.</param>
+/// <param name="cacheSize">The number of vertices of the simulated cache (4 to 64)</param>
+/// <returns>True on success, false if the mesh is not an indexed triangle list</returns>
+bool optimizeVertexCache(Mesh& mesh, uint32 cacheSize = 32);
+
+/// <summary>Reorder clusters of triangles of an indexed mesh so that triangles facing outwards are drawn first,
+/// which reduces overdraw from most viewpoints (Sander et al., "Fast Triangle Reordering for Vertex Locality and
+/// Reduced Overdraw").</summary>
+/// <param name="mesh">An indexed triangle list mesh with a POSITION attribute, whose triangles were ordered with
+/// optimizeVertexCache. Clusters are reordered within each bone batch.</param>
+/// <param name="threshold">How much the vertex cache miss ratio of the mesh may grow so that it can be split into
+/// smaller clusters. 1.0 only splits the mesh where the vertex cache is flushed anyway.</param>
+/// <returns>True on success, false if the mesh is not an indexed triangle list or has no POSITION attribute</returns>
+bool optimizeOverdraw(Mesh& mesh, float32 threshold = 1.05f);
+
+/// <summary>Reorder the vertices of an indexed mesh in the order they are first used by its triangles, so that
+/// vertex fetches are as sequential as possible. Vertices that no triangle uses are removed.</summary>
+/// <param name="mesh">An indexed triangle list mesh. All of its data blocks are reordered, and its levels of detail
+/// are removed.</param>
+/// <returns>True on success, false if the mesh is not an indexed triangle list or its vertex data is malformed
+/// </returns>
+bool optimizeVertexFetch(Mesh& mesh);
+
+/// <summary>Convert the 32 bit indices of a mesh to 16 bit if all of them fit. 0xFFFF is kept free, so that it can
+/// be used as the primitive restart index.</summary>
+/// <param name="mesh">An indexed mesh. If it uses primitive restart, its restart indices are converted too.</param>
+/// <returns>True if the indices of the mesh are 16 bit after the call, otherwise false</returns>
+bool narrowIndices(Mesh& mesh);
+
+/// <summary>Re-partition the triangles of a skinned mesh into as few bone batches as possible, each using at most a
+/// given number of bones, so that the mesh is drawn with fewer draw calls.</summary>
+/// <param name="mesh">An indexed, skinned triangle list mesh with bone batches and a BONEINDEX attribute. Its bone
+/// batches, faces and bone indices are replaced, and its levels of detail are removed.</param>
+/// <param name="maxBones">The largest number of bones of a batch: the size of the bone palette of the shader</param>
+/// <returns>True on success, false if the mesh is not skinned, a triangle uses more than maxBones bones or the bone
+/// indices are malformed. The mesh is unchanged on failure.</returns>
+/// <remarks>Batches are grown greedily: each starts at the first triangle not batched yet and adds the triangle that
+/// brings the fewest new bones (sharing the most bones on ties) until the palette is full. Triangles keep their
+/// relative order within a batch. Influences with a zero weight are ignored. Vertices used by several of the new
+/// batches are duplicated, as bone indices are local to a batch. Run weldVertices afterwards to merge the copies of
+/// vertices that the old batches shared, then the other optimisations (optimizeMesh).</remarks>
+bool repackBoneBatches(Mesh& mesh, uint32 maxBones);
+
+/// <summary>Convert a mesh made of triangle strips to an indexed triangle list, so that it is drawn with a single
+/// draw call (per bone batch) and can be optimised with the other functions of this file.</summary>
+/// <param name="mesh">A triangle strip mesh, indexed or not, that does not use primitive restart. Its faces are
+/// replaced, its bone batches moved to the new triangles and its levels of detail removed.</param>
+/// <returns>True on success, false if the mesh is not made of triangle strips or its strips are malformed. The mesh
+/// is unchanged on failure.</returns>
+/// <remarks>Every other triangle of a strip has its first two vertices swapped, to keep the winding of the strip.
+/// Degenerate triangles, used to stitch strips together, are dropped. The index type of indexed meshes is kept;
+/// other meshes get the smallest index type that fits their vertices.</remarks>
+bool convertStripsToTriangleList(Mesh& mesh);
+
+/// <summary>Join the triangle strips of a mesh into one strip, separated by primitive restart indices (all bits
+/// set), so that it is drawn with a single draw call of getNumIndices() indices. The strip lengths are kept, and
+/// MeshInfo::usesPrimitiveRestart is set. Pipelines drawing the mesh must enable primitive restart, which needs
+/// Vulkan or OpenGL ES 3.0.</summary>
+/// <param name="mesh">A triangle strip mesh, indexed or not, with at most one bone batch. Its faces are replaced
+/// and its levels of detail removed.</param>
+/// <returns>True on success, false if the mesh is not made of triangle strips, its strips are malformed or it has
+/// several bone batches. The mesh is unchanged on failure.</returns>
+/// <remarks>Strips draw fewer indices than triangle lists, but cannot be reordered for the vertex cache: prefer
+/// convertStripsToTriangleList followed by optimizeVertexCache unless index data size matters most.</remarks>
+bool joinStripsWithPrimitiveRestart(Mesh& mesh);
+
+/// <summary>Run all the optimisations of this file on a mesh, in order: convertStripsToTriangleList (if the mesh is
+/// made of triangle strips), weldVertices, optimizeVertexCache, optimizeOverdraw (if the mesh has a POSITION
+/// attribute), optimizeVertexFetch and narrowIndices. Levels of detail are removed: generate them afterwards.</summary>
+/// <param name="mesh">A triangle list or triangle strip mesh</param>
+/// <returns>True on success, false if one of the steps failed. The mesh is left valid in either case.</returns>
+bool optimizeMesh(Mesh& mesh);
+}
+}
+}
@@ -0,0 +1,535 @@
+/*!
+\brief Implementation of the mesh simplification functions.
+\file PVRAssets/MeshSimplifier.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/MeshSimplifier.h"
+#include "PVRAssets/MeshDataHelpers.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace {
+using internal::readIndices;
+using internal::readPositions;
+
+// Manifold vertices can move onto any neighbour. Border and seam vertices only move along their border or seam.
+enum VertexKind { KindManifold, KindBorder, KindSeam, KindLocked };
+
+// Open edges also constrain the vertices to the plane perpendicular to their triangle, so that borders and seams
+// keep their shape. This is how much these planes weigh compared to the triangles.
+const float64 BoundaryWeight = 10.0;
+
+// The squared distance to a weighted sum of planes, as the quadratic form p.A.p + 2 b.p + c.
+struct Quadric
+{
+	float64 a00, a01, a02, a11, a12, a22;
+	float64 b0, b1, b2;
+	float64 c;
+	float64 weight;
+
+	Quadric() : a00(0), a01(0), a02(0), a11(0), a12(0), a22(0), b0(0), b1(0), b2(0), c(0), weight(0) {}
+
+	void addPlane(const glm::dvec3& normal, float64 distance, float64 planeWeight)
+	{
+		a00 += planeWeight * normal.x * normal.x;
+		a01 += planeWeight * normal.x * normal.y;
+		a02 += planeWeight * normal.x * normal.z;
+		a11 += planeWeight * normal.y * normal.y;
+		a12 += planeWeight * normal.y * normal.z;
+		a22 += planeWeight * normal.z * normal.z;
+		b0 += planeWeight * normal.x * distance;
+		b1 += planeWeight * normal.y * distance;
+		b2 += planeWeight * normal.z * distance;
+		c += planeWeight * distance * distance;
+		weight += planeWeight;
+	}
+
+	void add(const Quadric& other)
+	{
+		a00 += other.a00; a01 += other.a01; a02 += other.a02;
+		a11 += other.a11; a12 += other.a12; a22 += other.a22;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+	}
+
+	float64 evaluate(const glm::dvec3& p) const
+	{
+		const float64 result = p.x * (a00 * p.x + 2.0 * (a01 * p.y + a02 * p.z + b0)) +
+		                       p.y * (a11 * p.y + 2.0 * (a12 * p.z + b1)) + p.z * (a22 * p.z + 2.0 * b2) + c;
+		return result > 0.0 ? result : 0.0;
+	}
+};
+
+struct Collapse
+{
+	uint32 from;
+	uint32 to;
+	float64 error; // The root mean square distance to the planes of the two vertices
+};
+
+bool compareCollapses(const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; }
+
+// The directed edges of the triangles, sorted for binary search.
+class EdgeSet
+{
+	std::vector<uint64> _edges;
+public:
+	void build(const std::vector<uint32>& indices)
+	{
+		_edges.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (uint32 e = 0; e < 3; ++e)
+			{
+				_edges[i + e] = ((uint64)indices[i + e] << 32) | indices[i + (e + 1) % 3];
+			}
+		}
+		std::sort(_edges.begin(), _edges.end());
+	}
+	bool contains(uint32 from, uint32 to) const
+	{
+		return std::binary_search(_edges.begin(), _edges.end(), ((uint64)from << 32) | to);
+	}
+	// An edge is open if only one of its sides has a triangle.
+	bool isOpen(uint32 from, uint32 to) const { return contains(from, to) != contains(to, from); }
+};
+
+class Simplifier
+{
+	std::vector<glm::dvec3> _positions;
+	std::vector<uint32> _positionIds; // The lowest vertex with the same position as each vertex
+	std::vector<uint32> _nextWedge;   // The vertices with the same position form a circular list
+	std::vector<uint8> _kinds;
+	std::vector<Quadric> _quadrics;   // Indexed by position id
+	std::vector<uint32> _indices;
+	std::vector<uint32> _remap;
+	float64 _error;
+
+	bool comparePositions(uint32 lhs, uint32 rhs) const
+	{
+		const glm::dvec3& a = _positions[lhs];
+		const glm::dvec3& b = _positions[rhs];
+		if (a.x != b.x) { return a.x < b.x; }
+		if (a.y != b.y) { return a.y < b.y; }
+		if (a.z != b.z) { return a.z < b.z; }
+		return lhs < rhs;
+	}
+
+	struct PositionComparator
+	{
+		const Simplifier* simplifier;
+		bool operator()(uint32 lhs, uint32 rhs) const { return simplifier->comparePositions(lhs, rhs); }
+	};
+
+	void findWedges()
+	{
+		const uint32 numVertices = (uint32)_positions.size();
+		std::vector<uint32> order(numVertices);
+		for (uint32 i = 0; i < numVertices; ++i) { order[i] = i; }
+		PositionComparator comparator = { this };
+		std::sort(order.begin(), order.end(), comparator);
+		_positionIds.resize(numVertices);
+		_nextWedge.resize(numVertices);
+		for (uint32 first = 0; first < numVertices;)
+		{
+			uint32 last = first + 1;
+			while (last < numVertices && _positions[order[last]] == _positions[order[first]]) { ++last; }
+			for (uint32 i = first; i < last; ++i)
+			{
+				_positionIds[order[i]] = order[first];
+				_nextWedge[order[i]] = order[i + 1 < last ? i + 1 : first];
+			}
+			first = last;
+		}
+	}
+
+	void classifyVertices(const EdgeSet& edges)
+	{
+		const uint32 numVertices = (uint32)_positions.size();
+		std::vector<uint32> openOut(numVertices, 0), openIn(numVertices, 0);
+		std::vector<uint32> openOutTarget(numVertices, 0), openInSource(numVertices, 0);
+		for (size_t i = 0; i < _indices.size(); i += 3)
+		{
+			for (uint32 e = 0; e < 3; ++e)
+			{
+				const uint32 from = _indices[i + e], to = _indices[i + (e + 1) % 3];
+				if (!edges.contains(to, from))
+				{
+					++openOut[from];
+					openOutTarget[from] = to;
+					++openIn[to];
+					openInSource[to] = from;
+				}
+			}
+		}
+		_kinds.assign(numVertices, KindManifold);
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			if (_positionIds[v] != v) { continue; }
+			const uint32 other = _nextWedge[v];
+			uint8 kind = KindLocked;
+			if (other == v)
+			{
+				if (!openOut[v] && !openIn[v]) { kind = KindManifold; }
+				else if (openOut[v] == 1 && openIn[v] == 1) { kind = KindBorder; }
+			}
+			else if (_nextWedge[other] == v && openOut[v] == 1 && openIn[v] == 1 && openOut[other] == 1 &&
+			         openIn[other] == 1 && _positionIds[openOutTarget[v]] == _positionIds[openInSource[other]] &&
+			         _positionIds[openInSource[v]] == _positionIds[openOutTarget[other]])
+			{
+				// Two copies of the vertex, whose open edges are the two sides of the same seam.
+				kind = KindSeam;
+			}
+			uint32 wedge = v;
+			do
+			{
+				_kinds[wedge] = kind;
+				wedge = _nextWedge[wedge];
+			}
+			while (wedge != v);
+		}
+	}
+
+	void computeQuadrics(const EdgeSet& edges)
+	{
+		_quadrics.resize(_positions.size());
+		for (size_t i = 0; i < _indices.size(); i += 3)
+		{
+			const glm::dvec3& p0 = _positions[_indices[i]];
+			const glm::dvec3& p1 = _positions[_indices[i + 1]];
+			const glm::dvec3& p2 = _positions[_indices[i + 2]];
+			glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float64 length = glm::length(normal);
+			if (length == 0.0) { continue; }
+			normal /= length;
+			for (uint32 e = 0; e < 3; ++e)
+			{
+				_quadrics[_positionIds[_indices[i + e]]].addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+			}
+			for (uint32 e = 0; e < 3; ++e)
+			{
+				const uint32 from = _indices[i + e], to = _indices[i + (e + 1) % 3];
+				if (edges.contains(to, from)) { continue; }
+				const glm::dvec3 edge = _positions[to] - _positions[from];
+				glm::dvec3 edgeNormal = glm::cross(edge, normal);
+				const float64 edgeLength = glm::length(edgeNormal);
+				if (edgeLength == 0.0) { continue; }
+				edgeNormal /= edgeLength;
+				const float64 distance = -glm::dot(edgeNormal, _positions[from]);
+				const float64 weight = glm::dot(edge, edge) * BoundaryWeight;
+				_quadrics[_positionIds[from]].addPlane(edgeNormal, distance, weight);
+				_quadrics[_positionIds[to]].addPlane(edgeNormal, distance, weight);
+			}
+		}
+	}
+
+	void addCandidate(uint32 from, uint32 to, const EdgeSet& edges, std::vector<Collapse>& collapses) const
+	{
+		const uint32 fromPosition = _positionIds[from], toPosition = _positionIds[to];
+		if (fromPosition == toPosition || _kinds[from] == KindLocked) { return; }
+		if (_kinds[from] != KindManifold && (!edges.isOpen(from, to) || _kinds[to] == KindManifold)) { return; }
+		Collapse collapse;
+		collapse.from = from;
+		collapse.to = to;
+		const float64 weight = _quadrics[fromPosition].weight + _quadrics[toPosition].weight;
+		const float64 cost = _quadrics[fromPosition].evaluate(_positions[to]) + _quadrics[toPosition].evaluate(_positions[to]);
+		collapse.error = weight > 0.0 ? sqrt(cost / weight) : 0.0;
+		collapses.push_back(collapse);
+	}
+
+	// Find where each copy of the collapsed vertex goes. Seam vertices move their two copies along the two sides of
+	// the seam.
+	bool mapWedges(const Collapse& collapse, const EdgeSet& edges, uint32* targets, uint32& numTargets) const
+	{
+		numTargets = 0;
+		if (_kinds[collapse.from] != KindSeam)
+		{
+			targets[numTargets++] = collapse.from;
+			targets[numTargets++] = collapse.to;
+			return true;
+		}
+		uint32 wedge = collapse.from;
+		do
+		{
+			uint32 target = collapse.to;
+			bool found = false;
+			do
+			{
+				if (edges.isOpen(wedge, target)) { found = true; break; }
+				target = _nextWedge[target];
+			}
+			while (target != collapse.to);
+			if (!found) { return false; }
+			targets[numTargets++] = wedge;
+			targets[numTargets++] = target;
+			wedge = _nextWedge[wedge];
+		}
+		while (wedge != collapse.from);
+		return true;
+	}
+
+public:
+	Simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32>& indices) :
+		_positions(positions.begin(), positions.end()), _indices(indices), _remap(positions.size()), _error(0.0)
+	{
+		for (uint32 i = 0; i < _remap.size(); ++i) { _remap[i] = i; }
+		findWedges();
+		EdgeSet edges;
+		edges.build(_indices);
+		classifyVertices(edges);
+		computeQuadrics(edges);
+	}
+
+	const std::vector<uint32>& getIndices() const { return _indices; }
+	uint32 getNumFaces() const { return (uint32)(_indices.size() / 3); }
+	float32 getError() const { return (float32)_error; }
+
+	// Collapse edges until the mesh has at most targetFaces triangles, or no edge can be collapsed.
+	void simplify(uint32 targetFaces, float64 maxError)
+	{
+		const uint32 numVertices = (uint32)_positions.size();
+		EdgeSet edges;
+		std::vector<Collapse> collapses;
+		std::vector<uint32> adjacencyOffsets, adjacency;
+		std::vector<uint8> locked(numVertices);
+		while (getNumFaces() > targetFaces)
+		{
+			edges.build(_indices);
+
+			// The triangles around each position.
+			adjacencyOffsets.assign(numVertices + 1, 0);
+			for (size_t i = 0; i < _indices.size(); ++i) { ++adjacencyOffsets[_positionIds[_indices[i]] + 1]; }
+			for (uint32 i = 0; i < numVertices; ++i) { adjacencyOffsets[i + 1] += adjacencyOffsets[i]; }
+			adjacency.resize(_indices.size());
+			for (size_t i = 0; i < _indices.size(); ++i)
+			{
+				adjacency[adjacencyOffsets[_positionIds[_indices[i]]]++] = (uint32)(i / 3);
+			}
+			for (uint32 i = numVertices; i > 0; --i) { adjacencyOffsets[i] = adjacencyOffsets[i - 1]; }
+			adjacencyOffsets[0] = 0;
+
+			collapses.clear();
+			for (size_t i = 0; i < _indices.size(); i += 3)
+			{
+				for (uint32 e = 0; e < 3; ++e)
+				{
+					const uint32 a = _indices[i + e], b = _indices[i + (e + 1) % 3];
+					addCandidate(a, b, edges, collapses);
+					addCandidate(b, a, edges, collapses);
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), compareCollapses);
+
+			// Each pass collapses the cheapest edges whose neighbourhoods do not overlap, so that the checks below
+			// see the triangles as they will be. Collapses much more expensive than the ones that would reach the
+			// target on their own wait for the next pass, where cheaper ones may have become available.
+			if (collapses.empty()) { break; }
+			const uint32 facesToRemove = getNumFaces() - targetFaces;
+			const float64 errorLimit = (std::min)(collapses[(std::min)(collapses.size(), (size_t)facesToRemove) - 1].error * 1.5,
+			                                      maxError);
+			uint32 facesRemoved = 0;
+			uint32 numCollapsed = 0;
+			std::fill(locked.begin(), locked.end(), 0);
+			for (size_t c = 0; c < collapses.size() && facesRemoved < facesToRemove; ++c)
+			{
+				const Collapse& collapse = collapses[c];
+				const uint32 fromPosition = _positionIds[collapse.from], toPosition = _positionIds[collapse.to];
+				if (locked[fromPosition] || locked[toPosition]) { continue; }
+				if (collapse.error > errorLimit) { break; }
+				uint32 targets[8];
+				uint32 numTargets;
+				if (!mapWedges(collapse, edges, targets, numTargets)) { continue; }
+
+				// Reject collapses that flip a triangle over.
+				bool flips = false;
+				uint32 removed = 0;
+				for (uint32 t = adjacencyOffsets[fromPosition]; t < adjacencyOffsets[fromPosition + 1] && !flips; ++t)
+				{
+					const uint32* triangle = &_indices[adjacency[t] * 3];
+					glm::dvec3 before[3], after[3];
+					bool degenerate = false;
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						before[k] = after[k] = _positions[triangle[k]];
+						if (_positionIds[triangle[k]] == fromPosition) { after[k] = _positions[collapse.to]; }
+						if (_positionIds[triangle[k]] == toPosition) { degenerate = true; }
+					}
+					if (degenerate) { ++removed; continue; }
+					const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips = glm::dot(normalBefore, normalAfter) <= 0.0;
+				}
+				if (flips) { continue; }
+
+				for (uint32 i = 0; i < numTargets; i += 2) { _remap[targets[i]] = targets[i + 1]; }
+				_quadrics[toPosition].add(_quadrics[fromPosition]);
+				locked[fromPosition] = locked[toPosition] = 1;
+				for (uint32 t = adjacencyOffsets[fromPosition]; t < adjacencyOffsets[fromPosition + 1]; ++t)
+				{
+					for (uint32 k = 0; k < 3; ++k) { locked[_positionIds[_indices[adjacency[t] * 3 + k]]] = 1; }
+				}
+				_error = (std::max)(_error, collapse.error);
+				facesRemoved += removed;
+				++numCollapsed;
+			}
+			if (!numCollapsed) { break; }
+
+			// Apply the collapses and remove the triangles that became degenerate.
+			size_t written = 0;
+			for (size_t i = 0; i < _indices.size(); i += 3)
+			{
+				const uint32 i0 = _remap[_indices[i]], i1 = _remap[_indices[i + 1]], i2 = _remap[_indices[i + 2]];
+				if (_positionIds[i0] == _positionIds[i1] || _positionIds[i1] == _positionIds[i2] ||
+				    _positionIds[i2] == _positionIds[i0])
+				{
+					continue;
+				}
+				_indices[written++] = i0;
+				_indices[written++] = i1;
+				_indices[written++] = i2;
+			}
+			_indices.resize(written);
+			for (uint32 i = 0; i < numVertices; ++i) { _remap[i] = i; }
+		}
+	}
+};
+
+void setFaces(Mesh::FaceData& faces, const std::vector<uint32>& indices, types::IndexType indexType)
+{
+	if (indexType == types::IndexType::IndexType16Bit)
+	{
+		std::vector<uint16> narrow(indices.begin(), indices.end());
+		faces.setData((const byte*)narrow.data(), (uint32)(narrow.size() * 2), indexType);
+	}
+	else
+	{
+		faces.setData((const byte*)indices.data(), (uint32)(indices.size() * 4), indexType);
+	}
+}
+
+// Reorder the vertices so that the least detailed level comes first, followed by the vertices that each more
+// detailed level adds. Returns the number of vertices each level uses.
+void sortVerticesByLevel(Mesh& mesh, std::vector<uint32>& meshIndices, std::vector<std::vector<uint32> >& levels,
+                         std::vector<uint32>& levelVertexCounts)
+{
+	const uint32 numVertices = mesh.getNumVertices();
+	std::vector<uint32> oldToNew(numVertices, 0xFFFFFFFFu);
+	std::vector<uint32> newToOld;
+	newToOld.reserve(numVertices);
+	levelVertexCounts.resize(levels.size());
+	for (size_t level = levels.size(); level > 0; --level)
+	{
+		const std::vector<uint32>& indices = levels[level - 1];
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			if (oldToNew[indices[i]] == 0xFFFFFFFFu)
+			{
+				oldToNew[indices[i]] = (uint32)newToOld.size();
+				newToOld.push_back(indices[i]);
+			}
+		}
+		levelVertexCounts[level - 1] = (uint32)newToOld.size();
+	}
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		if (oldToNew[i] == 0xFFFFFFFFu)
+		{
+			oldToNew[i] = (uint32)newToOld.size();
+			newToOld.push_back(i);
+		}
+	}
+
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	for (size_t i = 0; i < meshInternalData.vertexAttributeDataBlocks.size(); ++i)
+	{
+		StridedBuffer& block = meshInternalData.vertexAttributeDataBlocks[i];
+		const uint32 stride = block.stride;
+		if (block.size() < (size_t)numVertices * stride || !stride) { continue; }
+		UCharBuffer data(block.size());
+		for (uint32 j = 0; j < numVertices; ++j)
+		{
+			memcpy(data.data() + j * stride, block.data() + newToOld[j] * stride, stride);
+		}
+		memcpy(data.data() + numVertices * stride, block.data() + numVertices * stride, block.size() - numVertices * stride);
+		static_cast<UCharBuffer&>(block).swap(data);
+	}
+	for (size_t i = 0; i < meshIndices.size(); ++i) { meshIndices[i] = oldToNew[meshIndices[i]]; }
+	for (size_t level = 0; level < levels.size(); ++level)
+	{
+		for (size_t i = 0; i < levels[level].size(); ++i) { levels[level][i] = oldToNew[levels[level][i]]; }
+	}
+}
+}
+
+bool generateLevelsOfDetail(Mesh& mesh, const LevelOfDetailOptions& options)
+{
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty() ||
+	    !mesh.getMeshInfo().isIndexed || !mesh.getFaces().getDataSize())
+	{
+		Log(Log.Error, "generateLevelsOfDetail: Only indexed triangle lists can be simplified");
+		return false;
+	}
+	if (mesh.getInternalData().boneBatches.getCount() > 1)
+	{
+		Log(Log.Error, "generateLevelsOfDetail: Meshes with more than one bone batch are not supported");
+		return false;
+	}
+	if (options.reduction <= 0.0f || options.reduction >= 1.0f)
+	{
+		Log(Log.Error, "generateLevelsOfDetail: The reduction must be between 0 and 1");
+		return false;
+	}
+	if (mesh.hasDeferredData() && !mesh.loadDeferredData()) { return false; }
+	std::vector<glm::vec3> positions;
+	std::vector<uint32> indices;
+	if (!readPositions(mesh, positions, "generateLevelsOfDetail") || !readIndices(mesh, indices, "generateLevelsOfDetail"))
+	{
+		return false;
+	}
+	mesh.clearLevelsOfDetail();
+
+	Simplifier simplifier(positions, indices);
+	std::vector<std::vector<uint32> > levels;
+	std::vector<float32> levelErrors;
+	uint32 numFaces = mesh.getNumFaces();
+	while (levels.size() < options.maxLevels)
+	{
+		const uint32 targetFaces = (uint32)(numFaces * options.reduction);
+		if (targetFaces < options.minFaces) { break; }
+		simplifier.simplify(targetFaces, options.maxError);
+		// Stop if the simplification got stuck well before the target.
+		if (simplifier.getNumFaces() > numFaces - (numFaces - targetFaces) / 2) { break; }
+		levels.push_back(simplifier.getIndices());
+		levelErrors.push_back(simplifier.getError());
+		numFaces = simplifier.getNumFaces();
+	}
+
+	std::vector<uint32> levelVertexCounts(levels.size(), mesh.getNumVertices());
+	if (options.reorderVertices && !levels.empty())
+	{
+		sortVerticesByLevel(mesh, indices, levels, levelVertexCounts);
+		setFaces(mesh.getFaces(), indices, mesh.getFaces().getDataType());
+	}
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		Mesh::LevelOfDetail levelOfDetail;
+		setFaces(levelOfDetail.faces, levels[i], mesh.getFaces().getDataType());
+		levelOfDetail.numFaces = (uint32)(levels[i].size() / 3);
+		levelOfDetail.numVertices = levelVertexCounts[i];
+		levelOfDetail.error = levelErrors[i];
+		mesh.addLevelOfDetail(levelOfDetail);
+	}
+	return true;
+}
+}
+}
+}
+//!\endcond
@@ -0,0 +1,55 @@
+/*!
+\brief Functions that generate reduced versions of meshes, to be drawn when the meshes are far away.
+\file PVRAssets/MeshSimplifier.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model/Mesh.h"
+#include <limits>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+/// <summary>Controls how many levels of detail generateLevelsOfDetail creates, and how reduced they are.</summary>
+struct LevelOfDetailOptions
+{
+	/// <summary>The largest number of levels of detail to generate. Default 4.</summary>
+	uint32 maxLevels;
+	/// <summary>The number of triangles of each level of detail, as a fraction of the previous one. Default 0.5.
+	/// </summary>
+	float32 reduction;
+	/// <summary>No level of detail with fewer triangles than this is generated. Default 32.</summary>
+	uint32 minFaces;
+	/// <summary>The largest error allowed, in model units. The simplification stops when no triangle can be removed
+	/// without exceeding it. Default: no limit.</summary>
+	float32 maxError;
+	/// <summary>If true (default), the vertices of the mesh are reordered so that each level of detail only uses the
+	/// first LevelOfDetail::numVertices vertices, which can then be drawn from a smaller range of the vertex data.
+	/// </summary>
+	bool reorderVertices;
+
+	/// <summary>Constructor. Halves the number of triangles up to four times.</summary>
+	LevelOfDetailOptions() : maxLevels(4), reduction(0.5f), minFaces(32), maxError((std::numeric_limits<float32>::max)()),
+		reorderVertices(true) {}
+};
+
+/// <summary>Generate a chain of levels of detail for a mesh by repeatedly collapsing the edges whose removal
+/// changes the surface the least, measured with quadric error metrics (Garland and Heckbert, "Surface Simplification
+/// Using Quadric Error Metrics"). The levels of detail are stored in the mesh (Mesh::getLevelOfDetail), with their
+/// error so that they can be selected by their size on screen (Mesh::selectLevelOfDetail).</summary>
+/// <param name="mesh">An indexed triangle list mesh with a POSITION attribute, with at most one bone batch. Its
+/// existing levels of detail are replaced.</param>
+/// <param name="options">How many levels of detail to generate, and how reduced they are</param>
+/// <returns>True on success, even if the mesh could not be reduced at all. False if the mesh is not supported.
+/// </returns>
+/// <remarks>Vertices are never moved or created: each edge collapse moves one vertex onto a neighbour, so the
+/// attributes of the remaining vertices are unchanged. Vertices on the border of the mesh only move along the
+/// border, and vertices on a seam (the same position with different normals or texture coordinates) only move along
+/// the seam, together with their copies on the other side of it, so that seams do not open. Vertices whose position
+/// differs in any bit are considered distinct: call weldVertices first on meshes that are not indexed. Functions
+/// that reorder the vertices or triangles of the mesh afterwards invalidate its levels of detail.</remarks>
+bool generateLevelsOfDetail(Mesh& mesh, const LevelOfDetailOptions& options = LevelOfDetailOptions());
+}
+}
+}
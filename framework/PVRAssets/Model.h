@@ -532,6 +532,9 @@ public:
 		/// <returns>Return reference to the internal data</returns>
 		InternalData& getInternalData() { return _data; }
 
+		/// <summary>Return a const reference to the material's internal data structure.</summary>
+		const InternalData& getInternalData() const { return _data; }
+
 	private:
 		//uint32  flags;
 		UCharBuffer userData;
@@ -578,6 +581,20 @@ public:
 		}
 	};
 public:
+	/// <summary>Read the vertex data of all meshes that was deferred when the model was loaded (see
+	/// ModelLoadOptions::deferVertexData). Otherwise, the data of each mesh is read the first time it is accessed.
+	/// </summary>
+	/// <returns>True if all the data was read, false if any could not be read.</returns>
+	bool loadDeferredVertexData()
+	{
+		bool result = true;
+		for (uint32 i = 0; i < getNumMeshes(); ++i)
+		{
+			result = getMesh(i).loadDeferredData() && result;
+		}
+		return result;
+	}
+
 	void releaseVertexData()
 	{
 		for (uint32 i = 0; i < getNumMeshes(); ++i)
@@ -962,6 +979,9 @@ public:
 	/// <returns>Return internal data</returns>
 	InternalData& getInternalData() { return _data; }
 
+	/// <summary>Get a const reference to the internal data of this Model.</summary>
+	const InternalData& getInternalData() const { return _data; }
+
 	/// <summary>Get the properties of a camera. This is additional info on the class (remarks or documentation).
 	/// </summary>
 	/// <param name="cameraIdx">The index of the camera.</param>
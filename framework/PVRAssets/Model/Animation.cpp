@@ -9,9 +9,64 @@
 
 #include "PVRAssets/Model/Animation.h"
 #include "PVRCore/Maths.h"
+#include <algorithm>
 
 namespace pvr {
 namespace assets {
+namespace {
+// The number of floats of a key of each track, and between the keys of consecutive frames of tracks that are not
+// indexed.
+const uint32 TrackWidths[Animation::NumTrackTypes] = { 3, 4, 3, 16 };
+const uint32 TrackStrides[Animation::NumTrackTypes] = { 3, 4, 7, 16 };
+
+// List the keys of a track: a new key starts at each frame whose data differs from the data of the previous key.
+bool buildKeyTimes(const std::vector<float32>& data, const std::vector<uint32>& indices, Animation::TrackType track,
+                   uint32 numFrames, Animation::KeyTimes& keyTimes)
+{
+	keyTimes.frames.clear();
+	keyTimes.offsets.clear();
+	const uint32 width = TrackWidths[track];
+	for (uint32 frame = 0; frame < numFrames; ++frame)
+	{
+		const size_t offset = indices.empty() ? (size_t)frame * TrackStrides[track] :
+		                      (frame < indices.size() ? indices[frame] : data.size());
+		if (offset + width > data.size()) { return false; }
+		if (!keyTimes.offsets.empty())
+		{
+			const uint32 last = keyTimes.offsets.back();
+			if (offset == last || !memcmp(&data[offset], &data[last], width * sizeof(float32))) { continue; }
+		}
+		keyTimes.frames.push_back(frame);
+		keyTimes.offsets.push_back((uint32)offset);
+	}
+	return true;
+}
+
+// The data of the key of a frame, and of the next key if the frame is interpolated with it: only when the next key
+// starts at the next frame, as in the frame by frame lookups of Animation. Otherwise next is NULL.
+inline const float32* sampleKeys(const Animation::KeyTimes& keyTimes, const std::vector<float32>& data, uint32 frame,
+                                 uint32& key, const float32*& next)
+{
+	if (keyTimes.frames.empty())
+	{
+		next = NULL;
+		return data.data();
+	}
+	key = utils::internal::findKeyFrom(keyTimes.frames, frame, key);
+	next = key + 1 < keyTimes.frames.size() && keyTimes.frames[key + 1] == frame + 1 ?
+	       &data[keyTimes.offsets[key + 1]] : NULL;
+	return &data[keyTimes.offsets[key]];
+}
+
+inline glm::vec3 sampleVector(const Animation::KeyTimes& keyTimes, const std::vector<float32>& data, uint32 frame,
+                              float32 interp, uint32& key)
+{
+	const float32* next;
+	const glm::vec3 v0(glm::make_vec3(sampleKeys(keyTimes, data, frame, key, next)));
+	return next ? glm::mix(v0, glm::make_vec3(next), interp) : v0;
+}
+}
+
 glm::mat4x4 Animation::getTranslationMatrix(uint32 frame, float32 interp) const
 {
 	if (_data.positions.size())
@@ -158,6 +213,79 @@ glm::mat4x4 Animation::getTransformationMatrix(uint32 frame, float32 interp) con
 	}
 }
 
+glm::mat4x4 Animation::getTransformationMatrix(uint32 frame, float32 interp, uint32* keys) const
+{
+	if (!_hasKeyIndex) { return getTransformationMatrix(frame, interp); }
+	// The same choice of data as getTransformationMatrix.
+	const uint32 transformFlags = HasPositionAnimation | HasRotationAnimation | HasScaleAnimation;
+	if (_data.matrices.size() &&
+	    ((_data.flags & HasMatrixAnimation) || (_data.flags & transformFlags) != transformFlags))
+	{
+		const float32* next;
+		return glm::make_mat4(sampleKeys(_keyTimes[MatrixTrack], _data.matrices, frame, keys[MatrixTrack], next));
+	}
+	internal::optimizedMat4 m1(glm::mat4x4(1.0f)), m2(glm::mat4x4(1.0f)), m3(glm::mat4x4(1.0f));
+	if (_data.positions.size())
+	{
+		m1 = internal::optimizedMat4(glm::translate(sampleVector(_keyTimes[PositionTrack], _data.positions, frame,
+		                             interp, keys[PositionTrack])));
+	}
+	if (_data.rotations.size())
+	{
+		const float32* next;
+		glm::quat q(glm::make_quat(sampleKeys(_keyTimes[RotationTrack], _data.rotations, frame, keys[RotationTrack],
+		                                      next)));
+		if (next) { q = glm::slerp(q, glm::make_quat(next), interp); }
+		q.w = -q.w;
+		m2 = internal::optimizedMat4(glm::mat4_cast(q));
+	}
+	if (_data.scales.size())
+	{
+		m3 = internal::optimizedMat4(glm::scale(sampleVector(_keyTimes[ScaleTrack], _data.scales, frame, interp,
+		                             keys[ScaleTrack])));
+	}
+	return internal::toMat4(m1 * m2 * m3);
+}
+
+void Animation::getTransformationMatrices(Cursor* cursors, uint32 numCursors, uint32 frame, float32 interp,
+    glm::mat4x4* outMatrices)
+{
+	for (uint32 i = 0; i < numCursors; ++i) { outMatrices[i] = cursors[i].getTransformationMatrix(frame, interp); }
+}
+
+bool Animation::buildKeyIndex()
+{
+	const std::vector<float32>* data[NumTrackTypes] = { &_data.positions, &_data.rotations, &_data.scales,
+	                                                    &_data.matrices };
+	const std::vector<uint32>* indices[NumTrackTypes] = { &_data.positionIndices, &_data.rotationIndices,
+	                                                      &_data.scaleIndices, &_data.matrixIndices };
+	const uint32 flags[NumTrackTypes] = { HasPositionAnimation, HasRotationAnimation, HasScaleAnimation,
+	                                      HasMatrixAnimation };
+	_hasKeyIndex = true;
+	for (uint32 i = 0; i < NumTrackTypes; ++i)
+	{
+		if (data[i]->empty() || !(_data.flags & flags[i]))
+		{
+			_keyTimes[i] = KeyTimes();
+		}
+		else if (!buildKeyTimes(*data[i], *indices[i], (TrackType)i, _data.numberOfFrames, _keyTimes[i]))
+		{
+			Log(Log.Error, "Animation::buildKeyIndex: The animation data is smaller than its number of frames");
+			_hasKeyIndex = false;
+		}
+	}
+	if (!_hasKeyIndex)
+	{
+		for (uint32 i = 0; i < NumTrackTypes; ++i) { _keyTimes[i] = KeyTimes(); }
+	}
+	return _hasKeyIndex;
+}
+
+uint32 Animation::findKey(TrackType track, uint32 frame) const
+{
+	return utils::internal::findKeyFrom(_keyTimes[track].frames, frame, (uint32)_keyTimes[track].frames.size());
+}
+
 bool Animation::setPositions(uint32 numFrames, const float32* const data, const uint32* const indices)
 {
 	_data.positions.resize(0);
@@ -203,6 +331,7 @@ bool Animation::setPositions(uint32 numFrames, const float32* const data, const
 	{
 		_data.flags |= HasPositionAnimation;
 	}
+	buildKeyIndex();
 	return true;
 }
 
@@ -250,6 +379,7 @@ bool Animation::setRotations(uint32 numFrames, const float32* const data, const
 	{
 		_data.flags |= HasRotationAnimation;
 	}
+	buildKeyIndex();
 	return true;
 }
 
@@ -297,6 +427,7 @@ bool Animation::setScales(uint32 numFrames, const float32* const data, const uin
 	{
 		_data.flags |= HasScaleAnimation;
 	}
+	buildKeyIndex();
 	return true;
 }
 
@@ -344,6 +475,7 @@ bool Animation::setMatrices(uint32 numFrames, const float32* const data, const u
 	{
 		_data.flags |= HasMatrixAnimation;
 	}
+	buildKeyIndex();
 	return true;
 }
 
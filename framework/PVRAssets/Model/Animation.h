@@ -5,7 +5,7 @@
 \copyright Copyright (c) Imagination Technologies Limited.
 */
 #pragma once
-#include "PVRCore/CoreIncludes.h"
+#include "PVRAssets/Model/AnimationKeys.h"
 
 namespace pvr {
 namespace assets {
@@ -21,6 +21,48 @@ public:
 		HasMatrixAnimation   = 0x08//!< matrix animation data
 	};
 
+	/// <summary>The tracks of an animation.</summary>
+	enum TrackType
+	{
+		PositionTrack, //!< The positions
+		RotationTrack, //!< The rotations
+		ScaleTrack, //!< The scales
+		MatrixTrack, //!< The transformation matrices
+		NumTrackTypes
+	};
+
+	/// <summary>The keys of a track listed by time, so that the key used by a frame is found with a binary search.
+	/// A key is a run of consecutive frames that use the same data, so tracks with sparse keys have short lists.
+	/// </summary>
+	struct KeyTimes
+	{
+		std::vector<uint32> frames;  //!< The first frame of each key, increasing. Empty if the track is not animated.
+		std::vector<uint32> offsets; //!< The offset of the data of each key in the data array of the track
+	};
+
+	/// <summary>Samples an Animation, caching the key of each track found for the last frame sampled. Moving to a
+	/// later frame, as in playback, steps forward from the cached keys instead of searching, and frames between two
+	/// keys that are further than a frame apart are not interpolated. Any frame can be sampled. Each thread needs its
+	/// own cursor.</summary>
+	class Cursor : public utils::internal::KeyCursor<Animation>
+	{
+	public:
+		/// <summary>Constructor. Call reset before use.</summary>
+		Cursor() : KeyCursor<Animation>(NULL) {}
+
+		/// <summary>Constructor. Binds the cursor to an animation.</summary>
+		/// <param name="animation">The animation to sample. Must outlive the cursor.</param>
+		explicit Cursor(const Animation& animation) : KeyCursor<Animation>(&animation) {}
+
+		/// <summary>Get the transformation matrix of a frame, as Animation::getTransformationMatrix.</summary>
+		/// <param name="frame">The first frame for which the transformation matrix will be returned</param>
+		/// <param name="interp">Interpolation value used between the frames</param>
+		glm::mat4x4 getTransformationMatrix(uint32 frame = 0, float32 interp = 0)
+		{
+			return _animation->getTransformationMatrix(frame, interp, _keys);
+		}
+	};
+
 	/// <summary>Raw internal structure of the Animation.</summary>
 	struct InternalData
 	{
@@ -46,6 +88,8 @@ public:
 	};
 
 public:
+	/// <summary>Constructor. The animation is empty.</summary>
+	Animation() : _hasKeyIndex(false) {}
 
 	/// <summary>Get the transformation matrix of specific frame and amount of interpolation.</summary>
 	/// <param name="frame">The first frame for which the transformation matrix will be returned</param>
@@ -57,6 +101,35 @@ public:
 	/// Scale/ translation vectors and Rotation quaternia, Scale and Translation will be Linear Interpolated, and
 	/// Rotation will be SLERPed (Smooth Linear Interpolation) as normal.</remarks>
 	glm::mat4x4 getTransformationMatrix(uint32 frame = 0, float32 interp = 0) const;
+
+	/// <summary>Get the transformation matrices of several animations for the same frame, as
+	/// getTransformationMatrix, using and updating the cached keys of a cursor per animation.</summary>
+	/// <param name="cursors">A cursor bound to each animation to sample</param>
+	/// <param name="numCursors">The number of cursors</param>
+	/// <param name="frame">The first frame for which the transformation matrices will be returned</param>
+	/// <param name="interp">Interpolation value used between the frames</param>
+	/// <param name="outMatrices">The transformation matrix of each cursor is written here</param>
+	static void getTransformationMatrices(Cursor* cursors, uint32 numCursors, uint32 frame, float32 interp,
+	                                      glm::mat4x4* outMatrices);
+
+	/// <summary>Build the key index (the KeyTimes of each track) used by Cursors. The setters of this class and the
+	/// model readers build it. Call it again after changing the InternalData directly.</summary>
+	/// <returns>False if the index arrays of the animation point outside its data, in which case there is no index
+	/// and Cursors sample the animation as getTransformationMatrix does, otherwise true</returns>
+	bool buildKeyIndex();
+
+	/// <summary>Check if the key index was built.</summary>
+	bool hasKeyIndex() const { return _hasKeyIndex; }
+
+	/// <summary>Get the keys of a track listed by time. Requires the key index.</summary>
+	/// <param name="track">The track</param>
+	const KeyTimes& getKeyTimes(TrackType track) const { return _keyTimes[track]; }
+
+	/// <summary>Find the key of a track used by a frame with a binary search. Requires the key index.</summary>
+	/// <param name="track">The track</param>
+	/// <param name="frame">The frame</param>
+	/// <returns>The index of the key in getKeyTimes(track), or 0 if the track is not animated</returns>
+	uint32 findKey(TrackType track, uint32 frame) const;
 //
 //TO IMPLEMENT
 //	\brief	Get translation for specific frame and interpolation. The aniumation MUST
@@ -158,6 +231,9 @@ public:
 	/// </summary>
 	InternalData& getInternalData();  // If you know what you're doing
 
+	/// <summary>Gets a const reference to the data representation of this object.</summary>
+	const InternalData& getInternalData() const { return _data; }
+
 private:
 	glm::mat4x4 getTranslationMatrix(uint32 frame = 0, float32 interp = 0) const;
 
@@ -165,7 +241,11 @@ private:
 
 	glm::mat4x4 getScalingMatrix(uint32 frame = 0, float32 interp = 0) const;
 
+	glm::mat4x4 getTransformationMatrix(uint32 frame, float32 interp, uint32* keys) const;
+
 	InternalData _data;
+	KeyTimes _keyTimes[NumTrackTypes];
+	bool _hasKeyIndex;
 };
 }
 }
\ No newline at end of file
@@ -0,0 +1,334 @@
+/*!
+\brief Implementation of the AnimationEvaluator class.
+\file PVRAssets/Model/AnimationEvaluator.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/Model/AnimationEvaluator.h"
+#include "PVRCore/Math/Float4.h"
+#include <algorithm>
+#include <cmath>
+#if defined(PVR_SUPPORT_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(PVR_SUPPORT_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace pvr {
+namespace assets {
+namespace {
+enum KeyRow { RowTx, RowTy, RowTz, RowQx, RowQy, RowQz, RowQw, RowSx, RowSy, RowSz, NumKeyRows };
+
+// Four floats processed together: one lane per node.
+using math::Float4;
+
+// out = a * b, for matrices that do not overlap.
+inline void multiplyMatrices(const glm::mat4x4& a, const glm::mat4x4& b, glm::mat4x4& out)
+{
+#if defined(PVR_SUPPORT_SSE2)
+	const __m128 a0 = _mm_loadu_ps(&a[0][0]), a1 = _mm_loadu_ps(&a[1][0]);
+	const __m128 a2 = _mm_loadu_ps(&a[2][0]), a3 = _mm_loadu_ps(&a[3][0]);
+	for (uint32 column = 0; column < 4; ++column)
+	{
+		const __m128 result01 = _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[column][0])), _mm_mul_ps(a1, _mm_set1_ps(b[column][1])));
+		const __m128 result23 = _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[column][2])), _mm_mul_ps(a3, _mm_set1_ps(b[column][3])));
+		_mm_storeu_ps(&out[column][0], _mm_add_ps(result01, result23));
+	}
+#elif defined(PVR_SUPPORT_NEON)
+	const float32x4_t a0 = vld1q_f32(&a[0][0]), a1 = vld1q_f32(&a[1][0]);
+	const float32x4_t a2 = vld1q_f32(&a[2][0]), a3 = vld1q_f32(&a[3][0]);
+	for (uint32 column = 0; column < 4; ++column)
+	{
+		float32x4_t result = vmulq_n_f32(a0, b[column][0]);
+		result = vmlaq_n_f32(result, a1, b[column][1]);
+		result = vmlaq_n_f32(result, a2, b[column][2]);
+		result = vmlaq_n_f32(result, a3, b[column][3]);
+		vst1q_f32(&out[column][0], result);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+// The two keys a frame falls between, clamped to the frames of the track.
+inline void getKeyFrames(float32 frame, uint32 numFrames, uint32& frame0, float32& interp)
+{
+	if (frame <= 0.0f) { frame0 = 0; interp = 0.0f; return; }
+	frame0 = (uint32)frame;
+	interp = frame - (float32)frame0;
+	if (frame0 + 1 >= numFrames)
+	{
+		frame0 = numFrames - 2;
+		interp = 1.0f;
+	}
+}
+}
+
+void AnimationEvaluator::init(const Model& model)
+{
+	_model = &model;
+	const uint32 numNodes = model.getNumNodes();
+
+	// Sort the nodes by depth, so that every parent comes before its children.
+	std::vector<uint32> depths(numNodes, 0);
+	_parents.resize(numNodes);
+	for (uint32 i = 0; i < numNodes; ++i)
+	{
+		_parents[i] = model.getNode(i).getParentID();
+		if (_parents[i] >= 0 && (uint32)_parents[i] >= numNodes) { _parents[i] = -1; }
+		int32 parent = _parents[i];
+		for (uint32 depth = 0; parent >= 0 && (uint32)parent < numNodes && depth < numNodes; ++depth)
+		{
+			++depths[i];
+			parent = model.getNode(parent).getParentID();
+		}
+	}
+	_order.resize(numNodes);
+	for (uint32 i = 0; i < numNodes; ++i) { _order[i] = i; }
+	std::stable_sort(_order.begin(), _order.end(), [&depths](uint32 lhs, uint32 rhs) { return depths[lhs] < depths[rhs]; });
+
+	// Nodes without animation keep the local matrix computed here. Nodes with position, rotation or scale keys get a
+	// column of the structure-of-arrays buffers, initialised with their static values.
+	_staticLocalMatrices.assign(numNodes, glm::mat4x4(1.0f));
+	_localSlots.assign(numNodes, ~0u);
+	_animatedNodes.clear();
+	_matrixNodes.clear();
+	_positionTracks.clear();
+	_rotationTracks.clear();
+	_scaleTracks.clear();
+	for (uint32 i = 0; i < numNodes; ++i)
+	{
+		const Animation::InternalData& animation = model.getNode(i).getAnimation().getInternalData();
+		const uint32 transformFlags = Animation::HasPositionAnimation | Animation::HasRotationAnimation |
+		                              Animation::HasScaleAnimation;
+		const bool usesMatrices = !animation.matrices.empty() && ((animation.flags & Animation::HasMatrixAnimation) ||
+		                          (animation.flags & transformFlags) != transformFlags);
+		const bool positionAnimated = !animation.positions.empty() && (animation.flags & Animation::HasPositionAnimation);
+		const bool rotationAnimated = !animation.rotations.empty() && (animation.flags & Animation::HasRotationAnimation);
+		const bool scaleAnimated = !animation.scales.empty() && (animation.flags & Animation::HasScaleAnimation);
+		const bool animated = usesMatrices ? (animation.flags & Animation::HasMatrixAnimation) != 0 :
+		                      (positionAnimated || rotationAnimated || scaleAnimated);
+		if (animation.numberOfFrames < 2 || !animated)
+		{
+			_staticLocalMatrices[i] = model.getNode(i).getAnimation().getTransformationMatrix(0, 0.0f);
+			continue;
+		}
+		if (usesMatrices)
+		{
+			_matrixNodes.push_back(i);
+			continue;
+		}
+		const uint32 column = (uint32)_animatedNodes.size();
+		_animatedNodes.push_back(i);
+		_localSlots[i] = column;
+		Track track;
+		track.column = column;
+		track.numFrames = animation.numberOfFrames;
+		if (positionAnimated)
+		{
+			track.stride = 3;
+			track.keys = animation.positions.data();
+			track.indices = animation.positionIndices.empty() ? NULL : animation.positionIndices.data();
+			_positionTracks.push_back(track);
+		}
+		if (rotationAnimated)
+		{
+			track.stride = 4;
+			track.keys = animation.rotations.data();
+			track.indices = animation.rotationIndices.empty() ? NULL : animation.rotationIndices.data();
+			_rotationTracks.push_back(track);
+		}
+		if (scaleAnimated)
+		{
+			track.stride = 7;
+			track.keys = animation.scales.data();
+			track.indices = animation.scaleIndices.empty() ? NULL : animation.scaleIndices.data();
+			_scaleTracks.push_back(track);
+		}
+	}
+
+	// The local matrices of the nodes animated with matrices follow the ones of the animated columns.
+	_numAnimatedNodes = (uint32)_animatedNodes.size();
+	for (size_t i = 0; i < _matrixNodes.size(); ++i) { _localSlots[_matrixNodes[i]] = _numAnimatedNodes + (uint32)i; }
+
+	_paddedNumAnimatedNodes = (_numAnimatedNodes + 3) & ~3u;
+	_staticKeys.assign(NumKeyRows * _paddedNumAnimatedNodes, 0.0f);
+	for (uint32 column = 0; column < _paddedNumAnimatedNodes; ++column)
+	{
+		float32 keys[NumKeyRows] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+		if (column < _numAnimatedNodes)
+		{
+			// Static values, as Animation::getTransformationMatrix uses them. Animated tracks overwrite them.
+			const Animation::InternalData& animation = model.getNode(_animatedNodes[column]).getAnimation().getInternalData();
+			if (!animation.positions.empty())
+			{
+				keys[RowTx] = animation.positions[0]; keys[RowTy] = animation.positions[1]; keys[RowTz] = animation.positions[2];
+			}
+			if (!animation.rotations.empty())
+			{
+				keys[RowQx] = animation.rotations[0]; keys[RowQy] = animation.rotations[1];
+				keys[RowQz] = animation.rotations[2]; keys[RowQw] = -animation.rotations[3];
+			}
+			if (!animation.scales.empty())
+			{
+				keys[RowSx] = animation.scales[0]; keys[RowSy] = animation.scales[1]; keys[RowSz] = animation.scales[2];
+			}
+		}
+		for (uint32 row = 0; row < NumKeyRows; ++row) { _staticKeys[row * _paddedNumAnimatedNodes + column] = keys[row]; }
+	}
+
+	// The instance buffers are sized for the previous model, if any.
+	_pose = AnimationInstance();
+	evaluate(0.0f);
+	_frameZeroMatrices = _pose.getWorldMatrices();
+	_inverseFrameZeroMatrices.resize(numNodes);
+	for (uint32 i = 0; i < numNodes; ++i) { _inverseFrameZeroMatrices[i] = glm::inverse(_frameZeroMatrices[i]); }
+}
+
+void AnimationEvaluator::evaluate(float32 frame, AnimationInstance& instance) const
+{
+	// The keys of an instance only hold the static values of this evaluator if it was evaluated by it before.
+	const bool rebind = instance._evaluator != this || instance._keys.size() != _staticKeys.size() ||
+	                    instance._worldMatrices.size() != _order.size();
+	instance._evaluator = this;
+	instance._frame = frame;
+	if (!_model) { return; }
+	if (rebind)
+	{
+		instance._keys = _staticKeys;
+		instance._localMatrices.resize(_numAnimatedNodes + _matrixNodes.size());
+		instance._worldMatrices.resize(_order.size());
+	}
+	glm::mat4x4* localMatrices = instance._localMatrices.data();
+	sampleTracks(frame, instance._keys.data());
+	composeLocalMatrices(instance._keys.data(), localMatrices);
+	for (size_t i = 0; i < _matrixNodes.size(); ++i)
+	{
+		const Animation& animation = _model->getNode(_matrixNodes[i]).getAnimation();
+		uint32 frame0;
+		float32 interp;
+		getKeyFrames(frame, animation.getNumFrames(), frame0, interp);
+		localMatrices[_numAnimatedNodes + i] = animation.getTransformationMatrix(frame0, interp);
+	}
+	computeWorldMatrices(localMatrices, instance._worldMatrices.data());
+}
+
+void AnimationEvaluator::sampleTracks(float32 frame, float32* keys) const
+{
+	const uint32 stride = _paddedNumAnimatedNodes;
+	for (size_t i = 0; i < _positionTracks.size(); ++i)
+	{
+		const Track& track = _positionTracks[i];
+		uint32 frame0;
+		float32 interp;
+		getKeyFrames(frame, track.numFrames, frame0, interp);
+		const float32* p0 = track.keys + (track.indices ? track.indices[frame0] : frame0 * track.stride);
+		const float32* p1 = track.keys + (track.indices ? track.indices[frame0 + 1] : (frame0 + 1) * track.stride);
+		for (uint32 c = 0; c < 3; ++c) { keys[(RowTx + c) * stride + track.column] = p0[c] + (p1[c] - p0[c]) * interp; }
+	}
+	for (size_t i = 0; i < _scaleTracks.size(); ++i)
+	{
+		const Track& track = _scaleTracks[i];
+		uint32 frame0;
+		float32 interp;
+		getKeyFrames(frame, track.numFrames, frame0, interp);
+		const float32* s0 = track.keys + (track.indices ? track.indices[frame0] : frame0 * track.stride);
+		const float32* s1 = track.keys + (track.indices ? track.indices[frame0 + 1] : (frame0 + 1) * track.stride);
+		for (uint32 c = 0; c < 3; ++c) { keys[(RowSx + c) * stride + track.column] = s0[c] + (s1[c] - s0[c]) * interp; }
+	}
+	// Spherical interpolation along the shortest arc, as glm::slerp. The animation stores the conjugate rotation.
+	for (size_t i = 0; i < _rotationTracks.size(); ++i)
+	{
+		const Track& track = _rotationTracks[i];
+		uint32 frame0;
+		float32 interp;
+		getKeyFrames(frame, track.numFrames, frame0, interp);
+		const float32* q0 = track.keys + (track.indices ? track.indices[frame0] : frame0 * track.stride);
+		const float32* q1 = track.keys + (track.indices ? track.indices[frame0 + 1] : (frame0 + 1) * track.stride);
+		float32 cosTheta = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+		float32 sign = 1.0f;
+		if (cosTheta < 0.0f)
+		{
+			sign = -1.0f;
+			cosTheta = -cosTheta;
+		}
+		float32 weight0 = 1.0f - interp, weight1 = interp;
+		if (cosTheta <= 1.0f - glm::epsilon<float32>())
+		{
+			const float32 angle = acosf(cosTheta);
+			const float32 inverseSin = 1.0f / sinf(angle);
+			weight0 = sinf((1.0f - interp) * angle) * inverseSin;
+			weight1 = sinf(interp * angle) * inverseSin;
+		}
+		weight1 *= sign;
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			const float32 value = q0[c] * weight0 + q1[c] * weight1;
+			keys[(RowQx + c) * stride + track.column] = c == 3 ? -value : value;
+		}
+	}
+}
+
+void AnimationEvaluator::composeLocalMatrices(const float32* keys, glm::mat4x4* localMatrices) const
+{
+	// local = translation * rotation * scale, with the rotation matrix of glm::mat4_cast.
+	const uint32 stride = _paddedNumAnimatedNodes;
+	const Float4 one(1.0f), two(2.0f);
+	for (uint32 column = 0; column < _numAnimatedNodes; column += 4)
+	{
+		const float32* columnKeys = keys + column;
+		const Float4 qx = Float4::load(columnKeys + RowQx * stride), qy = Float4::load(columnKeys + RowQy * stride);
+		const Float4 qz = Float4::load(columnKeys + RowQz * stride), qw = Float4::load(columnKeys + RowQw * stride);
+		const Float4 sx = Float4::load(columnKeys + RowSx * stride), sy = Float4::load(columnKeys + RowSy * stride);
+		const Float4 sz = Float4::load(columnKeys + RowSz * stride);
+		const Float4 xx = qx * qx, yy = qy * qy, zz = qz * qz;
+		const Float4 xy = qx * qy, xz = qx * qz, yz = qy * qz;
+		const Float4 wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+		PVR_ALIGNED float32 elements[12][4];
+		(sx * (one - two * (yy + zz))).store(elements[0]);
+		(sx * (two * (xy + wz))).store(elements[1]);
+		(sx * (two * (xz - wy))).store(elements[2]);
+		(sy * (two * (xy - wz))).store(elements[3]);
+		(sy * (one - two * (xx + zz))).store(elements[4]);
+		(sy * (two * (yz + wx))).store(elements[5]);
+		(sz * (two * (xz + wy))).store(elements[6]);
+		(sz * (two * (yz - wx))).store(elements[7]);
+		(sz * (one - two * (xx + yy))).store(elements[8]);
+		Float4::load(columnKeys + RowTx * stride).store(elements[9]);
+		Float4::load(columnKeys + RowTy * stride).store(elements[10]);
+		Float4::load(columnKeys + RowTz * stride).store(elements[11]);
+
+		for (uint32 lane = 0; lane < 4 && column + lane < _numAnimatedNodes; ++lane)
+		{
+			glm::mat4x4& local = localMatrices[column + lane];
+			local[0] = glm::vec4(elements[0][lane], elements[1][lane], elements[2][lane], 0.0f);
+			local[1] = glm::vec4(elements[3][lane], elements[4][lane], elements[5][lane], 0.0f);
+			local[2] = glm::vec4(elements[6][lane], elements[7][lane], elements[8][lane], 0.0f);
+			local[3] = glm::vec4(elements[9][lane], elements[10][lane], elements[11][lane], 1.0f);
+		}
+	}
+}
+
+void AnimationEvaluator::computeWorldMatrices(const glm::mat4x4* localMatrices, glm::mat4x4* worldMatrices) const
+{
+	for (size_t i = 0; i < _order.size(); ++i)
+	{
+		const uint32 node = _order[i];
+		const uint32 slot = _localSlots[node];
+		const glm::mat4x4& local = slot == ~0u ? _staticLocalMatrices[node] : localMatrices[slot];
+		if (_parents[node] < 0)
+		{
+			worldMatrices[node] = local;
+		}
+		else
+		{
+			multiplyMatrices(worldMatrices[_parents[node]], local, worldMatrices[node]);
+		}
+	}
+}
+}
+}
+//!\endcond
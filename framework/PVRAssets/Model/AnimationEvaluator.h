@@ -0,0 +1,116 @@
+/*!
+\brief Contains a class that computes the world matrices of all the nodes of a model at once.
+\file PVRAssets/Model/AnimationEvaluator.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model.h"
+#include "PVRAssets/Model/AnimationInstance.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>Computes the world matrices of all the nodes of a Model for a frame in a single pass. The position,
+/// rotation and scale keys of the animated nodes are sampled into structure-of-arrays buffers, composed into local
+/// matrices four nodes at a time with SIMD instructions where available, and multiplied with the world matrices of
+/// their parents in an order where parents always come first.</summary>
+/// <remarks>Use this instead of Model::getWorldMatrix when the world matrices of most nodes are needed every
+/// frame, as for skinned characters. The results are the same as Model::getWorldMatrix. The evaluator only keeps
+/// what does not depend on the frame, so it can be shared by many AnimationInstance objects, each with its own
+/// frame, that can be evaluated concurrently. The evaluator also has a pose of its own (evaluate(float32) and
+/// getWorldMatrix). It reads the animation data of the model, which must not be changed or destroyed while the
+/// evaluator is used (call init again after changing it).</remarks>
+class AnimationEvaluator
+{
+public:
+	/// <summary>Constructor. Call init before use.</summary>
+	AnimationEvaluator() : _model(NULL), _numAnimatedNodes(0), _paddedNumAnimatedNodes(0) {}
+
+	/// <summary>Constructor. Prepares the evaluator for a model.</summary>
+	/// <param name="model">The model whose nodes will be evaluated</param>
+	explicit AnimationEvaluator(const Model& model) : _model(NULL), _numAnimatedNodes(0), _paddedNumAnimatedNodes(0)
+	{
+		init(model);
+	}
+
+	/// <summary>Prepare the evaluator for a model: sort its nodes, compute the local matrices of the nodes that are
+	/// not animated, and evaluate frame 0.</summary>
+	/// <param name="model">The model whose nodes will be evaluated</param>
+	void init(const Model& model);
+
+	/// <summary>Get the model this evaluator was prepared for, or NULL.</summary>
+	const Model* getModel() const { return _model; }
+
+	/// <summary>Compute the world matrices of all nodes of an instance for a frame. Thread safe, as long as each
+	/// instance is only evaluated by one thread at a time.</summary>
+	/// <param name="frame">The frame. Can be fractional, in which case the keys are interpolated as in
+	/// Model::setCurrentFrame. Frames past the end of an animation use its last frame.</param>
+	/// <param name="instance">The instance to update. It is bound to this evaluator if it is not already.</param>
+	void evaluate(float32 frame, AnimationInstance& instance) const;
+
+	/// <summary>Compute the world matrices of all nodes for a frame, in the pose of the evaluator itself.</summary>
+	/// <param name="frame">The frame. Can be fractional, in which case the keys are interpolated as in
+	/// Model::setCurrentFrame. Frames past the end of an animation use its last frame.</param>
+	void evaluate(float32 frame) { evaluate(frame, _pose); }
+
+	/// <summary>Get the number of nodes evaluated.</summary>
+	uint32 getNumNodes() const { return (uint32)_order.size(); }
+
+	/// <summary>Get the world matrix of a node for the frame last passed to evaluate(float32).</summary>
+	/// <param name="nodeId">The index of the node in the model</param>
+	const glm::mat4x4& getWorldMatrix(uint32 nodeId) const { return _pose.getWorldMatrix(nodeId); }
+
+	/// <summary>Get the world matrices of all nodes for the frame last passed to evaluate(float32), indexed by node.
+	/// </summary>
+	const std::vector<glm::mat4x4>& getWorldMatrices() const { return _pose.getWorldMatrices(); }
+
+	/// <summary>Get the world matrix of a bone for the frame last passed to evaluate(float32), as
+	/// Model::getBoneWorldMatrix.</summary>
+	/// <param name="skinNodeId">The node of the skinned mesh</param>
+	/// <param name="boneId">The node of the bone</param>
+	glm::mat4x4 getBoneWorldMatrix(uint32 skinNodeId, uint32 boneId) const
+	{
+		return getBoneWorldMatrix(_pose.getWorldMatrix(boneId), skinNodeId, boneId);
+	}
+
+private:
+	friend class AnimationInstance;
+
+	// A position, rotation or scale track of an animated node, written to one column of the structure-of-arrays
+	// buffers.
+	struct Track
+	{
+		uint32 column;
+		uint32 stride;
+		uint32 numFrames;
+		const float32* keys;
+		const uint32* indices;
+	};
+
+	const Model* _model;
+	std::vector<uint32> _order;                 // Node ids, parents before children
+	std::vector<int32> _parents;
+	std::vector<uint32> _animatedNodes;         // Node id of each column of the structure-of-arrays buffers
+	std::vector<uint32> _matrixNodes;           // Nodes animated with matrices, evaluated by their Animation
+	std::vector<uint32> _localSlots;            // Index of the local matrix of each node in an instance, or ~0u
+	uint32 _numAnimatedNodes;
+	uint32 _paddedNumAnimatedNodes;             // Rounded up to a multiple of 4
+	std::vector<float32> _staticKeys;           // Ten rows of _paddedNumAnimatedNodes: tx ty tz qx qy qz qw sx sy sz
+	std::vector<Track> _positionTracks;
+	std::vector<Track> _rotationTracks;
+	std::vector<Track> _scaleTracks;
+	std::vector<glm::mat4x4> _staticLocalMatrices;
+	std::vector<glm::mat4x4> _frameZeroMatrices;
+	std::vector<glm::mat4x4> _inverseFrameZeroMatrices;
+	AnimationInstance _pose;
+
+	glm::mat4x4 getBoneWorldMatrix(const glm::mat4x4& boneWorldMatrix, uint32 skinNodeId, uint32 boneId) const
+	{
+		return boneWorldMatrix * _inverseFrameZeroMatrices[boneId] * _frameZeroMatrices[skinNodeId];
+	}
+	void sampleTracks(float32 frame, float32* keys) const;
+	void composeLocalMatrices(const float32* keys, glm::mat4x4* localMatrices) const;
+	void computeWorldMatrices(const glm::mat4x4* localMatrices, glm::mat4x4* worldMatrices) const;
+};
+}
+}
@@ -0,0 +1,43 @@
+/*!
+\brief Implementation of the AnimationInstance class.
+\file PVRAssets/Model/AnimationInstance.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/Model/AnimationEvaluator.h"
+
+namespace pvr {
+namespace assets {
+AnimationInstance::AnimationInstance(const AnimationEvaluator& evaluator, float32 frame) : _evaluator(NULL), _frame(0.0f)
+{
+	init(evaluator, frame);
+}
+
+void AnimationInstance::init(const AnimationEvaluator& evaluator, float32 frame)
+{
+	evaluator.evaluate(frame, *this);
+}
+
+void AnimationInstance::setFrame(float32 frame)
+{
+	if (!_evaluator)
+	{
+		Log(Log.Error, "AnimationInstance::setFrame: The instance is not bound to an AnimationEvaluator");
+		return;
+	}
+	_evaluator->evaluate(frame, *this);
+}
+
+glm::mat4x4 AnimationInstance::getBoneWorldMatrix(uint32 skinNodeId, uint32 boneId) const
+{
+	if (!_evaluator)
+	{
+		Log(Log.Error, "AnimationInstance::getBoneWorldMatrix: The instance is not bound to an AnimationEvaluator");
+		return glm::mat4x4(1.0f);
+	}
+	return _evaluator->getBoneWorldMatrix(_worldMatrices[boneId], skinNodeId, boneId);
+}
+}
+}
+//!\endcond
@@ -0,0 +1,72 @@
+/*!
+\brief Contains a class holding the animation state of one instance of a model.
+\file PVRAssets/Model/AnimationInstance.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/CoreIncludes.h"
+
+namespace pvr {
+namespace assets {
+class AnimationEvaluator;
+
+/// <summary>The pose of one instance of an animated model: its current frame and the world matrices of its nodes.
+/// The model and its animation data are not copied: they are read through an AnimationEvaluator, which can be
+/// shared by any number of instances.</summary>
+/// <remarks>Instances sharing an evaluator can be updated concurrently from different threads, as long as each
+/// instance is only used by one thread at a time. The evaluator (and its model) must outlive its instances.
+/// </remarks>
+class AnimationInstance
+{
+public:
+	/// <summary>Constructor. The instance is empty until it is bound to an evaluator.</summary>
+	AnimationInstance() : _evaluator(NULL), _frame(0.0f) {}
+
+	/// <summary>Constructor. Binds the instance to an evaluator and computes its pose for a frame.</summary>
+	/// <param name="evaluator">The evaluator of the model this is an instance of</param>
+	/// <param name="frame">The initial frame</param>
+	explicit AnimationInstance(const AnimationEvaluator& evaluator, float32 frame = 0.0f);
+
+	/// <summary>Bind the instance to an evaluator and compute its pose for a frame.</summary>
+	/// <param name="evaluator">The evaluator of the model this is an instance of</param>
+	/// <param name="frame">The initial frame</param>
+	void init(const AnimationEvaluator& evaluator, float32 frame = 0.0f);
+
+	/// <summary>Set the current frame of this instance and compute the world matrices of its nodes.</summary>
+	/// <param name="frame">The frame. Can be fractional, in which case the keys are interpolated.</param>
+	void setFrame(float32 frame);
+
+	/// <summary>Get the current frame of this instance.</summary>
+	float32 getFrame() const { return _frame; }
+
+	/// <summary>Get the evaluator this instance is bound to, or NULL.</summary>
+	const AnimationEvaluator* getEvaluator() const { return _evaluator; }
+
+	/// <summary>Get the number of nodes of this instance.</summary>
+	uint32 getNumNodes() const { return (uint32)_worldMatrices.size(); }
+
+	/// <summary>Get the world matrix of a node for the current frame.</summary>
+	/// <param name="nodeId">The index of the node in the model</param>
+	const glm::mat4x4& getWorldMatrix(uint32 nodeId) const { return _worldMatrices[nodeId]; }
+
+	/// <summary>Get the world matrices of all nodes for the current frame, indexed by node.</summary>
+	const std::vector<glm::mat4x4>& getWorldMatrices() const { return _worldMatrices; }
+
+	/// <summary>Get the world matrix of a bone for the current frame, as Model::getBoneWorldMatrix.</summary>
+	/// <param name="skinNodeId">The node of the skinned mesh</param>
+	/// <param name="boneId">The node of the bone</param>
+	/// <returns>The world matrix of the bone, or the identity if the instance is not bound to an AnimationEvaluator
+	/// </returns>
+	glm::mat4x4 getBoneWorldMatrix(uint32 skinNodeId, uint32 boneId) const;
+
+private:
+	friend class AnimationEvaluator;
+	const AnimationEvaluator* _evaluator;
+	float32 _frame;
+	std::vector<float32> _keys;               // The sampled keys of the animated nodes
+	std::vector<glm::mat4x4> _localMatrices;  // The local matrices of the animated nodes
+	std::vector<glm::mat4x4> _worldMatrices;
+};
+}
+}
@@ -0,0 +1,61 @@
+/*!
+\brief Internal helpers shared by Animation and CompressedAnimation to find the key of a track used by a frame.
+\file PVRAssets/Model/AnimationKeys.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/CoreIncludes.h"
+#include <algorithm>
+
+//!\cond NO_DOXYGEN
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace internal {
+// The key of a track used for a frame, starting the search from the key used last: frames are the increasing first
+// frames of the keys. Steps forward a few keys from the cached key, as in playback, and otherwise searches.
+template<typename FrameType, typename Frame>
+inline uint32 findKeyFrom(const std::vector<FrameType>& frames, Frame frame, uint32 key)
+{
+	if (key >= frames.size() || frames[key] > frame)
+	{
+		key = (uint32)(std::upper_bound(frames.begin(), frames.end(), frame) - frames.begin());
+		return key ? key - 1 : 0;
+	}
+	for (uint32 steps = 0; key + 1 < frames.size() && frames[key + 1] <= frame; ++steps)
+	{
+		if (steps == 8) { return findKeyFrom(frames, frame, (uint32)frames.size()); }
+		++key;
+	}
+	return key;
+}
+
+// The animation and the cached keys of its position, rotation, scale and matrix tracks of the cursors of Animation
+// and CompressedAnimation, which add the sampling function of their animation.
+template<typename AnimationType>
+class KeyCursor
+{
+public:
+	/// <summary>Bind the cursor to an animation and forget the cached keys.</summary>
+	/// <param name="animation">The animation to sample. Must outlive the cursor.</param>
+	void reset(const AnimationType& animation)
+	{
+		_animation = &animation;
+		reset();
+	}
+
+	/// <summary>Get the animation the cursor samples, or NULL.</summary>
+	const AnimationType* getAnimation() const { return _animation; }
+
+protected:
+	explicit KeyCursor(const AnimationType* animation) : _animation(animation) { reset(); }
+	void reset() { _keys[0] = _keys[1] = _keys[2] = _keys[3] = 0; }
+	const AnimationType* _animation;
+	uint32 _keys[4];
+};
+}
+}
+}
+}
+//!\endcond
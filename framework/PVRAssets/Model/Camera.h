@@ -69,6 +69,9 @@ public:
 
 	/// <summary>Get a reference to the internal data of this object. Handle with care.</summary>
 	inline InternalData& getInternalData() { return _data; }
+
+	/// <summary>Get a const reference to the internal data of this object.</summary>
+	inline const InternalData& getInternalData() const { return _data; }
 private:
 	InternalData _data;
 };
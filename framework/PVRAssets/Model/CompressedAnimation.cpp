@@ -0,0 +1,347 @@
+/*!
+\brief Implementation of the CompressedAnimation class.
+\file PVRAssets/Model/CompressedAnimation.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/Model/CompressedAnimation.h"
+#include "PVRAssets/Model.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace pvr {
+namespace assets {
+namespace {
+// Two kept keys are never further apart than this, which bounds the cost of searching for the keys to remove.
+const uint32 MaxKeyInterval = 256;
+const float32 Sqrt2 = 1.41421356f;
+
+inline glm::vec3 decodeVector(const uint16* values, const glm::vec3& minimum, const glm::vec3& extent)
+{
+	return minimum + glm::vec3(values[0], values[1], values[2]) * (extent * (1.0f / 65535.0f));
+}
+
+// Smallest-three form: the index of the largest component in the top bits of the first two values, and the other
+// three components, in the range [-1/sqrt(2), 1/sqrt(2)], in the low 15 bits of each value. The largest component is
+// made positive, which gives the same rotation.
+void encodeQuaternion(const float32* quaternion, uint16* values)
+{
+	glm::vec4 q(quaternion[0], quaternion[1], quaternion[2], quaternion[3]);
+	const float32 length = glm::length(q);
+	q = length > 0.0f ? q / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	uint32 largest = 0;
+	for (uint32 i = 1; i < 4; ++i)
+	{
+		if (fabsf(q[i]) > fabsf(q[largest])) { largest = i; }
+	}
+	if (q[largest] < 0.0f) { q = -q; }
+	for (uint32 i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largest) { continue; }
+		const float32 unit = (std::min)(std::max((q[i] * Sqrt2 + 1.0f) * 0.5f, 0.0f), 1.0f);
+		values[j++] = (uint16)(unit * 32767.0f + 0.5f);
+	}
+	values[0] |= (uint16)((largest >> 1) << 15);
+	values[1] |= (uint16)((largest & 1) << 15);
+}
+
+inline glm::quat decodeQuaternion(const uint16* values)
+{
+	const uint32 largest = ((values[0] >> 15) << 1) | (values[1] >> 15);
+	float32 q[4];
+	float32 sum = 0.0f;
+	for (uint32 i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largest) { continue; }
+		q[i] = ((values[j++] & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * (1.0f / Sqrt2);
+		sum += q[i] * q[i];
+	}
+	q[largest] = sqrtf((std::max)(1.0f - sum, 0.0f));
+	glm::quat result;
+	result.x = q[0];
+	result.y = q[1];
+	result.z = q[2];
+	result.w = q[3];
+	return result;
+}
+
+inline float32 getAngle(const glm::quat& a, const glm::quat& b)
+{
+	const float32 cosine = fabsf(glm::dot(glm::normalize(a), glm::normalize(b)));
+	return 2.0f * acosf((std::min)(cosine, 1.0f));
+}
+
+inline float32 getMaxDifference(const float32* a, const float32* b, uint32 count)
+{
+	float32 difference = 0.0f;
+	for (uint32 i = 0; i < count; ++i) { difference = (std::max)(difference, fabsf(a[i] - b[i])); }
+	return difference;
+}
+
+inline float32 getKeyInterp(const std::vector<uint16>& frames, uint32 key, float32 frame)
+{
+	if (key + 1 >= frames.size()) { return 0.0f; }
+	const float32 interp = (frame - frames[key]) / (float32)(frames[key + 1] - frames[key]);
+	return (std::min)(std::max(interp, 0.0f), 1.0f);
+}
+
+// The keys of a track as floats, one per frame, or a single key if the track is not animated.
+bool readTrack(const std::vector<float32>& data, const std::vector<uint32>& indices, uint32 stride, uint32 width,
+               uint32 numFrames, std::vector<float32>& keys)
+{
+	keys.resize(numFrames * width);
+	for (uint32 frame = 0; frame < numFrames; ++frame)
+	{
+		const size_t index = numFrames == 1 ? 0 : (indices.empty() ? (size_t)frame * stride : indices[frame]);
+		if (index + width > data.size())
+		{
+			Log(Log.Error, "CompressedAnimation::compress: The animation data is smaller than its number of frames");
+			return false;
+		}
+		std::copy(data.begin() + index, data.begin() + index + width, keys.begin() + frame * width);
+	}
+	return true;
+}
+}
+
+bool CompressedAnimation::compress(const Animation& animation, const AnimationCompressionOptions& options)
+{
+	const Animation::InternalData& data = animation.getInternalData();
+	for (uint32 i = 0; i < 4; ++i) { _tracks[i] = Track(); }
+	_numFrames = (std::max)(data.numberOfFrames, 1u);
+	if (_numFrames > 65536)
+	{
+		Log(Log.Error, "CompressedAnimation::compress: Animations of more than 65536 frames are not supported");
+		_numFrames = 0;
+		return false;
+	}
+
+	// The same choice of data as Animation::getTransformationMatrix.
+	const uint32 transformFlags = Animation::HasPositionAnimation | Animation::HasRotationAnimation |
+	                              Animation::HasScaleAnimation;
+	_mode = !data.matrices.empty() && ((data.flags & Animation::HasMatrixAnimation) ||
+	                                   (data.flags & transformFlags) != transformFlags) ? ModeMatrices : ModeTransforms;
+	const bool animated = _numFrames > 1;
+	std::vector<float32> keys;
+	if (_mode == ModeMatrices)
+	{
+		// Matrices are not interpolated: a frame only needs a key if its matrix is different from the previous key.
+		const uint32 numFrames = animated && (data.flags & Animation::HasMatrixAnimation) ? _numFrames : 1;
+		if (!readTrack(data.matrices, data.matrixIndices, 16, 16, numFrames, keys)) { return false; }
+		Track& track = _tracks[TrackMatrix];
+		for (uint32 frame = 0; frame < numFrames; ++frame)
+		{
+			if (frame && frame - track.frames.back() < MaxKeyInterval &&
+			    getMaxDifference(&keys[frame * 16], &track.floats[track.floats.size() - 16], 16) <=
+			    options.positionTolerance)
+			{
+				continue;
+			}
+			track.frames.push_back((uint16)frame);
+			track.floats.insert(track.floats.end(), keys.begin() + frame * 16, keys.begin() + frame * 16 + 16);
+		}
+		return true;
+	}
+
+	const std::vector<float32>* sources[] = { &data.positions, &data.rotations, &data.scales };
+	const std::vector<uint32>* indices[] = { &data.positionIndices, &data.rotationIndices, &data.scaleIndices };
+	const uint32 flags[] = { Animation::HasPositionAnimation, Animation::HasRotationAnimation, Animation::HasScaleAnimation };
+	const uint32 strides[] = { 3, 4, 7 };
+	const float32 tolerances[] = { options.positionTolerance, options.rotationTolerance, options.scaleTolerance };
+	for (uint32 type = TrackPosition; type <= TrackScale; ++type)
+	{
+		if (sources[type]->empty()) { continue; }
+		const uint32 width = type == TrackRotation ? 4 : 3;
+		const uint32 numFrames = animated && (data.flags & flags[type]) ? _numFrames : 1;
+		if (!readTrack(*sources[type], *indices[type], strides[type], width, numFrames, keys)) { return false; }
+
+		// Quantize every key, then keep the ones that cannot be interpolated from the decoded values of their neighbours.
+		Track& track = _tracks[type];
+		std::vector<uint16> values(numFrames * 3);
+		std::vector<glm::vec3> vectors;
+		std::vector<glm::quat> quaternions;
+		if (type == TrackRotation)
+		{
+			quaternions.resize(numFrames);
+			for (uint32 frame = 0; frame < numFrames; ++frame)
+			{
+				encodeQuaternion(&keys[frame * 4], &values[frame * 3]);
+				quaternions[frame] = decodeQuaternion(&values[frame * 3]);
+			}
+		}
+		else
+		{
+			glm::vec3 maximum(keys[0], keys[1], keys[2]);
+			track.minimum = maximum;
+			for (uint32 frame = 1; frame < numFrames; ++frame)
+			{
+				const glm::vec3 key(keys[frame * 3], keys[frame * 3 + 1], keys[frame * 3 + 2]);
+				track.minimum = glm::min(track.minimum, key);
+				maximum = glm::max(maximum, key);
+			}
+			track.extent = maximum - track.minimum;
+			vectors.resize(numFrames);
+			for (uint32 frame = 0; frame < numFrames; ++frame)
+			{
+				for (uint32 c = 0; c < 3; ++c)
+				{
+					const float32 unit = track.extent[c] > 0.0f ? (keys[frame * 3 + c] - track.minimum[c]) / track.extent[c] : 0.0f;
+					values[frame * 3 + c] = (uint16)((std::min)(std::max(unit, 0.0f), 1.0f) * 65535.0f + 0.5f);
+				}
+				vectors[frame] = decodeVector(&values[frame * 3], track.minimum, track.extent);
+			}
+		}
+
+		// The error of a key rebuilt by interpolating two decoded keys.
+		auto getError = [&](uint32 first, uint32 last, uint32 frame) -> float32
+		{
+			const float32 interp = (float32)(frame - first) / (float32)(last - first);
+			if (type == TrackRotation)
+			{
+				const glm::quat original(keys[frame * 4 + 3], keys[frame * 4], keys[frame * 4 + 1], keys[frame * 4 + 2]);
+				return getAngle(glm::slerp(quaternions[first], quaternions[last], interp), original);
+			}
+			const glm::vec3 value = glm::mix(vectors[first], vectors[last], interp);
+			const glm::vec3 original(keys[frame * 3], keys[frame * 3 + 1], keys[frame * 3 + 2]);
+			return type == TrackPosition ? glm::distance(value, original) :
+			       getMaxDifference(&value[0], &original[0], 3);
+		};
+		auto isConstant = [&]() -> bool
+		{
+			for (uint32 frame = 1; frame < numFrames; ++frame)
+			{
+				const float32 error = type == TrackRotation ? getAngle(quaternions[0], quaternions[frame]) :
+				                      getMaxDifference(&vectors[0][0], &vectors[frame][0], 3);
+				if (error > tolerances[type])
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		std::vector<uint32> kept(1, 0);
+		if (numFrames > 1 && !isConstant())
+		{
+			for (uint32 first = 0; first + 1 < numFrames;)
+			{
+				uint32 last = first + 1;
+				for (uint32 candidate = last + 1; candidate < numFrames && candidate - first <= MaxKeyInterval; ++candidate)
+				{
+					bool fits = true;
+					for (uint32 frame = first + 1; frame < candidate && fits; ++frame)
+					{
+						fits = getError(first, candidate, frame) <= tolerances[type];
+					}
+					if (!fits) { break; }
+					last = candidate;
+				}
+				kept.push_back(last);
+				first = last;
+			}
+		}
+		if (kept.size() == 1)
+		{
+			// A single key is kept exact: it has no range to quantize against, and static data is often large scales.
+			track.frames.assign(1, 0);
+			track.floats.assign(keys.begin(), keys.begin() + width);
+			continue;
+		}
+		track.frames.resize(kept.size());
+		track.values.resize(kept.size() * 3);
+		for (size_t i = 0; i < kept.size(); ++i)
+		{
+			track.frames[i] = (uint16)kept[i];
+			std::copy(values.begin() + kept[i] * 3, values.begin() + kept[i] * 3 + 3, track.values.begin() + i * 3);
+		}
+	}
+	return true;
+}
+
+uint32 CompressedAnimation::getNumKeys() const
+{
+	uint32 numKeys = 0;
+	for (uint32 i = 0; i < 4; ++i) { numKeys += (uint32)_tracks[i].frames.size(); }
+	return numKeys;
+}
+
+size_t CompressedAnimation::getDataSize() const
+{
+	size_t size = sizeof(*this);
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		size += (_tracks[i].frames.size() + _tracks[i].values.size()) * sizeof(uint16) +
+		        _tracks[i].floats.size() * sizeof(float32);
+	}
+	return size;
+}
+
+glm::vec3 CompressedAnimation::sampleVector(const Track& track, float32 frame, uint32& key)
+{
+	if (!track.floats.empty()) { return glm::make_vec3(track.floats.data()); }
+	key = utils::internal::findKeyFrom(track.frames, frame, key);
+	const uint32 next = (std::min)(key + 1, (uint32)track.frames.size() - 1);
+	return glm::mix(decodeVector(&track.values[key * 3], track.minimum, track.extent),
+	                decodeVector(&track.values[next * 3], track.minimum, track.extent), getKeyInterp(track.frames, key, frame));
+}
+
+glm::mat4x4 CompressedAnimation::getTransformationMatrix(float32 frame, uint32* keys) const
+{
+	frame = (std::min)(std::max(frame, 0.0f), (float32)(std::max)(_numFrames, 1u) - 1.0f);
+	if (_mode == ModeMatrices)
+	{
+		const Track& track = _tracks[TrackMatrix];
+		if (track.frames.empty()) { return glm::mat4x4(1.0f); }
+		keys[TrackMatrix] = utils::internal::findKeyFrom(track.frames, frame, keys[TrackMatrix]);
+		return glm::make_mat4(&track.floats[keys[TrackMatrix] * 16]);
+	}
+
+	glm::mat4x4 result(1.0f);
+	const Track& position = _tracks[TrackPosition];
+	if (!position.frames.empty())
+	{
+		result = glm::translate(sampleVector(position, frame, keys[TrackPosition]));
+	}
+	const Track& rotation = _tracks[TrackRotation];
+	if (!rotation.frames.empty())
+	{
+		glm::quat q;
+		if (!rotation.floats.empty())
+		{
+			q = glm::make_quat(rotation.floats.data());
+		}
+		else
+		{
+			const uint32 key = keys[TrackRotation] =
+			                     utils::internal::findKeyFrom(rotation.frames, frame, keys[TrackRotation]);
+			const uint32 next = (std::min)(key + 1, (uint32)rotation.frames.size() - 1);
+			q = glm::slerp(decodeQuaternion(&rotation.values[key * 3]), decodeQuaternion(&rotation.values[next * 3]),
+			               getKeyInterp(rotation.frames, key, frame));
+		}
+		q.w = -q.w;
+		result = result * glm::mat4_cast(q);
+	}
+	const Track& scale = _tracks[TrackScale];
+	if (!scale.frames.empty())
+	{
+		result = result * glm::scale(sampleVector(scale, frame, keys[TrackScale]));
+	}
+	return result;
+}
+
+bool compressAnimations(const Model& model, std::vector<CompressedAnimation>& animations,
+                        const AnimationCompressionOptions& options)
+{
+	animations.resize(model.getNumNodes());
+	bool result = true;
+	for (uint32 i = 0; i < model.getNumNodes(); ++i)
+	{
+		result = animations[i].compress(model.getNode(i).getAnimation(), options) && result;
+	}
+	return result;
+}
+}
+}
+//!\endcond
@@ -0,0 +1,118 @@
+/*!
+\brief Contains a compact, quantized representation of an Animation and a cursor to sample it.
+\file PVRAssets/Model/CompressedAnimation.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model/Animation.h"
+
+namespace pvr {
+namespace assets {
+class Model;
+
+/// <summary>The tolerances used when compressing an animation.</summary>
+struct AnimationCompressionOptions
+{
+	/// <summary>The largest distance allowed between a compressed and an original position, in model units. Also
+	/// used for the elements of animations made of matrices. Default 0.001.</summary>
+	float32 positionTolerance;
+	/// <summary>The largest angle allowed between a compressed and an original rotation, in radians. Default 0.001.
+	/// </summary>
+	float32 rotationTolerance;
+	/// <summary>The largest difference allowed between a compressed and an original scale factor. Default 0.001.
+	/// </summary>
+	float32 scaleTolerance;
+
+	AnimationCompressionOptions() : positionTolerance(0.001f), rotationTolerance(0.001f), scaleTolerance(0.001f) {}
+};
+
+/// <summary>A read-only, compressed copy of an Animation. Keys that linear interpolation (slerp for rotations) can
+/// rebuild within the tolerances are removed, rotations are stored in the 48 bit smallest-three form and positions
+/// and scales as 16 bit values in the range of their track.</summary>
+/// <remarks>Sampling gives the same transformation as Animation::getTransformationMatrix, within the tolerances
+/// and the quantization error of positions and scales (1/131070 of the range of their track). Use a Cursor to
+/// sample sequential frames: it remembers the keys it found last, so that moving to the next frame does not search
+/// the keys again.</remarks>
+class CompressedAnimation
+{
+public:
+	/// <summary>Samples a CompressedAnimation, caching the keys of the last frame sampled. Cheapest when the frames
+	/// increase slowly, as in playback, but any frame can be sampled. Each thread needs its own cursor.</summary>
+	class Cursor : public utils::internal::KeyCursor<CompressedAnimation>
+	{
+	public:
+		/// <summary>Constructor. Call reset before use.</summary>
+		Cursor() : KeyCursor<CompressedAnimation>(NULL) {}
+
+		/// <summary>Constructor. Binds the cursor to an animation.</summary>
+		/// <param name="animation">The animation to sample. Must outlive the cursor.</param>
+		explicit Cursor(const CompressedAnimation& animation) : KeyCursor<CompressedAnimation>(&animation) {}
+
+		/// <summary>Get the transformation matrix of a frame.</summary>
+		/// <param name="frame">The frame. Can be fractional. Clamped to the frames of the animation.</param>
+		glm::mat4x4 getTransformationMatrix(float32 frame)
+		{
+			return _animation->getTransformationMatrix(frame, _keys);
+		}
+	};
+
+	/// <summary>Constructor. The animation is empty (identity) until compress is called.</summary>
+	CompressedAnimation() : _mode(ModeTransforms), _numFrames(0) {}
+
+	/// <summary>Compress an animation.</summary>
+	/// <param name="animation">The animation to compress</param>
+	/// <param name="options">The tolerances of the compression</param>
+	/// <returns>True on success, false if the animation has more than 65536 frames or inconsistent data</returns>
+	bool compress(const Animation& animation, const AnimationCompressionOptions& options = AnimationCompressionOptions());
+
+	/// <summary>Get the number of frames of the original animation.</summary>
+	uint32 getNumFrames() const { return _numFrames; }
+
+	/// <summary>Get the number of keys kept, for all tracks.</summary>
+	uint32 getNumKeys() const;
+
+	/// <summary>Get the size of the compressed data in bytes, including this object.</summary>
+	size_t getDataSize() const;
+
+	/// <summary>Get the transformation matrix of a frame, searching the keys. Prefer a Cursor for playback.</summary>
+	/// <param name="frame">The frame. Can be fractional. Clamped to the frames of the animation.</param>
+	glm::mat4x4 getTransformationMatrix(float32 frame) const
+	{
+		uint32 keys[4] = { 0, 0, 0, 0 };
+		return getTransformationMatrix(frame, keys);
+	}
+
+private:
+	enum Mode { ModeTransforms, ModeMatrices };
+	enum TrackType { TrackPosition, TrackRotation, TrackScale, TrackMatrix };
+
+	// The keys of a track: the frame of each key, and either the quantized values (3 per key) or the unquantized
+	// floats of matrix tracks (16 per key) and of tracks with a single key.
+	struct Track
+	{
+		std::vector<uint16> frames;
+		std::vector<uint16> values;
+		std::vector<float32> floats;
+		glm::vec3 minimum;
+		glm::vec3 extent;
+		Track() : minimum(0.0f), extent(0.0f) {}
+	};
+
+	Mode _mode;
+	uint32 _numFrames;
+	Track _tracks[4];
+
+	static glm::vec3 sampleVector(const Track& track, float32 frame, uint32& key);
+	glm::mat4x4 getTransformationMatrix(float32 frame, uint32* keys) const;
+};
+
+/// <summary>Compress the animations of all the nodes of a model.</summary>
+/// <param name="model">The model</param>
+/// <param name="animations">The compressed animation of each node, indexed by node</param>
+/// <param name="options">The tolerances of the compression</param>
+/// <returns>True on success, false if any animation could not be compressed</returns>
+bool compressAnimations(const Model& model, std::vector<CompressedAnimation>& animations,
+                        const AnimationCompressionOptions& options = AnimationCompressionOptions());
+}
+}
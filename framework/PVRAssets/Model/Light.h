@@ -105,6 +105,9 @@ public:
 	/// <summary>Get a reference to the internal representation of this object. Handle with care.</summary>
 	InternalData& getInternalData(); // If you know what you're doing
 
+	/// <summary>Get a const reference to the internal representation of this object.</summary>
+	const InternalData& getInternalData() const { return _data; }
+
 private:
 	InternalData _data;
 };
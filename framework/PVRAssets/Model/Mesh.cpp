@@ -95,6 +95,17 @@ void Mesh::removeData(uint32 index)
 {
 	// Remove element
 	_data.vertexAttributeDataBlocks.erase(_data.vertexAttributeDataBlocks.begin() + index);
+	for (size_t i = _data.deferredDataBlocks.size(); i-- > 0;)
+	{
+		if (_data.deferredDataBlocks[i].dataIndex == index)
+		{
+			_data.deferredDataBlocks.erase(_data.deferredDataBlocks.begin() + i);
+		}
+		else if (_data.deferredDataBlocks[i].dataIndex > index)
+		{
+			--_data.deferredDataBlocks[i].dataIndex;
+		}
+	}
 
 	VertexAttributeContainer::iterator walk = _data.vertexAttributes.begin();
 
@@ -115,6 +126,33 @@ void Mesh::removeData(uint32 index)
 	}
 }
 
+bool Mesh::loadDeferredData()
+{
+	if (_data.deferredDataBlocks.empty()) { return true; }
+	std::vector<DeferredDataBlock> blocks;
+	blocks.swap(_data.deferredDataBlocks);
+
+	Stream::ptr_type stream;
+	if (_data.deferredDataSource) { stream = _data.deferredDataSource(); }
+	bool result = stream.get() && (stream->isopen() || stream->open());
+	for (size_t i = 0; result && i < blocks.size(); ++i)
+	{
+		const DeferredDataBlock& block = blocks[i];
+		if (block.dataIndex >= _data.vertexAttributeDataBlocks.size()) { continue; }
+		StridedBuffer& buffer = _data.vertexAttributeDataBlocks[block.dataIndex];
+		buffer.resize(block.size);
+		size_t dataRead = 0;
+		result = stream->seek((long)block.offset, Stream::SeekOriginFromStart) &&
+		         stream->read(1, block.size, buffer.data(), dataRead) && dataRead == block.size;
+	}
+	if (!result)
+	{
+		Log(Log.Error, "Mesh::loadDeferredData: Could not read the deferred vertex data of the mesh");
+	}
+	_data.deferredDataSource = nullptr;
+	return result;
+}
+
 // Should this take all the parameters for an element along with data or just pass in an already complete class? or both?
 int32 Mesh::addVertexAttribute(const VertexAttributeData& element, bool forceReplace)
 {
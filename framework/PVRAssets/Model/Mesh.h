@@ -153,14 +153,37 @@ public:
 		types::PrimitiveTopology primitiveType; //!< Type of primitive in this Mesh
 		bool isIndexed;                   //!< Contains indexes (as opposed to being a flat list of vertices)
 		bool isSkinned;                   //!< Contains indexes (as opposed to being a flat list of vertices)
+		bool usesPrimitiveRestart;        //!< The strips are separated by a restart index (all bits set) in the index
+		                                  //!< data, so that the whole mesh is drawn as one strip of getNumIndices()
 
 		MeshInfo() : numVertices(0), numFaces(0), numPatchSubdivisions(0), numPatches(0), numControlPointsPerPatch(0), units(1.0f),
-			primitiveType(types::PrimitiveTopology::TriangleList), isIndexed(true), isSkinned(0) { }
+			primitiveType(types::PrimitiveTopology::TriangleList), isIndexed(true), isSkinned(0), usesPrimitiveRestart(false) { }
 	};
 
 	//This container should always be kept sorted so that binary search can be done.
 	typedef IndexedArray<VertexAttributeData, StringHash> VertexAttributeContainer;
 
+	/// <summary>A data block whose contents are still in the file the mesh was read from. It is read the first time
+	/// the data of the mesh is accessed.</summary>
+	struct DeferredDataBlock
+	{
+		uint32 dataIndex; //!< The index of the data block
+		uint64 offset;    //!< The offset of the contents of the data block in the stream
+		uint32 size;      //!< The size of the data block in bytes
+	};
+
+	/// <summary>A reduced version of the triangles of the mesh, used when the mesh is far away. It uses the vertex
+	/// data of the mesh.</summary>
+	struct LevelOfDetail
+	{
+		FaceData faces;      //!< The triangle list of this level of detail
+		uint32 numFaces;     //!< The number of triangles of this level of detail
+		uint32 numVertices;  //!< This level of detail only uses the first (numVertices) vertices of the mesh
+		float32 error;       //!< An estimate of the distance between this level of detail and the mesh, in model units
+
+		LevelOfDetail() : numFaces(0), numVertices(0), error(0.0f) {}
+	};
+
 	/// <summary>Raw internal structure of the Mesh.</summary>
 	struct InternalData
 	{
@@ -174,10 +197,20 @@ public:
 		BoneBatches boneBatches;   //!< Faces information
 		glm::mat4x4 unpackMatrix;  //!< This matrix is used to move from an int16 representation to a float
 		RefCountedResource<void> userDataPtr; //!< This is a pointer that is in complete control of the user, used for per-mesh data.
+		std::vector<DeferredDataBlock> deferredDataBlocks; //!< Data blocks that have not been read from their stream yet
+		std::function<Stream::ptr_type()> deferredDataSource; //!< Opens the stream the deferred data blocks are read from
+		std::vector<LevelOfDetail> levelsOfDetail; //!< Reduced versions of the faces, from the most detailed to the least
 	};
 
 private:
 	InternalData _data;
+
+	// Reading deferred data does not change the logical contents of the mesh, so it is allowed on const meshes.
+	void loadDeferredDataIfNeeded() const
+	{
+		if (!_data.deferredDataBlocks.empty()) { const_cast<Mesh*>(this)->loadDeferredData(); }
+	}
+
 	class PredicateVertAttribMinOffset
 	{
 	public:
@@ -234,12 +267,27 @@ public:
 	void clearAllData()
 	{
 		_data.vertexAttributeDataBlocks.clear();
+		_data.deferredDataBlocks.clear();
 	}
 
+	/// <summary>Check if any data block of this mesh has not been read from its file yet (see
+	/// ModelLoadOptions::deferVertexData).</summary>
+	/// <returns>True if some vertex data is still to be read</returns>
+	bool hasDeferredData() const { return !_data.deferredDataBlocks.empty(); }
+
+	/// <summary>Read the data blocks of this mesh that have not been read from their file yet. This is done
+	/// automatically the first time getData or getDataSize are called, but can be called explicitly to control when
+	/// the file is accessed. Reading deferred data is not thread safe: if the mesh is shared between threads, call
+	/// this function before sharing it.</summary>
+	/// <returns>True if all the data was read (or there was nothing to read), false if the file could not be read.
+	/// </returns>
+	bool loadDeferredData();
+
 	/// <summary>Get a pointer to the data of a specified Data block. Read only overload.</summary>
 	/// <returns>A const pointer to the specified data block.</returns>
 	const void* getData(uint32 index) const
 	{
+		loadDeferredDataIfNeeded();
 		return static_cast<const void*>(_data.vertexAttributeDataBlocks[index].data());
 	}
 
@@ -247,12 +295,14 @@ public:
 	/// <returns>A pointer to the specified data block.</returns>
 	byte* getData(uint32 index)
 	{
+		loadDeferredDataIfNeeded();
 		return (index >= _data.vertexAttributeDataBlocks.size()) ? NULL : _data.vertexAttributeDataBlocks[index].data();
 	}
 	/// <summary>Get the size of the specified Data block.</summary>
 	/// <returns>The size in bytes of the specified Data block.</returns>
 	size_t getDataSize(uint32 index) const
 	{
+		loadDeferredDataIfNeeded();
 		return _data.vertexAttributeDataBlocks[index].size();
 	}
 	/// <summary>Get distance in bytes from vertex in an array to the next.</summary>
@@ -309,10 +359,14 @@ public:
 	/// <summary>Get the number of faces that comprise the designated bonebatch.</summary>
 	uint32 getNumFaces(uint32 boneBatch) const;
 
-	/// <summary>Get the number of indexes that comprise this mesh. Takes TriangleStrips into consideration.
-	/// </summary>
+	/// <summary>Get the number of indexes that comprise this mesh. Takes TriangleStrips, and the restart indexes
+	/// between them, into consideration.</summary>
 	uint32 getNumIndices() const
 	{
+		if (_data.primitiveData.stripLengths.size() && _data.primitiveData.usesPrimitiveRestart)
+		{
+			return (uint32)(_data.primitiveData.numFaces + (_data.primitiveData.stripLengths.size() * 3) - 1);
+		}
 		return (uint32)(_data.primitiveData.stripLengths.size() ?
 		                _data.primitiveData.numFaces + (_data.primitiveData.stripLengths.size() * 2) :
 		                _data.primitiveData.numFaces * 3);
@@ -412,6 +466,38 @@ public:
 	/// <summary>Get all face data of this mesh.</summary>
 	FaceData& getFaces() { return _data.faces; }
 
+	/// <summary>Get the number of levels of detail of this mesh, not counting the faces of the mesh itself.</summary>
+	uint32 getNumLevelsOfDetail() const { return (uint32)_data.levelsOfDetail.size(); }
+
+	/// <summary>Get a level of detail of this mesh.</summary>
+	/// <param name="lod">The index of the level of detail. 0 is the most detailed after the mesh itself.</param>
+	const LevelOfDetail& getLevelOfDetail(uint32 lod) const { return _data.levelsOfDetail[lod]; }
+
+	/// <summary>Add a level of detail after the existing ones. It must have fewer faces than the previous ones.
+	/// </summary>
+	void addLevelOfDetail(const LevelOfDetail& levelOfDetail) { _data.levelsOfDetail.push_back(levelOfDetail); }
+
+	/// <summary>Remove all the levels of detail of this mesh.</summary>
+	void clearLevelsOfDetail() { _data.levelsOfDetail.clear(); }
+
+	/// <summary>Select the least detailed level of detail whose error is not visible on screen.</summary>
+	/// <param name="distance">The distance from the camera to the mesh, in model units</param>
+	/// <param name="pixelsPerUnit">The size in pixels of one model unit at distance 1. For a perspective projection,
+	/// this is viewportHeight / (2 * tan(fovY / 2)).</param>
+	/// <param name="maxPixelError">The largest error allowed, in pixels</param>
+	/// <returns>The index of the level of detail plus one, or 0 if the faces of the mesh itself must be used.
+	/// </returns>
+	uint32 selectLevelOfDetail(float32 distance, float32 pixelsPerUnit, float32 maxPixelError = 1.0f) const
+	{
+		uint32 selected = 0;
+		for (uint32 i = 0; i < _data.levelsOfDetail.size(); ++i)
+		{
+			if (_data.levelsOfDetail[i].error * pixelsPerUnit > maxPixelError * distance) { break; }
+			selected = i + 1;
+		}
+		return selected;
+	}
+
 	/// <summary>Get the information of a VertexAttribute by its SemanticName.</summary>
 	/// <returns>A VertexAttributeData object with information on this attribute. (layout, index etc.) Null if
 	/// failed</returns>
@@ -533,6 +619,12 @@ public:
 		return _data;
 	}
 
+	/// <summary>Get a const reference to the internal representation and data of this Mesh.</summary>
+	const InternalData& getInternalData() const
+	{
+		return _data;
+	}
+
 };
 }
 }
\ No newline at end of file
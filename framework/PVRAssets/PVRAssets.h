@@ -8,6 +8,7 @@
 #include "PVRAssets/Model.h"
 #include "PVRAssets/Shader.h"
 #include "PVRAssets/FileIO/PODReader.h"
+#include "PVRAssets/FileIO/CookedModelReader.h"
 #include "PVRAssets/FileIO/PFXReader.h"
 #include "PVRAssets/FileIO/PFXParser.h"
 #include "PVRAssets/TextureLoad.h"
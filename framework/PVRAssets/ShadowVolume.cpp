@@ -5,12 +5,22 @@
 \copyright Copyright (c) Imagination Technologies Limited.
 */
 //!\cond NO_DOXYGEN
+#include <algorithm>
 #include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "PVRAssets/ShadowVolume.h"
 #include "PVRAssets/Helper.h"
 
 #include "PVRCore/Log.h"
+#if defined(PVR_SUPPORT_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(PVR_SUPPORT_NEON)
+#include <arm_neon.h>
+#endif
 using std::pair;
 using std::map;
 // TODO: Test the hyper cube bounding code as it is untested
@@ -47,167 +57,207 @@ ShadowVolume::~ShadowVolume()
 	delete [] _shadowMesh.edges;
 	delete [] _shadowMesh.triangles;
 	delete [] _shadowMesh.vertexData;
+	delete [] _shadowMesh.facingData;
+	delete [] _shadowMesh.triangleFacing;
+	delete [] _shadowMesh.overflowEdges;
+	delete [] _shadowMesh.triangleEdgeSlots;
+	delete [] _shadowMesh.edgeFlags;
 }
 
-uint32 ShadowVolume::findOrCreateVertex(const glm::vec3& vertex, bool& existed)
+namespace {
+// Below this number of triangles per thread, the edges are built on fewer threads.
+const uint32 MinTrianglesPerThread = 16384;
+// Below this number of triangles (and edges) per thread, silhouettes are projected on fewer threads.
+const uint32 MinProjectedTrianglesPerThread = 8192;
+
+// Run function(thread, begin, end) over contiguous ranges of [0, count) on numThreads threads, the calling thread
+// taking the first range. Ranges start at multiples of alignment.
+template<typename Function>
+void runOnThreads(uint32 numThreads, uint32 count, uint32 alignment, const Function& function)
 {
-	// First check whether we already have a vertex here
-	for (uint32 i = 0; i < _shadowMesh.numVertices; ++i)
+	const uint32 perThread = ((count + numThreads - 1) / numThreads + alignment - 1) / alignment * alignment;
+	std::vector<std::thread> workers;
+	for (uint32 thread = 1; thread < numThreads && thread * perThread < count; ++thread)
 	{
-		if (_shadowMesh.vertices[i].x == vertex.x && _shadowMesh.vertices[i].y == vertex.y && _shadowMesh.vertices[i].z == vertex.z)
+		workers.push_back(std::thread(function, thread, thread * perThread, std::min((thread + 1) * perThread, count)));
+	}
+	function(0, 0, std::min(perThread, count));
+	for (auto& worker : workers) { worker.join(); }
+}
+
+// Set facing[i] to 1 if triangle i of [begin, end) faces the light (the dot product of its normal with the direction
+// from the light is positive or zero), else 0, and return the number of triangles facing the light.
+uint32 computeFacing(const float32* facingData, uint32 stride, const glm::vec3& lightModel, bool isPointLight,
+                     uint32 begin, uint32 end, byte* facing)
+{
+	const float32* nx = facingData, *ny = nx + stride, *nz = ny + stride;
+	const float32* px = nz + stride, *py = px + stride, *pz = py + stride;
+	uint32 numLit = 0;
+	uint32 i = begin;
+#if defined(PVR_SUPPORT_SSE2) || defined(PVR_SUPPORT_NEON)
+	// The four facing bytes of each mask of four comparisons, stored at once.
+	static const uint32 maskBytes[16] =
+	{
+		0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+	};
+	const uint32 vectorEnd = begin + ((end - begin) & ~3u);
+#endif
+#if defined(PVR_SUPPORT_SSE2)
+	const __m128 lx = _mm_set1_ps(lightModel.x), ly = _mm_set1_ps(lightModel.y), lz = _mm_set1_ps(lightModel.z);
+	for (; i < vectorEnd; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(nx + i), y = _mm_loadu_ps(ny + i), z = _mm_loadu_ps(nz + i);
+		__m128 f;
+		if (isPointLight)
 		{
-			// Don't do anything more if the vertex already exists
-			existed = true;
-			return i;
+			f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_sub_ps(_mm_loadu_ps(px + i), lx)),
+			                          _mm_mul_ps(y, _mm_sub_ps(_mm_loadu_ps(py + i), ly))),
+			               _mm_mul_ps(z, _mm_sub_ps(_mm_loadu_ps(pz + i), lz)));
 		}
+		else
+		{
+			f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, lx), _mm_mul_ps(y, ly)), _mm_mul_ps(z, lz));
+		}
+		const uint32 bytes = maskBytes[_mm_movemask_ps(_mm_cmpge_ps(f, _mm_setzero_ps()))];
+		memcpy(facing + i, &bytes, 4);
+		numLit += (bytes * 0x01010101u) >> 24;
 	}
-
-	if (_shadowMesh.numVertices == 0)
+#elif defined(PVR_SUPPORT_NEON)
+	const float32x4_t lx = vdupq_n_f32(lightModel.x), ly = vdupq_n_f32(lightModel.y), lz = vdupq_n_f32(lightModel.z);
+	const uint32x4_t laneBits = { 1, 2, 4, 8 };
+	for (; i < vectorEnd; i += 4)
 	{
-		_shadowMesh.minimum = _shadowMesh.maximum = vertex;
+		const float32x4_t x = vld1q_f32(nx + i), y = vld1q_f32(ny + i), z = vld1q_f32(nz + i);
+		float32x4_t f;
+		if (isPointLight)
+		{
+			f = vaddq_f32(vaddq_f32(vmulq_f32(x, vsubq_f32(vld1q_f32(px + i), lx)), vmulq_f32(y, vsubq_f32(vld1q_f32(py + i), ly))),
+			              vmulq_f32(z, vsubq_f32(vld1q_f32(pz + i), lz)));
+		}
+		else
+		{
+			f = vaddq_f32(vaddq_f32(vmulq_f32(x, lx), vmulq_f32(y, ly)), vmulq_f32(z, lz));
+		}
+		const uint32x4_t lanes = vandq_u32(vcgeq_f32(f, vdupq_n_f32(0.0f)), laneBits);
+		const uint32x2_t pairs = vadd_u32(vget_low_u32(lanes), vget_high_u32(lanes));
+		const uint32 bytes = maskBytes[vget_lane_u32(vpadd_u32(pairs, pairs), 0)];
+		memcpy(facing + i, &bytes, 4);
+		numLit += (bytes * 0x01010101u) >> 24;
 	}
-	else
+#endif
+	for (; i < end; ++i)
 	{
-		if (vertex.x < _shadowMesh.minimum.x)
-		{ _shadowMesh.minimum.x = vertex.x; }
-
-		if (vertex.y < _shadowMesh.minimum.y)
-		{ _shadowMesh.minimum.y = vertex.y; }
-
-		if (vertex.z < _shadowMesh.minimum.z)
-		{ _shadowMesh.minimum.z = vertex.z; }
-
-		if (vertex.x > _shadowMesh.maximum.x)
-		{ _shadowMesh.maximum.x = vertex.x; }
-
-		if (vertex.y > _shadowMesh.maximum.y)
-		{ _shadowMesh.maximum.y = vertex.y; }
-
-		if (vertex.z > _shadowMesh.maximum.z)
-		{ _shadowMesh.maximum.z = vertex.z; }
+		const float32 f = isPointLight ?
+		                  nx[i] * (px[i] - lightModel.x) + ny[i] * (py[i] - lightModel.y) + nz[i] * (pz[i] - lightModel.z) :
+		                  nx[i] * lightModel.x + ny[i] * lightModel.y + nz[i] * lightModel.z;
+		facing[i] = f >= 0 ? 1 : 0;
+		numLit += facing[i];
 	}
+	return numLit;
+}
 
-	// Add the vertex
-	memcpy(&_shadowMesh.vertices[_shadowMesh.numVertices], &vertex, sizeof(vertex));
-	existed = false;
-	return _shadowMesh.numVertices++;
+// Find the first entry of overflowEdges (edge, first slot, end slot) whose edge is not below edge.
+inline const uint32* findOverflowEdge(const uint32* overflowEdges, uint32 numOverflowEdges, uint32 edge)
+{
+	const uint32* overflowEnd = overflowEdges + numOverflowEdges * 3;
+	while (overflowEdges != overflowEnd && overflowEdges[0] < edge) { overflowEdges += 3; }
+	return overflowEdges;
 }
 
-uint32 ShadowVolume::findOrCreateEdge(const glm::vec3& v0, const glm::vec3& v1, bool& existed)
+// Classify an edge from the flags its triangles wrote: 0 if it is not on the silhouette (all its triangles face the
+// light, or none does), 1 if it is, 3 if it is and its extrusion needs reversing. overflow points to the entry of the
+// next edge with more than two triangles, and is moved past it if it is this edge.
+inline uint32 classifyEdge(const byte* edgeFlags, uint32 edge, const uint32*& overflow, const uint32* overflowEnd)
 {
-	uint32 vertexIndices[2];
-	bool alreadyExisted[2];
-	vertexIndices[0] = findOrCreateVertex(v0, alreadyExisted[0]);
-	vertexIndices[1] = findOrCreateVertex(v1, alreadyExisted[1]);
+	uint32 visibilityFlags = edgeFlags[edge * 2] | edgeFlags[edge * 2 + 1];
+	if (overflow != overflowEnd && overflow[0] == edge)
+	{
+		for (uint32 j = overflow[1]; j < overflow[2]; ++j) { visibilityFlags |= edgeFlags[j]; }
+		overflow += 3;
+	}
+	const uint32 silhouette = (visibilityFlags & (visibilityFlags >> 1)) & 1;
+	return silhouette | (silhouette & (visibilityFlags >> 2)) << 1;
+}
 
-	if (alreadyExisted[0] && alreadyExisted[1])
+// Hashes positions by the cell of a grid over the bounding box of the mesh that contains them. Equal positions (0 and
+// -0 included) always fall in the same cell, so looking up exact matches in a bucket merges the same vertices as
+// comparing every pair.
+struct PositionHash
+{
+	glm::vec3 minimum;
+	glm::vec3 scale;
+	size_t operator()(const glm::vec3& position) const
 	{
-		// Check whether we already have an edge here
-		for (uint32 i = 0; i < _shadowMesh.numEdges; ++i)
+		uint32 cell[3];
+		for (uint32 i = 0; i < 3; ++i)
 		{
-			if ((_shadowMesh.edges[i].vertexIndices[0] == vertexIndices[0] && _shadowMesh.edges[i].vertexIndices[1] == vertexIndices[1]) ||
-			    (_shadowMesh.edges[i].vertexIndices[0] == vertexIndices[1] && _shadowMesh.edges[i].vertexIndices[1] == vertexIndices[0]))
-			{
-				// Don't do anything more if the edge already exists
-				existed = true;
-				return i;
-			}
+			const float32 value = (position[i] - minimum[i]) * scale[i];
+			cell[i] = value >= 0.0f && value < 4294967040.0f ? (uint32)value : 0;
 		}
+		return (size_t)((cell[0] * 73856093u) ^ (cell[1] * 19349663u) ^ (cell[2] * 83492791u));
 	}
+};
 
-	// Add the edge
-	_shadowMesh.edges[_shadowMesh.numEdges].vertexIndices[0] = vertexIndices[0];
-	_shadowMesh.edges[_shadowMesh.numEdges].vertexIndices[1] = vertexIndices[1];
-	_shadowMesh.edges[_shadowMesh.numEdges].visibilityFlags = 0;
-	existed = false;
-	return _shadowMesh.numEdges++;
-}
+struct PositionEqual
+{
+	bool operator()(const glm::vec3& a, const glm::vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+};
 
-void ShadowVolume::findOrCreateTriangle(const glm::vec3& v0, const glm::vec3& v1,
-                                        const glm::vec3& v2)
+// An edge is identified by its two vertices, in either direction.
+inline uint64 getEdgeKey(uint32 vertex0, uint32 vertex1)
 {
-	ShadowVolumeEdge* edge0, *edge1, *edge2;
-	uint32 edgeIndex0, edgeIndex1, edgeIndex2;
-	bool alreadyExisted[3];
+	return vertex0 < vertex1 ? ((uint64)vertex0 << 32) | vertex1 : ((uint64)vertex1 << 32) | vertex0;
+}
 
-	edgeIndex0 = findOrCreateEdge(v0, v1, alreadyExisted[0]);
-	edgeIndex1 = findOrCreateEdge(v1, v2, alreadyExisted[1]);
-	edgeIndex2 = findOrCreateEdge(v2, v0, alreadyExisted[2]);
+struct TriangleKey
+{
+	uint32 edges[3];
+	bool operator==(const TriangleKey& other) const
+	{
+		return edges[0] == other.edges[0] && edges[1] == other.edges[1] && edges[2] == other.edges[2];
+	}
+};
 
-	if (edgeIndex0 == edgeIndex1 || edgeIndex1 == edgeIndex2 || edgeIndex2 == edgeIndex0)
+struct TriangleKeyHash
+{
+	size_t operator()(const TriangleKey& key) const
 	{
-		// Degenerate triangle
-		return;
+		return (size_t)(key.edges[0] * 73856093u) ^ (size_t)(key.edges[1] * 19349663u) ^ (size_t)(key.edges[2] * 83492791u);
 	}
+};
 
-	// First check whether we already have a triangle here
-	if (alreadyExisted[0] && alreadyExisted[1] && alreadyExisted[2])
+// The edges found in a contiguous range of triangles, in the order they first appear, with their first direction.
+struct EdgeTable
+{
+	std::unordered_map<uint64, uint32> indices;
+	std::vector<uint32> vertices;
+};
+
+// Find the edges of the triangles [begin, end), writing the index of each edge in the table to triangleEdges.
+void buildEdgeTable(const uint32* cornerVertices, uint32 begin, uint32 end, EdgeTable& table, uint32* triangleEdges)
+{
+	table.indices.reserve((end - begin) * 2);
+	table.vertices.reserve((end - begin) * 4);
+	for (uint32 triangle = begin; triangle < end; ++triangle)
 	{
-		for (uint32 i = 0; i < _shadowMesh.numTriangles; ++i)
+		for (uint32 i = 0; i < 3; ++i)
 		{
-			if ((_shadowMesh.triangles[i].edgeIndices[0] == edgeIndex0 || _shadowMesh.triangles[i].edgeIndices[0] == edgeIndex1
-			     || _shadowMesh.triangles[i].edgeIndices[0] == edgeIndex2) &&
-			    (_shadowMesh.triangles[i].edgeIndices[1] == edgeIndex0 || _shadowMesh.triangles[i].edgeIndices[1] == edgeIndex1
-			     || _shadowMesh.triangles[i].edgeIndices[1] == edgeIndex2) &&
-			    (_shadowMesh.triangles[i].edgeIndices[2] == edgeIndex0 || _shadowMesh.triangles[i].edgeIndices[2] == edgeIndex1
-			     || _shadowMesh.triangles[i].edgeIndices[2] == edgeIndex2))
+			const uint32 vertex0 = cornerVertices[triangle * 3 + i], vertex1 = cornerVertices[triangle * 3 + (i + 1) % 3];
+			const std::pair<std::unordered_map<uint64, uint32>::iterator, bool> inserted =
+			  table.indices.insert(std::make_pair(getEdgeKey(vertex0, vertex1), (uint32)table.vertices.size() / 2));
+			if (inserted.second)
 			{
-				// Don't do anything more if the triangle already exists
-				return;
+				table.vertices.push_back(vertex0);
+				table.vertices.push_back(vertex1);
 			}
+			triangleEdges[triangle * 3 + i] = inserted.first->second;
 		}
 	}
-
-	// Add the triangle then
-	_shadowMesh.triangles[_shadowMesh.numTriangles].edgeIndices[0] = edgeIndex0;
-	_shadowMesh.triangles[_shadowMesh.numTriangles].edgeIndices[1] = edgeIndex1;
-	_shadowMesh.triangles[_shadowMesh.numTriangles].edgeIndices[2] = edgeIndex2;
-
-	// Store the triangle indices; these are indices into the shadow mesh, not the source model indices
-	edge0 = &_shadowMesh.edges[edgeIndex0];
-	edge1 = &_shadowMesh.edges[edgeIndex1];
-	edge2 = &_shadowMesh.edges[edgeIndex2];
-
-	if (edge0->vertexIndices[0] == edge1->vertexIndices[0] || edge0->vertexIndices[0] == edge1->vertexIndices[1])
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[0] = edge0->vertexIndices[1]; }
-	else
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[0] = edge0->vertexIndices[0]; }
-
-	if (edge1->vertexIndices[0] == edge2->vertexIndices[0] || edge1->vertexIndices[0] == edge2->vertexIndices[1])
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[1] = edge1->vertexIndices[1]; }
-	else
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[1] = edge1->vertexIndices[0]; }
-
-	if (edge2->vertexIndices[0] == edge0->vertexIndices[0] || edge2->vertexIndices[0] == edge0->vertexIndices[1])
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[2] = edge2->vertexIndices[1]; }
-	else
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].vertexIndices[2] = edge2->vertexIndices[0]; }
-
-	// Calculate the triangle normal
-	glm::vec3 n0(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
-	glm::vec3 n1(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
-
-	_shadowMesh.triangles[_shadowMesh.numTriangles].normal.x = n0.y * n1.z - n0.z * n1.y;
-	_shadowMesh.triangles[_shadowMesh.numTriangles].normal.y = n0.z * n1.x - n0.x * n1.z;
-	_shadowMesh.triangles[_shadowMesh.numTriangles].normal.z = n0.x * n1.y - n0.y * n1.x;
-
-	// Check which edges have the correct winding order for this triangle
-	_shadowMesh.triangles[_shadowMesh.numTriangles].winding = 0;
-
-	if (memcmp(&_shadowMesh.vertices[edge0->vertexIndices[0]], &v0, sizeof(v0)) == 0)
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].winding |= 0x01; }
-
-	if (memcmp(&_shadowMesh.vertices[edge1->vertexIndices[0]], &v1, sizeof(v1)) == 0)
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].winding |= 0x02; }
-
-	if (memcmp(&_shadowMesh.vertices[edge2->vertexIndices[0]], &v2, sizeof(v2)) == 0)
-	{ _shadowMesh.triangles[_shadowMesh.numTriangles].winding |= 0x04; }
-
-	++_shadowMesh.numTriangles;
-	return;
+}
 }
 
-Result ShadowVolume::init(const assets::Mesh& mesh)
+Result ShadowVolume::init(const assets::Mesh& mesh, uint32 numThreads)
 {
 	const assets::Mesh::VertexAttributeData* positions = mesh.getVertexAttributeByName("POSITION");
 
@@ -220,120 +270,234 @@ Result ShadowVolume::init(const assets::Mesh& mesh)
 	const assets::Mesh::FaceData& faceData = mesh.getFaces();
 
 	return init(static_cast<const byte*>(mesh.getData(posIdx)), mesh.getNumVertices(), mesh.getStride(posIdx),
-	            positions->getVertexLayout().dataType, faceData.getData(), mesh.getNumFaces(), faceData.getDataType());
+	            positions->getVertexLayout().dataType, faceData.getData(), mesh.getNumFaces(), faceData.getDataType(),
+	            numThreads);
 }
 
 Result ShadowVolume::init(const byte* const data, uint32 numVertices,
                           uint32 verticesStride, DataType vertexType, const byte* const faceData,
-                          uint32 numFaces, IndexType indexType)
+                          uint32 numFaces, IndexType indexType, uint32 numThreads)
 {
 	delete [] _shadowMesh.vertices;
+	_shadowMesh.vertices = NULL;
 	_shadowMesh.numVertices = 0;
 
 	delete [] _shadowMesh.edges;
+	_shadowMesh.edges = NULL;
 	_shadowMesh.numEdges = 0;
 
 	delete [] _shadowMesh.triangles;
+	_shadowMesh.triangles = NULL;
 	_shadowMesh.numTriangles = 0;
 
-	_shadowMesh.vertices = new glm::vec3[numVertices];
-
+	// Read the corners of every triangle.
+	const uint32 numInputTriangles = faceData ? numFaces : numVertices / 3;
+	std::vector<glm::vec3> corners(numInputTriangles * 3);
 	if (faceData)
 	{
-		_shadowMesh.edges = new ShadowVolumeEdge[3 * numFaces];
-		_shadowMesh.triangles = new ShadowVolumeTriangle[3 * numFaces];
-
 		uint32 indexStride = indexTypeSizeInBytes(indexType);
 
 		byte* facePtr = (byte*) faceData;
 
-		for (uint32 i = 0; i < numFaces; ++i)
+		for (uint32 i = 0; i < numInputTriangles * 3; ++i)
 		{
-			uint32 indices[3];
-			VertexIndexRead(facePtr, indexType, &indices[0]);
-			facePtr += indexStride;
-			VertexIndexRead(facePtr, indexType, &indices[1]);
-			facePtr += indexStride;
-			VertexIndexRead(facePtr, indexType, &indices[2]);
+			uint32 index;
+			VertexIndexRead(facePtr, indexType, &index);
 			facePtr += indexStride;
-
-			glm::vec3 vertex0, vertex1, vertex2;
-			VertexRead(data + (verticesStride * indices[0]), vertexType, 3, &vertex0.x);
-			VertexRead(data + (verticesStride * indices[1]), vertexType, 3, &vertex1.x);
-			VertexRead(data + (verticesStride * indices[2]), vertexType, 3, &vertex2.x);
-
-			findOrCreateTriangle(vertex0, vertex1, vertex2);
+			VertexRead(data + (verticesStride * index), vertexType, 3, &corners[i].x);
 		}
 	}
 	else     // Non-index
 	{
-		_shadowMesh.edges = new ShadowVolumeEdge[numVertices / 3];
-		_shadowMesh.triangles = new ShadowVolumeTriangle[numVertices / 3];
-
-		for (uint32 i = 0; i < numVertices; i += 3)
+		if (!corners.empty())
 		{
-			glm::vec3 vertex0, vertex1, vertex2;
-			VertexRead(data + (verticesStride * (i + 0)), vertexType, 3, &vertex0.x);
-			VertexRead(data + (verticesStride * (i + 1)), vertexType, 3, &vertex1.x);
-			VertexRead(data + (verticesStride * (i + 2)), vertexType, 3, &vertex2.x);
-
-			findOrCreateTriangle(vertex0, vertex1, vertex2);
+			VertexReadBatch(data, verticesStride, vertexType, 3, numInputTriangles * 3, &corners[0].x, 3);
 		}
 	}
 
-#ifdef DEBUG
-	// Check the data is valid
-	for (uint32 edge = 0; edge < _shadowMesh.numEdges; ++edge)
+	// Merge the corners with the same position into vertices, numbered in the order they first appear.
+	std::vector<glm::vec3> vertices;
+	std::vector<uint32> cornerVertices(corners.size());
+	if (!corners.empty())
 	{
-		uint32 count = 0;
-		for (uint32 triangle = 0; triangle < _shadowMesh.numTriangles; ++triangle)
+		_shadowMesh.minimum = _shadowMesh.maximum = corners[0];
+		for (size_t i = 1; i < corners.size(); ++i)
 		{
-			if (_shadowMesh.triangles[triangle].edgeIndices[0] == edge)
-			{ ++count; }
-
-			if (_shadowMesh.triangles[triangle].edgeIndices[1] == edge)
-			{ ++count; }
-
-			if (_shadowMesh.triangles[triangle].edgeIndices[2] == edge)
-			{ ++count; }
+			_shadowMesh.minimum = glm::min(_shadowMesh.minimum, corners[i]);
+			_shadowMesh.maximum = glm::max(_shadowMesh.maximum, corners[i]);
+		}
+		PositionHash hash;
+		hash.minimum = _shadowMesh.minimum;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			const float32 extent = _shadowMesh.maximum[i] - _shadowMesh.minimum[i];
+			hash.scale[i] = extent > 0.0f ? 1023.0f / extent : 0.0f;
+		}
+		std::unordered_map<glm::vec3, uint32, PositionHash, PositionEqual> vertexIndices(corners.size(), hash);
+		for (size_t i = 0; i < corners.size(); ++i)
+		{
+			const std::pair<std::unordered_map<glm::vec3, uint32, PositionHash, PositionEqual>::iterator, bool> inserted =
+			  vertexIndices.insert(std::make_pair(corners[i], (uint32)vertices.size()));
+			if (inserted.second) { vertices.push_back(corners[i]); }
+			cornerVertices[i] = inserted.first->second;
 		}
+	}
 
-		/*
-			Every edge should be referenced exactly twice.
-			If they aren't then the mesh isn't closed which will cause problems when rendering the shadows.
-		*/
-		assertion(count == 2);
+	// Find the edges of contiguous ranges of triangles on several threads, then merge the tables in order so that the
+	// edges are numbered in the order they first appear, whatever the number of threads.
+	if (!numThreads) { numThreads = std::max(std::thread::hardware_concurrency(), 1u); }
+	numThreads = std::max(std::min(numThreads, numInputTriangles / MinTrianglesPerThread), 1u);
+	const uint32 trianglesPerThread = (numInputTriangles + numThreads - 1) / numThreads;
+	std::vector<EdgeTable> tables(numThreads);
+	std::vector<uint32> triangleEdges(numInputTriangles * 3);
+	{
+		std::vector<std::thread> workers;
+		for (uint32 thread = 1; thread < numThreads; ++thread)
+		{
+			workers.push_back(std::thread(buildEdgeTable, cornerVertices.data(), thread * trianglesPerThread,
+			                              std::min((thread + 1) * trianglesPerThread, numInputTriangles), std::ref(tables[thread]),
+			                              triangleEdges.data()));
+		}
+		buildEdgeTable(cornerVertices.data(), 0, std::min(trianglesPerThread, numInputTriangles), tables[0],
+		               triangleEdges.data());
+		for (auto& worker : workers) { worker.join(); }
+	}
+	EdgeTable& edges = tables[0];
+	std::vector<std::vector<uint32> > remaps(numThreads);
+	for (uint32 thread = 1; thread < numThreads; ++thread)
+	{
+		const EdgeTable& table = tables[thread];
+		remaps[thread].resize(table.vertices.size() / 2);
+		for (size_t i = 0; i < remaps[thread].size(); ++i)
+		{
+			const uint32 vertex0 = table.vertices[i * 2], vertex1 = table.vertices[i * 2 + 1];
+			const std::pair<std::unordered_map<uint64, uint32>::iterator, bool> inserted =
+			  edges.indices.insert(std::make_pair(getEdgeKey(vertex0, vertex1), (uint32)edges.vertices.size() / 2));
+			if (inserted.second)
+			{
+				edges.vertices.push_back(vertex0);
+				edges.vertices.push_back(vertex1);
+			}
+			remaps[thread][i] = inserted.first->second;
+		}
+		tables[thread] = EdgeTable();
+	}
+	for (uint32 thread = 1; thread < numThreads; ++thread)
+	{
+		const uint32 end = std::min((thread + 1) * trianglesPerThread, numInputTriangles) * 3;
+		for (uint32 i = thread * trianglesPerThread * 3; i < end; ++i) { triangleEdges[i] = remaps[thread][triangleEdges[i]]; }
 	}
 
-#endif
+	_shadowMesh.numVertices = (uint32)vertices.size();
+	_shadowMesh.vertices = new glm::vec3[_shadowMesh.numVertices];
+	if (!vertices.empty()) { memcpy(_shadowMesh.vertices, vertices.data(), vertices.size() * sizeof(vertices[0])); }
 
-	// Create the real mesh
+	_shadowMesh.numEdges = (uint32)edges.vertices.size() / 2;
+	_shadowMesh.edges = new ShadowVolumeEdge[_shadowMesh.numEdges];
+	for (uint32 i = 0; i < _shadowMesh.numEdges; ++i)
 	{
-		glm::vec3* tmp = new glm::vec3[_shadowMesh.numVertices];
-
-		memcpy(tmp, _shadowMesh.vertices, _shadowMesh.numVertices * sizeof(*_shadowMesh.vertices));
-		delete [] _shadowMesh.vertices;
-		_shadowMesh.vertices = tmp;
+		_shadowMesh.edges[i].vertexIndices[0] = edges.vertices[i * 2];
+		_shadowMesh.edges[i].vertexIndices[1] = edges.vertices[i * 2 + 1];
+		_shadowMesh.edges[i].visibilityFlags = 0;
 	}
+	edges = EdgeTable();
 
+	// Add the triangles, skipping the degenerate ones and the ones made of the same edges as a previous one.
+	std::vector<ShadowVolumeTriangle> triangles;
+	triangles.reserve(numInputTriangles);
+	std::unordered_set<TriangleKey, TriangleKeyHash> triangleKeys(numInputTriangles);
+	for (uint32 i = 0; i < numInputTriangles; ++i)
 	{
-		ShadowVolumeEdge* tmp = new ShadowVolumeEdge[_shadowMesh.numEdges];
+		const uint32 edgeIndex0 = triangleEdges[i * 3], edgeIndex1 = triangleEdges[i * 3 + 1];
+		const uint32 edgeIndex2 = triangleEdges[i * 3 + 2];
+		if (edgeIndex0 == edgeIndex1 || edgeIndex1 == edgeIndex2 || edgeIndex2 == edgeIndex0)
+		{
+			// Degenerate triangle
+			continue;
+		}
+		TriangleKey key = { { edgeIndex0, edgeIndex1, edgeIndex2 } };
+		std::sort(key.edges, key.edges + 3);
+		if (!triangleKeys.insert(key).second) { continue; }
+
+		const glm::vec3& v0 = corners[i * 3];
+		const glm::vec3& v1 = corners[i * 3 + 1];
+		const glm::vec3& v2 = corners[i * 3 + 2];
+		ShadowVolumeTriangle triangle;
+		triangle.edgeIndices[0] = edgeIndex0;
+		triangle.edgeIndices[1] = edgeIndex1;
+		triangle.edgeIndices[2] = edgeIndex2;
+
+		// Store the triangle indices; these are indices into the shadow mesh, not the source model indices
+		const ShadowVolumeEdge* edge0 = &_shadowMesh.edges[edgeIndex0];
+		const ShadowVolumeEdge* edge1 = &_shadowMesh.edges[edgeIndex1];
+		const ShadowVolumeEdge* edge2 = &_shadowMesh.edges[edgeIndex2];
+
+		if (edge0->vertexIndices[0] == edge1->vertexIndices[0] || edge0->vertexIndices[0] == edge1->vertexIndices[1])
+		{ triangle.vertexIndices[0] = edge0->vertexIndices[1]; }
+		else
+		{ triangle.vertexIndices[0] = edge0->vertexIndices[0]; }
 
-		memcpy(tmp, _shadowMesh.edges, _shadowMesh.numEdges * sizeof(*_shadowMesh.edges));
-		delete [] _shadowMesh.edges;
-		_shadowMesh.edges = tmp;
+		if (edge1->vertexIndices[0] == edge2->vertexIndices[0] || edge1->vertexIndices[0] == edge2->vertexIndices[1])
+		{ triangle.vertexIndices[1] = edge1->vertexIndices[1]; }
+		else
+		{ triangle.vertexIndices[1] = edge1->vertexIndices[0]; }
+
+		if (edge2->vertexIndices[0] == edge0->vertexIndices[0] || edge2->vertexIndices[0] == edge0->vertexIndices[1])
+		{ triangle.vertexIndices[2] = edge2->vertexIndices[1]; }
+		else
+		{ triangle.vertexIndices[2] = edge2->vertexIndices[0]; }
+
+		// Calculate the triangle normal
+		glm::vec3 n0(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+		glm::vec3 n1(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+
+		triangle.normal.x = n0.y * n1.z - n0.z * n1.y;
+		triangle.normal.y = n0.z * n1.x - n0.x * n1.z;
+		triangle.normal.z = n0.x * n1.y - n0.y * n1.x;
+
+		// Check which edges have the correct winding order for this triangle
+		triangle.winding = 0;
+
+		if (memcmp(&_shadowMesh.vertices[edge0->vertexIndices[0]], &v0, sizeof(v0)) == 0)
+		{ triangle.winding |= 0x01; }
+
+		if (memcmp(&_shadowMesh.vertices[edge1->vertexIndices[0]], &v1, sizeof(v1)) == 0)
+		{ triangle.winding |= 0x02; }
+
+		if (memcmp(&_shadowMesh.vertices[edge2->vertexIndices[0]], &v2, sizeof(v2)) == 0)
+		{ triangle.winding |= 0x04; }
+
+		triangles.push_back(triangle);
+	}
+	_shadowMesh.numTriangles = (uint32)triangles.size();
+	_shadowMesh.triangles = new ShadowVolumeTriangle[_shadowMesh.numTriangles];
+	if (!triangles.empty())
+	{
+		memcpy(_shadowMesh.triangles, triangles.data(), triangles.size() * sizeof(triangles[0]));
 	}
 
+#ifdef DEBUG
+	// Check the data is valid
 	{
-		ShadowVolumeTriangle* tmp = new ShadowVolumeTriangle[_shadowMesh.numTriangles];
+		std::vector<uint32> counts(_shadowMesh.numEdges, 0);
+		for (uint32 triangle = 0; triangle < _shadowMesh.numTriangles; ++triangle)
+		{
+			++counts[_shadowMesh.triangles[triangle].edgeIndices[0]];
+			++counts[_shadowMesh.triangles[triangle].edgeIndices[1]];
+			++counts[_shadowMesh.triangles[triangle].edgeIndices[2]];
+		}
 
-		memcpy(tmp, _shadowMesh.triangles, _shadowMesh.numTriangles * sizeof(*_shadowMesh.triangles));
-		delete [] _shadowMesh.triangles;
-		_shadowMesh.triangles = tmp;
+		/*
+			Every edge should be referenced exactly twice.
+			If they aren't then the mesh isn't closed which will cause problems when rendering the shadows.
+		*/
+		for (uint32 edge = 0; edge < _shadowMesh.numEdges; ++edge) { assertion(counts[edge] == 2); }
 	}
+#endif
 
 	_shadowMesh.needs32BitIndices = (_shadowMesh.numTriangles * 2 * 3) > 65535;
 
+	initializeSilhouetteData();
 	initializeVertexData();
 	return Result::Success;
 }
@@ -380,9 +544,10 @@ void ShadowVolume::initializeVertexData(byte** externalBuffer)
 
 void ShadowVolume::alllocateShadowVolume(uint32 volumeID)
 {
-	ShadowVolumeData volume;
+	ShadowVolumeData& volume = _shadowVolumes[volumeID];
+	delete [] volume.indexData;
 	volume.indexData = new byte[getIndexDataSize()];
-	_shadowVolumes.insert(pair<uint32, ShadowVolumeData>(volumeID, volume));
+	volume.indexCount = 0;
 }
 
 Result ShadowVolume::releaseVolume(uint32 volumeID)
@@ -478,26 +643,97 @@ byte* ShadowVolume::getIndices(uint32 volumeID)
 }
 
 Result ShadowVolume::projectSilhouette(uint32 volumeID, uint32 flags, const glm::vec3& lightModel, bool isPointLight,
-                                       byte** externalIndexBuffer)
+                                       byte** externalIndexBuffer, uint32 numThreads)
 {
 	if (_shadowMesh.needs32BitIndices)
 	{
-		return project<uint32>(volumeID, flags, lightModel, isPointLight, reinterpret_cast<uint32**>(externalIndexBuffer));
+		return project<uint32>(volumeID, flags, lightModel, isPointLight, reinterpret_cast<uint32**>(externalIndexBuffer),
+		                       numThreads);
 	}
 	else
 	{
-		return project<uint16>(volumeID, flags, lightModel, isPointLight, reinterpret_cast<uint16**>(externalIndexBuffer));
+		return project<uint16>(volumeID, flags, lightModel, isPointLight, reinterpret_cast<uint16**>(externalIndexBuffer),
+		                       numThreads);
+	}
+}
+
+void ShadowVolume::initializeSilhouetteData()
+{
+	delete [] _shadowMesh.facingData;
+	delete [] _shadowMesh.triangleFacing;
+	delete [] _shadowMesh.overflowEdges;
+	delete [] _shadowMesh.triangleEdgeSlots;
+	delete [] _shadowMesh.edgeFlags;
+
+	const uint32 stride = (_shadowMesh.numTriangles + 3) & ~3u;
+	_shadowMesh.facingData = new float32[stride * 6];
+	std::fill(_shadowMesh.facingData, _shadowMesh.facingData + stride * 6, 0.0f);
+	_shadowMesh.triangleFacing = new byte[stride];
+	for (uint32 i = 0; i < _shadowMesh.numTriangles; ++i)
+	{
+		const ShadowVolumeTriangle& triangle = _shadowMesh.triangles[i];
+		const glm::vec3& vertex = _shadowMesh.vertices[_shadowMesh.edges[triangle.edgeIndices[0]].vertexIndices[0]];
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			_shadowMesh.facingData[c * stride + i] = triangle.normal[c];
+			_shadowMesh.facingData[(3 + c) * stride + i] = vertex[c];
+		}
+	}
+
+	// Give each triangle a slot of its own in the flags of each of its edges, so that triangles can write the flags of
+	// their edges concurrently: slots 2 * edge and 2 * edge + 1 for the first two triangles of an edge, and slots after
+	// 2 * numEdges for the others, listed in overflowEdges in the order of the edges.
+	std::vector<uint32> numEdgeTriangles(_shadowMesh.numEdges, 0);
+	for (uint32 i = 0; i < _shadowMesh.numTriangles; ++i)
+	{
+		for (uint32 k = 0; k < 3; ++k) { ++numEdgeTriangles[_shadowMesh.triangles[i].edgeIndices[k]]; }
+	}
+	std::vector<uint32> next(_shadowMesh.numEdges);
+	std::vector<uint32> overflowEdges;
+	uint32 numSlots = _shadowMesh.numEdges * 2;
+	for (uint32 i = 0; i < _shadowMesh.numEdges; ++i)
+	{
+		next[i] = i * 2;
+		if (numEdgeTriangles[i] > 2)
+		{
+			overflowEdges.push_back(i);
+			overflowEdges.push_back(numSlots);
+			numSlots += numEdgeTriangles[i] - 2;
+			overflowEdges.push_back(numSlots);
+		}
+	}
+	_shadowMesh.numOverflowEdges = (uint32)overflowEdges.size() / 3;
+	_shadowMesh.overflowEdges = new uint32[overflowEdges.size() + 1];
+	std::copy(overflowEdges.begin(), overflowEdges.end(), _shadowMesh.overflowEdges);
+	_shadowMesh.triangleEdgeSlots = new uint32[_shadowMesh.numTriangles * 3];
+	_shadowMesh.edgeFlags = new byte[numSlots];
+	std::fill(_shadowMesh.edgeFlags, _shadowMesh.edgeFlags + numSlots, 0);
+	for (uint32 i = 0; i < _shadowMesh.numTriangles; ++i)
+	{
+		const ShadowVolumeTriangle& triangle = _shadowMesh.triangles[i];
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			const uint32 edge = triangle.edgeIndices[k];
+			uint32 slot = next[edge]++;
+			if (slot == edge * 2 + 2)
+			{
+				// Third triangle of the edge: continue in its overflow slots.
+				slot = findOverflowEdge(_shadowMesh.overflowEdges, _shadowMesh.numOverflowEdges, edge)[1];
+				next[edge] = slot + 1;
+			}
+			_shadowMesh.triangleEdgeSlots[i * 3 + k] = slot * 2 + (((uint32)triangle.winding >> k) & 1);
+		}
 	}
 }
 
 template<typename INDEXTYPE>
 Result ShadowVolume::project(uint32 volumeID, uint32 flags, const glm::vec3& lightModel, bool isPointLight,
-                             INDEXTYPE** externalIndexBuffer)
+                             INDEXTYPE** externalIndexBuffer, uint32 numThreads)
 {
 	ShadowVolumeMapType::iterator found = _shadowVolumes.find(volumeID);
 	assertion(found != _shadowVolumes.end());
 
-	if (found != _shadowVolumes.end())
+	if (found == _shadowVolumes.end())
 	{
 		return Result::OutOfBounds;
 	}
@@ -508,111 +744,107 @@ Result ShadowVolume::project(uint32 volumeID, uint32 flags, const glm::vec3& lig
 	if (indices == NULL)
 	{ return Result::NoData; }
 
-	float32 f;
-	volume.indexCount = 0;
-
-	// Run through triangles, testing which face the From point
-	for (uint32 i = 0; i < _shadowMesh.numTriangles; ++i)
+	if (!numThreads) { numThreads = std::max(std::thread::hardware_concurrency(), 1u); }
+	numThreads = std::max(std::min(numThreads, std::max(_shadowMesh.numTriangles, _shadowMesh.numEdges) /
+	                                           MinProjectedTrianglesPerThread), 1u);
+	const uint32 numVertices = _shadowMesh.numVertices;
+	const uint32 stride = (_shadowMesh.numTriangles + 3) & ~3u;
+	const uint32 frontCap = (flags & Cap_front) ? 3 : 0;
+	const uint32 backCap = (flags & Cap_back) ? 3 : 0;
+	std::vector<uint32> capOffsets(numThreads + 1, 0), edgeOffsets(numThreads + 1, 0);
+
+	// Find which triangles face the light, and count the cap indices of each range of triangles.
+	runOnThreads(numThreads, _shadowMesh.numTriangles, 4, [&](uint32 thread, uint32 begin, uint32 end)
 	{
-		ShadowVolumeEdge* edge0, *edge1, *edge2;
-		edge0 = &_shadowMesh.edges[_shadowMesh.triangles[i].edgeIndices[0]];
-		edge1 = &_shadowMesh.edges[_shadowMesh.triangles[i].edgeIndices[1]];
-		edge2 = &_shadowMesh.edges[_shadowMesh.triangles[i].edgeIndices[2]];
-
-		if (isPointLight)
-		{
-			glm::vec3 v;
-			v.x = _shadowMesh.vertices[edge0->vertexIndices[0]].x - lightModel.x;
-			v.y = _shadowMesh.vertices[edge0->vertexIndices[0]].y - lightModel.y;
-			v.z = _shadowMesh.vertices[edge0->vertexIndices[0]].z - lightModel.z;
-
-			// Dot product
-			f = _shadowMesh.triangles[i].normal.x * v.x + _shadowMesh.triangles[i].normal.y * v.y + _shadowMesh.triangles[i].normal.z *
-			    v.z;
-		}
-		else
-		{
-			f = _shadowMesh.triangles[i].normal.x * lightModel.x + _shadowMesh.triangles[i].normal.y * lightModel.y +
-			    _shadowMesh.triangles[i].normal.z * lightModel.z;
-		}
-
-		if (f >= 0)
+		const uint32 numLit = computeFacing(_shadowMesh.facingData, stride, lightModel, isPointLight, begin, end,
+		                                    _shadowMesh.triangleFacing);
+		capOffsets[thread + 1] = numLit * frontCap + (end - begin - numLit) * backCap;
+	});
+
+	// Write the caps: triangles facing the light un-extruded, the others extruded. numVertices is used as an offset so
+	// that the index refers to the corresponding vertex in the second, extruded, copy of the vertices. At the same
+	// time, each triangle flags its edges: bit 0 if it faces the light, else bit 1, and bit 2 if the winding order of
+	// the extrusion of the edge needs reversing.
+	for (uint32 thread = 0; thread < numThreads; ++thread) { capOffsets[thread + 1] += capOffsets[thread]; }
+	runOnThreads(numThreads, _shadowMesh.numTriangles, 4, [&](uint32 thread, uint32 begin, uint32 end)
+	{
+		const ShadowVolumeTriangle* const triangles = _shadowMesh.triangles;
+		const byte* const facing = _shadowMesh.triangleFacing;
+		const uint32* const slots = _shadowMesh.triangleEdgeSlots;
+		byte* const edgeFlags = _shadowMesh.edgeFlags;
+		INDEXTYPE* out = indices + capOffsets[thread];
+		for (uint32 i = begin; i < end; ++i)
 		{
-			// Triangle is in the light
-			edge0->visibilityFlags |= 0x01;
-			edge1->visibilityFlags |= 0x01;
-			edge2->visibilityFlags |= 0x01;
-
-			if (flags & Cap_front)
+			const uint32 lit = facing[i];
+			for (uint32 k = 0; k < 3; ++k)
 			{
-				// Add the triangle to the volume, un-extruded.
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[0]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[1]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[2]);
+				const uint32 slot = slots[i * 3 + k];
+				edgeFlags[slot >> 1] = (byte)(lit ? 0x01 : 0x02 | ((slot & 1) << 2));
 			}
-		}
-		else
-		{
-			// Triangle is in shade; set Bit3 if the winding order needs reversing
-			edge0->visibilityFlags |= 0x02 | (_shadowMesh.triangles[i].winding & 0x01) << 2;
-			edge1->visibilityFlags |= 0x02 | (_shadowMesh.triangles[i].winding & 0x02) << 1;
-			edge2->visibilityFlags |= 0x02 | (_shadowMesh.triangles[i].winding & 0x04);
-
-			if (flags & Cap_back)
+			if (lit ? frontCap : backCap)
 			{
-				// Add the triangle to the volume, extruded.
-				// numVertices is used as an offset so that the new index refers to the
-				// corresponding position in the second array of vertices (which are extruded)
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[0] + _shadowMesh.numVertices);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[1] + _shadowMesh.numVertices);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.triangles[i].vertexIndices[2] + _shadowMesh.numVertices);
+				const uint32* vertexIndices = triangles[i].vertexIndices;
+				const uint32 offset = lit ? 0 : numVertices;
+				out[0] = static_cast<INDEXTYPE>(vertexIndices[0] + offset);
+				out[1] = static_cast<INDEXTYPE>(vertexIndices[1] + offset);
+				out[2] = static_cast<INDEXTYPE>(vertexIndices[2] + offset);
+				out += 3;
 			}
 		}
-	}
-
-#ifdef DEBUG // Sanity checks
-	assertion(volume.indexCount * sizeof(INDEXTYPE) <= getIndexDataSize()); // Have we accessed memory we shouldn't have?
-
-	for (uint32 i = 0; i < volume.indexCount; ++i)
-	{
-		assertion(indices[i] < _shadowMesh.numVertices * 2);
-	}
-#endif
-
-	// Run through edges, testing which are silhouette edges
-	for (uint32 i = 0; i < _shadowMesh.numEdges; ++i)
+	});
+
+	// Write the extruded quads of the silhouette edges after the caps. With several threads, the silhouette edges of
+	// each range are counted first to find where its quads go, which also gives the index count. A single thread
+	// finds the index count as it writes the quads.
+	edgeOffsets[0] = capOffsets[numThreads];
+	uint32 singleThreadIndexCount = 0;
+	if (numThreads > 1)
 	{
-		if ((_shadowMesh.edges[i].visibilityFlags & 0x03) == 0x03)
+		runOnThreads(numThreads, _shadowMesh.numEdges, 1, [&](uint32 thread, uint32 begin, uint32 end)
 		{
-			/*
-				Silhouette edge found!
-				The edge is both visible and hidden, so it is along the silhouette of the model (See header notes for more info)
-			*/
-			if (_shadowMesh.edges[i].visibilityFlags & 0x04)
+			const byte* const edgeFlags = _shadowMesh.edgeFlags;
+			const uint32* overflow = findOverflowEdge(_shadowMesh.overflowEdges, _shadowMesh.numOverflowEdges, begin);
+			const uint32* const overflowEnd = _shadowMesh.overflowEdges + _shadowMesh.numOverflowEdges * 3;
+			uint32 numSilhouetteEdges = 0;
+			for (uint32 i = begin; i < end; ++i)
 			{
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0] + _shadowMesh.numVertices);
-
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0] + _shadowMesh.numVertices);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1] + _shadowMesh.numVertices);
+				numSilhouetteEdges += classifyEdge(edgeFlags, i, overflow, overflowEnd) & 1;
 			}
-			else
+			edgeOffsets[thread + 1] = numSilhouetteEdges * 6;
+		});
+		for (uint32 thread = 0; thread < numThreads; ++thread) { edgeOffsets[thread + 1] += edgeOffsets[thread]; }
+	}
+	runOnThreads(numThreads, _shadowMesh.numEdges, 1, [&](uint32 thread, uint32 begin, uint32 end)
+	{
+		const byte* const edgeFlags = _shadowMesh.edgeFlags;
+		const uint32* overflow = findOverflowEdge(_shadowMesh.overflowEdges, _shadowMesh.numOverflowEdges, begin);
+		const uint32* const overflowEnd = _shadowMesh.overflowEdges + _shadowMesh.numOverflowEdges * 3;
+		const ShadowVolumeEdge* const edges = _shadowMesh.edges;
+		INDEXTYPE* out = indices + edgeOffsets[thread];
+		for (uint32 i = begin; i < end; ++i)
+		{
+			const uint32 edgeClass = classifyEdge(edgeFlags, i, overflow, overflowEnd);
+			if (edgeClass)
 			{
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1] + _shadowMesh.numVertices);
-
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[1] + _shadowMesh.numVertices);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0]);
-				indices[volume.indexCount++] = static_cast<INDEXTYPE>(_shadowMesh.edges[i].vertexIndices[0] + _shadowMesh.numVertices);
+				/*
+					Silhouette edge found!
+					The edge is both visible and hidden, so it is along the silhouette of the model (See header notes for more info)
+				*/
+				const ShadowVolumeEdge& edge = edges[i];
+				const uint32 reversed = edgeClass >> 1;
+				const uint32 vertex0 = edge.vertexIndices[reversed], vertex1 = edge.vertexIndices[1 - reversed];
+				out[0] = static_cast<INDEXTYPE>(vertex1);
+				out[1] = static_cast<INDEXTYPE>(vertex0);
+				out[2] = static_cast<INDEXTYPE>(vertex1 + numVertices);
+				out[3] = static_cast<INDEXTYPE>(vertex1 + numVertices);
+				out[4] = static_cast<INDEXTYPE>(vertex0);
+				out[5] = static_cast<INDEXTYPE>(vertex0 + numVertices);
+				out += 6;
 			}
 		}
-
-		// Zero for next render
-		_shadowMesh.edges[i].visibilityFlags = 0;
-	}
+		if (numThreads == 1) { singleThreadIndexCount = static_cast<uint32>(out - indices); }
+	});
+	volume.indexCount = numThreads > 1 ? edgeOffsets[numThreads] : singleThreadIndexCount;
 
 #ifdef DEBUG // Sanity checks
 	assertion(volume.indexCount * sizeof(INDEXTYPE) <= getIndexDataSize()); // Have we accessed memory we shouldn't have?
@@ -31,11 +31,13 @@ public:
 	/// <summary>Initialize a shadow volume from the data of a Mesh.</summary>
 	/// <param name="mesh">A mesh whose vertex data is used to initialize this ShadowVolume instance. The POSITION
 	/// semantic must be present in the mesh.</param>
+	/// <param name="numThreads">The number of threads used to find the edges of large meshes. 0 (default) uses one
+	/// per hardware thread.</param>
 	/// <remarks>This method will pre-process the data in the mesh, to calculate all vertices, edges and faces of the
 	/// mesh as required. In effect it will extract the POSITION semantic data and the face data and use it to create
 	/// a "light" and cleaned up version of the mesh that will be then used to calculate extruded volumes as required.
 	/// </remarks>
-	Result init(const assets::Mesh& mesh);
+	Result init(const assets::Mesh& mesh, uint32 numThreads = 0);
 
 	/// <summary>Initialize a shadow volume from raw data.</summary>
 	/// <param name="data">Pointer to the first POSITION attribute of vertex data (so buffer_start + offset)</param>
@@ -45,14 +47,17 @@ public:
 	/// <param name="faceData">Pointer to index data</param>
 	/// <param name="numFaces">Number of Faces contained in (faceData)</param>
 	/// <param name="indexType">Type of indexes in faceData (16/32 bit)</param>
+	/// <param name="numThreads">The number of threads used to find the edges of large meshes. 0 (default) uses one
+	/// per hardware thread.</param>
 	/// <remarks>This method will pre-process the data in the mesh, to calculate all vertices, edges and faces of the
 	/// mesh as required. In effect it will the position data (assumed to be the first in the (data) buffer, so please
 	/// pre-add the offset if Position data are not the first in the buffer), and the face data and use it to create a
 	/// "light", cleaned up version of the mesh that will be henceforth be used to calculate extruded shadow volumes
-	/// as required.</remarks>
+	/// as required. Vertices and edges are matched with hash tables, so this is linear in the size of the mesh.
+	/// </remarks>
 	Result init(const byte* const data, uint32 numVertices, uint32 verticesStride,
 	            types::DataType vertexType, const byte* const faceData, uint32 numFaces,
-	            types::IndexType indexType);
+	            types::IndexType indexType, uint32 numThreads = 0);
 
 
 	/// <summary>Allocate memory for a new shadow volume with the specified ID.</summary>
@@ -111,11 +116,17 @@ public:
 	/// </param>
 	/// <param name="isPointLight">Pass true for point (or spot) light, false for directional</param>
 	/// <param name="externalIndexBuffer">An external buffer that contains custom, user provided index data.</param>
+	/// <param name="numThreads">The number of threads to split the triangles and edges across. Default 1. 0 uses one
+	/// per hardware thread. Only worth it for large meshes: small ones always use the calling thread only.</param>
+	/// <remarks>The facing of the triangles is computed four at a time with SIMD instructions where available, and
+	/// the indices are written at offsets given by a prefix sum over the triangles and edges, so the result is the same
+	/// for any number of threads.</remarks>
 	Result projectSilhouette(uint32 volumeID, uint32 flags, const glm::vec3& lightModel, bool isPointLight,
-	                         byte** externalIndexBuffer = NULL);
+	                         byte** externalIndexBuffer = NULL, uint32 numThreads = 1);
 
 private:
 	void initializeVertexData(byte** externalBuffer = NULL);
+	void initializeSilhouetteData();
 
 	struct ShadowVolumeEdge
 	{
@@ -146,6 +157,15 @@ private:
 		byte* vertexData;
 		bool needs32BitIndices;
 
+		// Structure-of-arrays copy of the data used to find the facing of the triangles: six rows of numTriangles
+		// rounded up to a multiple of 4 (normal x, y, z, then the first vertex of the first edge x, y, z).
+		float32* facingData;
+		byte* triangleFacing;         // Non-zero if the triangle faces the light, written by project
+		uint32* triangleEdgeSlots;    // The slot of each edge of each triangle in edgeFlags, * 2 + 1 if reversed
+		byte* edgeFlags;              // The visibility flags each triangle gives each of its edges, written by project
+		uint32* overflowEdges;        // Edge, first slot and end slot of the edges with more than two triangles
+		uint32 numOverflowEdges;
+
 		ShadowMesh() :
 			vertices(NULL),
 			edges(NULL),
@@ -154,7 +174,13 @@ private:
 			numEdges(0),
 			numTriangles(0),
 			vertexData(NULL),
-			needs32BitIndices(false)
+			needs32BitIndices(false),
+			facingData(NULL),
+			triangleFacing(NULL),
+			triangleEdgeSlots(NULL),
+			edgeFlags(NULL),
+			overflowEdges(NULL),
+			numOverflowEdges(0)
 		{
 		}
 	};
@@ -165,23 +191,16 @@ private:
 		byte* indexData;
 		uint32 indexCount; // If the index count is greater than 0 and indexData is NULL then the data is handled externally
 
+		// The index data is released by the ShadowVolume, as this is copied in and out of the map.
 		ShadowVolumeData() : indexData(NULL), indexCount(0)
 		{
 		}
-		~ShadowVolumeData()
-		{
-			delete indexData;
-		}
 	};
 
-	uint32 findOrCreateVertex(const glm::vec3& vertex, bool& existed);
-	uint32 findOrCreateEdge(const glm::vec3& v0, const glm::vec3& v1, bool& existed);
-	void findOrCreateTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
-
 	//Extrude
 	template<typename INDEXTYPE>
 	Result project(uint32 volumeID, uint32 flags, const glm::vec3& lightModel, bool isPointLight,
-	               INDEXTYPE** externalIndexBuffer);
+	               INDEXTYPE** externalIndexBuffer, uint32 numThreads);
 
 
 	typedef std::map<uint32, ShadowVolumeData> ShadowVolumeMapType;
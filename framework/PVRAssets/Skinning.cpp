@@ -0,0 +1,331 @@
+/*!
+\brief Implementation of the BonePalette and MeshSkinner classes.
+\file PVRAssets/Skinning.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/Skinning.h"
+#include "PVRAssets/Helper.h"
+#include "PVRCore/Log.h"
+#include "PVRCore/Math/Float4.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace pvr {
+namespace assets {
+namespace {
+// The floats of a bone of a MeshSkinner: the four columns of its matrix, then the three columns of its normal matrix,
+// each padded to four floats.
+const uint32 FloatsPerSkinningBone = 28;
+
+// Four floats processed together: the components of a position or normal.
+using math::Float4;
+
+// The world matrix of a node at frame 0, as Model::getWorldMatrixNoCache at frame 0.
+const glm::mat4x4& getFrameZeroMatrix(const Model& model, uint32 nodeId, std::vector<glm::mat4x4>& matrices,
+                                      std::vector<bool>& computed)
+{
+	if (!computed[nodeId])
+	{
+		const Model::Node& node = model.getNode(nodeId);
+		const glm::mat4x4 matrix = node.getAnimation().getTransformationMatrix(0, 0.0f);
+		const int32 parentId = node.getParentID();
+		// The matrix is marked first, so that a cycle in the hierarchy ends instead of recursing forever.
+		computed[nodeId] = true;
+		matrices[nodeId] = matrix;
+		if (parentId >= 0 && (uint32)parentId < model.getNumNodes())
+		{
+			matrices[nodeId] = getFrameZeroMatrix(model, parentId, matrices, computed) * matrix;
+		}
+	}
+	return matrices[nodeId];
+}
+
+// Read an attribute of all the vertices of a mesh as four floats per vertex, unused components 0 (w 1).
+bool readAttribute(const Mesh& mesh, const char* name, std::vector<float32>& values, uint32& width)
+{
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName(name);
+	if (!attribute || attribute->getDataIndex() < 0 || (uint32)attribute->getDataIndex() >= mesh.getNumDataElements())
+	{
+		return false;
+	}
+	const uint32 stride = mesh.getStride(attribute->getDataIndex());
+	width = (std::min)(attribute->getN(), 4u);
+	if (!stride || !width || mesh.getDataSize(attribute->getDataIndex()) < (size_t)mesh.getNumVertices() * stride ||
+	    attribute->getOffset() + types::dataTypeSize(attribute->getVertexLayout().dataType) * width > stride)
+	{
+		Log(Log.Error, "MeshSkinner::init: The %s data is smaller than the number of vertices", name);
+		return false;
+	}
+	const byte* data = static_cast<const byte*>(mesh.getData(attribute->getDataIndex())) + attribute->getOffset();
+	values.resize(mesh.getNumVertices() * 4);
+	VertexReadBatch(data, stride, attribute->getVertexLayout().dataType, width, mesh.getNumVertices(), values.data(), 4);
+	for (uint32 i = 0; i < mesh.getNumVertices() && width < 4; ++i)
+	{
+		for (uint32 c = width; c < 4; ++c) { values[i * 4 + c] = 0.0f; }
+	}
+	return true;
+}
+}
+
+bool BonePalette::init(const Model& model, Layout layout)
+{
+	_layout = layout;
+	_floatsPerMatrix = (layout == Matrix3x4 ? 12 : 16);
+	_nodeBatches.assign(1, 0);
+	_batchOffsets.clear();
+	_slotBones.clear();
+	_boneWorldIndices.clear();
+	_worldNodes.clear();
+	_inverseBindMatrices.clear();
+
+	const uint32 numNodes = model.getNumNodes();
+	std::vector<glm::mat4x4> frameZeroMatrices(numNodes);
+	std::vector<bool> computed(numNodes, false);
+	std::map<uint64, uint32> bones;        // (mesh node, bone node) -> bone
+	std::vector<uint32> worldIndices(numNodes, 0xFFFFFFFFu);
+	for (uint32 meshNodeId = 0; meshNodeId < model.getNumMeshNodes(); ++meshNodeId)
+	{
+		const int32 meshId = model.getMeshNode(meshNodeId).getObjectId();
+		if (meshId >= 0 && (uint32)meshId < model.getNumMeshes() && model.getMesh(meshId).getMeshInfo().isSkinned)
+		{
+			const Mesh& mesh = model.getMesh(meshId);
+			for (uint32 batch = 0; batch < mesh.getInternalData().boneBatches.getCount(); ++batch)
+			{
+				_batchOffsets.push_back((uint32)_slotBones.size());
+				for (uint32 i = 0; i < mesh.getBatchBoneCount(batch); ++i)
+				{
+					const uint32 boneNodeId = mesh.getBatchBone(batch, i);
+					if (boneNodeId >= numNodes)
+					{
+						Log(Log.Error, "BonePalette::init: Bone %d of batch %d of mesh node %d is not a node", i, batch,
+						    meshNodeId);
+						_nodeBatches.assign(1, 0);
+						_batchOffsets.clear();
+						_slotBones.clear();
+						return false;
+					}
+					std::map<uint64, uint32>::iterator found = bones.find(((uint64)meshNodeId << 32) | boneNodeId);
+					if (found == bones.end())
+					{
+						if (worldIndices[boneNodeId] == 0xFFFFFFFFu)
+						{
+							worldIndices[boneNodeId] = (uint32)_worldNodes.size();
+							_worldNodes.push_back(boneNodeId);
+						}
+						_boneWorldIndices.push_back(worldIndices[boneNodeId]);
+						_inverseBindMatrices.push_back(
+						  glm::inverse(getFrameZeroMatrix(model, boneNodeId, frameZeroMatrices, computed)) *
+						  getFrameZeroMatrix(model, meshNodeId, frameZeroMatrices, computed));
+						found = bones.insert(std::make_pair(((uint64)meshNodeId << 32) | boneNodeId,
+						                                    (uint32)_inverseBindMatrices.size() - 1)).first;
+					}
+					_slotBones.push_back(found->second);
+				}
+			}
+		}
+		_nodeBatches.push_back((uint32)_batchOffsets.size());
+	}
+	// Start at frame 0, which does not need the world matrix cache of the model.
+	_worldMatrices.resize(_worldNodes.size());
+	for (uint32 i = 0; i < _worldNodes.size(); ++i) { _worldMatrices[i] = frameZeroMatrices[_worldNodes[i]]; }
+	_boneMatrices.resize(_inverseBindMatrices.size());
+	_data.assign(_slotBones.size() * _floatsPerMatrix, 0.0f);
+	updateMatrices();
+	return true;
+}
+
+void BonePalette::update(const Model& model)
+{
+	for (uint32 i = 0; i < _worldNodes.size(); ++i) { _worldMatrices[i] = model.getWorldMatrix(_worldNodes[i]); }
+	updateMatrices();
+}
+
+void BonePalette::update(const AnimationInstance& instance)
+{
+	for (uint32 i = 0; i < _worldNodes.size(); ++i)
+	{
+		if (_worldNodes[i] >= instance.getNumNodes())
+		{
+			Log(Log.Error, "BonePalette::update: The instance does not have node %d", _worldNodes[i]);
+			return;
+		}
+		_worldMatrices[i] = instance.getWorldMatrix(_worldNodes[i]);
+	}
+	updateMatrices();
+}
+
+void BonePalette::updateMatrices()
+{
+	for (uint32 i = 0; i < _boneMatrices.size(); ++i)
+	{
+		_boneMatrices[i] = _worldMatrices[_boneWorldIndices[i]] * _inverseBindMatrices[i];
+	}
+	float32* out = _data.data();
+	for (uint32 i = 0; i < _slotBones.size(); ++i, out += _floatsPerMatrix)
+	{
+		const glm::mat4x4& matrix = _boneMatrices[_slotBones[i]];
+		if (_layout == Matrix3x4)
+		{
+			for (uint32 row = 0; row < 3; ++row)
+			{
+				for (uint32 column = 0; column < 4; ++column) { out[row * 4 + column] = matrix[column][row]; }
+			}
+		}
+		else
+		{
+			memcpy(out, &matrix[0][0], sizeof(matrix));
+		}
+	}
+}
+
+bool MeshSkinner::init(const Model& model, uint32 meshNodeId, const BonePalette& palette)
+{
+	_vertices.clear();
+	_bones.clear();
+	_weights.clear();
+	_paletteIndices.clear();
+	_numInfluences = 0;
+	_hasNormals = false;
+
+	const int32 meshId = meshNodeId < model.getNumMeshNodes() ? model.getMeshNode(meshNodeId).getObjectId() : -1;
+	if (meshId < 0 || (uint32)meshId >= model.getNumMeshes() || !model.getMesh(meshId).getMeshInfo().isSkinned ||
+	    !model.getMesh(meshId).getInternalData().boneBatches.getCount())
+	{
+		Log(Log.Error, "MeshSkinner::init: Node %d is not a skinned mesh node with bone batches", meshNodeId);
+		return false;
+	}
+	const Mesh& mesh = model.getMesh(meshId);
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList)
+	{
+		Log(Log.Error, "MeshSkinner::init: Only triangle lists are supported");
+		return false;
+	}
+	std::vector<float32> positions, normals, boneIndices, boneWeights;
+	uint32 positionWidth, normalWidth, indexWidth, weightWidth;
+	if (!readAttribute(mesh, "POSITION", positions, positionWidth) ||
+	    !readAttribute(mesh, "BONEINDEX", boneIndices, indexWidth) ||
+	    !readAttribute(mesh, "BONEWEIGHT", boneWeights, weightWidth))
+	{
+		Log(Log.Error, "MeshSkinner::init: The mesh of node %d needs POSITION, BONEINDEX and BONEWEIGHT attributes",
+		    meshNodeId);
+		return false;
+	}
+	_hasNormals = readAttribute(mesh, "NORMAL", normals, normalWidth);
+
+	// The bone batch of each vertex, from the triangles of the batches.
+	const uint32 numVertices = mesh.getNumVertices();
+	const uint32 numFaces = mesh.getNumFaces();
+	const Mesh::FaceData& faces = mesh.getFaces();
+	const uint32 indexSize = faces.getDataTypeSize() / 8;
+	const uint32 numBatches = mesh.getInternalData().boneBatches.getCount();
+	if (mesh.getMeshInfo().isIndexed && faces.getDataSize() < numFaces * 3 * indexSize)
+	{
+		Log(Log.Error, "MeshSkinner::init: The face data is smaller than the number of faces");
+		return false;
+	}
+	std::vector<uint32> vertexBatches(numVertices, 0);
+	for (uint32 batch = 0; batch < numBatches; ++batch)
+	{
+		const uint32 end = (std::min)(batch + 1 < numBatches ? mesh.getBatchFaceOffset(batch + 1) : numFaces, numFaces);
+		for (uint32 i = mesh.getBatchFaceOffset(batch) * 3; i < end * 3; ++i)
+		{
+			uint32 index = i;
+			if (mesh.getMeshInfo().isIndexed)
+			{
+				uint16 index16;
+				if (indexSize == 2) { memcpy(&index16, faces.getData() + i * 2, 2); index = index16; }
+				else { memcpy(&index, faces.getData() + i * 4, 4); }
+			}
+			if (index < numVertices) { vertexBatches[index] = batch; }
+		}
+	}
+
+	// The bones of the mesh, and the influences of each vertex as indices into them.
+	_numInfluences = (std::min)(indexWidth, weightWidth);
+	std::vector<uint32> localBones(palette.getNumMatrices(), 0xFFFFFFFFu);
+	_vertices.resize(numVertices * 8);
+	_bones.resize(numVertices * _numInfluences);
+	_weights.resize(numVertices * _numInfluences);
+	const glm::mat4& unpackMatrix = mesh.getUnpackMatrix();
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		const glm::vec4 position = unpackMatrix * glm::vec4(positions[i * 4], positions[i * 4 + 1], positions[i * 4 + 2], 1.0f);
+		float32* vertex = &_vertices[i * 8];
+		vertex[0] = position.x; vertex[1] = position.y; vertex[2] = position.z; vertex[3] = 1.0f;
+		vertex[4] = _hasNormals ? normals[i * 4] : 0.0f;
+		vertex[5] = _hasNormals ? normals[i * 4 + 1] : 0.0f;
+		vertex[6] = _hasNormals ? normals[i * 4 + 2] : 0.0f;
+		vertex[7] = 0.0f;
+		for (uint32 j = 0; j < _numInfluences; ++j)
+		{
+			const uint32 batch = vertexBatches[i];
+			const uint32 bone = (uint32)boneIndices[i * 4 + j];
+			const uint32 slot = palette.getBatchOffset(meshNodeId, batch) + bone;
+			if (bone >= mesh.getBatchBoneCount(batch) || slot >= palette.getNumMatrices())
+			{
+				Log(Log.Error, "MeshSkinner::init: Vertex %d uses bone %d, which batch %d of the palette does not have", i,
+				    bone, batch);
+				_vertices.clear();
+				return false;
+			}
+			if (localBones[slot] == 0xFFFFFFFFu)
+			{
+				localBones[slot] = (uint32)_paletteIndices.size();
+				_paletteIndices.push_back(slot);
+			}
+			_bones[i * _numInfluences + j] = localBones[slot];
+			_weights[i * _numInfluences + j] = boneWeights[i * 4 + j];
+		}
+	}
+	return true;
+}
+
+void MeshSkinner::skin(const BonePalette& palette, float32* positions, uint32 positionStride, float32* normals,
+                       uint32 normalStride) const
+{
+	// The matrices of the bones of the mesh, and their inverse transposes for the normals.
+	std::vector<float32> bones(_paletteIndices.size() * FloatsPerSkinningBone, 0.0f);
+	for (uint32 i = 0; i < _paletteIndices.size(); ++i)
+	{
+		const glm::mat4x4& matrix = palette.getMatrix(_paletteIndices[i]);
+		const glm::mat3x3 normalMatrix = glm::inverseTranspose(glm::mat3x3(matrix));
+		float32* bone = &bones[i * FloatsPerSkinningBone];
+		memcpy(bone, &matrix[0][0], sizeof(matrix));
+		for (uint32 column = 0; column < 3; ++column) { memcpy(bone + 16 + column * 4, &normalMatrix[column][0], 12); }
+	}
+	const bool skinNormals = normals && _hasNormals;
+	const uint32 numVertices = getNumVertices();
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		const float32* vertex = &_vertices[i * 8];
+		const Float4 x(vertex[0]), y(vertex[1]), z(vertex[2]);
+		const Float4 normalX(vertex[4]), normalY(vertex[5]), normalZ(vertex[6]);
+		Float4 position(0.0f), normal(0.0f);
+		for (uint32 j = 0; j < _numInfluences; ++j)
+		{
+			const float32* bone = &bones[_bones[i * _numInfluences + j] * FloatsPerSkinningBone];
+			const Float4 weight(_weights[i * _numInfluences + j]);
+			position = position + (Float4::load(bone) * x + Float4::load(bone + 4) * y + Float4::load(bone + 8) * z +
+			                       Float4::load(bone + 12)) * weight;
+			if (skinNormals)
+			{
+				normal = normal + (Float4::load(bone + 16) * normalX + Float4::load(bone + 20) * normalY +
+				                   Float4::load(bone + 24) * normalZ) * weight;
+			}
+		}
+		float32 result[4];
+		position.store(result);
+		memcpy(reinterpret_cast<byte*>(positions) + (size_t)i * positionStride, result, 3 * sizeof(float32));
+		if (skinNormals)
+		{
+			normal.store(result);
+			memcpy(reinterpret_cast<byte*>(normals) + (size_t)i * normalStride, result, 3 * sizeof(float32));
+		}
+	}
+}
+}
+}
+//!\endcond
@@ -0,0 +1,145 @@
+/*!
+\brief Contains a bone palette that computes the bone matrices of all the skinned meshes of a model at once, and a
+CPU skinning path for the meshes.
+\file PVRAssets/Skinning.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model.h"
+#include "PVRAssets/Model/AnimationInstance.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>The bone matrices of all the bone batches of all the skinned meshes of a model, in one contiguous array
+/// ready to be uploaded to a uniform or storage buffer.</summary>
+/// <remarks>Each bone batch gets a contiguous range of matrices in the order of its bones, so the bone indices of the
+/// vertices index the range of their batch directly (bind the range at getBatchOffset). A bone used by several
+/// batches or meshes is still only computed once per update, and the inverse bind matrices
+/// (Model::getBoneWorldMatrix) are computed once by init instead of once per bone per draw. The matrices are the same
+/// as Model::getBoneWorldMatrix with the mesh node as skin node.</remarks>
+class BonePalette
+{
+public:
+	/// <summary>How each matrix is stored in the palette.</summary>
+	enum Layout
+	{
+		Matrix4x4, //!< A column major 4x4 matrix (16 floats), as glm::mat4x4 and mat4 uniforms
+		Matrix3x4  //!< The first three rows of the matrix (12 floats), for mat3x4 uniforms used as vec4(v, 1.0) * matrix
+	};
+
+	/// <summary>Constructor. Call init before use.</summary>
+	BonePalette() : _layout(Matrix4x4), _floatsPerMatrix(16) {}
+
+	/// <summary>Find the bones of all the skinned meshes of a model, and compute their inverse bind matrices.</summary>
+	/// <param name="model">The model. Its meshes and nodes must not change while the palette is used.</param>
+	/// <param name="layout">How the matrices are stored</param>
+	/// <returns>True on success, false if a bone batch refers to a node that does not exist</returns>
+	bool init(const Model& model, Layout layout = Matrix4x4);
+
+	/// <summary>Compute the matrices for the current frame of the model (Model::setCurrentFrame).</summary>
+	/// <param name="model">The model the palette was initialized with</param>
+	void update(const Model& model);
+
+	/// <summary>Compute the matrices for the current frame of an instance of the model.</summary>
+	/// <param name="instance">An instance bound to an AnimationEvaluator of the model the palette was initialized with
+	/// </param>
+	void update(const AnimationInstance& instance);
+
+	/// <summary>Get how the matrices are stored.</summary>
+	Layout getLayout() const { return _layout; }
+
+	/// <summary>Get the number of matrices of the palette: the bones of all the bone batches.</summary>
+	uint32 getNumMatrices() const { return (uint32)_slotBones.size(); }
+
+	/// <summary>Get the number of different bones (pairs of skinned mesh node and bone node) computed per update.
+	/// </summary>
+	uint32 getNumBones() const { return (uint32)_boneMatrices.size(); }
+
+	/// <summary>Get the size of one matrix of the palette in bytes: 64 for Matrix4x4, 48 for Matrix3x4.</summary>
+	uint32 getMatrixSize() const { return _floatsPerMatrix * sizeof(float32); }
+
+	/// <summary>Get the matrices of the palette, getNumMatrices() * getMatrixSize() bytes.</summary>
+	const float32* getData() const { return _data.data(); }
+
+	/// <summary>Get the size of the matrices of the palette in bytes.</summary>
+	size_t getDataSize() const { return _data.size() * sizeof(float32); }
+
+	/// <summary>Get the index of the first matrix of a bone batch of a skinned mesh node.</summary>
+	/// <param name="meshNodeId">The mesh node</param>
+	/// <param name="batch">The bone batch of its mesh</param>
+	/// <returns>The index of the matrix of the first bone of the batch, or getNumMatrices() if the node is not a
+	/// skinned mesh node or has no such batch</returns>
+	uint32 getBatchOffset(uint32 meshNodeId, uint32 batch) const
+	{
+		if (meshNodeId + 1 >= _nodeBatches.size() || _nodeBatches[meshNodeId] + batch >= _nodeBatches[meshNodeId + 1])
+		{
+			return getNumMatrices();
+		}
+		return _batchOffsets[_nodeBatches[meshNodeId] + batch];
+	}
+
+	/// <summary>Get a matrix of the palette as a 4x4 matrix, whatever the layout.</summary>
+	/// <param name="index">The index of the matrix in the palette</param>
+	const glm::mat4x4& getMatrix(uint32 index) const { return _boneMatrices[_slotBones[index]]; }
+
+private:
+	Layout _layout;
+	uint32 _floatsPerMatrix;
+	std::vector<uint32> _nodeBatches;             // Index of the first batch of each mesh node in _batchOffsets
+	std::vector<uint32> _batchOffsets;            // Index of the first matrix of each batch
+	std::vector<uint32> _slotBones;               // Index in _boneMatrices of each matrix of the palette
+	std::vector<uint32> _boneWorldIndices;        // Index in _worldMatrices of the bone node of each bone
+	std::vector<uint32> _worldNodes;              // The different bone nodes
+	std::vector<glm::mat4x4> _inverseBindMatrices; // Per bone: the frame 0 matrix of the skin relative to the bone
+	std::vector<glm::mat4x4> _worldMatrices;      // Per bone node, for the frame
+	std::vector<glm::mat4x4> _boneMatrices;       // Per bone, for the frame
+	std::vector<float32> _data;
+
+	void updateMatrices();
+};
+
+/// <summary>Skins the vertices of a mesh on the CPU, for devices or passes without vertex shader skinning. The
+/// positions and normals are transformed as the skinning shaders do: the sum of the vertex transformed by each of its
+/// bones, scaled by the weight of the bone. Normals use the inverse transpose of the bone matrices and are not
+/// normalized.</summary>
+/// <remarks>Four components are processed at once with SSE2 or NEON where available, with the same results as the
+/// scalar path. The vertices are read from the mesh once by init, so skin only reads compact arrays and writes the
+/// skinned vertices to the (typically streaming) buffer given.</remarks>
+class MeshSkinner
+{
+public:
+	/// <summary>Constructor. Call init before use.</summary>
+	MeshSkinner() : _numInfluences(0), _hasNormals(false) {}
+
+	/// <summary>Read the positions, normals, bone indices and bone weights of the mesh of a skinned mesh node.</summary>
+	/// <param name="model">The model</param>
+	/// <param name="meshNodeId">The skinned mesh node</param>
+	/// <param name="palette">A palette initialized with the model. Only used to find the matrices of the bones of
+	/// the mesh: it can be updated and shared freely afterwards.</param>
+	/// <returns>True on success, false if the mesh is not skinned or misses attributes</returns>
+	bool init(const Model& model, uint32 meshNodeId, const BonePalette& palette);
+
+	/// <summary>Get the number of vertices skinned.</summary>
+	uint32 getNumVertices() const { return (uint32)(_vertices.size() / 8); }
+
+	/// <summary>Skin the vertices with the matrices of a palette. Thread safe.</summary>
+	/// <param name="palette">The palette the skinner was initialized with, updated for the frame</param>
+	/// <param name="positions">Receives three floats per vertex: the skinned position</param>
+	/// <param name="positionStride">The distance between two positions in bytes</param>
+	/// <param name="normals">Receives three floats per vertex: the skinned normal. Can be NULL. Left untouched if the
+	/// mesh has no normals.</param>
+	/// <param name="normalStride">The distance between two normals in bytes</param>
+	void skin(const BonePalette& palette, float32* positions, uint32 positionStride, float32* normals = NULL,
+	          uint32 normalStride = 0) const;
+
+private:
+	uint32 _numInfluences;          // Bones per vertex
+	bool _hasNormals;
+	std::vector<float32> _vertices; // Eight floats per vertex: position x, y, z, 1, then normal x, y, z, 0
+	std::vector<uint32> _bones;     // _numInfluences per vertex: index in _paletteIndices
+	std::vector<float32> _weights;  // _numInfluences per vertex
+	std::vector<uint32> _paletteIndices; // The index in the palette of each bone of the mesh
+};
+}
+}
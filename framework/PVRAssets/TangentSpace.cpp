@@ -0,0 +1,384 @@
+/*!
+\brief Implementation of the tangent space generation functions.
+\file PVRAssets/TangentSpace.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/TangentSpace.h"
+#include "PVRAssets/MeshDataHelpers.h"
+#include "PVRCore/Log.h"
+#include "PVRCore/Math/Float4.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace {
+using internal::hasAttribute;
+using internal::readAttribute;
+using internal::readIndices;
+
+// The floats of a vertex that identify it: position, normal and texture coordinates.
+const uint32 KeySize = 8;
+
+// Four floats processed together, and a mask selecting some of them.
+using math::Float4;
+using math::Mask4;
+
+// The arc cosine of values in -1..1, as Cephes' acosf: asin is a polynomial up to 0.5, and
+// acos(x) = 2 * asin(sqrt((1 - x) / 2)) above.
+inline Float4 arcCosine(const Float4& x)
+{
+	const Float4 zero(0.0f), half(0.5f), a = absolute(x);
+	const Mask4 large = greaterThan(a, half);
+	const Float4 z = select(large, (Float4(1.0f) - a) * half, a * a);
+	const Float4 s = select(large, squareRoot(z), a);
+	const Float4 arcSine = ((((Float4(4.2163199048e-2f) * z + Float4(2.4181311049e-2f)) * z + Float4(4.5470025998e-2f)) *
+	                         z + Float4(7.4953002686e-2f)) * z + Float4(1.6666752422e-1f)) * z * s + s;
+	const Mask4 negative = greaterThan(zero, x);
+	return select(large, select(negative, Float4(glm::pi<float32>()) - (arcSine + arcSine), arcSine + arcSine),
+	              Float4(glm::half_pi<float32>()) - select(negative, zero - arcSine, arcSine));
+}
+
+// The corners of a few triangles, as structures of arrays small enough to stay in the cache.
+const uint32 CornersPerBlock = 96;
+struct CornerBlock
+{
+	enum { NormalX, NormalY, NormalZ, ToPreviousX, ToPreviousY, ToPreviousZ, ToNextX, ToNextY, ToNextZ, TangentX,
+	       TangentY, TangentZ, NumRows
+	     };
+	float32 rows[NumRows][CornersPerBlock];
+	uint32 groups[CornersPerBlock];
+	uint32 count;
+};
+
+// Project the tangent of the triangle of each corner onto the plane of the normal of the corner, weight it by the
+// angle of the triangle at the corner (also measured in the plane of the normal) and add it to the group of the
+// corner.
+void accumulateCorners(CornerBlock& block, std::vector<glm::vec3>& tangents)
+{
+	const Float4 zero(0.0f);
+	for (uint32 i = 0; i < block.count; i += 4)
+	{
+		const Float4 nx = Float4::load(&block.rows[CornerBlock::NormalX][i]);
+		const Float4 ny = Float4::load(&block.rows[CornerBlock::NormalY][i]);
+		const Float4 nz = Float4::load(&block.rows[CornerBlock::NormalZ][i]);
+		Float4 px = Float4::load(&block.rows[CornerBlock::ToPreviousX][i]);
+		Float4 py = Float4::load(&block.rows[CornerBlock::ToPreviousY][i]);
+		Float4 pz = Float4::load(&block.rows[CornerBlock::ToPreviousZ][i]);
+		Float4 qx = Float4::load(&block.rows[CornerBlock::ToNextX][i]);
+		Float4 qy = Float4::load(&block.rows[CornerBlock::ToNextY][i]);
+		Float4 qz = Float4::load(&block.rows[CornerBlock::ToNextZ][i]);
+		Float4 tx = Float4::load(&block.rows[CornerBlock::TangentX][i]);
+		Float4 ty = Float4::load(&block.rows[CornerBlock::TangentY][i]);
+		Float4 tz = Float4::load(&block.rows[CornerBlock::TangentZ][i]);
+		const Float4 dp = nx * px + ny * py + nz * pz, dq = nx * qx + ny * qy + nz * qz, dt = nx * tx + ny * ty + nz * tz;
+		px = px - nx * dp; py = py - ny * dp; pz = pz - nz * dp;
+		qx = qx - nx * dq; qy = qy - ny * dq; qz = qz - nz * dq;
+		tx = tx - nx * dt; ty = ty - ny * dt; tz = tz - nz * dt;
+		const Float4 lengths = (px * px + py * py + pz * pz) * (qx * qx + qy * qy + qz * qz);
+		const Float4 cosine = select(greaterThan(lengths, zero), (px * qx + py * qy + pz * qz) / squareRoot(lengths), zero);
+		const Float4 angle = arcCosine(maximum(Float4(-1.0f), minimum(cosine, Float4(1.0f))));
+		const Float4 tangentLength = tx * tx + ty * ty + tz * tz;
+		const Float4 scale = select(greaterThan(tangentLength, zero), angle / squareRoot(tangentLength), zero);
+		(tx * scale).store(&block.rows[CornerBlock::TangentX][i]);
+		(ty * scale).store(&block.rows[CornerBlock::TangentY][i]);
+		(tz * scale).store(&block.rows[CornerBlock::TangentZ][i]);
+	}
+	for (uint32 i = 0; i < block.count; ++i)
+	{
+		tangents[block.groups[i]] += glm::vec3(block.rows[CornerBlock::TangentX][i], block.rows[CornerBlock::TangentY][i],
+		                                       block.rows[CornerBlock::TangentZ][i]);
+	}
+	block.count = 0;
+}
+
+// Group the vertices with the same position, normal and texture coordinates. Returns the number of groups.
+uint32 weldVertices(const std::vector<float32>& keys, std::vector<uint32>& welded)
+{
+	const uint32 numVertices = (uint32)(keys.size() / KeySize);
+	uint32 tableSize = 1;
+	while (tableSize < numVertices * 2) { tableSize *= 2; }
+	std::vector<uint32> table(tableSize, 0); // First vertex of the group + 1, 0 if empty
+	welded.resize(numVertices);
+	uint32 numGroups = 0;
+	for (uint32 v = 0; v < numVertices; ++v)
+	{
+		const float32* key = &keys[v * KeySize];
+		uint32 hash = 2166136261u;
+		for (uint32 i = 0; i < KeySize; ++i)
+		{
+			uint32 bits;
+			memcpy(&bits, key + i, 4);
+			hash = (hash ^ bits) * 16777619u;
+		}
+		uint32 slot = (hash ^ (hash >> 15)) & (tableSize - 1);
+		while (table[slot] && memcmp(&keys[(table[slot] - 1) * KeySize], key, KeySize * sizeof(float32)))
+		{
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (!table[slot])
+		{
+			table[slot] = v + 1;
+			welded[v] = numGroups++;
+		}
+		else
+		{
+			welded[v] = welded[table[slot] - 1];
+		}
+	}
+	return numGroups;
+}
+
+inline glm::vec3 projectOnPlane(const glm::vec3& vector, const glm::vec3& normal)
+{
+	const glm::vec3 projected = vector - normal * glm::dot(normal, vector);
+	const float32 length = glm::length(projected);
+	return length > 0.0f ? projected / length : projected;
+}
+
+// Any unit vector perpendicular to the normal, for vertices without texture coordinate area.
+glm::vec3 anyTangent(const glm::vec3& normal)
+{
+	const glm::vec3 axis = fabsf(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::vec3 tangent = projectOnPlane(axis, normal);
+	return glm::dot(tangent, tangent) > 0.0f ? tangent : axis;
+}
+
+// A data block that only the attribute uses can be overwritten, otherwise a new one is needed.
+int32 getReusableDataBlock(const Mesh& mesh, const StringHash& semantic, const StringHash& otherSemantic)
+{
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName(semantic);
+	if (!attribute || attribute->getDataIndex() < 0 || (uint32)attribute->getDataIndex() >= mesh.getNumDataElements())
+	{
+		return -1;
+	}
+	for (uint32 i = 0; i < mesh.getVertexAttributesSize(); ++i)
+	{
+		const Mesh::VertexAttributeData& other = *mesh.getVertexAttribute(i);
+		if (other.getDataIndex() == attribute->getDataIndex() && other.getSemantic() != semantic &&
+		    other.getSemantic() != otherSemantic)
+		{
+			return -1;
+		}
+	}
+	return attribute->getDataIndex();
+}
+}
+
+bool generateTangents(Mesh& mesh, const TangentGenerationOptions& options)
+{
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty())
+	{
+		Log(Log.Error, "generateTangents: Only triangle lists are supported");
+		return false;
+	}
+	if (mesh.hasDeferredData() && !mesh.loadDeferredData()) { return false; }
+	const uint32 numVertices = mesh.getNumVertices();
+	const uint32 numTriangles = mesh.getNumFaces();
+	std::vector<float32> positions, normals, texCoords;
+	std::vector<uint32> indices;
+	if (!readAttribute(mesh, "POSITION", 3, positions, "generateTangents") ||
+	    !readAttribute(mesh, "NORMAL", 3, normals, "generateTangents") ||
+	    !readAttribute(mesh, options.texCoordSemantic, 2, texCoords, "generateTangents") ||
+	    !readIndices(mesh, indices, "generateTangents"))
+	{
+		return false;
+	}
+
+	// Vertices are identified by value, so that the tangents are continuous across duplicated vertices.
+	std::vector<float32> keys(numVertices * KeySize);
+	const glm::mat4& unpackMatrix = mesh.getUnpackMatrix();
+	for (uint32 v = 0; v < numVertices; ++v)
+	{
+		const glm::vec3 position(unpackMatrix * glm::vec4(positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2], 1.0f));
+		const glm::vec3 normal = glm::normalize(glm::vec3(normals[v * 3], normals[v * 3 + 1], normals[v * 3 + 2]));
+		float32* key = &keys[v * KeySize];
+		key[0] = position.x; key[1] = position.y; key[2] = position.z;
+		key[3] = normal.x == normal.x ? normal.x : 0.0f; // Zero normals normalize to NaN
+		key[4] = normal.y == normal.y ? normal.y : 0.0f;
+		key[5] = normal.z == normal.z ? normal.z : 0.0f;
+		key[6] = texCoords[v * 2]; key[7] = texCoords[v * 2 + 1];
+	}
+	std::vector<uint32> welded;
+	const uint32 numWelded = weldVertices(keys, welded);
+
+	// Accumulate the tangent of each triangle at each of its corners, per welded vertex and orientation of the
+	// texture coordinates (index welded * 2 + 1 if preserved, welded * 2 if mirrored).
+	std::vector<glm::vec3> tangents(numWelded * 2, glm::vec3(0.0f));
+	std::vector<byte> triangleOrientations(numTriangles, 2); // 2 for triangles without texture coordinate area
+	CornerBlock block;
+	memset(&block, 0, sizeof(block));
+	for (uint32 t = 0; t < numTriangles; ++t)
+	{
+		const uint32* triangle = &indices[t * 3];
+		const glm::vec3 p0 = glm::make_vec3(&keys[triangle[0] * KeySize]);
+		const glm::vec3 d1 = glm::make_vec3(&keys[triangle[1] * KeySize]) - p0;
+		const glm::vec3 d2 = glm::make_vec3(&keys[triangle[2] * KeySize]) - p0;
+		const glm::vec2 uv0 = glm::make_vec2(&keys[triangle[0] * KeySize + 6]);
+		const glm::vec2 t21 = glm::make_vec2(&keys[triangle[1] * KeySize + 6]) - uv0;
+		const glm::vec2 t31 = glm::make_vec2(&keys[triangle[2] * KeySize + 6]) - uv0;
+		const float32 signedArea = t21.x * t31.y - t21.y * t31.x;
+		glm::vec3 faceTangent = d1 * t31.y - d2 * t21.y;
+		const float32 length = glm::length(faceTangent);
+		if (fabsf(signedArea) <= FLT_MIN || !(length > 0.0f)) { continue; }
+		const byte orientation = signedArea > 0.0f ? 1 : 0;
+		triangleOrientations[t] = orientation;
+		faceTangent *= (orientation ? 1.0f : -1.0f) / length;
+
+		const glm::vec3 positions[3] = { p0, p0 + d1, p0 + d2 };
+		for (uint32 c = 0; c < 3; ++c, ++block.count)
+		{
+			const glm::vec3 toPrevious = positions[(c + 2) % 3] - positions[c], toNext = positions[(c + 1) % 3] - positions[c];
+			const float32 values[CornerBlock::NumRows] = { keys[triangle[c] * KeySize + 3], keys[triangle[c] * KeySize + 4],
+			                                               keys[triangle[c] * KeySize + 5], toPrevious.x, toPrevious.y, toPrevious.z, toNext.x, toNext.y, toNext.z,
+			                                               faceTangent.x, faceTangent.y, faceTangent.z
+			                                             };
+			for (uint32 row = 0; row < CornerBlock::NumRows; ++row) { block.rows[row][block.count] = values[row]; }
+			block.groups[block.count] = welded[triangle[c]] * 2 + orientation;
+		}
+		if (block.count + 3 > CornersPerBlock) { accumulateCorners(block, tangents); }
+	}
+	accumulateCorners(block, tangents);
+
+	// Each vertex keeps its index for the first orientation it is used with, and is copied for the other.
+	const uint32 Unused = 0xFFFFFFFFu;
+	std::vector<uint32> vertexOrientations(numVertices, Unused), copies(numVertices, Unused), newToOld(numVertices);
+	for (uint32 v = 0; v < numVertices; ++v) { newToOld[v] = v; }
+	for (uint32 i = 0; i < indices.size(); ++i)
+	{
+		const uint32 v = indices[i];
+		uint32 orientation = triangleOrientations[i / 3];
+		if (orientation == 2)
+		{
+			// Triangles without area take the tangent the vertex already has.
+			orientation = vertexOrientations[v] != Unused ? vertexOrientations[v] :
+			              glm::dot(tangents[welded[v] * 2 + 1], tangents[welded[v] * 2 + 1]) > 0.0f ||
+			              glm::dot(tangents[welded[v] * 2], tangents[welded[v] * 2]) == 0.0f ? 1 : 0;
+		}
+		if (vertexOrientations[v] == Unused) { vertexOrientations[v] = orientation; }
+		else if (vertexOrientations[v] != orientation)
+		{
+			if (copies[v] == Unused)
+			{
+				copies[v] = (uint32)newToOld.size();
+				newToOld.push_back(v);
+				vertexOrientations.push_back(orientation);
+			}
+			indices[i] = copies[v];
+		}
+	}
+
+	const uint32 newNumVertices = (uint32)newToOld.size();
+	const uint32 stride = options.generateBinormals ? 7 : 4;
+	std::vector<float32> tangentData(newNumVertices * stride);
+	for (uint32 v = 0; v < newNumVertices; ++v)
+	{
+		const uint32 old = newToOld[v];
+		const glm::vec3 normal = glm::make_vec3(&keys[old * KeySize + 3]);
+		const uint32 orientation = vertexOrientations[v] == Unused ? 1 : vertexOrientations[v];
+		const glm::vec3& sum = tangents[welded[old] * 2 + orientation];
+		const float32 length = glm::length(sum);
+		const glm::vec3 tangent = length > 0.0f ? sum / length : anyTangent(normal);
+		const float32 sign = orientation ? 1.0f : -1.0f;
+		float32* out = &tangentData[v * stride];
+		out[0] = tangent.x; out[1] = tangent.y; out[2] = tangent.z; out[3] = sign;
+		if (options.generateBinormals)
+		{
+			const glm::vec3 binormal = glm::cross(normal, tangent) * sign;
+			out[4] = binormal.x; out[5] = binormal.y; out[6] = binormal.z;
+		}
+	}
+
+	// Copy the vertices that were split, then store the tangents.
+	Mesh::InternalData& meshInternalData = mesh.getInternalData();
+	if (newNumVertices != numVertices)
+	{
+		for (size_t i = 0; i < meshInternalData.vertexAttributeDataBlocks.size(); ++i)
+		{
+			StridedBuffer& block = meshInternalData.vertexAttributeDataBlocks[i];
+			if (block.empty() || !block.stride) { continue; }
+			block.resize(newNumVertices * block.stride);
+			for (uint32 v = numVertices; v < newNumVertices; ++v)
+			{
+				memcpy(block.data() + v * block.stride, block.data() + newToOld[v] * block.stride, block.stride);
+			}
+		}
+		meshInternalData.primitiveData.numVertices = newNumVertices;
+		const types::IndexType indexType = mesh.getMeshInfo().isIndexed &&
+		                                   mesh.getFaces().getDataType() == types::IndexType::IndexType16Bit &&
+		                                   newNumVertices <= 0xFFFF ? types::IndexType::IndexType16Bit : types::IndexType::IndexType32Bit;
+		if (indexType == types::IndexType::IndexType16Bit)
+		{
+			std::vector<uint16> narrow(indices.begin(), indices.end());
+			meshInternalData.faces.setData((const byte*)narrow.data(), (uint32)(narrow.size() * 2), indexType);
+		}
+		else
+		{
+			meshInternalData.faces.setData((const byte*)indices.data(), (uint32)(indices.size() * 4), indexType);
+		}
+		meshInternalData.primitiveData.isIndexed = true;
+		// The levels of detail do not know which copy of a split vertex their triangles need.
+		mesh.clearLevelsOfDetail();
+	}
+	const byte* data = reinterpret_cast<const byte*>(tangentData.data());
+	const uint32 dataSize = (uint32)(tangentData.size() * sizeof(float32));
+	// A block shared with a BINORMAL attribute is only reused if the binormals are rewritten too, as the attribute
+	// would otherwise point into the new layout.
+	int32 dataIndex = getReusableDataBlock(mesh, "TANGENT", options.generateBinormals ? "BINORMAL" : "TANGENT");
+	if (dataIndex < 0 && options.generateBinormals) { dataIndex = getReusableDataBlock(mesh, "BINORMAL", "TANGENT"); }
+	if (dataIndex < 0) { dataIndex = mesh.addData(data, dataSize, stride * sizeof(float32)); }
+	else { mesh.addData(data, dataSize, stride * sizeof(float32), dataIndex); }
+	mesh.addVertexAttribute("TANGENT", types::DataType::Float32, 4, 0, dataIndex, true);
+	if (options.generateBinormals)
+	{
+		mesh.addVertexAttribute("BINORMAL", types::DataType::Float32, 3, 4 * sizeof(float32), dataIndex, true);
+	}
+	return true;
+}
+
+bool generateTangents(Model& model, const TangentGenerationOptions& options, uint32 numThreads)
+{
+	// Meshes without the attributes are skipped. The largest meshes are started first, so that the work is spread
+	// evenly over the threads, which only share the index of the next mesh.
+	std::vector<uint32> meshes;
+	for (uint32 i = 0; i < model.getNumMeshes(); ++i)
+	{
+		const Mesh& mesh = model.getMesh(i);
+		if (hasAttribute(mesh, "POSITION") && hasAttribute(mesh, "NORMAL") && hasAttribute(mesh, options.texCoordSemantic))
+		{
+			meshes.push_back(i);
+		}
+	}
+	std::sort(meshes.begin(), meshes.end(), [&model](uint32 lhs, uint32 rhs)
+	{
+		return model.getMesh(lhs).getNumFaces() > model.getMesh(rhs).getNumFaces();
+	});
+
+	std::atomic<size_t> nextMesh(0);
+	std::atomic<bool> failed(false);
+	auto worker = [&]()
+	{
+		for (size_t i = nextMesh++; i < meshes.size(); i = nextMesh++)
+		{
+			if (!generateTangents(model.getMesh(meshes[i]), options)) { failed = true; }
+		}
+	};
+	if (!numThreads) { numThreads = (std::max)(std::thread::hardware_concurrency(), 1u); }
+	numThreads = (std::min)(numThreads, (uint32)meshes.size());
+	std::vector<std::thread> threads;
+	for (uint32 i = 1; i < numThreads; ++i) { threads.push_back(std::thread(worker)); }
+	worker();
+	for (size_t i = 0; i < threads.size(); ++i) { threads[i].join(); }
+	return !failed;
+}
+}
+}
+}
+//!\endcond
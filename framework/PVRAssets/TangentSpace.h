@@ -0,0 +1,56 @@
+/*!
+\brief Functions that generate the tangent space (TANGENT and BINORMAL attributes) of meshes.
+\file PVRAssets/TangentSpace.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model.h"
+
+namespace pvr {
+namespace assets {
+namespace utils {
+/// <summary>The attributes that generateTangents reads and writes.</summary>
+struct TangentGenerationOptions
+{
+	/// <summary>The semantic of the texture coordinates that the tangents follow. Default "UV0".</summary>
+	StringHash texCoordSemantic;
+	/// <summary>If true, a BINORMAL attribute (three floats, sign * cross(normal, tangent)) is written as well, for
+	/// shaders that do not rebuild it. Default false.</summary>
+	bool generateBinormals;
+
+	/// <summary>Constructor. Generates tangents for UV0, without binormals.</summary>
+	TangentGenerationOptions() : texCoordSemantic("UV0"), generateBinormals(false) {}
+};
+
+/// <summary>Generate the tangents of a mesh from its positions, normals, texture coordinates and faces, the same way
+/// as MikkTSpace: the tangent of each triangle is projected onto the plane of the normal of each of its vertices and
+/// averaged with the other triangles of the vertex, weighted by the angle of the triangle at the vertex.</summary>
+/// <param name="mesh">A triangle list mesh with POSITION, NORMAL (three components) and texture coordinate attributes
+/// </param>
+/// <param name="options">The attributes to read and write</param>
+/// <returns>True on success, false if the mesh is not a triangle list, misses an attribute or its data is malformed.
+/// The mesh is unchanged on failure.</returns>
+/// <remarks>The tangents are written as a TANGENT attribute of four floats: the tangent, and the sign of the
+/// bitangent (1 or -1) in w, so that bitangent = w * cross(normal, tangent). Shaders reading three components ignore
+/// the sign, which only matters for mirrored texture coordinates. The attribute replaces any TANGENT attribute of the
+/// mesh, in a new data block (or in the data block of the replaced attribute if nothing else uses it).
+/// Vertices are grouped by value (position, normal and texture coordinates), so duplicated vertices get the same
+/// tangents, as in MikkTSpace. Vertices used by triangles with mirrored and unmirrored texture coordinates are split
+/// in two, as the sign of their bitangent differs, which removes the levels of detail of the mesh. Triangles without
+/// texture coordinate area do not contribute. Runs in linear time in the number of triangles.</remarks>
+bool generateTangents(Mesh& mesh, const TangentGenerationOptions& options = TangentGenerationOptions());
+
+/// <summary>Generate the tangents of all the meshes of a model that have the attributes needed (see
+/// generateTangents(Mesh&amp;)).</summary>
+/// <param name="model">The model</param>
+/// <param name="options">The attributes to read and write</param>
+/// <param name="numThreads">The number of threads that process meshes concurrently. 0 uses one per hardware
+/// thread.</param>
+/// <returns>True on success, false if the tangents of a mesh that has the attributes could not be generated
+/// </returns>
+bool generateTangents(Model& model, const TangentGenerationOptions& options = TangentGenerationOptions(),
+                      uint32 numThreads = 0);
+}
+}
+}
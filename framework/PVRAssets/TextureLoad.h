@@ -32,5 +32,43 @@ inline Result textureLoad(Stream::ptr_type textureStream, TextureFileFormat type
 	assetRd->closeAssetStream();
 	return rslt;
 }
+
+/// <summary>Load a texture, skipping its largest MIP levels, for example to save memory on low-end devices.
+/// </summary>
+/// <param name="textureStream">The stream to load the texture from</param>
+/// <param name="type">The file format of the stream</param>
+/// <param name="outTex">The loaded texture</param>
+/// <param name="options">The streaming options. Only supported by the PVR and KTX formats, other formats are
+/// loaded whole.</param>
+/// <returns>Success, or an error code.</returns>
+/// <remarks>MIP levels deferred by options.initialByteBudget cannot be read later with this function, as the reader
+/// is not kept. To stream in MIP levels progressively, use TextureReaderPVR or TextureReaderKTX directly.</remarks>
+inline Result textureLoad(Stream::ptr_type textureStream, TextureFileFormat type, Texture& outTex,
+                          const TextureStreamingOptions& options)
+{
+	if (type != TextureFileFormat::PVR && type != TextureFileFormat::KTX)
+	{
+		return textureLoad(textureStream, type, outTex);
+	}
+	if (!textureStream.get() || !textureStream->open())
+	{
+		return Result::UnableToOpen;
+	}
+	bool read;
+	if (type == TextureFileFormat::PVR)
+	{
+		assetReaders::TextureReaderPVR reader(textureStream);
+		reader.setStreamingOptions(options);
+		read = reader.readAsset(outTex);
+	}
+	else
+	{
+		assetReaders::TextureReaderKTX reader(textureStream);
+		reader.setStreamingOptions(options);
+		read = reader.readAsset(outTex);
+	}
+	textureStream->close();
+	return read ? Result::Success : Result::NotFound;
+}
 }
 }
\ No newline at end of file
@@ -0,0 +1,704 @@
+/*!
+\brief Implementation of the TriangleBvh and ModelBvh classes.
+\file PVRAssets/TriangleBvh.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/TriangleBvh.h"
+#include "PVRAssets/Helper.h"
+#include "PVRCore/Log.h"
+#include "PVRCore/Math/Float4.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace pvr {
+namespace assets {
+namespace {
+// The floats of a triangle in leaf order: its first vertex, then the edges to the second and third vertices.
+const uint32 FloatsPerTriangle = 9;
+// Leaves hold at most this many triangles.
+const uint32 MaxLeafTriangles = 8;
+// The number of bins along each axis that split candidates are evaluated at.
+const uint32 NumBins = 16;
+// Below this depth, nodes are split in the middle instead of by the surface area heuristic, which bounds the depth of
+// the hierarchy (and the traversal stacks) for any input.
+const uint32 MaxSahDepth = 40;
+const uint32 StackSize = 256;
+// The cost of traversing a node, relative to intersecting a triangle.
+const float32 TraversalCost = 1.0f;
+
+// The four children of a node processed together.
+using math::Float4;
+
+// An axis aligned box, used while building.
+struct Box
+{
+	glm::vec3 min;
+	glm::vec3 max;
+	Box() : min(FLT_MAX), max(-FLT_MAX) {}
+	void add(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+	void add(const Box& box) { min = glm::min(min, box.min); max = glm::max(max, box.max); }
+	// Half the surface area of the box, 0 if it is empty.
+	float32 area() const
+	{
+		if (min.x > max.x) { return 0.0f; }
+		const glm::vec3 size = max - min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+};
+
+// A node of the binary hierarchy that is built before it is flattened into nodes of four children.
+struct BuildNode
+{
+	Box bounds;
+	uint32 children[2]; // Both 0 for leaves, as the root is nobody's child
+	uint32 first;
+	uint32 count;
+	bool isLeaf() const { return children[0] == 0; }
+};
+
+struct Builder
+{
+	std::vector<Box> triangleBounds;
+	std::vector<glm::vec3> centroids;
+	std::vector<uint32>& order;
+	std::vector<BuildNode> nodes;
+
+	explicit Builder(std::vector<uint32>& order) : order(order) {}
+
+	// Split order[first, first + count) in place. Returns the index of the node.
+	uint32 build(uint32 first, uint32 count, uint32 depth)
+	{
+		const uint32 nodeIndex = (uint32)nodes.size();
+		nodes.push_back(BuildNode());
+		Box bounds, centroidBounds;
+		for (uint32 i = first; i < first + count; ++i)
+		{
+			bounds.add(triangleBounds[order[i]]);
+			centroidBounds.add(centroids[order[i]]);
+		}
+		nodes[nodeIndex].bounds = bounds;
+		nodes[nodeIndex].children[0] = nodes[nodeIndex].children[1] = 0;
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].count = count;
+		if (count <= 2) { return nodeIndex; }
+
+		uint32 split = first + count / 2;
+		const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		const uint32 largestAxis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		if (extent[largestAxis] <= 0.0f)
+		{
+			// All the centroids coincide, so any split is as good as another.
+			if (count <= MaxLeafTriangles) { return nodeIndex; }
+		}
+		else if (depth >= MaxSahDepth)
+		{
+			std::nth_element(order.begin() + first, order.begin() + split, order.begin() + first + count,
+			                 [&](uint32 a, uint32 b) { return centroids[a][largestAxis] < centroids[b][largestAxis]; });
+		}
+		else
+		{
+			// Evaluate the surface area heuristic between the bins of each axis.
+			float32 bestCost = FLT_MAX;
+			uint32 bestAxis = 0, bestBin = 0;
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				if (extent[axis] <= 0.0f) { continue; }
+				const float32 scale = NumBins / extent[axis];
+				Box binBounds[NumBins];
+				uint32 binCounts[NumBins] = {};
+				for (uint32 i = first; i < first + count; ++i)
+				{
+					const uint32 bin = (std::min)((uint32)((centroids[order[i]][axis] - centroidBounds.min[axis]) * scale),
+					                              NumBins - 1);
+					binBounds[bin].add(triangleBounds[order[i]]);
+					++binCounts[bin];
+				}
+				float32 rightCosts[NumBins];
+				Box right;
+				uint32 rightCount = 0;
+				for (uint32 bin = NumBins - 1; bin > 0; --bin)
+				{
+					right.add(binBounds[bin]);
+					rightCount += binCounts[bin];
+					rightCosts[bin] = right.area() * rightCount;
+				}
+				Box left;
+				uint32 leftCount = 0;
+				for (uint32 bin = 1; bin < NumBins; ++bin)
+				{
+					left.add(binBounds[bin - 1]);
+					leftCount += binCounts[bin - 1];
+					const float32 cost = left.area() * leftCount + rightCosts[bin];
+					if (leftCount && leftCount < count && cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+			const float32 area = bounds.area();
+			const float32 splitCost = area > 0.0f ? TraversalCost + bestCost / area : 0.0f;
+			if (count <= MaxLeafTriangles && splitCost >= (float32)count) { return nodeIndex; }
+			const float32 scale = NumBins / extent[bestAxis], origin = centroidBounds.min[bestAxis];
+			split = (uint32)(std::partition(order.begin() + first, order.begin() + first + count, [&](uint32 triangle)
+			{
+				return (std::min)((uint32)((centroids[triangle][bestAxis] - origin) * scale), NumBins - 1) < bestBin;
+			}) - order.begin());
+		}
+		const uint32 left = build(first, split - first, depth + 1);
+		const uint32 right = build(split, first + count - split, depth + 1);
+		nodes[nodeIndex].children[0] = left;
+		nodes[nodeIndex].children[1] = right;
+		return nodeIndex;
+	}
+
+	// Flatten the binary node into a node of four children: its children are replaced by theirs, largest first, until
+	// there are four. Returns the index of the node.
+	uint32 flatten(uint32 buildNode, std::vector<TriangleBvh::Node>& flatNodes) const
+	{
+		uint32 children[4];
+		uint32 numChildren = 0;
+		if (nodes[buildNode].isLeaf()) { children[numChildren++] = buildNode; }
+		else
+		{
+			children[numChildren++] = nodes[buildNode].children[0];
+			children[numChildren++] = nodes[buildNode].children[1];
+		}
+		while (numChildren < 4)
+		{
+			uint32 largest = numChildren;
+			for (uint32 i = 0; i < numChildren; ++i)
+			{
+				if (!nodes[children[i]].isLeaf() && (largest == numChildren ||
+				                                      nodes[children[i]].bounds.area() > nodes[children[largest]].bounds.area()))
+				{
+					largest = i;
+				}
+			}
+			if (largest == numChildren) { break; }
+			const BuildNode& opened = nodes[children[largest]];
+			children[largest] = opened.children[0];
+			children[numChildren++] = opened.children[1];
+		}
+
+		const uint32 nodeIndex = (uint32)flatNodes.size();
+		flatNodes.push_back(TriangleBvh::Node());
+		memset(&flatNodes[nodeIndex], 0, sizeof(TriangleBvh::Node));
+		flatNodes[nodeIndex].numChildren = numChildren;
+		for (uint32 i = 0; i < numChildren; ++i)
+		{
+			const BuildNode& child = nodes[children[i]];
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				flatNodes[nodeIndex].bounds[axis][i] = child.bounds.min[axis];
+				flatNodes[nodeIndex].bounds[axis + 3][i] = child.bounds.max[axis];
+			}
+			if (child.isLeaf())
+			{
+				flatNodes[nodeIndex].child[i] = child.first;
+				flatNodes[nodeIndex].count[i] = child.count;
+			}
+			else
+			{
+				const uint32 flatChild = flatten(children[i], flatNodes);
+				flatNodes[nodeIndex].child[i] = flatChild;
+			}
+		}
+		return nodeIndex;
+	}
+};
+
+// The distances at which a ray enters each child of a node, and a bit per child that it enters before maxDistance.
+struct RayBoxes
+{
+	Float4 origin[3];
+	Float4 inverseDirection[3];
+
+	RayBoxes(const glm::vec3& rayOrigin, const glm::vec3& direction) :
+		origin{ Float4(rayOrigin.x), Float4(rayOrigin.y), Float4(rayOrigin.z) },
+		inverseDirection{ Float4(safeInverse(direction.x)), Float4(safeInverse(direction.y)),
+		                  Float4(safeInverse(direction.z)) } {}
+
+	// Avoids infinities, as 0 * infinity is NaN for rays starting on the plane of a box.
+	static float32 safeInverse(float32 value)
+	{
+		return 1.0f / (fabsf(value) > 1e-20f ? value : (value < 0.0f ? -1e-20f : 1e-20f));
+	}
+
+	uint32 intersect(const TriangleBvh::Node& node, float32 maxDistance, float32* distances) const
+	{
+		const Float4 x0 = (Float4::load(node.bounds[0]) - origin[0]) * inverseDirection[0];
+		const Float4 x1 = (Float4::load(node.bounds[3]) - origin[0]) * inverseDirection[0];
+		const Float4 y0 = (Float4::load(node.bounds[1]) - origin[1]) * inverseDirection[1];
+		const Float4 y1 = (Float4::load(node.bounds[4]) - origin[1]) * inverseDirection[1];
+		const Float4 z0 = (Float4::load(node.bounds[2]) - origin[2]) * inverseDirection[2];
+		const Float4 z1 = (Float4::load(node.bounds[5]) - origin[2]) * inverseDirection[2];
+		const Float4 enter = maximum(maximum(minimum(x0, x1), minimum(y0, y1)), maximum(minimum(z0, z1), Float4(0.0f)));
+		const Float4 exit = minimum(minimum(maximum(x0, x1), maximum(y0, y1)), minimum(maximum(z0, z1), Float4(maxDistance)));
+		enter.store(distances);
+		return lessEqualBits(enter, exit) & ((1u << node.numChildren) - 1);
+	}
+};
+
+// Moller-Trumbore intersection of a ray with a triangle stored as a vertex and two edges. Both sides are hit.
+inline bool intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const float32* triangle,
+                              float32 maxDistance, float32& distance, float32& u, float32& v)
+{
+	const glm::vec3 edge1(triangle[3], triangle[4], triangle[5]), edge2(triangle[6], triangle[7], triangle[8]);
+	const glm::vec3 p = glm::cross(direction, edge2);
+	const float32 determinant = glm::dot(edge1, p);
+	if (determinant == 0.0f) { return false; }
+	const float32 inverse = 1.0f / determinant;
+	const glm::vec3 s = origin - glm::vec3(triangle[0], triangle[1], triangle[2]);
+	u = glm::dot(s, p) * inverse;
+	if (u < 0.0f || u > 1.0f) { return false; }
+	const glm::vec3 q = glm::cross(s, edge1);
+	v = glm::dot(direction, q) * inverse;
+	if (v < 0.0f || u + v > 1.0f) { return false; }
+	distance = glm::dot(edge2, q) * inverse;
+	return distance >= 0.0f && distance <= maxDistance;
+}
+
+// The squared distance from a point to a triangle (Ericson, "Real-Time Collision Detection", 5.1.5).
+float32 squaredDistanceToTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	const glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+	const float32 d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) { return glm::dot(ap, ap); }
+	const glm::vec3 bp = p - b;
+	const float32 d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) { return glm::dot(bp, bp); }
+	const float32 vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		const glm::vec3 d = ap - ab * (d1 / (d1 - d3));
+		return glm::dot(d, d);
+	}
+	const glm::vec3 cp = p - c;
+	const float32 d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) { return glm::dot(cp, cp); }
+	const float32 vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		const glm::vec3 d = ap - ac * (d2 / (d2 - d6));
+		return glm::dot(d, d);
+	}
+	const float32 va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+	{
+		const glm::vec3 d = bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		return glm::dot(d, d);
+	}
+	const float32 denominator = va + vb + vc;
+	if (denominator == 0.0f) { return glm::dot(ap, ap); } // Degenerate triangle whose vertices coincide
+	const glm::vec3 d = ap - ab * (vb / denominator) - ac * (vc / denominator);
+	return glm::dot(d, d);
+}
+
+bool intersectsBox(const glm::vec3* bounds, const glm::vec3& origin, const glm::vec3& direction, float32 maxDistance)
+{
+	float32 enter = 0.0f, exit = maxDistance;
+	for (uint32 axis = 0; axis < 3; ++axis)
+	{
+		const float32 inverse = RayBoxes::safeInverse(direction[axis]);
+		const float32 t0 = (bounds[0][axis] - origin[axis]) * inverse, t1 = (bounds[1][axis] - origin[axis]) * inverse;
+		enter = (std::max)(enter, (std::min)(t0, t1));
+		exit = (std::min)(exit, (std::max)(t0, t1));
+	}
+	return enter <= exit;
+}
+}
+
+bool TriangleBvh::init(const Mesh& mesh)
+{
+	_nodes.clear();
+	_triangles.clear();
+	_triangleIds.clear();
+	_triangleLeafOrder.clear();
+	_bounds[0] = glm::vec3(FLT_MAX);
+	_bounds[1] = glm::vec3(-FLT_MAX);
+	if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty())
+	{
+		Log(Log.Error, "TriangleBvh::init: Only triangle lists are supported");
+		return false;
+	}
+	const Mesh::VertexAttributeData* attribute = mesh.getVertexAttributeByName("POSITION");
+	if (!attribute || attribute->getDataIndex() < 0 || (uint32)attribute->getDataIndex() >= mesh.getNumDataElements() ||
+	    attribute->getN() < 3)
+	{
+		Log(Log.Error, "TriangleBvh::init: The mesh has no POSITION attribute of three components");
+		return false;
+	}
+	const uint32 numVertices = mesh.getNumVertices(), numTriangles = mesh.getNumFaces();
+	const uint32 stride = mesh.getStride(attribute->getDataIndex());
+	const uint32 n = (std::min)(attribute->getN(), 4u);
+	const byte* data = static_cast<const byte*>(mesh.getData(attribute->getDataIndex()));
+	if (!stride || !data || mesh.getDataSize(attribute->getDataIndex()) < (size_t)numVertices * stride ||
+	    attribute->getOffset() + types::dataTypeSize(attribute->getVertexLayout().dataType) * n > stride)
+	{
+		Log(Log.Error, "TriangleBvh::init: The POSITION data is smaller than the number of vertices");
+		return false;
+	}
+	const uint32 indexSize = mesh.getFaces().getDataTypeSize() / 8;
+	if (mesh.getMeshInfo().isIndexed && mesh.getFaces().getDataSize() < (size_t)numTriangles * 3 * indexSize)
+	{
+		Log(Log.Error, "TriangleBvh::init: The face data is smaller than the number of faces");
+		return false;
+	}
+
+	std::vector<glm::vec3> positions(numVertices);
+	const glm::mat4& unpackMatrix = mesh.getUnpackMatrix();
+	if (numVertices)
+	{
+		VertexReadBatch(data + attribute->getOffset(), stride, attribute->getVertexLayout().dataType, 3, numVertices,
+		                &positions[0].x, 3);
+	}
+	for (uint32 i = 0; i < numVertices; ++i) { positions[i] = glm::vec3(unpackMatrix * glm::vec4(positions[i], 1.0f)); }
+	std::vector<uint32> indices(numTriangles * 3);
+	for (uint32 i = 0; i < indices.size(); ++i)
+	{
+		if (!mesh.getMeshInfo().isIndexed) { indices[i] = i; }
+		else { VertexIndexRead(mesh.getFaces().getData() + i * indexSize, mesh.getFaces().getDataType(), &indices[i]); }
+		if (indices[i] >= numVertices)
+		{
+			Log(Log.Error, "TriangleBvh::init: The mesh uses vertices that it does not have");
+			return false;
+		}
+	}
+	if (!numTriangles) { return true; }
+
+	_triangleIds.resize(numTriangles);
+	Builder builder(_triangleIds);
+	builder.triangleBounds.resize(numTriangles);
+	builder.centroids.resize(numTriangles);
+	for (uint32 i = 0; i < numTriangles; ++i)
+	{
+		_triangleIds[i] = i;
+		Box& bounds = builder.triangleBounds[i];
+		for (uint32 corner = 0; corner < 3; ++corner) { bounds.add(positions[indices[i * 3 + corner]]); }
+		builder.centroids[i] = (bounds.min + bounds.max) * 0.5f;
+	}
+	builder.nodes.reserve(numTriangles * 2 / 3 + 1);
+	builder.build(0, numTriangles, 0);
+	_bounds[0] = builder.nodes[0].bounds.min;
+	_bounds[1] = builder.nodes[0].bounds.max;
+	_nodes.reserve(builder.nodes.size() / 3 + 1);
+	builder.flatten(0, _nodes);
+
+	_triangles.resize(numTriangles * FloatsPerTriangle);
+	_triangleLeafOrder.resize(numTriangles);
+	for (uint32 i = 0; i < numTriangles; ++i)
+	{
+		const uint32 triangle = _triangleIds[i];
+		_triangleLeafOrder[triangle] = i;
+		const glm::vec3& v0 = positions[indices[triangle * 3]];
+		const glm::vec3 edge1 = positions[indices[triangle * 3 + 1]] - v0, edge2 = positions[indices[triangle * 3 + 2]] - v0;
+		float32* out = &_triangles[i * FloatsPerTriangle];
+		out[0] = v0.x; out[1] = v0.y; out[2] = v0.z;
+		out[3] = edge1.x; out[4] = edge1.y; out[5] = edge1.z;
+		out[6] = edge2.x; out[7] = edge2.y; out[8] = edge2.z;
+	}
+	return true;
+}
+
+bool TriangleBvh::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float32 maxDistance,
+                               RayHit& hit) const
+{
+	if (_nodes.empty()) { return false; }
+	const RayBoxes ray(origin, direction);
+	struct Entry
+	{
+		uint32 node;
+		float32 distance;
+	};
+	Entry stack[StackSize];
+	uint32 stackSize = 0;
+	stack[stackSize].node = 0;
+	stack[stackSize++].distance = 0.0f;
+	bool found = false;
+	while (stackSize)
+	{
+		const Entry entry = stack[--stackSize];
+		if (entry.distance > maxDistance) { continue; }
+		const Node& node = _nodes[entry.node];
+		float32 distances[4];
+		uint32 hits = ray.intersect(node, maxDistance, distances);
+
+		// Leaves are intersected straight away, so that maxDistance shrinks before the children are pushed.
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (!(hits & (1u << i)) || !node.count[i]) { continue; }
+			hits &= ~(1u << i);
+			for (uint32 t = node.child[i]; t < node.child[i] + node.count[i]; ++t)
+			{
+				float32 distance, u, v;
+				if (intersectTriangle(origin, direction, &_triangles[t * FloatsPerTriangle], maxDistance, distance, u, v))
+				{
+					maxDistance = distance;
+					hit.distance = distance;
+					hit.triangle = _triangleIds[t];
+					hit.u = u;
+					hit.v = v;
+					found = true;
+				}
+			}
+		}
+		// The nearest child is pushed last, so that it is visited first.
+		Entry children[4];
+		uint32 numChildren = 0;
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (!(hits & (1u << i)) || distances[i] > maxDistance) { continue; }
+			uint32 position = numChildren++;
+			for (; position > 0 && children[position - 1].distance < distances[i]; --position)
+			{
+				children[position] = children[position - 1];
+			}
+			children[position].node = node.child[i];
+			children[position].distance = distances[i];
+		}
+		for (uint32 i = 0; i < numChildren; ++i) { stack[stackSize++] = children[i]; }
+	}
+	return found;
+}
+
+bool TriangleBvh::intersectsSegment(const glm::vec3& from, const glm::vec3& to) const
+{
+	if (_nodes.empty()) { return false; }
+	const glm::vec3 direction = to - from;
+	const RayBoxes ray(from, direction);
+	uint32 stack[StackSize];
+	uint32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize)
+	{
+		const Node& node = _nodes[stack[--stackSize]];
+		float32 distances[4];
+		const uint32 hits = ray.intersect(node, 1.0f, distances);
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (!(hits & (1u << i))) { continue; }
+			if (!node.count[i])
+			{
+				stack[stackSize++] = node.child[i];
+				continue;
+			}
+			for (uint32 t = node.child[i]; t < node.child[i] + node.count[i]; ++t)
+			{
+				float32 distance, u, v;
+				if (intersectTriangle(from, direction, &_triangles[t * FloatsPerTriangle], 1.0f, distance, u, v))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+uint32 TriangleBvh::intersectSphere(const glm::vec3& centre, float32 radius, std::vector<uint32>& triangles) const
+{
+	if (_nodes.empty()) { return 0; }
+	const size_t oldSize = triangles.size();
+	const Float4 x(centre.x), y(centre.y), z(centre.z), zero(0.0f), squaredRadius(radius * radius);
+	uint32 stack[StackSize];
+	uint32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize)
+	{
+		const Node& node = _nodes[stack[--stackSize]];
+		// The distance from the centre to each box, 0 inside it.
+		const Float4 dx = maximum(maximum(Float4::load(node.bounds[0]) - x, x - Float4::load(node.bounds[3])), zero);
+		const Float4 dy = maximum(maximum(Float4::load(node.bounds[1]) - y, y - Float4::load(node.bounds[4])), zero);
+		const Float4 dz = maximum(maximum(Float4::load(node.bounds[2]) - z, z - Float4::load(node.bounds[5])), zero);
+		const uint32 hits = lessEqualBits(dx * dx + dy * dy + dz * dz, squaredRadius) & ((1u << node.numChildren) - 1);
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			if (!(hits & (1u << i))) { continue; }
+			if (!node.count[i])
+			{
+				stack[stackSize++] = node.child[i];
+				continue;
+			}
+			for (uint32 t = node.child[i]; t < node.child[i] + node.count[i]; ++t)
+			{
+				const float32* triangle = &_triangles[t * FloatsPerTriangle];
+				const glm::vec3 v0(triangle[0], triangle[1], triangle[2]);
+				if (squaredDistanceToTriangle(centre, v0, v0 + glm::vec3(triangle[3], triangle[4], triangle[5]),
+				                              v0 + glm::vec3(triangle[6], triangle[7], triangle[8])) <= radius * radius)
+				{
+					triangles.push_back(_triangleIds[t]);
+				}
+			}
+		}
+	}
+	return (uint32)(triangles.size() - oldSize);
+}
+
+void TriangleBvh::getTriangle(uint32 triangle, glm::vec3* vertices) const
+{
+	const float32* data = &_triangles[_triangleLeafOrder[triangle] * FloatsPerTriangle];
+	vertices[0] = glm::vec3(data[0], data[1], data[2]);
+	vertices[1] = vertices[0] + glm::vec3(data[3], data[4], data[5]);
+	vertices[2] = vertices[0] + glm::vec3(data[6], data[7], data[8]);
+}
+
+bool ModelBvh::init(const Model& model)
+{
+	_meshes.clear();
+	_instances.clear();
+	_meshes.resize(model.getNumMeshes());
+	for (uint32 i = 0; i < model.getNumMeshes(); ++i)
+	{
+		const Mesh& mesh = model.getMesh(i);
+		if (mesh.getPrimitiveType() != types::PrimitiveTopology::TriangleList || !mesh.getMeshInfo().stripLengths.empty() ||
+		    !mesh.getVertexAttributeByName("POSITION"))
+		{
+			continue;
+		}
+		if (!_meshes[i].init(mesh))
+		{
+			Log(Log.Error, "ModelBvh::init: Could not build the hierarchy of mesh %d", i);
+			return false;
+		}
+	}
+	for (uint32 i = 0; i < model.getNumMeshNodes(); ++i)
+	{
+		const int32 meshId = model.getMeshNode(i).getObjectId();
+		if (meshId < 0 || (uint32)meshId >= _meshes.size() || !_meshes[meshId].getNumTriangles()) { continue; }
+		Instance instance;
+		instance.meshNodeId = i;
+		instance.meshId = (uint32)meshId;
+		_instances.push_back(instance);
+	}
+	update(model);
+	return true;
+}
+
+void ModelBvh::update(const Model& model)
+{
+	for (uint32 i = 0; i < _instances.size(); ++i)
+	{
+		placeInstance(_instances[i], model.getWorldMatrix(_instances[i].meshNodeId));
+	}
+}
+
+void ModelBvh::update(const AnimationInstance& instance)
+{
+	for (uint32 i = 0; i < _instances.size(); ++i)
+	{
+		if (_instances[i].meshNodeId >= instance.getNumNodes())
+		{
+			Log(Log.Error, "ModelBvh::update: The instance does not have node %d", _instances[i].meshNodeId);
+			return;
+		}
+		placeInstance(_instances[i], instance.getWorldMatrix(_instances[i].meshNodeId));
+	}
+}
+
+void ModelBvh::placeInstance(Instance& instance, const glm::mat4x4& worldMatrix)
+{
+	instance.worldMatrix = worldMatrix;
+	instance.inverseWorldMatrix = glm::inverse(worldMatrix);
+	// The box of the transformed box (Arvo, "Transforming Axis-Aligned Bounding Boxes").
+	const glm::vec3* bounds = _meshes[instance.meshId].getBoundingBox();
+	instance.worldBounds[0] = instance.worldBounds[1] = glm::vec3(worldMatrix[3]);
+	for (uint32 column = 0; column < 3; ++column)
+	{
+		for (uint32 row = 0; row < 3; ++row)
+		{
+			const float32 a = worldMatrix[column][row] * bounds[0][column], b = worldMatrix[column][row] * bounds[1][column];
+			instance.worldBounds[0][row] += (std::min)(a, b);
+			instance.worldBounds[1][row] += (std::max)(a, b);
+		}
+	}
+	// A world sphere is an ellipsoid in the coordinates of the mesh: bound it by a sphere whose radius is the largest
+	// stretch of the inverse matrix (the length of its longest column if they are orthogonal, as for rotations and
+	// scales, otherwise its Frobenius norm).
+	const glm::vec3 x(instance.inverseWorldMatrix[0]), y(instance.inverseWorldMatrix[1]), z(instance.inverseWorldMatrix[2]);
+	const float32 xx = glm::dot(x, x), yy = glm::dot(y, y), zz = glm::dot(z, z);
+	const float32 longest = (std::max)(xx, (std::max)(yy, zz)), tolerance = 1e-5f * longest;
+	const bool orthogonal = fabsf(glm::dot(x, y)) <= tolerance && fabsf(glm::dot(y, z)) <= tolerance &&
+	                        fabsf(glm::dot(z, x)) <= tolerance;
+	instance.radiusScale = sqrtf(orthogonal ? longest : xx + yy + zz);
+}
+
+bool ModelBvh::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float32 maxDistance,
+                            ModelRayHit& hit) const
+{
+	bool found = false;
+	for (uint32 i = 0; i < _instances.size(); ++i)
+	{
+		const Instance& instance = _instances[i];
+		if (!intersectsBox(instance.worldBounds, origin, direction, maxDistance)) { continue; }
+		// An affine transform keeps distances along the ray in multiples of its direction.
+		RayHit meshHit;
+		if (_meshes[instance.meshId].intersectRay(glm::vec3(instance.inverseWorldMatrix * glm::vec4(origin, 1.0f)),
+		    glm::vec3(instance.inverseWorldMatrix * glm::vec4(direction, 0.0f)), maxDistance, meshHit))
+		{
+			maxDistance = meshHit.distance;
+			hit.distance = meshHit.distance;
+			hit.meshNodeId = instance.meshNodeId;
+			hit.triangle = meshHit.triangle;
+			hit.u = meshHit.u;
+			hit.v = meshHit.v;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool ModelBvh::intersectsSegment(const glm::vec3& from, const glm::vec3& to) const
+{
+	for (uint32 i = 0; i < _instances.size(); ++i)
+	{
+		const Instance& instance = _instances[i];
+		if (intersectsBox(instance.worldBounds, from, to - from, 1.0f) &&
+		    _meshes[instance.meshId].intersectsSegment(glm::vec3(instance.inverseWorldMatrix * glm::vec4(from, 1.0f)),
+		        glm::vec3(instance.inverseWorldMatrix * glm::vec4(to, 1.0f))))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32 ModelBvh::intersectSphere(const glm::vec3& centre, float32 radius, std::vector<ModelTriangle>& triangles) const
+{
+	const size_t oldSize = triangles.size();
+	std::vector<uint32> candidates;
+	for (uint32 i = 0; i < _instances.size(); ++i)
+	{
+		const Instance& instance = _instances[i];
+		const glm::vec3 outside = glm::max(glm::max(instance.worldBounds[0] - centre, centre - instance.worldBounds[1]),
+		                                   glm::vec3(0.0f));
+		if (glm::dot(outside, outside) > radius * radius) { continue; }
+		const TriangleBvh& mesh = _meshes[instance.meshId];
+		candidates.clear();
+		mesh.intersectSphere(glm::vec3(instance.inverseWorldMatrix * glm::vec4(centre, 1.0f)),
+		                     radius * instance.radiusScale, candidates);
+		// The candidates are in a sphere around the ellipsoid: keep those in the sphere in world coordinates.
+		for (uint32 j = 0; j < candidates.size(); ++j)
+		{
+			glm::vec3 vertices[3];
+			mesh.getTriangle(candidates[j], vertices);
+			for (uint32 k = 0; k < 3; ++k) { vertices[k] = glm::vec3(instance.worldMatrix * glm::vec4(vertices[k], 1.0f)); }
+			if (squaredDistanceToTriangle(centre, vertices[0], vertices[1], vertices[2]) <= radius * radius)
+			{
+				ModelTriangle triangle;
+				triangle.meshNodeId = instance.meshNodeId;
+				triangle.triangle = candidates[j];
+				triangles.push_back(triangle);
+			}
+		}
+	}
+	return (uint32)(triangles.size() - oldSize);
+}
+}
+}
+//!\endcond
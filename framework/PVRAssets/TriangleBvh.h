@@ -0,0 +1,199 @@
+/*!
+\brief Contains bounding volume hierarchies of the triangles of meshes and models, for ray casting, picking and
+line of sight tests on the CPU.
+\file PVRAssets/TriangleBvh.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model.h"
+#include "PVRAssets/Model/AnimationInstance.h"
+
+namespace pvr {
+namespace assets {
+/// <summary>The closest intersection of a ray with the triangles of a mesh.</summary>
+struct RayHit
+{
+	float32 distance; //!< The distance along the ray, in multiples of its direction
+	uint32 triangle;  //!< The index of the triangle in the faces of the mesh
+	float32 u;        //!< Barycentric coordinate of the hit: the weight of the second vertex of the triangle
+	float32 v;        //!< Barycentric coordinate of the hit: the weight of the third vertex of the triangle
+};
+
+/// <summary>A bounding volume hierarchy of the triangles of a mesh, in the coordinates of the mesh (after its unpack
+/// matrix).</summary>
+/// <remarks>The hierarchy is built with the surface area heuristic, then flattened into nodes of four children so
+/// that queries test four bounding boxes at once (with SSE2 or NEON where available). Queries are thread safe and
+/// allocate no memory, except for the triangles returned by intersectSphere. Skinned meshes are built in their
+/// bind pose.</remarks>
+class TriangleBvh
+{
+public:
+	/// <summary>Constructor. Call init before use; an empty hierarchy intersects nothing.</summary>
+	TriangleBvh() {}
+
+	/// <summary>Build the hierarchy of the triangles of a mesh.</summary>
+	/// <param name="mesh">A triangle list mesh with a POSITION attribute. The hierarchy keeps a copy of the
+	/// triangles, so the mesh can change or be released afterwards.</param>
+	/// <returns>True on success, false if the mesh is not a triangle list or its data is malformed</returns>
+	bool init(const Mesh& mesh);
+
+	/// <summary>Find the closest intersection of a ray with the triangles, both sides of the triangles included.
+	/// </summary>
+	/// <param name="origin">The origin of the ray</param>
+	/// <param name="direction">The direction of the ray. Need not be normalized: distances are measured in multiples
+	/// of it.</param>
+	/// <param name="maxDistance">Intersections further than this (in multiples of direction) are ignored</param>
+	/// <param name="hit">Receives the closest intersection, if any</param>
+	/// <returns>True if the ray intersects a triangle</returns>
+	bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float32 maxDistance, RayHit& hit) const;
+
+	/// <summary>Find the intersection of a segment with the triangles that is closest to its start.</summary>
+	/// <param name="from">The start of the segment</param>
+	/// <param name="to">The end of the segment</param>
+	/// <param name="hit">Receives the intersection, with a distance from 0 (from) to 1 (to)</param>
+	/// <returns>True if the segment intersects a triangle</returns>
+	bool intersectSegment(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const
+	{
+		return intersectRay(from, to - from, 1.0f, hit);
+	}
+
+	/// <summary>Test if a segment intersects any triangle, for line of sight tests. Faster than intersectSegment, as
+	/// the search stops at the first triangle found.</summary>
+	/// <param name="from">The start of the segment</param>
+	/// <param name="to">The end of the segment</param>
+	/// <returns>True if the segment intersects a triangle</returns>
+	bool intersectsSegment(const glm::vec3& from, const glm::vec3& to) const;
+
+	/// <summary>Find the triangles that intersect a sphere.</summary>
+	/// <param name="centre">The centre of the sphere</param>
+	/// <param name="radius">The radius of the sphere</param>
+	/// <param name="triangles">The index of each triangle found is appended to this</param>
+	/// <returns>The number of triangles found</returns>
+	uint32 intersectSphere(const glm::vec3& centre, float32 radius, std::vector<uint32>& triangles) const;
+
+	/// <summary>Get the number of triangles of the hierarchy.</summary>
+	uint32 getNumTriangles() const { return (uint32)_triangleIds.size(); }
+
+	/// <summary>Get the bounding box of the triangles: minimum, then maximum. Inverted if there are none.</summary>
+	const glm::vec3* getBoundingBox() const { return _bounds; }
+
+	/// <summary>Get the three vertices of a triangle.</summary>
+	/// <param name="triangle">The index of the triangle in the faces of the mesh</param>
+	/// <param name="vertices">Receives the positions of the vertices of the triangle</param>
+	void getTriangle(uint32 triangle, glm::vec3* vertices) const;
+
+	/// <summary>A node of the hierarchy: the bounding boxes of up to four children, each either a node or a leaf of
+	/// triangles.</summary>
+	struct Node
+	{
+		float32 bounds[6][4]; //!< Minimum x, y, z then maximum x, y, z of each child
+		uint32 child[4];      //!< The index of the node of each child, or the first triangle of a leaf
+		uint32 count[4];      //!< The number of triangles of each leaf child, 0 for node children
+		uint32 numChildren;   //!< The number of children used
+	};
+
+private:
+	glm::vec3 _bounds[2];
+	std::vector<Node> _nodes;
+	std::vector<float32> _triangles;       // Per triangle in leaf order: first vertex, then both edges from it
+	std::vector<uint32> _triangleIds;      // The index in the mesh of each triangle, in leaf order
+	std::vector<uint32> _triangleLeafOrder; // The position in leaf order of each triangle of the mesh
+};
+
+/// <summary>The closest intersection of a ray with the triangles of a model.</summary>
+struct ModelRayHit
+{
+	float32 distance; //!< The distance along the ray, in multiples of its direction
+	uint32 meshNodeId; //!< The mesh node hit
+	uint32 triangle;  //!< The index of the triangle in the faces of the mesh of the node
+	float32 u;        //!< Barycentric coordinate of the hit: the weight of the second vertex of the triangle
+	float32 v;        //!< Barycentric coordinate of the hit: the weight of the third vertex of the triangle
+};
+
+/// <summary>A triangle of a model intersecting a sphere.</summary>
+struct ModelTriangle
+{
+	uint32 meshNodeId; //!< The mesh node
+	uint32 triangle;   //!< The index of the triangle in the faces of the mesh of the node
+};
+
+/// <summary>The triangle hierarchies of all the meshes of a model, placed in the world by the matrices of the mesh
+/// nodes. Queries are in world coordinates.</summary>
+/// <remarks>Each mesh is built once, however many nodes use it. Queries first test the world bounding box of each
+/// mesh node, then intersect the hierarchy of its mesh in the coordinates of the mesh.</remarks>
+class ModelBvh
+{
+public:
+	/// <summary>Constructor. Call init before use.</summary>
+	ModelBvh() {}
+
+	/// <summary>Build the hierarchies of the meshes of a model, and place them at the current frame of the model.
+	/// </summary>
+	/// <param name="model">The model. Meshes that are not triangle lists or have no positions are ignored.</param>
+	/// <returns>True on success, false if a mesh with positions could not be built</returns>
+	bool init(const Model& model);
+
+	/// <summary>Place the meshes at the current frame of the model (Model::setCurrentFrame).</summary>
+	/// <param name="model">The model the hierarchy was initialized with</param>
+	void update(const Model& model);
+
+	/// <summary>Place the meshes at the current frame of an instance of the model.</summary>
+	/// <param name="instance">An instance bound to an AnimationEvaluator of the model the hierarchy was initialized
+	/// with</param>
+	void update(const AnimationInstance& instance);
+
+	/// <summary>Find the closest intersection of a ray with the triangles of the model.</summary>
+	/// <param name="origin">The origin of the ray, in world coordinates</param>
+	/// <param name="direction">The direction of the ray. Need not be normalized: distances are measured in multiples
+	/// of it.</param>
+	/// <param name="maxDistance">Intersections further than this (in multiples of direction) are ignored</param>
+	/// <param name="hit">Receives the closest intersection, if any</param>
+	/// <returns>True if the ray intersects a triangle</returns>
+	bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float32 maxDistance, ModelRayHit& hit) const;
+
+	/// <summary>Find the intersection of a segment with the triangles of the model that is closest to its start.
+	/// </summary>
+	/// <param name="from">The start of the segment, in world coordinates</param>
+	/// <param name="to">The end of the segment, in world coordinates</param>
+	/// <param name="hit">Receives the intersection, with a distance from 0 (from) to 1 (to)</param>
+	/// <returns>True if the segment intersects a triangle</returns>
+	bool intersectSegment(const glm::vec3& from, const glm::vec3& to, ModelRayHit& hit) const
+	{
+		return intersectRay(from, to - from, 1.0f, hit);
+	}
+
+	/// <summary>Test if a segment intersects any triangle of the model, for line of sight tests.</summary>
+	/// <param name="from">The start of the segment, in world coordinates</param>
+	/// <param name="to">The end of the segment, in world coordinates</param>
+	/// <returns>True if the segment intersects a triangle</returns>
+	bool intersectsSegment(const glm::vec3& from, const glm::vec3& to) const;
+
+	/// <summary>Find the triangles of the model that intersect a sphere.</summary>
+	/// <param name="centre">The centre of the sphere, in world coordinates</param>
+	/// <param name="radius">The radius of the sphere</param>
+	/// <param name="triangles">Each triangle found is appended to this</param>
+	/// <returns>The number of triangles found</returns>
+	uint32 intersectSphere(const glm::vec3& centre, float32 radius, std::vector<ModelTriangle>& triangles) const;
+
+	/// <summary>Get the hierarchy of a mesh, in the coordinates of the mesh.</summary>
+	/// <param name="meshId">The index of the mesh in the model</param>
+	const TriangleBvh& getMeshBvh(uint32 meshId) const { return _meshes[meshId]; }
+
+private:
+	struct Instance
+	{
+		uint32 meshNodeId;
+		uint32 meshId;
+		glm::mat4x4 worldMatrix;
+		glm::mat4x4 inverseWorldMatrix;
+		glm::vec3 worldBounds[2];
+		float32 radiusScale; // Scales world radii to radii in the coordinates of the mesh that contain them
+	};
+	std::vector<TriangleBvh> _meshes;
+	std::vector<Instance> _instances;
+
+	void placeInstance(Instance& instance, const glm::mat4x4& worldMatrix);
+};
+}
+}
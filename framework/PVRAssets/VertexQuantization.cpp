@@ -0,0 +1,253 @@
+/*!
+\brief Implementation of the vertex attribute quantization functions.
+\file PVRAssets/VertexQuantization.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/VertexQuantization.h"
+#include "PVRCore/Base/HalfFloat.h"
+#include "PVRCore/Log.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace pvr {
+namespace assets {
+namespace utils {
+namespace {
+enum AttributeKind { KindOther, KindPosition, KindNormal, KindTexCoord, KindTangent };
+
+AttributeKind getAttributeKind(const StringHash& semantic)
+{
+	const std::string& name = semantic.str();
+	if (name == "POSITION") { return KindPosition; }
+	if (name == "NORMAL") { return KindNormal; }
+	if (name == "TANGENT" || name == "BINORMAL") { return KindTangent; }
+	if (name.size() == 3 && name[0] == 'U' && name[1] == 'V' && name[2] >= '0' && name[2] <= '7') { return KindTexCoord; }
+	return KindOther;
+}
+
+bool isSupported(types::DataType type, types::DataType a, types::DataType b, types::DataType c)
+{
+	return type == types::DataType::Float32 || type == a || type == b || type == c;
+}
+
+void writeComponent(byte* out, types::DataType type, float32 value)
+{
+	switch (type)
+	{
+	case types::DataType::Float16:
+	{
+		const uint16 bits = HalfFloat(value).getBits();
+		memcpy(out, &bits, sizeof(bits));
+	}
+	break;
+	case types::DataType::Int16Norm:
+	{
+		const int16 quantized = (int16)floorf((std::max)(-1.0f, (std::min)(value, 1.0f)) * 32767.0f + 0.5f);
+		memcpy(out, &quantized, 2);
+	}
+	break;
+	case types::DataType::UInt16Norm:
+	{
+		const uint16 quantized = (uint16)floorf((std::max)(0.0f, (std::min)(value, 1.0f)) * 65535.0f + 0.5f);
+		memcpy(out, &quantized, 2);
+	}
+	break;
+	case types::DataType::Int8Norm:
+	{
+		const int8 quantized = (int8)floorf((std::max)(-1.0f, (std::min)(value, 1.0f)) * 127.0f + 0.5f);
+		memcpy(out, &quantized, 1);
+	}
+	break;
+	default:
+		memcpy(out, &value, 4);
+		break;
+	}
+}
+
+// Map a unit vector onto the octahedron, then unfold the lower half onto the outside of the upper half.
+glm::vec2 encodeOctahedral(const glm::vec3& normal)
+{
+	const float32 sum = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (sum == 0.0f) { return glm::vec2(0.0f); }
+	glm::vec2 encoded(normal.x / sum, normal.y / sum);
+	if (normal.z < 0.0f)
+	{
+		encoded = glm::vec2((1.0f - fabsf(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+		                    (1.0f - fabsf(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return encoded;
+}
+
+struct QuantizedAttribute
+{
+	Mesh::VertexAttributeData source;
+	AttributeKind kind;
+	types::DataType type;
+	uint32 width;
+	uint32 offset;
+	glm::vec4 scale; // Quantized value = (value - bias) / scale
+	glm::vec4 bias;
+};
+}
+
+bool quantizeVertexAttributes(Mesh& mesh, const VertexQuantizationOptions& options)
+{
+	if (!isSupported(options.positionType, types::DataType::Int16Norm, types::DataType::Float16, types::DataType::Float16) ||
+	    !isSupported(options.normalType, types::DataType::Int8Norm, types::DataType::Int16Norm, types::DataType::Float16) ||
+	    !isSupported(options.texCoordType, types::DataType::UInt16Norm, types::DataType::Float16, types::DataType::Float16) ||
+	    !isSupported(options.tangentType, types::DataType::Int8Norm, types::DataType::Int16Norm, types::DataType::Float16))
+	{
+		Log(Log.Error, "quantizeVertexAttributes: Unsupported data type in the quantization options");
+		return false;
+	}
+	if (mesh.hasDeferredData() && !mesh.loadDeferredData()) { return false; }
+	const uint32 numVertices = mesh.getNumVertices();
+
+	// Work out the new layout: every attribute four byte aligned, in one interleaved block.
+	std::vector<QuantizedAttribute> attributes;
+	uint32 stride = 0;
+	for (uint32 i = 0; i < mesh.getVertexAttributesSize(); ++i)
+	{
+		QuantizedAttribute attribute;
+		attribute.source = *mesh.getVertexAttribute(i);
+		const int32 dataIndex = attribute.source.getDataIndex();
+		const types::DataType sourceType = attribute.source.getVertexLayout().dataType;
+		if (dataIndex < 0 || (uint32)dataIndex >= mesh.getNumDataElements()) { continue; }
+		const uint32 sourceSize = types::dataTypeSize(sourceType) * attribute.source.getN();
+		if (mesh.getDataSize(dataIndex) < (uint64)numVertices * mesh.getStride(dataIndex) ||
+		    attribute.source.getOffset() + sourceSize > mesh.getStride(dataIndex))
+		{
+			Log(Log.Error, "quantizeVertexAttributes: The data of attribute %s is smaller than the number of vertices",
+			    attribute.source.getSemantic().c_str());
+			return false;
+		}
+
+		attribute.kind = sourceType == types::DataType::Float32 ? getAttributeKind(attribute.source.getSemantic()) : KindOther;
+		attribute.type = sourceType;
+		attribute.width = attribute.source.getN();
+		switch (attribute.kind)
+		{
+		case KindPosition: attribute.type = options.positionType; break;
+		case KindNormal: attribute.type = options.normalType; break;
+		case KindTexCoord: attribute.type = options.texCoordType; break;
+		case KindTangent: attribute.type = options.tangentType; break;
+		default: break;
+		}
+		if (attribute.kind == KindNormal && options.octahedralNormals && attribute.width == 3 &&
+		    (attribute.type == types::DataType::Int8Norm || attribute.type == types::DataType::Int16Norm))
+		{
+			attribute.width = 2;
+		}
+		attribute.scale = glm::vec4(1.0f);
+		attribute.bias = glm::vec4(0.0f);
+		attribute.offset = stride;
+		stride += (types::dataTypeSize(attribute.type) * attribute.width + 3) & ~3u;
+		attributes.push_back(attribute);
+	}
+
+	// Positions and texture coordinates stored in normalized integers are rescaled to their range.
+	for (size_t a = 0; a < attributes.size(); ++a)
+	{
+		QuantizedAttribute& attribute = attributes[a];
+		const bool rescale = (attribute.kind == KindPosition && attribute.type == types::DataType::Int16Norm) ||
+		                     (attribute.kind == KindTexCoord && attribute.type == types::DataType::UInt16Norm);
+		if (!rescale || !numVertices) { continue; }
+		const uint32 width = (std::min)(attribute.width, 4u);
+		const byte* data = mesh.getData(attribute.source.getDataIndex()) + attribute.source.getOffset();
+		const uint32 sourceStride = mesh.getStride(attribute.source.getDataIndex());
+		glm::vec4 minimum(FLT_MAX), maximum(-FLT_MAX);
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			glm::vec4 value(0.0f);
+			memcpy(&value[0], data + v * sourceStride, width * 4);
+			minimum = glm::min(minimum, value);
+			maximum = glm::max(maximum, value);
+		}
+		// The fourth component of a position is left as is, as the unpack matrix transforms 3D positions.
+		for (uint32 c = 0; c < (attribute.kind == KindPosition ? (std::min)(width, 3u) : width); ++c)
+		{
+			if (attribute.kind == KindPosition)
+			{
+				// -1..1 covers the bounding box.
+				attribute.bias[c] = (minimum[c] + maximum[c]) * 0.5f;
+				attribute.scale[c] = (maximum[c] - minimum[c]) * 0.5f;
+			}
+			else
+			{
+				// 0..1 covers the range of the coordinates.
+				attribute.bias[c] = minimum[c];
+				attribute.scale[c] = maximum[c] - minimum[c];
+			}
+			if (attribute.scale[c] <= 0.0f) { attribute.scale[c] = 1.0f; }
+		}
+		if (attribute.kind == KindPosition)
+		{
+			glm::mat4 unpack(1.0f);
+			unpack[0][0] = attribute.scale.x;
+			unpack[1][1] = attribute.scale.y;
+			unpack[2][2] = attribute.scale.z;
+			unpack[3] = glm::vec4(glm::vec3(attribute.bias), 1.0f);
+			mesh.setUnpackMatrix(mesh.getUnpackMatrix() * unpack);
+		}
+		else
+		{
+			mesh.getInternalData().semantics[StringHash(attribute.source.getSemantic().str() + "UNPACK")].setValue(
+			  glm::vec4(attribute.scale.x, attribute.scale.y, attribute.bias.x, attribute.bias.y));
+		}
+	}
+
+	std::vector<byte> vertexData(numVertices * stride, 0);
+	for (size_t a = 0; a < attributes.size(); ++a)
+	{
+		const QuantizedAttribute& attribute = attributes[a];
+		const byte* data = mesh.getData(attribute.source.getDataIndex()) + attribute.source.getOffset();
+		const uint32 sourceStride = mesh.getStride(attribute.source.getDataIndex());
+		const uint32 sourceWidth = attribute.source.getN();
+		if (attribute.kind == KindOther || attribute.type == types::DataType::Float32)
+		{
+			const uint32 size = types::dataTypeSize(attribute.source.getVertexLayout().dataType) * sourceWidth;
+			for (uint32 v = 0; v < numVertices; ++v)
+			{
+				memcpy(vertexData.data() + v * stride + attribute.offset, data + v * sourceStride, size);
+			}
+			continue;
+		}
+		const uint32 componentSize = types::dataTypeSize(attribute.type);
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			float32 value[16] = {};
+			memcpy(value, data + v * sourceStride, (std::min)(sourceWidth, 16u) * 4);
+			byte* out = vertexData.data() + v * stride + attribute.offset;
+			if (attribute.width != sourceWidth)
+			{
+				const glm::vec2 encoded = encodeOctahedral(glm::vec3(value[0], value[1], value[2]));
+				writeComponent(out, attribute.type, encoded.x);
+				writeComponent(out + componentSize, attribute.type, encoded.y);
+				continue;
+			}
+			for (uint32 c = 0; c < attribute.width && c < 16; ++c)
+			{
+				const float32 scaled = c < 4 ? (value[c] - attribute.bias[c]) / attribute.scale[c] : value[c];
+				writeComponent(out + c * componentSize, attribute.type, scaled);
+			}
+		}
+	}
+
+	mesh.clearAllData();
+	mesh.addData(vertexData.data(), (uint32)vertexData.size(), stride);
+	mesh.removeAllVertexAttributes();
+	for (size_t a = 0; a < attributes.size(); ++a)
+	{
+		mesh.addVertexAttribute(Mesh::VertexAttributeData(attributes[a].source.getSemantic(), attributes[a].type,
+		                        (uint8)attributes[a].width, (uint16)attributes[a].offset, 0));
+	}
+	return true;
+}
+}
+}
+}
+//!\endcond
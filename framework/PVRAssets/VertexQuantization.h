@@ -0,0 +1,54 @@
+/*!
+\brief Functions that convert the floating point vertex attributes of meshes to smaller data types.
+\file PVRAssets/VertexQuantization.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRAssets/Model/Mesh.h"
+
+namespace pvr {
+namespace assets {
+namespace utils {
+/// <summary>The data types that quantizeVertexAttributes converts each kind of attribute to. Float32 leaves the
+/// attributes of that kind as they are.</summary>
+struct VertexQuantizationOptions
+{
+	/// <summary>Type of POSITION: Int16Norm (default), Float16 or Float32. Int16Norm positions are stored relative to
+	/// the bounding box of the mesh, which is recorded in the unpack matrix of the mesh (Mesh::getUnpackMatrix).
+	/// </summary>
+	types::DataType positionType;
+	/// <summary>Type of NORMAL: Int8Norm (default), Int16Norm, Float16 or Float32.</summary>
+	types::DataType normalType;
+	/// <summary>If true, normals are stored as two octahedral-encoded components instead of three. Only used with
+	/// Int8Norm and Int16Norm normals. Default false.</summary>
+	bool octahedralNormals;
+	/// <summary>Type of the texture coordinates (UV0 to UV7): Float16 (default), UInt16Norm or Float32. UInt16Norm
+	/// coordinates are stored relative to their range, which is recorded in the mesh semantic named after the
+	/// attribute followed by "UNPACK" (for example "UV0UNPACK"), as a vec4 (scale.xy, bias.xy).</summary>
+	types::DataType texCoordType;
+	/// <summary>Type of TANGENT and BINORMAL: Int8Norm (default), Int16Norm, Float16 or Float32.</summary>
+	types::DataType tangentType;
+
+	/// <summary>Constructor. Halves the size of positions and texture coordinates, and quarters normals and tangents.
+	/// </summary>
+	VertexQuantizationOptions() : positionType(types::DataType::Int16Norm), normalType(types::DataType::Int8Norm),
+		octahedralNormals(false), texCoordType(types::DataType::Float16), tangentType(types::DataType::Int8Norm) {}
+};
+
+/// <summary>Convert the Float32 positions, normals, texture coordinates and tangents of a mesh to the smaller data
+/// types of the options. The vertex data is rebuilt as a single interleaved data block, and the vertex attributes
+/// are updated to describe it.</summary>
+/// <param name="mesh">The mesh to quantize. Attributes with other semantics, or that are not Float32, are copied
+/// as they are.</param>
+/// <param name="options">The data type of each kind of attribute</param>
+/// <returns>True on success, false if an option is not a supported data type or the vertex data is malformed.
+/// </returns>
+/// <remarks>Shaders read Int16Norm positions in the range -1..1, and must transform them with the unpack matrix of
+/// the mesh (the "UNPACKMATRIX" node semantic of the RenderManager) before any other transformation. Octahedral
+/// normals must be decoded in the shader: n = vec3(e.xy, 1 - |e.x| - |e.y|); if (n.z < 0) n.xy = (1 - |n.yx|) *
+/// sign(n.xy), with sign(0) = 1; n = normalize(n).</remarks>
+bool quantizeVertexAttributes(Mesh& mesh, const VertexQuantizationOptions& options = VertexQuantizationOptions());
+}
+}
+}
@@ -37,6 +37,13 @@
 #define PVR_PLATFORM_IS_DESKTOP 1
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PVR_SUPPORT_SSE2 1
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define PVR_SUPPORT_NEON 1
+#endif
+
 #include "PVRCore/Base/Types.h"
 
 #if !defined(PVR_ASSERT_SUCCESS)
@@ -19,6 +19,17 @@ public:
 	HalfFloat(const HalfFloat& value) : _value(value._value) {}
 	HalfFloat(float value) { packFloat(value); }
 
+	/// <summary>Create a half float from its 16 bit representation (sign, exponent and mantissa bits).</summary>
+	static HalfFloat fromBits(unsigned short bits)
+	{
+		HalfFloat half;
+		half._value = static_cast<short>(bits);
+		return half;
+	}
+
+	/// <summary>Get the 16 bit representation (sign, exponent and mantissa bits) of this half float.</summary>
+	unsigned short getBits() const { return static_cast<unsigned short>(_value); }
+
 	// Operators
 	HalfFloat& operator= (HalfFloat rhs)
 	{
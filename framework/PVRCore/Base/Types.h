@@ -295,6 +295,8 @@ inline uint32 dataTypeSize(DataType type)
 	case DataType::Int16:
 	case DataType::Int16Norm:
 	case DataType::UInt16:
+	case DataType::UInt16Norm:
+	case DataType::Float16:
 		return 2;
 	case DataType::UInt8:
 	case DataType::UInt8Norm:
@@ -320,6 +322,8 @@ inline uint32  dataTypeComponentCount(DataType type)
 	case DataType::Int16:
 	case DataType::Int16Norm:
 	case DataType::UInt16:
+	case DataType::UInt16Norm:
+	case DataType::Float16:
 	case DataType::Fixed16_16:
 	case DataType::Int8:
 	case DataType::Int8Norm:
@@ -23,9 +23,10 @@ public:
 
 	void set(const glm::vec3& center, float32 radius)
 	{
-		PVR_ASSERTION(radius > 0);
+		PVR_ASSERTION(radius >= 0);
 		_center = center;
 		_radius = radius;
+		_isValid = true;
 	}
 
 	void expandRadius(const glm::vec3& point)
@@ -0,0 +1,140 @@
+/*!
+\brief Four floats processed together with SSE2, NEON or plain C++, for the vectorised loops of the framework.
+\file PVRCore/Math/Float4.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/Base/Defines.h"
+#include <cmath>
+#if defined(PVR_SUPPORT_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(PVR_SUPPORT_NEON)
+#include <arm_neon.h>
+#endif
+
+//!\cond NO_DOXYGEN
+namespace pvr {
+namespace math {
+// Float4 holds four floats in a register where the target supports it. Mask4 holds the result of a comparison, one
+// lane per float, and is consumed by select. Loads and stores are unaligned.
+#if defined(PVR_SUPPORT_SSE2)
+struct Float4
+{
+	__m128 v;
+	Float4(__m128 v) : v(v) {}
+	explicit Float4(float32 value) : v(_mm_set1_ps(value)) {}
+	static Float4 load(const float32* data) { return Float4(_mm_loadu_ps(data)); }
+	void store(float32* data) const { _mm_storeu_ps(data, v); }
+};
+typedef __m128 Mask4;
+inline Float4 operator+(const Float4& a, const Float4& b) { return Float4(_mm_add_ps(a.v, b.v)); }
+inline Float4 operator-(const Float4& a, const Float4& b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+inline Float4 operator*(const Float4& a, const Float4& b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+inline Float4 operator/(const Float4& a, const Float4& b) { return Float4(_mm_div_ps(a.v, b.v)); }
+inline Float4 squareRoot(const Float4& a) { return Float4(_mm_sqrt_ps(a.v)); }
+inline Float4 minimum(const Float4& a, const Float4& b) { return Float4(_mm_min_ps(a.v, b.v)); }
+inline Float4 maximum(const Float4& a, const Float4& b) { return Float4(_mm_max_ps(a.v, b.v)); }
+inline Float4 absolute(const Float4& a) { return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+inline Mask4 greaterThan(const Float4& a, const Float4& b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float4 select(const Mask4& mask, const Float4& a, const Float4& b)
+{
+	return Float4(_mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v)));
+}
+// One bit per lane where a <= b.
+inline uint32 lessEqualBits(const Float4& a, const Float4& b)
+{
+	return (uint32)_mm_movemask_ps(_mm_cmple_ps(a.v, b.v));
+}
+#elif defined(PVR_SUPPORT_NEON)
+struct Float4
+{
+	float32x4_t v;
+	Float4(float32x4_t v) : v(v) {}
+	explicit Float4(float32 value) : v(vdupq_n_f32(value)) {}
+	static Float4 load(const float32* data) { return Float4(vld1q_f32(data)); }
+	void store(float32* data) const { vst1q_f32(data, v); }
+};
+typedef uint32x4_t Mask4;
+inline Float4 operator+(const Float4& a, const Float4& b) { return Float4(vaddq_f32(a.v, b.v)); }
+inline Float4 operator-(const Float4& a, const Float4& b) { return Float4(vsubq_f32(a.v, b.v)); }
+inline Float4 operator*(const Float4& a, const Float4& b) { return Float4(vmulq_f32(a.v, b.v)); }
+#if defined(__aarch64__)
+inline Float4 operator/(const Float4& a, const Float4& b) { return Float4(vdivq_f32(a.v, b.v)); }
+inline Float4 squareRoot(const Float4& a) { return Float4(vsqrtq_f32(a.v)); }
+#else
+// ARMv7 NEON has no exact division or square root: they are done one lane at a time.
+inline Float4 operator/(const Float4& a, const Float4& b)
+{
+	float32 x[4], y[4];
+	a.store(x);
+	b.store(y);
+	for (uint32 i = 0; i < 4; ++i) { x[i] /= y[i]; }
+	return Float4::load(x);
+}
+inline Float4 squareRoot(const Float4& a)
+{
+	float32 x[4];
+	a.store(x);
+	for (uint32 i = 0; i < 4; ++i) { x[i] = sqrtf(x[i]); }
+	return Float4::load(x);
+}
+#endif
+inline Float4 minimum(const Float4& a, const Float4& b) { return Float4(vminq_f32(a.v, b.v)); }
+inline Float4 maximum(const Float4& a, const Float4& b) { return Float4(vmaxq_f32(a.v, b.v)); }
+inline Float4 absolute(const Float4& a) { return Float4(vabsq_f32(a.v)); }
+inline Mask4 greaterThan(const Float4& a, const Float4& b) { return vcgtq_f32(a.v, b.v); }
+inline Float4 select(const Mask4& mask, const Float4& a, const Float4& b) { return Float4(vbslq_f32(mask, a.v, b.v)); }
+inline uint32 lessEqualBits(const Float4& a, const Float4& b)
+{
+	const uint32x4_t mask = vcleq_f32(a.v, b.v);
+	return (vgetq_lane_u32(mask, 0) & 1) | (vgetq_lane_u32(mask, 1) & 2) | (vgetq_lane_u32(mask, 2) & 4) |
+	       (vgetq_lane_u32(mask, 3) & 8);
+}
+#else
+struct Float4
+{
+	float32 v[4];
+	Float4() {}
+	explicit Float4(float32 value) { v[0] = v[1] = v[2] = v[3] = value; }
+	static Float4 load(const float32* data)
+	{
+		Float4 result;
+		for (uint32 i = 0; i < 4; ++i) { result.v[i] = data[i]; }
+		return result;
+	}
+	void store(float32* data) const { for (uint32 i = 0; i < 4; ++i) { data[i] = v[i]; } }
+};
+struct Mask4
+{
+	bool v[4];
+};
+#define PVR_FLOAT4_OPERATION(signature, expression) \
+	inline Float4 signature { Float4 r; for (uint32 i = 0; i < 4; ++i) { r.v[i] = expression; } return r; }
+PVR_FLOAT4_OPERATION(operator+(const Float4& a, const Float4& b), a.v[i] + b.v[i])
+PVR_FLOAT4_OPERATION(operator-(const Float4& a, const Float4& b), a.v[i] - b.v[i])
+PVR_FLOAT4_OPERATION(operator*(const Float4& a, const Float4& b), a.v[i] * b.v[i])
+PVR_FLOAT4_OPERATION(operator/(const Float4& a, const Float4& b), a.v[i] / b.v[i])
+PVR_FLOAT4_OPERATION(squareRoot(const Float4& a), sqrtf(a.v[i]))
+PVR_FLOAT4_OPERATION(minimum(const Float4& a, const Float4& b), a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+PVR_FLOAT4_OPERATION(maximum(const Float4& a, const Float4& b), a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+PVR_FLOAT4_OPERATION(absolute(const Float4& a), fabsf(a.v[i]))
+PVR_FLOAT4_OPERATION(select(const Mask4& mask, const Float4& a, const Float4& b), mask.v[i] ? a.v[i] : b.v[i])
+#undef PVR_FLOAT4_OPERATION
+inline Mask4 greaterThan(const Float4& a, const Float4& b)
+{
+	Mask4 r;
+	for (uint32 i = 0; i < 4; ++i) { r.v[i] = a.v[i] > b.v[i]; }
+	return r;
+}
+inline uint32 lessEqualBits(const Float4& a, const Float4& b)
+{
+	uint32 bits = 0;
+	for (uint32 i = 0; i < 4; ++i) { bits |= (a.v[i] <= b.v[i] ? 1u : 0u) << i; }
+	return bits;
+}
+#endif
+}
+}
+//!\endcond
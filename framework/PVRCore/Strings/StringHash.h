@@ -27,6 +27,17 @@ public:
 	/// <param name="right">The string to initialize with.</param>
 	StringHash(const std::string& right) : _String(right), _Hash(HashFn()(_String)) { }
 
+	/// <summary>Constructor. Initialize with c++style string and its precalculated hash, for example one stored in a
+	/// file with the string, so that the hash is not calculated again.</summary>
+	/// <param name="right">The string to initialize with.</param>
+	/// <param name="hash">The hash of the string, as returned by getHash() of a StringHash of the same string.</param>
+	StringHash(const std::string& right, std::size_t hash) : _String(right), _Hash(hash)
+	{
+#ifdef DEBUG
+		assertion(_Hash == HashFn()(_String), "StringHash: Precalculated hash does not match the string");
+#endif
+	}
+
 	/// <summary>Conversion to string reference. No-op.</summary>
 	/// <returns>A string representatation of this hash</returns>
 	operator const std::string& () const { return _String; }
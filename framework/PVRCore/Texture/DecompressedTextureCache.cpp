@@ -0,0 +1,206 @@
+/*!
+\brief Implementation of the on-disk cache of textures decompressed in software.
+\file PVRCore/Texture/DecompressedTextureCache.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRCore/Texture/DecompressedTextureCache.h"
+#include "PVRCore/IO/FileStream.h"
+#include "PVRCore/Log.h"
+#include <cstdio>
+#include <cstring>
+
+namespace pvr {
+namespace {
+// Meta data block identifying the source of a cache file.
+const uint32 CacheFourCC = ('P' << 0) | ('V' << 8) | ('R' << 16) | ('D' << 24);
+const uint32 CacheRecordVersion = 1;
+
+struct CacheRecord
+{
+	uint64 sourceHash;
+	uint64 sourcePixelFormat;
+	uint32 sourceDataSize;
+	uint32 version;
+};
+
+std::string& cacheDirectory()
+{
+	static std::string directory;
+	return directory;
+}
+
+// 64 bit FNV-1a, eight bytes at a time.
+struct Hasher
+{
+	uint64 value;
+	Hasher() : value(14695981039346656037ULL) {}
+	void add(uint64 word) { value = (value ^ word) * 1099511628211ULL; }
+	void add(const void* data, size_t size)
+	{
+		const uint8* bytes = static_cast<const uint8*>(data);
+		uint64 word;
+		for (; size >= sizeof(word); size -= sizeof(word), bytes += sizeof(word))
+		{
+			memcpy(&word, bytes, sizeof(word));
+			add(word);
+		}
+		word = 0;
+		memcpy(&word, bytes, size);
+		add(word ^ ((uint64)size << 56));
+	}
+};
+
+CacheRecord getCacheRecord(const Texture& compressedTexture)
+{
+	const TextureHeader::Header& header = compressedTexture.getHeader();
+	Hasher hasher;
+	hasher.add(header.pixelFormat.getPixelTypeId());
+	hasher.add(((uint64)header.colorSpace << 32) | (uint64)header.channelType);
+	hasher.add(((uint64)header.width << 32) | header.height);
+	hasher.add(((uint64)header.depth << 32) | header.numberOfSurfaces);
+	hasher.add(((uint64)header.numberOfFaces << 32) | header.mipMapCount);
+	hasher.add(compressedTexture.getDataPointer(), compressedTexture.getDataSize());
+
+	CacheRecord record;
+	memset(&record, 0, sizeof(record));
+	record.sourceHash = hasher.value;
+	record.sourcePixelFormat = header.pixelFormat.getPixelTypeId();
+	record.sourceDataSize = compressedTexture.getDataSize();
+	record.version = CacheRecordVersion;
+	return record;
+}
+
+std::string getCacheFilePath(const CacheRecord& record, const PixelFormat& format, VariableType channelType)
+{
+	const std::string& directory = cacheDirectory();
+	char fileName[64];
+	sprintf(fileName, "%016llx_%016llx_%02x.pvr", (unsigned long long)record.sourceHash,
+	        (unsigned long long)format.getPixelTypeId(), (unsigned)channelType);
+	const char last = directory[directory.length() - 1];
+	return directory + (last == '/' || last == '\\' ? "" : "/") + fileName;
+}
+
+template<typename T>
+inline bool readValue(const Stream& stream, T& value)
+{
+	size_t dataRead = 0;
+	return stream.read(sizeof(value), 1, &value, dataRead) && dataRead == 1;
+}
+
+template<typename T>
+inline bool writeValue(Stream& stream, const T& value)
+{
+	size_t dataWritten = 0;
+	return stream.write(sizeof(value), 1, &value, dataWritten) && dataWritten == 1;
+}
+
+bool readHeader(const Stream& stream, TextureHeader::Header& header)
+{
+	uint32 version = 0;
+	return readValue(stream, version) && version == TextureHeader::Header::PVRv3 &&
+	       readValue(stream, header.flags) && readValue(stream, header.pixelFormat) &&
+	       readValue(stream, header.colorSpace) && readValue(stream, header.channelType) &&
+	       readValue(stream, header.height) && readValue(stream, header.width) && readValue(stream, header.depth) &&
+	       readValue(stream, header.numberOfSurfaces) && readValue(stream, header.numberOfFaces) &&
+	       readValue(stream, header.mipMapCount) && readValue(stream, header.metaDataSize);
+}
+
+bool writeHeader(Stream& stream, const TextureHeader::Header& header)
+{
+	const uint32 version = TextureHeader::Header::PVRv3;
+	return writeValue(stream, version) && writeValue(stream, header.flags) && writeValue(stream, header.pixelFormat) &&
+	       writeValue(stream, header.colorSpace) && writeValue(stream, header.channelType) &&
+	       writeValue(stream, header.height) && writeValue(stream, header.width) && writeValue(stream, header.depth) &&
+	       writeValue(stream, header.numberOfSurfaces) && writeValue(stream, header.numberOfFaces) &&
+	       writeValue(stream, header.mipMapCount) && writeValue(stream, header.metaDataSize);
+}
+}
+
+void setDecompressedTextureCacheDirectory(const std::string& directory)
+{
+	cacheDirectory() = directory;
+}
+
+const std::string& getDecompressedTextureCacheDirectory()
+{
+	return cacheDirectory();
+}
+
+bool loadDecompressedTextureFromCache(const Texture& compressedTexture, const PixelFormat& format,
+                                      VariableType channelType, Texture& outDecompressedTexture)
+{
+	if (cacheDirectory().empty()) { return false; }
+
+	const CacheRecord expectedRecord = getCacheRecord(compressedTexture);
+	FileStream stream(getCacheFilePath(expectedRecord, format, channelType), "rb");
+	if (!stream.open()) { return false; }
+
+	// The file must describe the same texture as the source, in the requested format.
+	TextureHeader::Header fileHeader;
+	const TextureHeader::Header& sourceHeader = compressedTexture.getHeader();
+	TextureMetaData recordBlock;
+	if (!readHeader(stream, fileHeader) || fileHeader.pixelFormat != format || fileHeader.channelType != channelType ||
+	    fileHeader.width != sourceHeader.width || fileHeader.height != sourceHeader.height ||
+	    fileHeader.depth != sourceHeader.depth || fileHeader.numberOfSurfaces != sourceHeader.numberOfSurfaces ||
+	    fileHeader.numberOfFaces != sourceHeader.numberOfFaces || fileHeader.mipMapCount != sourceHeader.mipMapCount ||
+	    !recordBlock.loadFromStream(stream) || fileHeader.metaDataSize != recordBlock.getTotalSizeInMemory() ||
+	    recordBlock.getFourCC() != CacheFourCC || recordBlock.getDataSize() != sizeof(CacheRecord) ||
+	    memcmp(recordBlock.getData(), &expectedRecord, sizeof(CacheRecord)))
+	{
+		Log(Log.Warning, "Decompressed texture cache: Ignoring invalid or stale cache file");
+		return false;
+	}
+
+	TextureHeader decompressedHeader(compressedTexture);
+	decompressedHeader.setPixelFormat(format);
+	decompressedHeader.setChannelType(channelType);
+	Texture decompressedTexture(decompressedHeader);
+	size_t dataRead = 0;
+	if (!stream.read(1, decompressedTexture.getDataSize(), decompressedTexture.getDataPointer(), dataRead) ||
+	    dataRead != decompressedTexture.getDataSize())
+	{
+		Log(Log.Warning, "Decompressed texture cache: Cache file is truncated");
+		return false;
+	}
+	outDecompressedTexture = std::move(decompressedTexture);
+	return true;
+}
+
+bool storeDecompressedTextureInCache(const Texture& compressedTexture, const Texture& decompressedTexture)
+{
+	if (cacheDirectory().empty()) { return false; }
+
+	const CacheRecord record = getCacheRecord(compressedTexture);
+	const TextureMetaData recordBlock(CacheFourCC, 0, sizeof(record), reinterpret_cast<const byte*>(&record));
+	TextureHeader::Header fileHeader = decompressedTexture.getHeader();
+	fileHeader.metaDataSize = recordBlock.getTotalSizeInMemory();
+
+	// Write to a temporary file and rename it, so that an interrupted write never leaves a truncated cache entry.
+	const std::string path = getCacheFilePath(record, decompressedTexture.getPixelFormat(),
+	                         decompressedTexture.getChannelType());
+	const std::string tempPath = path + ".tmp";
+	{
+		FileStream stream(tempPath, "wb");
+		size_t dataWritten = 0;
+		if (!stream.open() || !writeHeader(stream, fileHeader) || !recordBlock.writeToStream(stream) ||
+		    !stream.write(1, decompressedTexture.getDataSize(), decompressedTexture.getDataPointer(), dataWritten) ||
+		    dataWritten != decompressedTexture.getDataSize())
+		{
+			Log(Log.Warning, "Decompressed texture cache: Could not write cache file %s", tempPath.c_str());
+			stream.close();
+			remove(tempPath.c_str());
+			return false;
+		}
+	}
+	remove(path.c_str());
+	if (rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+}
+//!\endcond
@@ -0,0 +1,42 @@
+/*!
+\brief A persistent, on-disk cache of textures decompressed in software.
+\file PVRCore/Texture/DecompressedTextureCache.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/Texture.h"
+
+namespace pvr {
+/// <summary>Enable the cache of software-decompressed textures by setting the directory it is stored in. The texture
+/// upload functions then store the result of every software decompression there, and reuse it when the same texture
+/// is decompressed again, even in a later run.</summary>
+/// <param name="directory">An existing, writable directory. An empty string disables the cache (default).</param>
+/// <remarks>Set the directory before any texture is uploaded; it is not synchronized with uploads running on other
+/// threads. Cache files are PVR v3 files with the decompressed data in a single block after the header, so they can
+/// also be memory mapped or inspected with any PVR tool. Entries are never evicted; clear the directory to reclaim
+/// space.</remarks>
+void setDecompressedTextureCacheDirectory(const std::string& directory);
+
+/// <summary>Get the directory of the cache of software-decompressed textures.</summary>
+/// <returns>The cache directory, or an empty string if the cache is disabled.</returns>
+const std::string& getDecompressedTextureCacheDirectory();
+
+/// <summary>Look up the decompressed version of a texture in the cache.</summary>
+/// <param name="compressedTexture">The texture that would be decompressed</param>
+/// <param name="format">The pixel format the texture would be decompressed to</param>
+/// <param name="channelType">The channel type the texture would be decompressed to</param>
+/// <param name="outDecompressedTexture">If found, the decompressed texture. It has the header (including meta data)
+/// of compressedTexture, with format and channelType.</param>
+/// <returns>True if the texture was found in the cache, false if it was not or the cache is disabled.</returns>
+bool loadDecompressedTextureFromCache(const Texture& compressedTexture, const PixelFormat& format,
+                                      VariableType channelType, Texture& outDecompressedTexture);
+
+/// <summary>Store the decompressed version of a texture in the cache. Does nothing if the cache is disabled.
+/// </summary>
+/// <param name="compressedTexture">The texture that was decompressed</param>
+/// <param name="decompressedTexture">The decompressed texture</param>
+/// <returns>True if the texture was stored, false if the cache is disabled or the file could not be written.
+/// </returns>
+bool storeDecompressedTextureInCache(const Texture& compressedTexture, const Texture& decompressedTexture);
+}
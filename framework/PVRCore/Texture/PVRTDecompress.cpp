@@ -14,6 +14,7 @@
 #include <cstring>
 #include "PVRTDecompress.h"
 #include "PVRCore/Texture.h"
+#include "PVRCore/Texture/Twiddle.h"
 namespace pvr {
 enum
 {
@@ -470,54 +471,6 @@ static bool isPowerOf2(unsigned int input)
 	return ((input | minus1) == (input ^ minus1));
 }
 
-static uint32 TwiddleUV(uint32 XSize, uint32 YSize, uint32 XPos, uint32 YPos)
-{
-	//Initially assume X is the larger size.
-	uint32 MinDimension = XSize;
-	uint32 MaxValue = YPos;
-	uint32 Twiddled = 0;
-	uint32 SrcBitPos = 1;
-	uint32 DstBitPos = 1;
-	int ShiftCount = 0;
-
-	//Check the sizes are valid.
-	assertion(YPos < YSize);
-	assertion(XPos < XSize);
-	assertion(isPowerOf2(YSize));
-	assertion(isPowerOf2(XSize));
-
-	//If Y is the larger dimension - switch the min/max values.
-	if (YSize < XSize)
-	{
-		MinDimension = YSize;
-		MaxValue   = XPos;
-	}
-
-	// Step through all the bits in the "minimum" dimension
-	while (SrcBitPos < MinDimension)
-	{
-		if (YPos & SrcBitPos)
-		{
-			Twiddled |= DstBitPos;
-		}
-
-		if (XPos & SrcBitPos)
-		{
-			Twiddled |= (DstBitPos << 1);
-		}
-
-		SrcBitPos <<= 1;
-		DstBitPos <<= 2;
-		ShiftCount += 1;
-	}
-
-	// Prepend any unused bits
-	MaxValue >>= ShiftCount;
-	Twiddled |= (MaxValue << (2 * ShiftCount));
-
-	return Twiddled;
-}
-
 static void mapDecompressedData(Pixel32* pOutput, int width,
                                 const Pixel32* pWord,
                                 const PVRTCWordIndices& words,
@@ -568,6 +521,11 @@ static int pvrtcDecompress(uint8* pCompressedData,
 	int i32NumXWords = (int)(ui32Width / ui32WordWidth);
 	int i32NumYWords = (int)(ui32Height / ui32WordHeight);
 
+	// Twiddled offsets of each column and row of words.
+	std::vector<uint32> wordColumnOffsets, wordRowOffsets;
+	assertion(isPowerOf2(i32NumXWords) && isPowerOf2(i32NumYWords));
+	utils::getTwiddledOffsets(i32NumXWords, i32NumYWords, wordColumnOffsets, wordRowOffsets);
+
 	// Structs used for decompression
 	PVRTCWordIndices indices;
 	Pixel32* pPixels;
@@ -591,10 +549,10 @@ static int pvrtcDecompress(uint8* pCompressedData,
 			//Work out the offsets into the twiddle structs, multiply by two as there are two members per word.
 			uint32 WordOffsets[4] =
 			{
-				TwiddleUV(i32NumXWords, i32NumYWords, indices.P[0], indices.P[1]) * 2,
-				TwiddleUV(i32NumXWords, i32NumYWords, indices.Q[0], indices.Q[1]) * 2,
-				TwiddleUV(i32NumXWords, i32NumYWords, indices.R[0], indices.R[1]) * 2,
-				TwiddleUV(i32NumXWords, i32NumYWords, indices.S[0], indices.S[1]) * 2,
+				(wordColumnOffsets[indices.P[0]] | wordRowOffsets[indices.P[1]]) * 2,
+				(wordColumnOffsets[indices.Q[0]] | wordRowOffsets[indices.Q[1]]) * 2,
+				(wordColumnOffsets[indices.R[0]] | wordRowOffsets[indices.R[1]]) * 2,
+				(wordColumnOffsets[indices.S[0]] | wordRowOffsets[indices.S[1]]) * 2,
 			};
 
 			//Access individual elements to fill out PVRTCWord
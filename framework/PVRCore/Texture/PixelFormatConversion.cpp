@@ -0,0 +1,684 @@
+/*!
+\brief Implementation of the conversion of pixel data between uncompressed pixel formats.
+\file PVRCore/Texture/PixelFormatConversion.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRCore/Texture/PixelFormatConversion.h"
+#include "PVRCore/Base/Defines.h"
+#include "PVRCore/Base/HalfFloat.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#if defined(PVR_SUPPORT_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+#if defined(PVR_SUPPORT_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace pvr {
+namespace {
+// Channel slots a channel can be read into / written from, besides r, g, b, a (0-3).
+const int8 SlotNone = -1;
+const int8 SlotLuminance = -2;
+const int8 SlotIntensity = -3;
+
+// Below this number of pixels, a conversion is never split across threads.
+const size_t MinPixelsPerThread = 16384;
+
+enum class ChannelStorage { UnsignedInt, SignedInt, Float };
+
+struct PixelLayout
+{
+	uint32 numChannels;
+	uint32 bytesPerPixel;
+	bool packed; // All channels packed in a single 8/16/32 bit word. The first channel is in the most significant bits.
+	bool normalized;
+	ChannelStorage storage;
+	char content[4];
+	uint8 bits[4];
+	uint8 offset[4]; // Bit shift of the channel if packed, otherwise byte offset of the channel in the pixel.
+	int8 slot[4];
+};
+
+inline int8 getChannelSlot(char content)
+{
+	switch (content)
+	{
+	case 'r': case 'd': return 0;
+	case 'g': return 1;
+	case 'b': return 2;
+	case 'a': return 3;
+	case 'l': return SlotLuminance;
+	case 'i': return SlotIntensity;
+	default: return SlotNone;
+	}
+}
+
+bool getPixelLayout(const PixelFormat& format, VariableType type, PixelLayout& layout)
+{
+	// Compressed and irregular formats.
+	if (format.getPart().High == 0 || type >= VariableType::NumVarTypes) { return false; }
+
+	const uint8* chars = format.getPixelTypeChar();
+	uint32 totalBits = 0;
+	bool byteAligned = true;
+	layout.numChannels = 0;
+	for (uint32 channel = 0; channel < 4 && chars[channel + 4]; ++channel)
+	{
+		layout.content[channel] = (char)chars[channel];
+		layout.bits[channel] = chars[channel + 4];
+		layout.slot[channel] = getChannelSlot(layout.content[channel]);
+		byteAligned = byteAligned && (layout.bits[channel] == 8 || layout.bits[channel] == 16 || layout.bits[channel] == 32);
+		totalBits += layout.bits[channel];
+		++layout.numChannels;
+	}
+	if (!layout.numChannels || totalBits % 8) { return false; }
+
+	layout.bytesPerPixel = totalBits / 8;
+	layout.normalized = isVariableTypeNormalized(type);
+	layout.storage = (type == VariableType::SignedFloat || type == VariableType::UnsignedFloat) ? ChannelStorage::Float :
+	                 isVariableTypeSigned(type) ? ChannelStorage::SignedInt : ChannelStorage::UnsignedInt;
+	layout.packed = !byteAligned;
+
+	uint32 position = layout.packed ? totalBits : 0;
+	for (uint32 channel = 0; channel < layout.numChannels; ++channel)
+	{
+		if (layout.packed)
+		{
+			position -= layout.bits[channel];
+			layout.offset[channel] = (uint8)position;
+		}
+		else
+		{
+			// There are no 8 bit floats.
+			if (layout.storage == ChannelStorage::Float && layout.bits[channel] == 8) { return false; }
+			layout.offset[channel] = (uint8)position;
+			position += layout.bits[channel] / 8;
+		}
+	}
+	return !layout.packed || (layout.storage == ChannelStorage::UnsignedInt &&
+	                          (totalBits == 8 || totalBits == 16 || totalBits == 32));
+}
+
+inline double getUnsignedMax(uint32 bits) { return std::ldexp(1.0, (int)bits) - 1.0; }
+inline double getSignedMax(uint32 bits) { return std::ldexp(1.0, (int)bits - 1) - 1.0; }
+
+template<typename T>
+inline T readUnaligned(const uint8* ptr)
+{
+	T value;
+	memcpy(&value, ptr, sizeof(T));
+	return value;
+}
+
+template<typename T>
+inline void writeUnaligned(uint8* ptr, T value)
+{
+	memcpy(ptr, &value, sizeof(T));
+}
+
+inline uint32 readPackedWord(const uint8* pixel, uint32 bytesPerPixel)
+{
+	switch (bytesPerPixel)
+	{
+	case 1: return *pixel;
+	case 2: return readUnaligned<uint16>(pixel);
+	default: return readUnaligned<uint32>(pixel);
+	}
+}
+
+inline void writePackedWord(uint8* pixel, uint32 bytesPerPixel, uint32 word)
+{
+	switch (bytesPerPixel)
+	{
+	case 1: *pixel = (uint8)word; break;
+	case 2: writeUnaligned<uint16>(pixel, (uint16)word); break;
+	default: writeUnaligned<uint32>(pixel, word); break;
+	}
+}
+
+double readChannel(const uint8* pixel, uint32 packedWord, const PixelLayout& layout, uint32 channel)
+{
+	const uint32 bits = layout.bits[channel];
+	if (layout.packed)
+	{
+		const uint32 mask = (uint32)getUnsignedMax(bits);
+		const double value = (double)((packedWord >> layout.offset[channel]) & mask);
+		return layout.normalized ? value / mask : value;
+	}
+
+	const uint8* ptr = pixel + layout.offset[channel];
+	double value = 0.0;
+	switch (layout.storage)
+	{
+	case ChannelStorage::Float:
+		if (bits == 16) { return (float)HalfFloat::fromBits(readUnaligned<uint16>(ptr)); }
+		return readUnaligned<float>(ptr);
+	case ChannelStorage::SignedInt:
+		value = bits == 8 ? (double)(int8) * ptr : bits == 16 ? (double)readUnaligned<int16>(ptr) :
+		        (double)readUnaligned<int32>(ptr);
+		return layout.normalized ? std::max(value / getSignedMax(bits), -1.0) : value;
+	default:
+		value = bits == 8 ? (double) * ptr : bits == 16 ? (double)readUnaligned<uint16>(ptr) :
+		        (double)readUnaligned<uint32>(ptr);
+		return layout.normalized ? value / getUnsignedMax(bits) : value;
+	}
+}
+
+void writeChannel(uint8* pixel, uint32& packedWord, const PixelLayout& layout, uint32 channel, double value)
+{
+	const uint32 bits = layout.bits[channel];
+	if (layout.storage == ChannelStorage::Float)
+	{
+		uint8* ptr = pixel + layout.offset[channel];
+		if (bits == 16) { writeUnaligned<uint16>(ptr, HalfFloat((float)value).getBits()); }
+		else { writeUnaligned<float>(ptr, (float)value); }
+		return;
+	}
+
+	if (layout.storage == ChannelStorage::SignedInt)
+	{
+		const double maxValue = getSignedMax(bits);
+		if (layout.normalized) { value = std::min(std::max(value, -1.0), 1.0) * maxValue; }
+		value = std::floor(std::min(std::max(value, -maxValue - 1.0), maxValue) + .5);
+		uint8* ptr = pixel + layout.offset[channel];
+		switch (bits)
+		{
+		case 8: *ptr = (uint8)(int8)value; break;
+		case 16: writeUnaligned<int16>(ptr, (int16)value); break;
+		default: writeUnaligned<int32>(ptr, (int32)value); break;
+		}
+		return;
+	}
+
+	const double maxValue = getUnsignedMax(bits);
+	if (layout.normalized) { value = std::min(std::max(value, 0.0), 1.0) * maxValue; }
+	const uint32 intValue = (uint32)std::floor(std::min(std::max(value, 0.0), maxValue) + .5);
+	if (layout.packed)
+	{
+		packedWord |= intValue << layout.offset[channel];
+		return;
+	}
+	uint8* ptr = pixel + layout.offset[channel];
+	switch (bits)
+	{
+	case 8: *ptr = (uint8)intValue; break;
+	case 16: writeUnaligned<uint16>(ptr, (uint16)intValue); break;
+	default: writeUnaligned<uint32>(ptr, intValue); break;
+	}
+}
+
+// Generic path: Every pixel is expanded to double precision rgba, and then written to the destination format.
+void convertGeneric(const uint8* src, const PixelLayout& srcLayout, uint8* dst, const PixelLayout& dstLayout,
+                    size_t numPixels)
+{
+	for (size_t pixel = 0; pixel < numPixels; ++pixel, src += srcLayout.bytesPerPixel, dst += dstLayout.bytesPerPixel)
+	{
+		double rgba[4] = { 0.0, 0.0, 0.0, 1.0 };
+		const uint32 srcWord = srcLayout.packed ? readPackedWord(src, srcLayout.bytesPerPixel) : 0;
+		for (uint32 channel = 0; channel < srcLayout.numChannels; ++channel)
+		{
+			const double value = readChannel(src, srcWord, srcLayout, channel);
+			switch (srcLayout.slot[channel])
+			{
+			case SlotNone: break;
+			case SlotIntensity: rgba[3] = value; // fall through
+			case SlotLuminance: rgba[0] = rgba[1] = rgba[2] = value; break;
+			default: rgba[srcLayout.slot[channel]] = value; break;
+			}
+		}
+
+		uint32 dstWord = 0;
+		for (uint32 channel = 0; channel < dstLayout.numChannels; ++channel)
+		{
+			const int8 slot = dstLayout.slot[channel];
+			writeChannel(dst, dstWord, dstLayout, channel, slot >= 0 ? rgba[slot] : slot == SlotNone ? 0.0 : rgba[0]);
+		}
+		if (dstLayout.packed) { writePackedWord(dst, dstLayout.bytesPerPixel, dstWord); }
+	}
+}
+
+// FAST PATHS
+enum class ConversionPath
+{
+	Generic,
+	ByteSwizzle,      // 3 or 4 channel 8 bit to 3 or 4 channel 8 bit, same datatype: a byte shuffle.
+	PackBytesTo16,    // 4 channel 8 bit normalized to 16 bit packed normalized (r5g6b5, r4g4b4a4, r5g5b5a1...)
+	FloatToHalf,      // Same channels, 32 bit float to 16 bit float
+	HalfToFloat,      // Same channels, 16 bit float to 32 bit float
+	UnormByteToFloat, // Same channels, 8 bit unsigned normalized to 32 bit float
+	FloatToUnormByte  // Same channels, 32 bit float to 8 bit unsigned normalized
+};
+
+struct ConversionJob
+{
+	PixelLayout src;
+	PixelLayout dst;
+	ConversionPath path;
+	int8 map[4];      // For each destination channel, the source byte it is copied from, or -1 to write fill.
+	uint8 fill;
+};
+
+inline bool allChannelsAre(const PixelLayout& layout, uint32 bits, ChannelStorage storage)
+{
+	if (layout.packed || layout.storage != storage) { return false; }
+	for (uint32 channel = 0; channel < layout.numChannels; ++channel)
+	{
+		if (layout.bits[channel] != bits) { return false; }
+	}
+	return true;
+}
+
+inline bool sameChannelContent(const PixelLayout& lhs, const PixelLayout& rhs)
+{
+	return lhs.numChannels == rhs.numChannels && !memcmp(lhs.content, rhs.content, lhs.numChannels);
+}
+
+// Fill map with the source channel of each destination channel. Only plain r, g, b, a channels can be mapped, and
+// only alpha may be missing from the source.
+bool mapChannels(const PixelLayout& src, const PixelLayout& dst, int8* map)
+{
+	for (uint32 dstChannel = 0; dstChannel < dst.numChannels; ++dstChannel)
+	{
+		if (dst.slot[dstChannel] < 0) { return false; }
+		map[dstChannel] = -1;
+		for (uint32 srcChannel = 0; srcChannel < src.numChannels; ++srcChannel)
+		{
+			if (src.slot[srcChannel] < 0) { return false; }
+			if (src.content[srcChannel] == dst.content[dstChannel]) { map[dstChannel] = (int8)srcChannel; }
+		}
+		if (map[dstChannel] == -1 && dst.content[dstChannel] != 'a') { return false; }
+	}
+	return true;
+}
+
+ConversionPath selectConversionPath(ConversionJob& job)
+{
+	const PixelLayout& src = job.src;
+	const PixelLayout& dst = job.dst;
+	if (allChannelsAre(src, 8, ChannelStorage::UnsignedInt) && (src.numChannels == 3 || src.numChannels == 4))
+	{
+		if (allChannelsAre(dst, 8, ChannelStorage::UnsignedInt) && (dst.numChannels == 3 || dst.numChannels == 4) &&
+		    src.normalized == dst.normalized && mapChannels(src, dst, job.map))
+		{
+			job.fill = src.normalized ? 255 : 1;
+			return ConversionPath::ByteSwizzle;
+		}
+		if (src.normalized && src.numChannels == 4 && dst.packed && dst.normalized && dst.bytesPerPixel == 2 &&
+		    mapChannels(src, dst, job.map))
+		{
+			return ConversionPath::PackBytesTo16;
+		}
+	}
+	if (sameChannelContent(src, dst))
+	{
+		if (allChannelsAre(src, 32, ChannelStorage::Float) && allChannelsAre(dst, 16, ChannelStorage::Float))
+		{
+			return ConversionPath::FloatToHalf;
+		}
+		if (allChannelsAre(src, 16, ChannelStorage::Float) && allChannelsAre(dst, 32, ChannelStorage::Float))
+		{
+			return ConversionPath::HalfToFloat;
+		}
+		if (allChannelsAre(src, 8, ChannelStorage::UnsignedInt) && src.normalized &&
+		    allChannelsAre(dst, 32, ChannelStorage::Float))
+		{
+			return ConversionPath::UnormByteToFloat;
+		}
+		if (allChannelsAre(src, 32, ChannelStorage::Float) &&
+		    allChannelsAre(dst, 8, ChannelStorage::UnsignedInt) && dst.normalized)
+		{
+			return ConversionPath::FloatToUnormByte;
+		}
+	}
+	return ConversionPath::Generic;
+}
+
+inline void swizzleBytesScalar(const uint8* src, uint8* dst, size_t numPixels, const ConversionJob& job)
+{
+	const uint32 srcStride = job.src.numChannels, dstStride = job.dst.numChannels;
+	for (size_t pixel = 0; pixel < numPixels; ++pixel, src += srcStride, dst += dstStride)
+	{
+		for (uint32 channel = 0; channel < dstStride; ++channel)
+		{
+			dst[channel] = job.map[channel] < 0 ? job.fill : src[job.map[channel]];
+		}
+	}
+}
+
+void swizzleBytes(const uint8* src, uint8* dst, size_t numPixels, const ConversionJob& job)
+{
+	const uint32 srcStride = job.src.numChannels, dstStride = job.dst.numChannels;
+	size_t pixel = 0;
+#if defined(PVR_SUPPORT_NEON)
+	for (; pixel + 16 <= numPixels; pixel += 16, src += 16 * srcStride, dst += 16 * dstStride)
+	{
+		uint8x16_t channels[4];
+		if (srcStride == 3)
+		{
+			const uint8x16x3_t in = vld3q_u8(src);
+			channels[0] = in.val[0]; channels[1] = in.val[1]; channels[2] = in.val[2];
+		}
+		else
+		{
+			const uint8x16x4_t in = vld4q_u8(src);
+			channels[0] = in.val[0]; channels[1] = in.val[1]; channels[2] = in.val[2]; channels[3] = in.val[3];
+		}
+		const uint8x16_t fill = vdupq_n_u8(job.fill);
+		if (dstStride == 3)
+		{
+			uint8x16x3_t out;
+			for (uint32 channel = 0; channel < 3; ++channel) { out.val[channel] = job.map[channel] < 0 ? fill : channels[job.map[channel]]; }
+			vst3q_u8(dst, out);
+		}
+		else
+		{
+			uint8x16x4_t out;
+			for (uint32 channel = 0; channel < 4; ++channel) { out.val[channel] = job.map[channel] < 0 ? fill : channels[job.map[channel]]; }
+			vst4q_u8(dst, out);
+		}
+	}
+#elif defined(__SSSE3__)
+	// Each iteration shuffles 4 (or 5 for rgb to rgb) pixels within a 16 byte register. Loads and stores are always 16
+	// bytes, so only iterate while a whole register fits in both the remaining source and destination pixels.
+	const uint32 pixelsPerIteration = (srcStride == 3 && dstStride == 3) ? 5 : 4;
+	int8 shuffle[16], fillBytes[16];
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		const uint32 pix = i / dstStride, channel = i % dstStride;
+		const bool inRange = pix < pixelsPerIteration;
+		shuffle[i] = (inRange && job.map[channel] >= 0) ? (int8)(pix * srcStride + job.map[channel]) : (int8)0x80;
+		fillBytes[i] = (inRange && job.map[channel] < 0) ? (int8)job.fill : 0;
+	}
+	const __m128i shuffleMask = _mm_loadu_si128((const __m128i*)shuffle);
+	const __m128i fillMask = _mm_loadu_si128((const __m128i*)fillBytes);
+	for (; pixel + 6 <= numPixels; pixel += pixelsPerIteration,
+	     src += pixelsPerIteration * srcStride, dst += pixelsPerIteration * dstStride)
+	{
+		const __m128i in = _mm_loadu_si128((const __m128i*)src);
+		_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_shuffle_epi8(in, shuffleMask), fillMask));
+	}
+#elif defined(PVR_SUPPORT_SSE2)
+	// Without a byte shuffle, only accelerate the most common swizzle: bgra <-> rgba.
+	if (srcStride == 4 && dstStride == 4 && job.map[0] == 2 && job.map[1] == 1 && job.map[2] == 0 && job.map[3] == 3)
+	{
+		const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+		for (; pixel + 4 <= numPixels; pixel += 4, src += 16, dst += 16)
+		{
+			const __m128i in = _mm_loadu_si128((const __m128i*)src);
+			const __m128i rb = _mm_and_si128(in, maskRB);
+			const __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+			_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_andnot_si128(maskRB, in), _mm_and_si128(swapped, maskRB)));
+		}
+	}
+#endif
+	swizzleBytesScalar(src, dst, numPixels - pixel, job);
+}
+
+// Rounds value * maxValue / 255 to the nearest integer, exactly, for any value and maxValue in [0..255].
+inline uint32 rescaleByte(uint32 value, uint32 maxValue)
+{
+	const uint32 tmp = value * maxValue + 128;
+	return (tmp + (tmp >> 8)) >> 8;
+}
+
+void packBytesTo16(const uint8* src, uint8* dst, size_t numPixels, const ConversionJob& job)
+{
+	const PixelLayout& dstLayout = job.dst;
+	uint32 maxValue[4], shift[4];
+	for (uint32 channel = 0; channel < dstLayout.numChannels; ++channel)
+	{
+		maxValue[channel] = (uint32)getUnsignedMax(dstLayout.bits[channel]);
+		shift[channel] = dstLayout.offset[channel];
+	}
+	size_t pixel = 0;
+#if defined(PVR_SUPPORT_NEON)
+	for (; pixel + 8 <= numPixels; pixel += 8, src += 32, dst += 16)
+	{
+		const uint8x8x4_t in = vld4_u8(src);
+		uint16x8_t out = vdupq_n_u16(0);
+		for (uint32 channel = 0; channel < dstLayout.numChannels; ++channel)
+		{
+			uint16x8_t value = vdupq_n_u16((uint16)maxValue[channel]);
+			if (job.map[channel] >= 0)
+			{
+				value = vaddq_u16(vmull_u8(in.val[job.map[channel]], vdup_n_u8((uint8)maxValue[channel])), vdupq_n_u16(128));
+				value = vshrq_n_u16(vaddq_u16(value, vshrq_n_u16(value, 8)), 8);
+			}
+			out = vorrq_u16(out, vshlq_u16(value, vdupq_n_s16((int16)shift[channel])));
+		}
+		vst1q_u16((uint16*)dst, out);
+	}
+#elif defined(PVR_SUPPORT_SSE2)
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	const __m128i rounding = _mm_set1_epi32(128);
+	for (; pixel + 8 <= numPixels; pixel += 8, src += 32, dst += 16)
+	{
+		__m128i packed[2];
+		for (uint32 half = 0; half < 2; ++half)
+		{
+			// One pixel per 32 bit lane, computed in the low 16 bits.
+			const __m128i in = _mm_loadu_si128((const __m128i*)(src + half * 16));
+			__m128i out = _mm_setzero_si128();
+			for (uint32 channel = 0; channel < dstLayout.numChannels; ++channel)
+			{
+				__m128i value = _mm_set1_epi32((int32)maxValue[channel]);
+				if (job.map[channel] >= 0)
+				{
+					value = _mm_and_si128(_mm_srli_epi32(in, 8 * job.map[channel]), byteMask);
+					value = _mm_add_epi32(_mm_mullo_epi16(value, _mm_set1_epi32((int32)maxValue[channel])), rounding);
+					value = _mm_srli_epi32(_mm_add_epi32(value, _mm_srli_epi32(value, 8)), 8);
+				}
+				out = _mm_or_si128(out, _mm_sll_epi32(value, _mm_cvtsi32_si128((int32)shift[channel])));
+			}
+			// Sign extend so that the saturating pack keeps all 16 bits.
+			packed[half] = _mm_srai_epi32(_mm_slli_epi32(out, 16), 16);
+		}
+		_mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(packed[0], packed[1]));
+	}
+#endif
+	for (; pixel < numPixels; ++pixel, src += 4, dst += 2)
+	{
+		uint32 out = 0;
+		for (uint32 channel = 0; channel < dstLayout.numChannels; ++channel)
+		{
+			const uint32 value = job.map[channel] >= 0 ? rescaleByte(src[job.map[channel]], maxValue[channel]) : maxValue[channel];
+			out |= value << shift[channel];
+		}
+		writeUnaligned<uint16>(dst, (uint16)out);
+	}
+}
+
+void floatToHalf(const float* src, uint16* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(__F16C__)
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storel_epi64((__m128i*)(dst + i), _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+#elif defined(PVR_SUPPORT_NEON) && defined(__aarch64__)
+	for (; i + 4 <= count; i += 4)
+	{
+		vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		dst[i] = HalfFloat(src[i]).getBits();
+	}
+}
+
+void halfToFloat(const uint16* src, float* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(__F16C__)
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(src + i))));
+	}
+#elif defined(PVR_SUPPORT_NEON) && defined(__aarch64__)
+	for (; i + 4 <= count; i += 4)
+	{
+		vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		dst[i] = HalfFloat::fromBits(src[i]);
+	}
+}
+
+void unormByteToFloat(const uint8* src, float* dst, size_t count)
+{
+	const float scale = 1.f / 255.f;
+	size_t i = 0;
+#if defined(PVR_SUPPORT_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t in = vld1q_u8(src + i);
+		const uint16x8_t low = vmovl_u8(vget_low_u8(in)), high = vmovl_u8(vget_high_u8(in));
+		vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(low))), scale));
+		vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(low))), scale));
+		vst1q_f32(dst + i + 8, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(high))), scale));
+		vst1q_f32(dst + i + 12, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(high))), scale));
+	}
+#elif defined(PVR_SUPPORT_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scaleVec = _mm_set1_ps(scale);
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i low = _mm_unpacklo_epi8(in, zero), high = _mm_unpackhi_epi8(in, zero);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scaleVec));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scaleVec));
+		_mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scaleVec));
+		_mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scaleVec));
+	}
+#endif
+	for (; i < count; ++i) { dst[i] = src[i] * scale; }
+}
+
+void floatToUnormByte(const float* src, uint8* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(PVR_SUPPORT_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.f), one = vdupq_n_f32(1.f), half = vdupq_n_f32(.5f);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint32x4_t values[2];
+		for (uint32 j = 0; j < 2; ++j)
+		{
+			const float32x4_t clamped = vminq_f32(vmaxq_f32(vld1q_f32(src + i + j * 4), zero), one);
+			values[j] = vcvtq_u32_f32(vmlaq_n_f32(half, clamped, 255.f));
+		}
+		vst1_u8(dst + i, vmovn_u16(vcombine_u16(vmovn_u32(values[0]), vmovn_u32(values[1]))));
+	}
+#elif defined(PVR_SUPPORT_SSE2)
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), half = _mm_set1_ps(.5f), scale = _mm_set1_ps(255.f);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i values[4];
+		for (uint32 j = 0; j < 4; ++j)
+		{
+			const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + j * 4), zero), one);
+			values[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+		}
+		const __m128i low = _mm_packs_epi32(values[0], values[1]), high = _mm_packs_epi32(values[2], values[3]);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		dst[i] = (uint8)(std::min(std::max(src[i], 0.f), 1.f) * 255.f + .5f);
+	}
+}
+
+void runConversion(const uint8* src, uint8* dst, size_t numPixels, const ConversionJob& job)
+{
+	const size_t numElements = numPixels * job.src.numChannels;
+	switch (job.path)
+	{
+	case ConversionPath::ByteSwizzle: swizzleBytes(src, dst, numPixels, job); break;
+	case ConversionPath::PackBytesTo16: packBytesTo16(src, dst, numPixels, job); break;
+	case ConversionPath::FloatToHalf: floatToHalf((const float*)src, (uint16*)dst, numElements); break;
+	case ConversionPath::HalfToFloat: halfToFloat((const uint16*)src, (float*)dst, numElements); break;
+	case ConversionPath::UnormByteToFloat: unormByteToFloat(src, (float*)dst, numElements); break;
+	case ConversionPath::FloatToUnormByte: floatToUnormByte((const float*)src, dst, numElements); break;
+	default: convertGeneric(src, job.src, dst, job.dst, numPixels); break;
+	}
+}
+}
+
+bool isPixelFormatConversionSupported(const PixelFormat& srcFormat, VariableType srcType,
+                                      const PixelFormat& dstFormat, VariableType dstType)
+{
+	PixelLayout src, dst;
+	return getPixelLayout(srcFormat, srcType, src) && getPixelLayout(dstFormat, dstType, dst);
+}
+
+bool convertPixels(const void* srcPixels, const PixelFormat& srcFormat, VariableType srcType,
+                   void* dstPixels, const PixelFormat& dstFormat, VariableType dstType,
+                   size_t numPixels, uint32 numThreads)
+{
+	ConversionJob job;
+	if (!getPixelLayout(srcFormat, srcType, job.src) || !getPixelLayout(dstFormat, dstType, job.dst))
+	{
+		Log(Log.Error, "convertPixels: Conversion between the requested pixel formats is not supported");
+		return false;
+	}
+	job.path = selectConversionPath(job);
+
+	const uint8* src = static_cast<const uint8*>(srcPixels);
+	uint8* dst = static_cast<uint8*>(dstPixels);
+
+	if (!numThreads) { numThreads = std::max(std::thread::hardware_concurrency(), 1u); }
+	numThreads = (uint32)std::min<size_t>(numThreads, std::max<size_t>(numPixels / MinPixelsPerThread, 1));
+
+	// Split into contiguous ranges of pixels, the calling thread taking the last one.
+	const size_t pixelsPerThread = (numPixels + numThreads - 1) / numThreads;
+	std::vector<std::thread> workers;
+	workers.reserve(numThreads - 1);
+	size_t begin = 0;
+	for (uint32 thread = 0; thread + 1 < numThreads; ++thread, begin += pixelsPerThread)
+	{
+		workers.push_back(std::thread(runConversion, src + begin * job.src.bytesPerPixel,
+		                              dst + begin * job.dst.bytesPerPixel, pixelsPerThread, std::cref(job)));
+	}
+	runConversion(src + begin * job.src.bytesPerPixel, dst + begin * job.dst.bytesPerPixel, numPixels - begin, job);
+	for (auto& worker : workers) { worker.join(); }
+	return true;
+}
+
+bool convertTexture(const Texture& srcTexture, Texture& outTexture, const PixelFormat& dstFormat,
+                    VariableType dstType, uint32 numThreads)
+{
+	PixelLayout src, dst;
+	if (!getPixelLayout(srcTexture.getPixelFormat(), srcTexture.getChannelType(), src) ||
+	    !getPixelLayout(dstFormat, dstType, dst))
+	{
+		Log(Log.Error, "convertTexture: Conversion between the requested pixel formats is not supported");
+		return false;
+	}
+	TextureHeader header(srcTexture);
+	header.setPixelFormat(dstFormat);
+	header.setChannelType(dstType);
+	outTexture = Texture(header);
+
+	// All surfaces (mip levels, array members, faces) are contiguous, so they are converted as a single array.
+	return convertPixels(srcTexture.getDataPointer(), srcTexture.getPixelFormat(), srcTexture.getChannelType(),
+	                     outTexture.getDataPointer(), dstFormat, dstType,
+	                     srcTexture.getDataSize() / src.bytesPerPixel, numThreads);
+}
+}
+//!\endcond
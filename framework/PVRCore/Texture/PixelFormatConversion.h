@@ -0,0 +1,57 @@
+/*!
+\brief Functions to convert pixel data and textures between uncompressed pixel formats.
+\file PVRCore/Texture/PixelFormatConversion.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/Texture.h"
+
+namespace pvr {
+
+/// <summary>Query if pixels of an uncompressed format can be converted to another uncompressed format.</summary>
+/// <param name="srcFormat">The pixel format of the source data</param>
+/// <param name="srcType">The datatype of the channels of the source data</param>
+/// <param name="dstFormat">The pixel format of the destination data</param>
+/// <param name="dstType">The datatype of the channels of the destination data</param>
+/// <returns>True if the conversion is supported.</returns>
+/// <remarks>Supported are formats where each channel is 8, 16 or 32 bits wide (16 bit float channels are half
+/// floats), and unsigned formats packed in a single 8, 16 or 32 bit word, in which case the first channel occupies the
+/// most significant bits (e.g. r5g6b5). Compressed and irregular formats are not supported.</remarks>
+bool isPixelFormatConversionSupported(const PixelFormat& srcFormat, VariableType srcType,
+                                      const PixelFormat& dstFormat, VariableType dstType);
+
+/// <summary>Convert an array of pixels from one uncompressed pixel format to another.</summary>
+/// <param name="srcPixels">Pointer to the source pixels</param>
+/// <param name="srcFormat">The pixel format of the source pixels</param>
+/// <param name="srcType">The datatype of the channels of the source pixels</param>
+/// <param name="dstPixels">Pointer to the destination. Must have room for numPixels pixels of dstFormat and must not
+/// overlap the source.</param>
+/// <param name="dstFormat">The pixel format of the destination pixels</param>
+/// <param name="dstType">The datatype of the channels of the destination pixels</param>
+/// <param name="numPixels">The number of pixels to convert</param>
+/// <param name="numThreads">The maximum number of threads to split the work into. 0 uses the number of hardware
+/// threads. Small conversions always run on the calling thread.</param>
+/// <returns>True on success, false if the conversion is not supported.</returns>
+/// <remarks>Channels are matched by content: r, g, b and a map to themselves, 'l' (luminance) reads into r, g and b and
+/// 'i' (intensity) into r, g, b and a. Writing 'l', 'i' or 'd' takes the value of red. Missing color channels are
+/// zero and missing alpha is one. Values are normalized, clamped and rounded according to the datatypes. The colorspace
+/// is not changed. Common combinations (8 bit channel swizzles and RGB/RGBA expansion, RGBA8888 to 16 bit packed
+/// formats, float/half and 8 bit normalized/float) use SIMD implementations where available.</remarks>
+bool convertPixels(const void* srcPixels, const PixelFormat& srcFormat, VariableType srcType,
+                   void* dstPixels, const PixelFormat& dstFormat, VariableType dstType,
+                   size_t numPixels, uint32 numThreads = 0);
+
+/// <summary>Create a copy of a texture with all its surfaces converted to a different uncompressed pixel format.
+/// </summary>
+/// <param name="srcTexture">The texture to convert</param>
+/// <param name="outTexture">The converted texture. Will have the same dimensions, mip levels, array members, faces
+/// and colorspace as srcTexture.</param>
+/// <param name="dstFormat">The pixel format to convert to</param>
+/// <param name="dstType">The datatype to convert to</param>
+/// <param name="numThreads">The maximum number of threads to split the work into. 0 uses the number of hardware
+/// threads.</param>
+/// <returns>True on success, false if the conversion is not supported.</returns>
+bool convertTexture(const Texture& srcTexture, Texture& outTexture, const PixelFormat& dstFormat,
+                    VariableType dstType, uint32 numThreads = 0);
+}
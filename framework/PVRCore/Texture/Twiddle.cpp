@@ -0,0 +1,95 @@
+/*!
+\brief Implementation of the functions converting between linear and twiddled texture layouts.
+\file PVRCore/Texture/Twiddle.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRCore/Texture/Twiddle.h"
+#include "PVRCore/Log.h"
+#include <cstring>
+
+namespace pvr {
+namespace utils {
+namespace {
+inline bool isPowerOfTwo(uint32 value) { return value && !(value & (value - 1)); }
+
+struct Element8 { uint8 bytes[8]; };
+struct Element16 { uint8 bytes[16]; };
+
+// Copy elements between the layouts using the precomputed offsets. toTwiddled selects the direction.
+template<typename Element, bool toTwiddled>
+void copyElements(const uint8* src, uint8* dst, uint32 width, uint32 height, const std::vector<uint32>& columnOffsets,
+                  const std::vector<uint32>& rowOffsets)
+{
+	const Element* srcElements = reinterpret_cast<const Element*>(src);
+	Element* dstElements = reinterpret_cast<Element*>(dst);
+	for (uint32 y = 0; y < height; ++y)
+	{
+		const uint32 rowOffset = rowOffsets[y];
+		const uint32 linearRow = y * width;
+		for (uint32 x = 0; x < width; ++x)
+		{
+			if (toTwiddled) { dstElements[columnOffsets[x] | rowOffset] = srcElements[linearRow + x]; }
+			else { dstElements[linearRow + x] = srcElements[columnOffsets[x] | rowOffset]; }
+		}
+	}
+}
+
+template<bool toTwiddled>
+bool convertSurface(const void* src, void* dst, uint32 width, uint32 height, uint32 bytesPerElement)
+{
+	if (!isPowerOfTwo(width) || !isPowerOfTwo(height))
+	{
+		Log(Log.Error, "Twiddled surfaces must have power of two dimensions (got %ux%u)", width, height);
+		return false;
+	}
+	std::vector<uint32> columnOffsets, rowOffsets;
+	getTwiddledOffsets(width, height, columnOffsets, rowOffsets);
+
+	const uint8* srcBytes = static_cast<const uint8*>(src);
+	uint8* dstBytes = static_cast<uint8*>(dst);
+	switch (bytesPerElement)
+	{
+	case 1: copyElements<uint8, toTwiddled>(srcBytes, dstBytes, width, height, columnOffsets, rowOffsets); break;
+	case 2: copyElements<uint16, toTwiddled>(srcBytes, dstBytes, width, height, columnOffsets, rowOffsets); break;
+	case 4: copyElements<uint32, toTwiddled>(srcBytes, dstBytes, width, height, columnOffsets, rowOffsets); break;
+	case 8: copyElements<Element8, toTwiddled>(srcBytes, dstBytes, width, height, columnOffsets, rowOffsets); break;
+	case 16: copyElements<Element16, toTwiddled>(srcBytes, dstBytes, width, height, columnOffsets, rowOffsets); break;
+	default:
+		for (uint32 y = 0; y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const size_t linear = ((size_t)y * width + x) * bytesPerElement;
+				const size_t twiddled = (size_t)(columnOffsets[x] | rowOffsets[y]) * bytesPerElement;
+				memcpy(dstBytes + (toTwiddled ? twiddled : linear), srcBytes + (toTwiddled ? linear : twiddled),
+				       bytesPerElement);
+			}
+		}
+	}
+	return true;
+}
+}
+
+void getTwiddledOffsets(uint32 width, uint32 height, std::vector<uint32>& outColumnOffsets,
+                        std::vector<uint32>& outRowOffsets)
+{
+	outColumnOffsets.resize(width);
+	outRowOffsets.resize(height);
+	for (uint32 x = 0; x < width; ++x) { outColumnOffsets[x] = getTwiddledIndex(width, height, x, 0); }
+	for (uint32 y = 0; y < height; ++y) { outRowOffsets[y] = getTwiddledIndex(width, height, 0, y); }
+}
+
+bool twiddleSurface(const void* srcLinear, void* dstTwiddled, uint32 width, uint32 height, uint32 bytesPerElement)
+{
+	return convertSurface<true>(srcLinear, dstTwiddled, width, height, bytesPerElement);
+}
+
+bool untwiddleSurface(const void* srcTwiddled, void* dstLinear, uint32 width, uint32 height, uint32 bytesPerElement)
+{
+	return convertSurface<false>(srcTwiddled, dstLinear, width, height, bytesPerElement);
+}
+}
+}
+//!\endcond
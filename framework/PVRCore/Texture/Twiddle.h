@@ -0,0 +1,126 @@
+/*!
+\brief Functions to convert between linear (row major) and twiddled (Morton order) texture layouts.
+\file PVRCore/Texture/Twiddle.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/Base/Defines.h"
+#include <vector>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace pvr {
+namespace utils {
+/// <summary>Interleave the bits of two 16 bit values: bit i of even goes to bit 2i, bit i of odd goes to bit 2i+1.
+/// </summary>
+/// <param name="even">The value whose bits go to the even bit positions. Only the low 16 bits are used.</param>
+/// <param name="odd">The value whose bits go to the odd bit positions. Only the low 16 bits are used.</param>
+/// <returns>The interleaved bits</returns>
+inline uint32 interleaveBits(uint32 even, uint32 odd)
+{
+#if defined(__BMI2__)
+	return _pdep_u32(even, 0x55555555u) | _pdep_u32(odd, 0xAAAAAAAAu);
+#else
+	uint32 bits[2] = { even & 0xFFFFu, odd & 0xFFFFu };
+	for (uint32 i = 0; i < 2; ++i)
+	{
+		bits[i] = (bits[i] | (bits[i] << 8)) & 0x00FF00FFu;
+		bits[i] = (bits[i] | (bits[i] << 4)) & 0x0F0F0F0Fu;
+		bits[i] = (bits[i] | (bits[i] << 2)) & 0x33333333u;
+		bits[i] = (bits[i] | (bits[i] << 1)) & 0x55555555u;
+	}
+	return bits[0] | (bits[1] << 1);
+#endif
+}
+
+/// <summary>Separate interleaved bits. Inverse of interleaveBits.</summary>
+/// <param name="interleaved">The interleaved bits</param>
+/// <param name="outEven">The bits of the even positions</param>
+/// <param name="outOdd">The bits of the odd positions</param>
+inline void deinterleaveBits(uint32 interleaved, uint32& outEven, uint32& outOdd)
+{
+#if defined(__BMI2__)
+	outEven = _pext_u32(interleaved, 0x55555555u);
+	outOdd = _pext_u32(interleaved, 0xAAAAAAAAu);
+#else
+	uint32 bits[2] = { interleaved & 0x55555555u, (interleaved >> 1) & 0x55555555u };
+	for (uint32 i = 0; i < 2; ++i)
+	{
+		bits[i] = (bits[i] | (bits[i] >> 1)) & 0x33333333u;
+		bits[i] = (bits[i] | (bits[i] >> 2)) & 0x0F0F0F0Fu;
+		bits[i] = (bits[i] | (bits[i] >> 4)) & 0x00FF00FFu;
+		bits[i] = (bits[i] | (bits[i] >> 8)) & 0x0000FFFFu;
+	}
+	outEven = bits[0];
+	outOdd = bits[1];
+#endif
+}
+
+/// <summary>Get the index of an element of a twiddled surface. Twiddled surfaces store their elements in Morton
+/// order, with the y coordinate in the even bits and the x coordinate in the odd bits. If the surface is not square,
+/// the coordinate of the larger dimension contributes its remaining high bits above the interleaved ones.</summary>
+/// <param name="width">The width of the surface in elements (pixels or blocks). Must be a power of two.</param>
+/// <param name="height">The height of the surface in elements. Must be a power of two.</param>
+/// <param name="x">The x coordinate of the element</param>
+/// <param name="y">The y coordinate of the element</param>
+/// <returns>The index of the element in the twiddled surface</returns>
+inline uint32 getTwiddledIndex(uint32 width, uint32 height, uint32 x, uint32 y)
+{
+	const uint32 minDimension = width < height ? width : height;
+	const uint32 lowMask = minDimension - 1;
+	uint32 interleavedBits = 0;
+	while ((1u << interleavedBits) < minDimension) { ++interleavedBits; }
+	const uint32 highBits = (width > height ? x : y) >> interleavedBits;
+	return interleaveBits(y & lowMask, x & lowMask) | (highBits << (2 * interleavedBits));
+}
+
+/// <summary>Get the coordinates of an element of a twiddled surface from its index. Inverse of getTwiddledIndex.
+/// </summary>
+/// <param name="width">The width of the surface in elements. Must be a power of two.</param>
+/// <param name="height">The height of the surface in elements. Must be a power of two.</param>
+/// <param name="index">The index of the element in the twiddled surface</param>
+/// <param name="outX">The x coordinate of the element</param>
+/// <param name="outY">The y coordinate of the element</param>
+inline void getUntwiddledCoordinates(uint32 width, uint32 height, uint32 index, uint32& outX, uint32& outY)
+{
+	const uint32 minDimension = width < height ? width : height;
+	uint32 interleavedBits = 0;
+	while ((1u << interleavedBits) < minDimension) { ++interleavedBits; }
+	const uint32 lowIndexMask = minDimension * minDimension - 1;
+	deinterleaveBits(index & lowIndexMask, outY, outX);
+	const uint32 highBits = (index >> (2 * interleavedBits)) << interleavedBits;
+	if (width > height) { outX |= highBits; }
+	else { outY |= highBits; }
+}
+
+/// <summary>Precompute per-column and per-row twiddled offsets of a surface, such that
+/// getTwiddledIndex(width, height, x, y) == outColumnOffsets[x] | outRowOffsets[y]. Useful for walking whole
+/// surfaces without recomputing the index of each element.</summary>
+/// <param name="width">The width of the surface in elements. Must be a power of two.</param>
+/// <param name="height">The height of the surface in elements. Must be a power of two.</param>
+/// <param name="outColumnOffsets">Resized to width and filled with the offsets of each column</param>
+/// <param name="outRowOffsets">Resized to height and filled with the offsets of each row</param>
+void getTwiddledOffsets(uint32 width, uint32 height, std::vector<uint32>& outColumnOffsets,
+                        std::vector<uint32>& outRowOffsets);
+
+/// <summary>Convert a surface from linear (row major) layout to twiddled layout.</summary>
+/// <param name="srcLinear">The source surface, row major</param>
+/// <param name="dstTwiddled">The destination. Must not overlap the source.</param>
+/// <param name="width">The width of the surface in elements. Must be a power of two.</param>
+/// <param name="height">The height of the surface in elements. Must be a power of two.</param>
+/// <param name="bytesPerElement">The size of each element (e.g. a pixel or a compressed block) in bytes</param>
+/// <returns>False if the dimensions are not powers of two, otherwise true.</returns>
+bool twiddleSurface(const void* srcLinear, void* dstTwiddled, uint32 width, uint32 height, uint32 bytesPerElement);
+
+/// <summary>Convert a surface from twiddled layout to linear (row major) layout.</summary>
+/// <param name="srcTwiddled">The source surface, twiddled</param>
+/// <param name="dstLinear">The destination. Must not overlap the source.</param>
+/// <param name="width">The width of the surface in elements. Must be a power of two.</param>
+/// <param name="height">The height of the surface in elements. Must be a power of two.</param>
+/// <param name="bytesPerElement">The size of each element (e.g. a pixel or a compressed block) in bytes</param>
+/// <returns>False if the dimensions are not powers of two, otherwise true.</returns>
+bool untwiddleSurface(const void* srcTwiddled, void* dstLinear, uint32 width, uint32 height, uint32 bytesPerElement);
+}
+}
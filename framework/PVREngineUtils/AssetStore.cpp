@@ -407,8 +407,17 @@ bool AssetStore::loadModel(const char* filename, assets::ModelHandle& outModel,
 		return false;
 	}
 
-	assets::PODReader reader(assetStream);
-	assets::ModelHandle handle = assets::Model::createWithReader(reader);
+	assets::ModelHandle handle;
+	if (strings::endsWith(filename, "pvrcm"))
+	{
+		assets::CookedModelReader reader(assetStream);
+		handle = assets::Model::createWithReader(reader);
+	}
+	else
+	{
+		assets::PODReader reader(assetStream);
+		handle = assets::Model::createWithReader(reader);
+	}
 
 	if (handle.isNull())
 	{
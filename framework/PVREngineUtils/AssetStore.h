@@ -11,6 +11,7 @@ into API objects, while ensuring no duplicate loading happens.
 #include "PVRAssets/Shader.h"
 #include "PVRAssets/Model.h"
 #include "PVRAssets/FileIO/PODReader.h"
+#include "PVRAssets/FileIO/CookedModelReader.h"
 #include "PVRAssets/FileIO/PFXParser.h"
 #include "PVRCore/Stream.h"
 #include "PVRCore/Texture.h"
@@ -189,7 +190,8 @@ private:
 public:
 
 	/// <summary>Load model from file.</summary>
-	/// <param name="filename">Model file name</param>
+	/// <param name="filename">Model file name. Files with the pvrcm extension are read as cooked models, all others as
+	/// POD files.</param>
 	/// <param name="outModel">A reference to a ModelHandle object. The model will be loaded there.</param>
 	/// <param name="force">(Default false) If true, will force loading the asset from the file, even if it is already
 	/// cached by the AssetStore.</param>
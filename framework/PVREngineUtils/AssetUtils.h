@@ -80,7 +80,8 @@ inline void createInputAssemblyFromMeshAndEffect(const assets::Mesh& mesh, asset
 			inoutDesc.vertexInput
 			.addVertexAttribute(current, attr->getDataIndex(), layout, bindingMap[current].variableName.c_str())
 			.setInputBinding(attr->getDataIndex(), stride, types::StepRate::Vertex);
-			inoutDesc.inputAssembler.setPrimitiveTopology(mesh.getMeshInfo().primitiveType);
+			inoutDesc.inputAssembler.setPrimitiveTopology(mesh.getMeshInfo().primitiveType)
+			.setPrimitiveRestartEnable(mesh.getMeshInfo().usesPrimitiveRestart);
 		}
 		else
 		{
@@ -91,7 +92,8 @@ inline void createInputAssemblyFromMeshAndEffect(const assets::Mesh& mesh, asset
 		}
 		++current;
 	}
-	inoutDesc.inputAssembler.setPrimitiveTopology(mesh.getMeshInfo().primitiveType);
+	inoutDesc.inputAssembler.setPrimitiveTopology(mesh.getMeshInfo().primitiveType)
+			.setPrimitiveRestartEnable(mesh.getMeshInfo().usesPrimitiveRestart);
 }
 
 inline void createInputAssemblyFromMesh(const assets::Mesh& mesh, const VertexBindings* bindingMap, uint16 numBindings,
@@ -120,7 +122,8 @@ inline void createInputAssemblyFromMesh(const assets::Mesh& mesh, const VertexBi
 		}
 		++current;
 	}
-	inputAssemblerCreateParam.setPrimitiveTopology(mesh.getMeshInfo().primitiveType);
+	inputAssemblerCreateParam.setPrimitiveTopology(mesh.getMeshInfo().primitiveType)
+			.setPrimitiveRestartEnable(mesh.getMeshInfo().usesPrimitiveRestart);
 }
 
 inline void createInputAssemblyFromMesh(const assets::Mesh& mesh, const VertexBindings_Name* bindingMap, uint16 numBindings,
@@ -144,7 +147,8 @@ inline void createInputAssemblyFromMesh(const assets::Mesh& mesh, const VertexBi
 			vertexCreateParam
 				.addVertexAttribute(current, attr->getDataIndex(), layout, bindingMap[current].variableName.c_str())
 				.setInputBinding(attr->getDataIndex(), stride, types::StepRate::Vertex);
-			inputAssemblerCreateParam.setPrimitiveTopology(mesh.getMeshInfo().primitiveType);
+			inputAssemblerCreateParam.setPrimitiveTopology(mesh.getMeshInfo().primitiveType)
+			.setPrimitiveRestartEnable(mesh.getMeshInfo().usesPrimitiveRestart);
 		}
 		else
 		{
@@ -8,7 +8,9 @@
 
 #include "PVREngineUtils/RenderManager.h"
 #include "PVRApi/ApiUtils.h"
+#include "PVRCore/Base/HalfFloat.h"
 #include <algorithm>
+#include <cstring>
 namespace pvr {
 namespace utils {
 
@@ -75,7 +77,8 @@ inline std::pair<StringHash, effect::PipelineDef*> selectPipelineForSubpassGroup
 	if (!incompatible) // cond_pipe_it!=pass.subpasses[subpass].pipelines.end()
 	{
 		effect::PipelineDef* pipeDef =  effect->getPipelineDefinition(cond_pipe_it->pipeline);
-		pipeDef->createParam.inputAssembler.setPrimitiveTopology(mesh.getPrimitiveType());
+		pipeDef->createParam.inputAssembler.setPrimitiveTopology(mesh.getPrimitiveType())
+		.setPrimitiveRestartEnable(mesh.getMeshInfo().usesPrimitiveRestart);
 		return std::make_pair(cond_pipe_it->pipeline, pipeDef);
 	}
 
@@ -127,6 +130,74 @@ void attribToAttrib(
 	}
 }
 
+inline float32 quantizedToFloat(int8 value) { return std::max(value / 127.0f, -1.0f); }
+inline float32 quantizedToFloat(uint8 value) { return value / 255.0f; }
+inline float32 quantizedToFloat(int16 value) { return std::max(value / 32767.0f, -1.0f); }
+inline float32 quantizedToFloat(uint16 value) { return value / 65535.0f; }
+// Half floats are read as their bits: HalfFloat is not trivially copyable, so it cannot be the target of a memcpy.
+struct HalfFloatBits { uint16 bits; };
+inline float32 quantizedToFloat(HalfFloatBits value) { return HalfFloat::fromBits(value.bits); }
+
+// Normalized integers and half floats, as written by assets::utils::quantizeVertexAttributes, converted to float.
+template<typename Fromtype>
+void quantizedAttribToFloat(
+  byte* to, byte* from, uint32_t toOffset, uint32_t fromOffset, uint32_t toWidth, uint32_t fromWidth,
+  uint32_t tostride, uint32_t fromstride, uint32_t items)
+{
+	uint_fast16_t width = std::min(fromWidth, toWidth);
+	for (uint_fast32_t item = 0; item < items; ++item)
+	{
+		unsigned char* tmpTo = to + toOffset + item * tostride;
+		unsigned char* tmpFrom = from + fromOffset + item * fromstride;
+		uint32_t vec = 0;
+		for (; vec < width; ++vec)
+		{
+			Fromtype from_value;
+			memcpy(&from_value, tmpFrom + vec * sizeof(Fromtype), sizeof(Fromtype));
+			*reinterpret_cast<float32*>(tmpTo + vec * sizeof(float32)) = quantizedToFloat(from_value);
+		}
+		for (; vec < toWidth; ++vec)
+		{
+			*reinterpret_cast<float32*>(tmpTo + vec * sizeof(float32)) = (vec < 3 ? 0.0f : 1.0f);
+		}
+	}
+}
+
+// Quantized attributes are uploaded as they are. Missing components are left to zero.
+template<typename Type>
+void quantizedAttribToSame(
+  byte* to, byte* from, uint32_t toOffset, uint32_t fromOffset, uint32_t toWidth, uint32_t fromWidth,
+  uint32_t tostride, uint32_t fromstride, uint32_t items)
+{
+	uint_fast16_t width = std::min(fromWidth, toWidth);
+	for (uint_fast32_t item = 0; item < items; ++item)
+	{
+		memcpy(to + toOffset + item * tostride, from + fromOffset + item * fromstride, width * sizeof(Type));
+		memset(to + toOffset + item * tostride + width * sizeof(Type), 0, (toWidth - width) * sizeof(Type));
+	}
+}
+
+inline Reswizzler selectQuantizedReswizzler(types::DataType fromType, types::DataType toType)
+{
+	if (fromType == toType)
+	{
+		return types::dataTypeSize(fromType) == 2 ? &(quantizedAttribToSame<uint16>) : &(quantizedAttribToSame<uint8>);
+	}
+	if (toType != types::DataType::Float32)
+	{
+		assertion(false, "Unsupported POD Vertex Datatype");
+		return NULL;
+	}
+	switch (fromType)
+	{
+	case types::DataType::Int8Norm: return &(quantizedAttribToFloat<int8>);
+	case types::DataType::UInt8Norm: return &(quantizedAttribToFloat<uint8>);
+	case types::DataType::Int16Norm: return &(quantizedAttribToFloat<int16>);
+	case types::DataType::UInt16Norm: return &(quantizedAttribToFloat<uint16>);
+	default: return &(quantizedAttribToFloat<HalfFloatBits>);
+	}
+}
+
 struct Remapper { void* to; void* from; uint32_t tooffset, fromoffset, towidth, fromwidth, tostride, fromstride; };
 
 template<typename Fromtype, typename Totype>
@@ -248,6 +319,8 @@ Reswizzler selectReswizzler(types::DataType fromType, types::DataType toType)
 	case types::DataType::UInt8Norm:
 	case types::DataType::Int16Norm:
 	case types::DataType::UInt16Norm:
+	case types::DataType::Float16:
+		return selectQuantizedReswizzler(fromType, toType);
 	case types::DataType::Fixed16_16:
 		assertion(false, "Unsupported POD Vertex Datatype");
 		break;
@@ -458,10 +531,31 @@ inline Attribute mergeAttribute(Attribute one, const Attribute& two)
 	return one;
 }
 
+inline bool isQuantizedDatatype(types::DataType datatype)
+{
+	return types::dataTypeIsNormalised(datatype) || datatype == types::DataType::Float16;
+}
+
 inline void fixVertexLayoutDatatypes(Attribute& one, const assets::VertexAttributeData& two)
 {
 	assertion(one.semantic == two.getSemantic(), "RenderManager: Error processing effects. Attempted to merge attributes with different semantics");
-	one.datatype = (one.datatype == types::DataType::None ? two.getVertexLayout().dataType : std::min(one.datatype, two.getVertexLayout().dataType));
+	const types::DataType datatype = two.getVertexLayout().dataType;
+	if (one.datatype == types::DataType::None && isQuantizedDatatype(datatype))
+	{
+		// Quantized attributes are consumed directly, with their own width (octahedral normals have two components).
+		one.datatype = datatype;
+		one.width = (uint16)two.getN();
+	}
+	else if (one.datatype != datatype && (isQuantizedDatatype(one.datatype) || isQuantizedDatatype(datatype)))
+	{
+		// Meshes with different quantization share this layout: fall back to float.
+		one.datatype = types::DataType::Float32;
+		one.width = std::max(one.width, (uint16)two.getN());
+	}
+	else
+	{
+		one.datatype = (one.datatype == types::DataType::None ? datatype : std::min(one.datatype, datatype));
+	}
 }
 
 inline void mergeAttributeLayouts(AttributeLayout& inout_inner, AttributeLayout& willBeDestroyed_outer)
@@ -1691,6 +1785,12 @@ inline bool getBoneCount(TypedMem& mem, const RendermanNode& node)
 	return true;
 }
 
+inline bool getUnpackMatrix(TypedMem& mem, const RendermanNode& node)
+{
+	mem.setValue(node.toRendermanMesh().assetMesh->getUnpackMatrix());
+	return true;
+}
+
 #define BONEFUNC(idx) bool getBoneMatrix##idx(TypedMem& mem, const RendermanNode& node) { return getBoneMatrix(mem, node, idx); }\
     bool getBoneMatrixIT##idx(TypedMem& mem, const RendermanNode& node) { return getBoneMatrixIT(mem, node, idx); }
 
@@ -1833,6 +1933,13 @@ NodeSemanticSetter RendermanNode::getNodeSemanticSetter(const StringHash& semant
 		return &getBoneCount;
 	}
 	break;
+	case HashCompileTime<'U', 'N', 'P', 'A', 'C', 'K', 'M', 'A', 'T', 'R', 'I', 'X'>::value:
+	case HashCompileTime<'U', 'N', 'P', 'A', 'C', 'K', 'M', 'T', 'X'>::value:
+	case HashCompileTime<'U', 'N', 'P', 'A', 'C', 'K'>::value:
+	{
+		return &getUnpackMatrix;
+	}
+	break;
 	case HashCompileTime<'B', 'O', 'N', 'E', 'M', 'A', 'T', 'R', 'I', 'C', 'E', 'S'>::value: \
 	case HashCompileTime<'B', 'O', 'N', 'E', 'M', 'A', 'T', 'R', 'I', 'X', 'A', 'R', 'R', 'A', 'Y'>::value: \
 	case HashCompileTime<'B', 'O', 'N', 'E', 'M', 'A', 'T', 'R', 'I', 'X'>::value: \
@@ -2076,7 +2183,31 @@ void RendermanNode::recordRenderingCommands(api::CommandBufferBase cbuff, uint16
 	if (recordDrawCalls)
 	{
 		pvr::assets::Mesh& mesh = *rmesh.assetMesh;
-		if (rmesh.ibo.isValid())
+		const pvr::assets::Mesh::MeshInfo& meshInfo = mesh.getMeshInfo();
+		if (rmesh.ibo.isValid() && meshInfo.usesPrimitiveRestart)
+		{
+			cbuff->drawIndexed(0, mesh.getNumIndices());
+		}
+		else if (!meshInfo.stripLengths.empty())
+		{
+			// Strips that were not joined or converted at load (see ModelLoadOptions::stripConversion) are drawn
+			// one at a time. The bone batch offsets count strip triangles: draw the strips starting in this batch.
+			const uint32 batchBegin = mesh.getBatchFaceOffset(batchId);
+			const uint32 batchEnd = batchBegin + mesh.getNumFaces(batchId);
+			uint32 first = 0;
+			uint32 triangle = 0;
+			for (uint32 i = 0; i < meshInfo.stripLengths.size() && triangle < batchEnd; ++i)
+			{
+				if (triangle >= batchBegin)
+				{
+					if (rmesh.ibo.isValid()) { cbuff->drawIndexed(first, meshInfo.stripLengths[i] + 2); }
+					else { cbuff->drawArrays(first, meshInfo.stripLengths[i] + 2); }
+				}
+				first += meshInfo.stripLengths[i] + 2;
+				triangle += meshInfo.stripLengths[i];
+			}
+		}
+		else if (rmesh.ibo.isValid())
 		{
 			cbuff->drawIndexed(mesh.getBatchFaceOffset(batchId) * 3, mesh.getNumFaces(batchId) * 3);
 		}
@@ -10,6 +10,8 @@
 #include "PVRNativeApi/OGLES/TextureUtilsGles.h"
 #include "PVRCore/Texture.h"
 #include "PVRCore/Texture/PVRTDecompress.h"
+#include "PVRCore/Texture/PixelFormatConversion.h"
+#include "PVRCore/Texture/DecompressedTextureCache.h"
 #include "PVRNativeApi/OGLES/ApiErrorsGles.h"
 #include "PVRNativeApi/OGLES/NativeObjectsGles.h"
 #include "PVRNativeApi/OGLES/OpenGLESBindings.h"
@@ -98,6 +100,9 @@ TextureUploadResults textureUpload(IPlatformContext& context, const Texture& tex
 	//Texture to use if we decompress in software.
 	Texture cDecompressedTexture;
 
+	//Texture to use if we convert the pixel format in software.
+	Texture cConvertedTexture;
+
 	// Texture pointer which points at the texture we should use for the function. Allows switching to,
 	// for example, a decompressed version of the texture.
 	const Texture* textureToUse = &texture;
@@ -191,13 +196,19 @@ TextureUploadResults textureUpload(IPlatformContext& context, const Texture& tex
 					//No longer compressed if this is the case.
 					isCompressedFormat = false;
 
-					//Set up the new texture and header.
-					TextureHeader cDecompressedHeader(texture);
-					// robin: not sure what should happen here. The PVRTGENPIXELID4 macro is used in the old SDK.
-					cDecompressedHeader.setPixelFormat(GeneratePixelType4<'r', 'g', 'b', 'a', 8, 8, 8, 8>::ID);
+					//Reuse the result of a previous decompression if it is in the cache.
+					const bool cached = loadDecompressedTextureFromCache(texture, PixelFormat::RGBA_8888,
+					                    VariableType::UnsignedByteNorm, cDecompressedTexture);
+					if (!cached)
+					{
+						//Set up the new texture and header.
+						TextureHeader cDecompressedHeader(texture);
+						// robin: not sure what should happen here. The PVRTGENPIXELID4 macro is used in the old SDK.
+						cDecompressedHeader.setPixelFormat(GeneratePixelType4<'r', 'g', 'b', 'a', 8, 8, 8, 8>::ID);
 
-					cDecompressedHeader.setChannelType(VariableType::UnsignedByteNorm);
-					cDecompressedTexture = Texture(cDecompressedHeader);
+						cDecompressedHeader.setChannelType(VariableType::UnsignedByteNorm);
+						cDecompressedTexture = Texture(cDecompressedHeader);
+					}
 
 					//Update the texture format.
 					nativeGles::ConvertToGles::getOpenGLFormat(cDecompressedTexture.getPixelFormat(), cDecompressedTexture.getColorSpace(),
@@ -205,7 +216,7 @@ TextureUploadResults textureUpload(IPlatformContext& context, const Texture& tex
 					    glTypeSize, unused);
 
 					//Do decompression, one surface at a time.
-					for (uint32 uiMIPLevel = 0; uiMIPLevel < textureToUse->getNumberOfMIPLevels(); ++uiMIPLevel)
+					for (uint32 uiMIPLevel = 0; !cached && uiMIPLevel < textureToUse->getNumberOfMIPLevels(); ++uiMIPLevel)
 					{
 						for (uint32 uiArray = 0; uiArray < textureToUse->getNumberOfArrayMembers(); ++uiArray)
 						{
@@ -218,6 +229,7 @@ TextureUploadResults textureUpload(IPlatformContext& context, const Texture& tex
 							}
 						}
 					}
+					if (!cached) { storeDecompressedTextureInCache(texture, cDecompressedTexture); }
 					//Make sure the function knows to use a decompressed texture instead.
 					textureToUse = &cDecompressedTexture;
 				}
@@ -306,6 +318,13 @@ TextureUploadResults textureUpload(IPlatformContext& context, const Texture& tex
 					//The APPLE extension differs from the EXT extension, and accepts GL_RGBA as the internal format instead.
 					glInternalFormat =  GL_RGBA;
 				}
+				else if (convertTexture(*textureToUse, cConvertedTexture, PixelFormat::RGBA_8888, VariableType::UnsignedByteNorm))
+				{
+					Log(Log.Information, "BGRA8888 texture format support not detected. Converting to RGBA8888.");
+					nativeGles::ConvertToGles::getOpenGLFormat(cConvertedTexture.getPixelFormat(), cConvertedTexture.getColorSpace(),
+					    cConvertedTexture.getChannelType(), glInternalFormat, glFormat, glType, glTypeSize, unused);
+					textureToUse = &cConvertedTexture;
+				}
 				else
 				{
 					Log(Log.Error, cszUnsupportedFormat, "BGRA8888");
@@ -146,6 +146,7 @@ inline VkPrimitiveTopology primitiveTopology(types::PrimitiveTopology primitiveT
 inline VkFormat dataFormat(types::DataType dataType, uint8 width)
 {
 	static const VkFormat Float32[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static const VkFormat Float16[] = { VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT };
 	static const VkFormat Int32[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
 	static const VkFormat UInt32[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
 	static const VkFormat Int8[] = { VK_FORMAT_R8_SINT, VK_FORMAT_R8G8_SINT, VK_FORMAT_R8G8B8_SINT, VK_FORMAT_R8G8B8A8_SINT };
@@ -159,6 +160,7 @@ inline VkFormat dataFormat(types::DataType dataType, uint8 width)
 	switch (dataType)
 	{
 	case pvr::types::DataType::Float32: return Float32[width - 1];
+	case pvr::types::DataType::Float16: return Float16[width - 1];
 	case pvr::types::DataType::Int16: return Int16[width - 1];
 	case pvr::types::DataType::Int16Norm: return Int16Norm[width - 1];
 	case pvr::types::DataType::Int8: return Int8[width - 1];
@@ -15,6 +15,8 @@
 #include "PVRNativeApi/Vulkan/BufferUtilsVk.h"
 #include "PVRNativeApi/Vulkan/VkErrors.h"
 #include "PVRCore/Texture/PVRTDecompress.h"
+#include "PVRCore/Texture/PixelFormatConversion.h"
+#include "PVRCore/Texture/DecompressedTextureCache.h"
 
 namespace pvr {
 namespace utils {
@@ -439,7 +441,13 @@ bool createImage(VkDevice device, VkCommandBuffer cbuff,
 	return true;
 }
 
-
+inline uint32 getFullMipChainLength(uint32 width, uint32 height, uint32 depth)
+{
+	uint32 maxDimension = std::max(width, std::max(height, depth));
+	uint32 numMipLevels = 1;
+	while (maxDimension >>= 1) { ++numMipLevels; }
+	return numMipLevels;
+}
 
 }
 
@@ -805,6 +813,48 @@ void updateImage(IPlatformContext& ctx, ImageUpdateParam* updateParams, uint32 n
 	                     cbuff_transfer_operation, cbuff_give_ownership, cbuff_return_ownership);
 }
 
+bool isFormatSupportedForMipmapGeneration(VkPhysicalDevice physicalDevice, VkFormat format)
+{
+	if (isCompressedFormat(format)) { return false; }
+	const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+	    VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	VkFormatProperties prop;
+	vk::GetPhysicalDeviceFormatProperties(physicalDevice, format, &prop);
+	return (prop.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void generateMipmapsDeferred(VkCommandBuffer cbuff, VkImage image, VkFormat format, const types::Extent3D& dimension,
+                             uint32 numMipLevels, uint32 numArrayLayers, VkImageLayout finalLayout)
+{
+	const VkImageAspectFlags aspect = inferAspectFromFormat(format);
+	VkImageBlit blit = {};
+	blit.srcSubresource = VkImageSubresourceLayers{ aspect, 0, 0, numArrayLayers };
+	blit.dstSubresource = VkImageSubresourceLayers{ aspect, 0, 0, numArrayLayers };
+	blit.srcOffsets[1] = VkOffset3D{ (int32)dimension.width, (int32)dimension.height, (int32)dimension.depth };
+
+	for (uint32 mipLevel = 1; mipLevel < numMipLevels; ++mipLevel)
+	{
+		blit.srcSubresource.mipLevel = mipLevel - 1;
+		blit.dstSubresource.mipLevel = mipLevel;
+		blit.dstOffsets[1] = VkOffset3D{ std::max(blit.srcOffsets[1].x >> 1, 1), std::max(blit.srcOffsets[1].y >> 1, 1),
+		                                 std::max(blit.srcOffsets[1].z >> 1, 1) };
+
+		setImageLayoutAndQueueOwnership(cbuff, VK_NULL_HANDLE, -1, -1, VK_IMAGE_LAYOUT_UNDEFINED,
+		                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image, mipLevel, 1, 0, numArrayLayers, aspect);
+
+		vk::CmdBlitImage(cbuff, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                 1, &blit, VK_FILTER_LINEAR);
+
+		// The level just written is the source of the next one.
+		setImageLayoutAndQueueOwnership(cbuff, VK_NULL_HANDLE, -1, -1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, mipLevel, 1, 0, numArrayLayers, aspect);
+		blit.srcOffsets[1] = blit.dstOffsets[1];
+	}
+
+	setImageLayoutAndQueueOwnership(cbuff, VK_NULL_HANDLE, -1, -1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                                finalLayout, image, 0, numMipLevels, 0, numArrayLayers, aspect);
+}
+
 bool createImageAndMemory(platform::NativePlatformHandles_& handles,
   const types::Extent3D &dimension, uint32 arrayLayer,
   VkSampleCountFlagBits sampleCount, uint32 numMipLevels, bool isCubeMap,
@@ -904,7 +954,12 @@ const Texture* decompressIfRequired(const Texture& texture, Texture& decompresse
 			{
 				Log(Log.Information, "PVRTC texture format support not detected. Decompressing PVRTC to"
 				    " corresponding format (RGBA32 or RGB24)");
-				decompressPvrtc(texture, decompressedTexture);
+				if (!loadDecompressedTextureFromCache(texture, PixelFormat::RGBA_8888, VariableType::UnsignedByteNorm,
+				                                      decompressedTexture))
+				{
+					decompressPvrtc(texture, decompressedTexture);
+					storeDecompressedTextureInCache(texture, decompressedTexture);
+				}
 				textureToUse = &decompressedTexture;
 				results.decompressed = true;
 			}
@@ -956,8 +1011,54 @@ const Texture* decompressIfRequired(const Texture& texture, Texture& decompresse
 }
 
 
+// Find the VkFormat of the texture. If there is none, convert the texture to RGBA8888 (e.g. BGR888 TGA files).
+const Texture* convertIfUnsupported(const Texture& texture, Texture& convertedTexture, VkFormat& outFormat)
+{
+	outFormat = nativeVk::ConvertToVk::pixelFormat(texture.getPixelFormat(), texture.getColorSpace(),
+	            texture.getChannelType());
+	if (outFormat != VK_FORMAT_UNDEFINED ||
+	    !isPixelFormatConversionSupported(texture.getPixelFormat(), texture.getChannelType(),
+	                                      PixelFormat::RGBA_8888, VariableType::UnsignedByteNorm))
+	{
+		return &texture;
+	}
+	Log(Log.Information, "TextureUtils.h:textureUpload:: Texture's pixel type is not supported by this API."
+	    " Converting to RGBA8888.");
+	if (!convertTexture(texture, convertedTexture, PixelFormat::RGBA_8888, VariableType::UnsignedByteNorm))
+	{
+		return &texture;
+	}
+	outFormat = nativeVk::ConvertToVk::pixelFormat(convertedTexture.getPixelFormat(), convertedTexture.getColorSpace(),
+	            convertedTexture.getChannelType());
+	return &convertedTexture;
+}
+
+// Find the mip levels to create and to upload. If mipmaps are generated, the full chain is created and only the top
+// level is uploaded, to be blitted down afterwards. If the format cannot be blitted, the texture's own levels are
+// uploaded instead and generateMipmaps is cleared.
+void prepareMipmapGeneration(VkPhysicalDevice physicalDevice, const Texture& texture, VkFormat format,
+                             bool& generateMipmaps, uint32& numMipLevels, uint32& numUploadMipLevels,
+                             TextureUploadResultsData_& results, const char* function)
+{
+	numMipLevels = numUploadMipLevels = texture.getNumberOfMIPLevels();
+	if (!generateMipmaps) { return; }
+	if (isFormatSupportedForMipmapGeneration(physicalDevice, format))
+	{
+		numMipLevels = getFullMipChainLength(texture.getWidth(), texture.getHeight(), texture.getDepth());
+		numUploadMipLevels = 1;
+		results.textureSize.numMipLevels = (uint16)numMipLevels;
+	}
+	else
+	{
+		Log(Log.Warning, "TextureUtils.h:%s:: Texture's format does not support mipmap generation by blitting. "
+		    "Uploading the texture's own mip levels instead.\n", function);
+		generateMipmaps = false;
+	}
+}
+
 
-TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture, bool allowDecompress)
+TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture, bool allowDecompress,
+                                   bool generateMipmaps)
 {
 	auto& handles = ctx.getNativePlatformHandles();
 	const VkDevice& device = handles.context.device;
@@ -989,10 +1090,13 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 	                              supportPvrtc2, results);
 
 
+	//Texture to use if the format has to be converted in software.
+	Texture convertedTexture;
+
 	// Check that the format is a valid format for this API - Doesn't check specifically between OpenGL/ES,
 	// it simply gets the values that would be set for a KTX file.
-	if ((format = nativeVk::ConvertToVk::pixelFormat(textureToUse->getPixelFormat(), textureToUse->getColorSpace(),
-	              textureToUse->getChannelType())) == VK_FORMAT_UNDEFINED)
+	textureToUse = convertIfUnsupported(*textureToUse, convertedTexture, format);
+	if (format == VK_FORMAT_UNDEFINED)
 	{
 		Log(Log.Error, "TextureUtils.h:textureUpload:: Texture's pixel type is not supported by this API.\n");
 		results.result = Result::UnsupportedRequest;
@@ -1005,6 +1109,11 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 	       texMipLevels = textureToUse->getNumberOfMIPLevels(), texArraySlices = textureToUse->getNumberOfArrayMembers(),
 	       texFaces = textureToUse->getNumberOfFaces();
 
+	uint32 uploadMipLevels;
+	const types::Extent3D topLevelExtent(texWidth, texHeight, texDepth);
+	prepareMipmapGeneration(handles.context.physicalDevice, *textureToUse, format, generateMipmaps, texMipLevels,
+	                        uploadMipLevels, results, "textureUpload");
+
 	// create the out image and prepare for trasfer operation
 	if (!vulkan::createImageAndMemory(device, memprops,
 	                                  types::Extent3D(texWidth, texHeight, texDepth), texArraySlices,
@@ -1025,9 +1134,9 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 
 	//Edit the info to be the small, linear images that we are using.
 	using utils::vulkan::ImageUpdateParam;
-	std::vector<ImageUpdateParam> imageUpdates(texMipLevels * texArraySlices * texFaces);
+	std::vector<ImageUpdateParam> imageUpdates(uploadMipLevels * texArraySlices * texFaces);
 	uint32 imageUpdateIndex = 0;
-	for (uint32 mipLevel = 0; mipLevel < texMipLevels; ++mipLevel)
+	for (uint32 mipLevel = 0; mipLevel < uploadMipLevels; ++mipLevel)
 	{
 		texWidth = textureToUse->getWidth(mipLevel);
 		texHeight = textureToUse->getHeight(mipLevel);
@@ -1052,8 +1161,15 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 
 	auto result = vulkan::updateImageDeferred(
 	                device, cbuff, VK_NULL_HANDLE, VK_NULL_HANDLE, -1, -1, memprops,
-	                imageUpdates.data(), (uint32)imageUpdates.size(),
-	                format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texFaces > 1, results.image.image);
+	                imageUpdates.data(), (uint32)imageUpdates.size(), format,
+	                generateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                texFaces > 1, results.image.image);
+
+	if (generateMipmaps)
+	{
+		generateMipmapsDeferred(cbuff, results.image.image, format, topLevelExtent, texMipLevels,
+		                        texArraySlices * texFaces, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
 
 	nativeVk::vkThrowIfFailed(vk::EndCommandBuffer(cbuff), "TextureUtils:TextureUpload End");
 
@@ -1065,7 +1181,8 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 }
 
 
-TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, const Texture& texture, bool allowDecompress)
+TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, const Texture& texture, bool allowDecompress,
+    bool generateMipmaps)
 {
 	auto& handle = ctx.getParentContext().getNativePlatformHandles();
 	auto& sharedhandle = ctx.getSharedHandles();
@@ -1097,10 +1214,13 @@ TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, con
 	                              supportPvrtc2, results);
 
 
+	//Texture to use if the format has to be converted in software.
+	Texture convertedTexture;
+
 	// Check that the format is a valid format for this API - Doesn't check specifically between OpenGL/ES,
 	// it simply gets the values that would be set for a KTX file.
-	if ((format = nativeVk::ConvertToVk::pixelFormat(textureToUse->getPixelFormat(), textureToUse->getColorSpace(),
-	              textureToUse->getChannelType())) == VK_FORMAT_UNDEFINED)
+	textureToUse = convertIfUnsupported(*textureToUse, convertedTexture, format);
+	if (format == VK_FORMAT_UNDEFINED)
 	{
 		Log(Log.Error, "TextureUtils.h:textureUpload:: Texture's pixel type is not supported by this API.\n");
 		results.result = Result::UnsupportedRequest;
@@ -1113,6 +1233,11 @@ TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, con
 	       texMipLevels = textureToUse->getNumberOfMIPLevels(), texArraySlices = textureToUse->getNumberOfArrayMembers(),
 	       texFaces = textureToUse->getNumberOfFaces();
 
+	uint32 uploadMipLevels;
+	const types::Extent3D topLevelExtent(texWidth, texHeight, texDepth);
+	prepareMipmapGeneration(handle.context.physicalDevice, *textureToUse, format, generateMipmaps, texMipLevels,
+	                        uploadMipLevels, results, "textureUploadDeferred");
+
 	// create the out image and prepare for trasfer operation
 	if (!vulkan::createImageAndMemory(
 	      device, memprops, types::Extent3D(texWidth, texHeight, texDepth), texArraySlices,
@@ -1150,9 +1275,9 @@ TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, con
 
 		//Edit the info to be the small, linear images that we are using.
 		using utils::vulkan::ImageUpdateParam;
-		std::vector<ImageUpdateParam> imageUpdates(texMipLevels * texArraySlices * texFaces);
+		std::vector<ImageUpdateParam> imageUpdates(uploadMipLevels * texArraySlices * texFaces);
 		uint32 imageUpdateIndex = 0;
-		for (uint32 mipLevel = 0; mipLevel < texMipLevels; ++mipLevel)
+		for (uint32 mipLevel = 0; mipLevel < uploadMipLevels; ++mipLevel)
 		{
 			texWidth = textureToUse->getWidth(mipLevel);
 			texHeight = textureToUse->getHeight(mipLevel);
@@ -1178,7 +1303,16 @@ TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, con
 		results.updateCleanupData = updateImageDeferred(
 		                              device, cbuffMain, cbuffTakeOwn, cbuffRelinquishOwn, handle.universalQueueFamily,
 		                              sharedhandle.queueFamily, memprops, imageUpdates.data(), (uint32)imageUpdates.size(),
-		                              format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texFaces > 1, results.image.image);
+		                              format, generateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		                              texFaces > 1, results.image.image);
+
+		// The shared queue may be transfer-only: if ownership returns to the main queue, blit there instead.
+		if (generateMipmaps)
+		{
+			generateMipmapsDeferred(multiQFamily ? cbuffRelinquishOwn : cbuffMain, results.image.image, format,
+			                        topLevelExtent, texMipLevels, texArraySlices * texFaces,
+			                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
 
 		nativeVk::vkThrowIfFailed(vk::EndCommandBuffer(cbuffMain), "TextureUtils:TextureUpload End");
 		if (multiQFamily)
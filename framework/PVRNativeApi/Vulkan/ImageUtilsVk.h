@@ -213,6 +213,29 @@ void updateImage(IPlatformContext& ctx, ImageUpdateParam* updateParams, uint32 n
                  uint32 numArraySlice, VkFormat srcFormat, bool isCubeMap, VkImage image,
                  VkImageLayout currentLayout);
 
+/// <summary>Query if images of a specific format can have their mipmaps generated with vkCmdBlitImage on this
+/// device. Requires optimal tiling support for blit source, blit destination and linear filtering.</summary>
+/// <param name="physicalDevice">The physical device to query</param>
+/// <param name="format">The format of the image</param>
+/// <returns>Return true if the format supports mipmap generation by blitting</returns>
+bool isFormatSupportedForMipmapGeneration(VkPhysicalDevice physicalDevice, VkFormat format);
+
+/// <summary>Utility function to record the generation of mip levels 1 to numMipLevels-1 of an image from its mip
+/// level 0, using a chain of linear-filtered blits where each level is downsampled from the previous one. This function
+/// will record the commands in the supplied command buffer but NOT submit the command buffer.
+/// IMPORTANT. Assumes mip level 0 of all array layers is in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL. The previous contents
+/// of all other levels are discarded.
+/// IMPORTANT. The command buffer must be submitted to a queue supporting graphics operations.</summary>
+/// <param name="cbuff">The command buffer to record the commands into</param>
+/// <param name="image">The image whose mip levels will be generated</param>
+/// <param name="format">The format of the image. Use isFormatSupportedForMipmapGeneration to check support.</param>
+/// <param name="dimension">The dimensions of mip level 0 of the image</param>
+/// <param name="numMipLevels">The total number of mip levels of the image</param>
+/// <param name="numArrayLayers">The number of array layers of the image (cube faces count as array layers)</param>
+/// <param name="finalLayout">The layout all mip levels will be transitioned to after generation</param>
+void generateMipmapsDeferred(VkCommandBuffer cbuff, VkImage image, VkFormat format, const types::Extent3D& dimension,
+                             uint32 numMipLevels, uint32 numArrayLayers, VkImageLayout finalLayout);
+
 struct TextureUploadResultsData_
 {
 	/// <summary>The dimensions of the texture created</summary>
@@ -345,10 +368,14 @@ typedef std::auto_ptr<TextureUploadAsyncResults_> TextureUploadAsyncResults;
 /// The textures will be decompressed if ALL of the following are true: The texture is in a compressed format that
 /// can be decompressed by the framework (PVRTC), the platform does NOT support this format (if it is hardware
 /// supported, it will never be decompressed), and this flag is set to true. Default:true.</param>
+/// <param name="generateMipmaps">Set to true to only upload the texture's top mip level and generate a full mip chain
+/// on the GPU by blitting. Ignored (the texture's own mip levels are uploaded) if the format does not support linear
+/// blits, for example if it is compressed. Default:false.</param>
 /// <returns>A TextureUploadResults struct containing the result of the function as well as all required information
 /// about the returned texture, including if the function succeeded, the handles to the texture and memory, the
 /// size and format of the resulting texture, and if it was decompressed</returns>
-TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture, bool allowDecompress);
+TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture, bool allowDecompress,
+                                   bool generateMipmaps = false);
 
 /// <summary>Upload a texture to the GPU and retrieve the into native handle. Image layout after upload is
 /// VK_LAYOUT_SHADER_READ_ONLY_OPTIMAL. Must wait on the fence before using.</summary>
@@ -358,10 +385,14 @@ TextureUploadResults textureUpload(IPlatformContext& ctx, const Texture& texture
 /// The textures will be decompressed if ALL of the following are true: The texture is in a compressed format that
 /// can be decompressed by the framework (PVRTC), the platform does NOT support this format (if it is hardware
 /// supported, it will never be decompressed), and this flag is set to true. Default:true.</param>
+/// <param name="generateMipmaps">Set to true to only upload the texture's top mip level and generate a full mip chain
+/// on the GPU by blitting. The blits are recorded on the main (graphics) queue if the shared context's queue belongs
+/// to a different family. Ignored if the format does not support linear blits. Default:false.</param>
 /// <returns>A TextureUploadResults struct containing the result of the function as well as all required information
 /// about the returned texture, including if the function succeeded, the handles to the texture and memory, the
 /// size and format of the resulting texture, and if it was decompressed</returns>
-TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, const Texture& texture, bool allowDecompress);
+TextureUploadAsyncResults textureUploadDeferred(ISharedPlatformContext& ctx, const Texture& texture, bool allowDecompress,
+    bool generateMipmaps = false);
 }
 }
 }
@@ -0,0 +1,140 @@
+/*!
+\brief Checks that CookedModelReader rejects truncated cooked model files and files whose tables refer to entries
+that do not exist.
+\file Tests/PVRAssets/CookedModelReaderTest.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/FileIO/CookedModelReader.h"
+#include "PVRAssets/FileIO/CookedModelWriter.h"
+#include "PVRAssets/Model.h"
+#include "PVRCore/IO/BufferStream.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+using namespace pvr;
+using namespace pvr::assets;
+namespace {
+// A triangle mesh node using a material, a light node, a camera node and a node that both of them target.
+void buildModel(Model& model)
+{
+	static const float32 positions[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	static const uint16 indices[3] = { 0, 1, 2 };
+	model.allocMeshes(1);
+	Mesh& mesh = model.getMesh(0);
+	mesh.addData(reinterpret_cast<const byte*>(positions), sizeof(positions), 12);
+	mesh.addVertexAttribute("POSITION", types::DataType::Float32, 3, 0, 0);
+	mesh.addFaces(reinterpret_cast<const byte*>(indices), sizeof(indices), types::IndexType::IndexType16Bit);
+	mesh.setNumVertices(3);
+	mesh.setNumFaces(1);
+	model.addMaterial(Model::Material());
+	model.allocLights(1);
+	model.allocCameras(1);
+	model.allocMeshNodes(1);
+	model.allocNodes(4);
+	model.getNode(0).setIndex(0);
+	model.getNode(0).setMaterialIndex(0);
+	model.getNode(1).setIndex(0);
+	model.getNode(1).setParentID(0);
+	model.getNode(2).setIndex(0);
+	model.getNode(3).setParentID(2);
+	model.getLight(0).setTargetNodeIdx(3);
+	model.getCamera(0).setTargetNodeIndex(3);
+}
+
+// Write a model to memory and return the size of the cooked file.
+size_t cook(const Model& model, std::vector<byte>& file)
+{
+	file.assign(1 << 16, 0);
+	assetWriters::CookedModelWriter writer;
+	writer.openAssetStream(Stream::ptr_type(new BufferStream("", file.data(), file.size())));
+	writer.addAssetToWrite(model);
+	if (!writer.writeAllAssets()) { return 0; }
+	cookedModel::SectionEntry sections[2];
+	memcpy(sections, file.data() + sizeof(cookedModel::FileHeader), sizeof(sections));
+	return (size_t)(sections[1].offset + sections[1].size);
+}
+
+bool load(const std::vector<byte>& file, size_t size, Model& model)
+{
+	CookedModelReader reader(Stream::ptr_type(new BufferStream("", file.data(), size)));
+	return reader.readAsset(model);
+}
+
+// Cook a copy of the model broken by corrupt, and check that it is rejected.
+template<typename Corruption>
+uint32 checkRejected(const char* name, const Model& original, Corruption corrupt)
+{
+	Model model = original;
+	corrupt(model);
+	std::vector<byte> file;
+	Model loaded;
+	const size_t size = cook(model, file);
+	if (size && !load(file, size, loaded)) { return 0; }
+	printf("Loaded a model with %s\n", name);
+	return 1;
+}
+}
+
+int main()
+{
+	Model model;
+	buildModel(model);
+	std::vector<byte> file;
+	const size_t size = cook(model, file);
+	uint32 failures = 0;
+	Model loaded;
+	if (!size || !load(file, size, loaded) || loaded.getNumNodes() != 4 || loaded.getNumMeshes() != 1)
+	{
+		printf("Failed to load the valid model\n");
+		++failures;
+	}
+
+	// Every truncation leaves a section past the end of the file.
+	for (size_t truncated = 0; truncated < size; ++truncated)
+	{
+		Model partial;
+		if (load(file, truncated, partial))
+		{
+			printf("Loaded a model truncated to %u of %u bytes\n", (uint32)truncated, (uint32)size);
+			++failures;
+		}
+	}
+
+	// Section sizes beyond the end of the file.
+	for (uint32 section = 0; section < 2; ++section)
+	{
+		std::vector<byte> corrupted(file.begin(), file.begin() + size);
+		const uint64 hugeSize = ~0ull >> 4;
+		memcpy(corrupted.data() + sizeof(cookedModel::FileHeader) + section * sizeof(cookedModel::SectionEntry) +
+		       offsetof(cookedModel::SectionEntry, size), &hugeSize, sizeof(hugeSize));
+		Model partial;
+		if (load(corrupted, corrupted.size(), partial))
+		{
+			printf("Loaded a model whose section %u is larger than the file\n", section);
+			++failures;
+		}
+	}
+
+	failures += checkRejected("a mesh node of a missing mesh", model, [](Model & m) { m.getNode(0).setIndex(1); });
+	failures += checkRejected("a light node of a missing light", model, [](Model & m) { m.getNode(1).setIndex(1); });
+	failures += checkRejected("a camera node without a camera", model, [](Model & m) { m.getNode(2).setIndex(-1); });
+	failures += checkRejected("a missing material", model, [](Model & m) { m.getNode(0).setMaterialIndex(1); });
+	failures += checkRejected("a negative material", model,
+	                          [](Model & m) { m.getNode(0).getInternalData().materialIndex = -2; });
+	failures += checkRejected("a missing parent", model, [](Model & m) { m.getNode(3).setParentID(4); });
+	failures += checkRejected("a node parenting itself", model, [](Model & m) { m.getNode(2).setParentID(2); });
+	failures += checkRejected("a parent cycle", model, [](Model & m) { m.getNode(0).setParentID(1); });
+	failures += checkRejected("a missing camera target", model, [](Model & m) { m.getCamera(0).setTargetNodeIndex(4); });
+	failures += checkRejected("a missing spot target", model, [](Model & m) { m.getLight(0).setTargetNodeIdx(9); });
+	failures += checkRejected("more mesh nodes than nodes", model,
+	                          [](Model & m) { m.getInternalData().numMeshNodes = 5; });
+	failures += checkRejected("too few nodes for the lights and cameras", model,
+	                          [](Model & m) { m.getInternalData().numMeshNodes = 3; });
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
+//!\endcond
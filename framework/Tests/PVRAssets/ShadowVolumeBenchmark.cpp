@@ -0,0 +1,60 @@
+/*!
+\brief Times ShadowVolume::init, which finds the vertices, edges and triangles of the shadow mesh, on generated
+meshes of 10 thousand to 1 million triangles.
+\file Tests/PVRAssets/ShadowVolumeBenchmark.cpp
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+//!\cond NO_DOXYGEN
+#include "PVRAssets/ShadowVolume.h"
+#include "Tests/PVRAssets/TorusMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace pvr;
+namespace {
+// The best of a few runs of init, in milliseconds, or a negative value if init fails.
+float64 timeInit(const std::vector<float32>& positions, const std::vector<uint32>& indices, uint32 numThreads)
+{
+	const uint32 NumRuns = 3;
+	float64 best = 0.0;
+	for (uint32 run = 0; run < NumRuns; ++run)
+	{
+		ShadowVolume volume;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (volume.init((const byte*)positions.data(), (uint32)positions.size() / 3, 12, types::DataType::Float32,
+		                (const byte*)indices.data(), (uint32)indices.size() / 3, types::IndexType::IndexType32Bit,
+		                numThreads) != Result::Success)
+		{
+			return -1.0;
+		}
+		const float64 milliseconds =
+		  std::chrono::duration<float64, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = run ? (std::min)(best, milliseconds) : milliseconds;
+	}
+	return best;
+}
+}
+
+int main()
+{
+	// Rings and sides of tori of 10k, 100k and 1M triangles.
+	const uint32 sizes[][2] = { { 50, 100 }, { 250, 200 }, { 1000, 500 } };
+	printf("%10s %16s %16s\n", "triangles", "1 thread (ms)", "all threads (ms)");
+	std::vector<float32> positions;
+	std::vector<uint32> indices;
+	for (uint32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		tests::buildTorus(sizes[i][0], sizes[i][1], positions, indices);
+		const float64 singleThread = timeInit(positions, indices, 1), allThreads = timeInit(positions, indices, 0);
+		if (singleThread < 0.0 || allThreads < 0.0)
+		{
+			printf("init failed\n");
+			return 1;
+		}
+		printf("%10u %16.1f %16.1f\n", (uint32)indices.size() / 3, singleThread, allThreads);
+	}
+	return 0;
+}
+//!\endcond
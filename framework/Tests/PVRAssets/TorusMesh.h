@@ -0,0 +1,44 @@
+/*!
+\brief Generates a closed torus triangle mesh for the PVRAssets tests and benchmarks.
+\file Tests/PVRAssets/TorusMesh.h
+\author PowerVR by Imagination, Developer Technology Team
+\copyright Copyright (c) Imagination Technologies Limited.
+*/
+#pragma once
+#include "PVRCore/CoreIncludes.h"
+#include <cmath>
+
+//!\cond NO_DOXYGEN
+namespace pvr {
+namespace tests {
+// A torus of rings * sides * 2 triangles: closed, so that every edge is shared by two triangles. Positions are three
+// floats per vertex, indices three per triangle.
+inline void buildTorus(uint32 rings, uint32 sides, std::vector<float32>& positions, std::vector<uint32>& indices)
+{
+	positions.clear();
+	indices.clear();
+	for (uint32 ring = 0; ring < rings; ++ring)
+	{
+		const float32 u = 6.2831853f * ring / rings;
+		for (uint32 side = 0; side < sides; ++side)
+		{
+			const float32 v = 6.2831853f * side / sides;
+			positions.push_back((2.0f + cosf(v)) * cosf(u));
+			positions.push_back((2.0f + cosf(v)) * sinf(u));
+			positions.push_back(sinf(v));
+		}
+	}
+	for (uint32 ring = 0; ring < rings; ++ring)
+	{
+		for (uint32 side = 0; side < sides; ++side)
+		{
+			const uint32 a = ring * sides + side, b = ((ring + 1) % rings) * sides + side;
+			const uint32 c = ring * sides + (side + 1) % sides, d = ((ring + 1) % rings) * sides + (side + 1) % sides;
+			const uint32 quad[6] = { a, b, c, c, b, d };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+}
+}
+//!\endcond